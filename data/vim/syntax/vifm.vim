@@ -14,8 +14,8 @@ set cpo-=C
 
 " General commands
 syntax keyword vifmCommand contained
-		\ alink apropos bmark bmarks bmgo cds change chi[story] chmod chown clone
-		\ compare cope[n] co[py] cq[uit] d[elete] delbmarks delm[arks] delsession
+		\ alink apropos bmark bmarks bmgo cachestats cds change chi[story] chmod
+		\ chown clone compare cope[n] co[py] cq[uit] d[elete] delbmarks delm[arks] delsession
 		\ di[splay] dirs e[dit] el[se] empty en[dif] exi[t] file fin[d] fini[sh]
 		\ go[to] gr[ep] h[elp] hideui histnext his[tory] histprev keepsel jobs
 		\ locate ls lstrash marks media mes[sages] mkdir m[ove] noh[lsearch]
@@ -27,8 +27,8 @@ syntax keyword vifmCommand contained
 		\ w[rite] wq wqa[ll] xa[ll] x[it] y[ank]
 		\ nextgroup=vifmArgs
 syntax keyword vifmCommandCN contained
-		\ alink apropos bmark bmarks bmgo cds change chi[story] chmod chown clone
-		\ compare cope[n] co[py] cq[uit] d[elete] delbmarks delm[arks] delsession
+		\ alink apropos bmark bmarks bmgo cachestats cds change chi[story] chmod
+		\ chown clone compare cope[n] co[py] cq[uit] d[elete] delbmarks delm[arks] delsession
 		\ di[splay] dirs e[dit] el[se] empty en[dif] exi[t] file fin[d] fini[sh]
 		\ go[to] gr[ep] h[elp] hideui histnext his[tory] histprev keepsel jobs
 		\ locate ls lstrash marks media mes[sages] mkdir m[ove] noh[lsearch]
@@ -159,17 +159,19 @@ syntax match vifmHiGroups contained
 
 " Options
 syntax keyword vifmOption contained aproposprg autocd autochpos caseoptions
-		\ cdpath cd chaselinks classify columns co confirm cf cpoptions cpo
-		\ cvoptions deleteprg dotdirs dotfiles dirsize extprompt fastrun fillchars
-		\ fcs findprg followlinks fusehome gdefault grepprg histcursor history hi
-		\ hloptions hlsearch hls iec ignorecase ic iooptions incsearch is keepsel
-		\ laststatus lines locateprg ls lsoptions lsview mediaprg milleroptions
-		\ millerview mintimeoutlen mouse navoptions number nu numberwidth nuw
-		\ previewoptions previewprg quickview relativenumber rnu rulerformat ruf
+		\ cdpath cd chaselinks classify columns co comparecache confirm cf cpoptions
+		\ cpo cvoptions deleteprg dotdirs dotfiles dirsize extprompt fastrun
+		\ fillchars fcs findprg followlinks fusehome gdefault grepprg histcursor
+		\ history hi hloptions hlsearch hls iec ignorecase ic iooptions incsearch is
+		\ keepsel laststatus lines listcache locateprg ls lsoptions lsview mediaprg
+		\ milleroptions millerview mintimeoutlen mouse navoptions number nu
+		\ numberwidth nuw prefetchmax previewoptions previewprg quickview
+		\ relativenumber rnu rulerformat ruf
 		\ runexec scrollbind scb scrolloff sessionoptions ssop so sort sortgroups
 		\ sortorder sortnumbers shell sh shellflagcmd shcf shortmess shm showtabline
-		\ stal sizefmt slowfs smartcase scs statusline stl suggestoptions syncregs
-		\ syscalls tablabel tabline tabprefix tabscope tabstop tabsuffix tal timefmt
+		\ stal sizefmt slowfs smartcase scs snapshotmin statusline stl
+		\ suggestoptions syncregs syscalls tablabel tabline tabprefix tabscope tabstop
+		\ tabsuffix tal timefmt
 		\ timeoutlen title tm trash trashdir ts tuioptions to uioptions undolevels
 		\ ul vicmd viewcolumns vifminfo vimhelp vixcmd wildinc wildmenu wmnu
 		\ wildstyle wordchars wrap wrapscan ws
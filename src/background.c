@@ -30,7 +30,7 @@
 #include <sys/wait.h> /* waitpid() */
 #endif
 #include <signal.h> /* SIG* kill() */
-#include <unistd.h> /* execve() fork() setsid() usleep() */
+#include <unistd.h> /* execve() fork() setpgid() setsid() usleep() */
 
 #include <assert.h> /* assert() */
 #include <errno.h> /* errno */
@@ -126,6 +126,8 @@ static void make_ready_list(const bg_job_t *jobs, selector_t *selector);
 static void rip_children(void);
 static void rip_child(pid_t pid, int status);
 static void report_error_msg(const char title[], const char text[]);
+static pid_t run_and_capture(char cmd[], int user_sh, FILE *in, FILE **out,
+		FILE **err, int new_group);
 #endif
 static bg_job_t * launch_external(const char cmd[], const char pwd[],
 		BgJobFlags flags, ShellRequester by);
@@ -697,6 +699,22 @@ append_error_msg(bg_job_t *job, const char err_msg[])
 #ifndef _WIN32
 pid_t
 bg_run_and_capture(char cmd[], int user_sh, FILE *in, FILE **out, FILE **err)
+{
+	return run_and_capture(cmd, user_sh, in, out, err, /*new_group=*/0);
+}
+
+pid_t
+bg_run_and_capture_group(char cmd[], int user_sh, FILE *in, FILE **out,
+		FILE **err)
+{
+	return run_and_capture(cmd, user_sh, in, out, err, /*new_group=*/1);
+}
+
+/* Implements bg_run_and_capture() and bg_run_and_capture_group().  Returns id
+ * of the process or (pid_t)-1 on error. */
+static pid_t
+run_and_capture(char cmd[], int user_sh, FILE *in, FILE **out, FILE **err,
+		int new_group)
 {
 	pid_t pid;
 	int out_pipe[2];
@@ -739,6 +757,12 @@ bg_run_and_capture(char cmd[], int user_sh, FILE *in, FILE **out, FILE **err)
 		return (pid_t)-1;
 	}
 
+	/* Both processes set the group to not depend on which of them runs first. */
+	if(new_group)
+	{
+		(void)setpgid(pid, 0);
+	}
+
 	if(pid == 0)
 	{
 		if(out != NULL)
@@ -170,6 +170,14 @@ int bg_and_wait_for_errors(char cmd[],
 pid_t bg_run_and_capture(char cmd[], int user_sh, FILE *in, FILE **out,
 		FILE **err);
 
+#ifndef _WIN32
+/* Same as bg_run_and_capture(), but puts the command in a new process group
+ * whose id matches id of the process, so that signals can reach every process
+ * it starts.  Returns id of the process or (pid_t)-1 on error. */
+pid_t bg_run_and_capture_group(char cmd[], int user_sh, FILE *in, FILE **out,
+		FILE **err);
+#endif
+
 /* Checks status of background jobs (their streams and state).  Removes finished
  * ones from the list, optionally displays any pending error messages, corrects
  * job bar if needed. */
@@ -184,6 +184,10 @@ cfg_init(void)
 	cfg.short_term_mux_titles = 0;
 
 	cfg.slow_fs_list = strdup("");
+	cfg.snapshot_min = 0;
+	cfg.compare_cache = 0;
+	cfg.list_cache_size = 32*1024;
+	cfg.prefetch_max = 0;
 
 	cfg.cd_path = strdup(env_get_def("CDPATH", DEFAULT_CD_PATH));
 	replace_char(cfg.cd_path, ':', ',');
@@ -611,6 +615,9 @@ store_config_paths(const char data_dir[])
 	free(trash_base);
 
 	snprintf(cfg.log_file, sizeof(cfg.log_file), "%s/" LOG, base);
+	snprintf(cfg.snapshots_dir, sizeof(cfg.snapshots_dir), "%s/snapshots", base);
+	snprintf(cfg.hash_cache_file, sizeof(cfg.hash_cache_file), "%s/hashes",
+			base);
 
 	char *fuse_home = format_str("%s/fuse/", base);
 	(void)cfg_set_fuse_home(fuse_home);
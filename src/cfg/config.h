@@ -201,6 +201,10 @@ typedef struct config_t
 	/* This one should be set using trash_set_specs() function. */
 	char trash_dir[PATH_MAX + 64];
 	char log_file[PATH_MAX + 8];
+	char snapshots_dir[PATH_MAX + 16]; /* Where snapshots of listings are
+	                                      stored. */
+	char hash_cache_file[PATH_MAX + 16]; /* Where hashes of contents of files
+	                                        are stored. */
 	char *vi_command;
 	int vi_cmd_bg;
 	char *vi_x_command;
@@ -305,6 +309,22 @@ typedef struct config_t
 	/* Comma-separated list of file system types which are slow to respond. */
 	char *slow_fs_list;
 
+	/* Minimal number of files in a directory to store snapshots of its listing
+	 * on disk.  Zero disables snapshots. */
+	int snapshot_min;
+
+	/* Maximal number of hashes of contents of files to keep on disk between
+	 * comparisons.  Zero disables the cache. */
+	int compare_cache;
+
+	/* Memory limit for lists of recently visited directories in KiB.  Zero
+	 * disables caching. */
+	int list_cache_size;
+
+	/* Maximal number of files in a directory under cursor to read it in
+	 * advance.  Zero disables reading in advance. */
+	int prefetch_max;
+
 	/* Comma-separated list of places to look for relative path to directories. */
 	char *cd_path;
 
@@ -96,6 +96,7 @@
 #include "filelist.h"
 #include "filetype.h"
 #include "filtering.h"
+#include "flist_cache.h"
 #include "flist_hist.h"
 #include "flist_pos.h"
 #include "flist_sel.h"
@@ -135,6 +136,7 @@ static int bmarks_do(const cmd_info_t *cmd_info, int go);
 static char * make_tags_list(const cmd_info_t *cmd_info);
 static char * args_to_csl(const cmd_info_t *cmd_info);
 static int cabbrev_cmd(const cmd_info_t *cmd_info);
+static int cachestats_cmd(const cmd_info_t *cmd_info);
 static int call_cmd(const cmd_info_t *cmd_info);
 static int chistory_cmd(const cmd_info_t *cmd_info);
 static int cnoreabbrev_cmd(const cmd_info_t *cmd_info);
@@ -401,6 +403,10 @@ const cmd_add_t cmds_list[] = {
 	  .descr = "display/create cmdline abbrevs",
 	  .flags = 0,
 	  .handler = &cabbrev_cmd,     .min_args = 0,   .max_args = NOT_DEF, },
+	{ .name = "cachestats",        .abbr = NULL,    .id = -1,
+	  .descr = "display statistics of cache of directory lists",
+	  .flags = HAS_COMMENT,
+	  .handler = &cachestats_cmd,  .min_args = 0,   .max_args = 0, },
 	/* engine/parsing unit handles comments to resolve parsing ambiguity. */
 	{ .name = "call",              .abbr = "cal",   .id = COM_CALL,
 	  .descr = "Invoke a function discarding its return value",
@@ -1376,6 +1382,25 @@ cabbrev_cmd(const cmd_info_t *cmd_info)
 	return handle_cabbrevs(cmd_info, 0);
 }
 
+/* Displays statistics of cache of lists of recently visited directories. */
+static int
+cachestats_cmd(const cmd_info_t *cmd_info)
+{
+	flist_cache_stats_t stats;
+	flist_cache_get_stats(&stats);
+
+	char size[64];
+	char capacity[64];
+	(void)friendly_size_notation(stats.size, sizeof(size), size);
+	(void)friendly_size_notation(stats.capacity, sizeof(capacity), capacity);
+
+	const int lookups = stats.hits + stats.misses;
+	ui_sb_msgf("Lists: %d\nMemory: %s of %s\nHits: %d of %d (%d%%)",
+			stats.listings, size, capacity, stats.hits, lookups,
+			(lookups == 0) ? 0 : stats.hits*100/lookups);
+	return 1;
+}
+
 /* Invokes a function discarding its return value. */
 static int
 call_cmd(const cmd_info_t *cmd_info)
@@ -18,13 +18,22 @@
 
 #include "compare.h"
 
+#ifndef _WIN32
+#include <sys/stat.h> /* S_ISDIR S_ISLNK fstatat() stat */
+#include <dirent.h> /* DIR DT_* dirfd() */
+#include <fcntl.h> /* AT_SYMLINK_NOFOLLOW POSIX_FADV_SEQUENTIAL
+                      posix_fadvise() */
+#endif
+
 #include <assert.h> /* assert() */
-#include <stddef.h> /* size_t */
+#include <inttypes.h> /* PRIx64 */
+#include <stddef.h> /* NULL size_t */
 #include <stdint.h> /* INTPTR_MAX INT64_MAX */
-#include <stdio.h> /* FILE fclose() feof() fopen() fread() */
-#include <stdlib.h> /* free() malloc() */
-#include <string.h> /* memcmp() */
+#include <stdio.h> /* FILE fclose() feof() ferror() fileno() fopen() fread() */
+#include <stdlib.h> /* calloc() free() malloc() */
+#include <string.h> /* memcmp() strdup() */
 
+#include "cfg/config.h"
 #include "compat/fs_limits.h"
 #include "compat/os.h"
 #include "compat/reallocarray.h"
@@ -36,6 +45,8 @@
 #include "utils/fs.h"
 #include "utils/fsdata.h"
 #include "utils/macros.h"
+#include "utils/matcher.h"
+#include "utils/parallel.h"
 #include "utils/path.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
@@ -47,6 +58,7 @@
 #include "fops_common.h"
 #include "fops_cpmv.h"
 #include "fops_misc.h"
+#include "hash_cache.h"
 #include "running.h"
 #include "undo.h"
 
@@ -64,6 +76,10 @@
  *       * compute contents fingerprint for current file and insert it
  *   - there is more than one conflicting file:
  *       * compute contents fingerprint for current file and insert it
+ *
+ * Files that will need contents fingerprint are known in advance from their
+ * sizes, so their fingerprints are computed beforehand on several threads in
+ * the order of device and inode numbers to make disk access more sequential.
  */
 
 /* This is the only unit that uses xxhash, so import it directly here. */
@@ -73,8 +89,8 @@
 /* Amount of data to read at once when comparing files in full. */
 #define BLOCK_SIZE (32*1024)
 
-/* Amount of data to hash for coarse comparison. */
-#define PREFIX_SIZE (4*1024)
+/* Amount of data to read at once when hashing files. */
+#define HASH_BLOCK_SIZE (256*1024)
 
 /* Entry in singly-bounded list of files that have matched fingerprints. */
 typedef struct compare_record_t
@@ -88,6 +104,63 @@ typedef struct compare_record_t
 }
 compare_record_t;
 
+/* File whose contents fingerprint is to be computed in advance. */
+typedef struct
+{
+	const char *path;        /* Full path to the file. */
+	unsigned long long size; /* Size of the file. */
+	hcache_key_t key;        /* Key of the file in the hash cache, which also
+	                            holds its device and inode numbers. */
+	hcache_hash_t hash;      /* Hash of the file. */
+	unsigned needed : 1;     /* Whether fingerprint will be necessary. */
+	unsigned hashed : 1;     /* Whether hash was successfully obtained. */
+	unsigned has_key : 1;    /* Whether key field is valid. */
+}
+hash_job_t;
+
+/* Files whose fingerprints are computed by several threads. */
+typedef struct
+{
+	hash_job_t *jobs; /* The files. */
+	int njobs;        /* Number of elements in the jobs array. */
+	const char *msg;  /* Name of the current stage for progress messages. */
+}
+hash_batch_t;
+
+/* Entry of a directory read by list_files_in_parallel(). */
+typedef struct
+{
+	char *name;                  /* Name of the entry (first field for sorting
+	                                via str*sorter()), full path for files and
+	                                NULL for directories after sorting. */
+	struct listed_dir_t *subdir; /* Subdirectory or NULL. */
+	int is_dir;                  /* Whether this is a directory. */
+}
+listed_item_t;
+
+/* Directory read by list_files_in_parallel(). */
+typedef struct listed_dir_t
+{
+	char *path;           /* Full path to the directory. */
+	listed_item_t *items; /* Sorted visible entries of the directory. */
+	int nitems;           /* Number of elements in items array. */
+}
+listed_dir_t;
+
+/* Type of qsort() comparer of file names. */
+typedef int (*name_sorter_func)(const void *a, const void *b);
+
+/* Parameters of reading a tree by list_files_in_parallel(). */
+typedef struct
+{
+	const view_t *view;      /* View whose filters are applied. */
+	int skip_dot_files;      /* Whether dot files should be skipped. */
+	name_sorter_func sorter; /* Comparer of names of entries. */
+}
+listing_t;
+
+static void open_hash_cache(CompareType ct);
+static void close_hash_cache(void);
 static void make_unique_lists(entries_t curr, entries_t other);
 static void leave_only_dups(entries_t *curr, entries_t *other);
 static int is_not_duplicate(view_t *view, const dir_entry_t *entry, void *arg);
@@ -107,12 +180,44 @@ static int append_valid_nodes(const char name[], int valid,
 		const void *parent_data, void *data, void *arg);
 static void list_files_recursively(const view_t *view, const char path[],
 		int skip_dot_files, int flags, strlist_t *list);
-static char * get_file_fingerprint(const char path[], const dir_entry_t *entry,
-		CompareType ct, int flags, int lazy);
+static void list_files_serially(const view_t *view, const char path[],
+		int skip_dot_files, int flags, strlist_t *list);
+#ifndef _WIN32
+static void list_files_in_parallel(const view_t *view, const char path[],
+		int skip_dot_files, int flags, strlist_t *list);
+static void list_dir(par_tasks_t *tasks, int worker, void *task, void *arg);
+static void read_listed_dir(const listing_t *listing, listed_dir_t *dir,
+		DIR *d);
+static int get_listed_type(int dir_fd, const struct dirent *d);
+static int list_poll(size_t ndone, void *arg);
+static void collect_listed_files(listed_dir_t *dir, strlist_t *list);
+static listed_dir_t * alloc_listed_dir(char path[]);
+static void free_listed_dir(listed_dir_t *dir);
+#endif
+static name_sorter_func get_name_sorter(int flags);
+static trie_t * hash_contents(trie_t *trie, entries_t files, char *paths[]);
+static hash_job_t * add_hash_job(trie_t *hashes, hash_job_t **jobs,
+		int *njobs, const char path[], unsigned long long size);
+static int size_sorter(const void *first, const void *second);
+static int location_sorter(const void *first, const void *second);
+static void key_job(size_t idx, void *arg);
+static void hash_job(size_t idx, void *arg);
+static int hash_poll(size_t ndone, void *arg);
+static char * get_file_fingerprint(trie_t *hashes, const char path[],
+		const dir_entry_t *entry, CompareType ct, int flags, int lazy);
+static char * get_cached_fingerprint(trie_t *hashes, const char path[],
+		int is_readable, unsigned long long size);
 static char * get_contents_fingerprint(const char path[], int is_readable,
 		unsigned long long size);
-static int add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
-		CompareType ct, int dups_only, int flags, int *next_id);
+static int get_contents_hash(const char path[], int is_readable,
+		hcache_key_t *key, int *has_key, hcache_hash_t *hash);
+static int hash_path(const char path[], hcache_hash_t *hash);
+static int hash_file(FILE *file, hcache_hash_t *hash);
+static char * format_fingerprint(unsigned long long size,
+		const hcache_hash_t *hash);
+static int add_file_to_diff(trie_t *trie, trie_t *hashes, const char path[],
+		dir_entry_t *entry, CompareType ct, int dups_only, int flags,
+		int *next_id);
 static int filetype_is_readable(FileType type);
 static int files_are_identical(const char a[], int a_readable, const char b[],
 		int b_readable);
@@ -123,6 +228,10 @@ static void put_file_id(trie_t *trie, const char path[],
 static void free_compare_records(void *ptr);
 static void compare_move_entry(ops_t *ops, view_t *from, view_t *to, int idx);
 
+/* Persistent cache of hashes of file contents, which is loaded for the time of
+ * comparison by contents if it's enabled. */
+static hcache_t *hash_cache;
+
 int
 compare_two_panes(CompareType ct, ListType lt, int flags)
 {
@@ -145,10 +254,12 @@ compare_two_panes(CompareType ct, ListType lt, int flags)
 
 	trie_t *const trie = trie_create(&free_compare_records);
 	ui_cancellation_push_on();
+	open_hash_cache(ct);
 
 	curr = make_diff_list(trie, curr_view, &next_id, ct, /*dups_only=*/0, flags);
 	other = make_diff_list(trie, other_view, &next_id, ct, lt == LT_DUPS, flags);
 
+	close_hash_cache();
 	ui_cancellation_pop();
 	trie_free(trie);
 
@@ -234,6 +345,28 @@ compare_two_panes(CompareType ct, ListType lt, int flags)
 	return 0;
 }
 
+/* Loads persistent cache of hashes if it's enabled and will be of use. */
+static void
+open_hash_cache(CompareType ct)
+{
+	if(ct == CT_CONTENTS && cfg.compare_cache > 0)
+	{
+		hash_cache = hcache_load(cfg.hash_cache_file, cfg.compare_cache);
+	}
+}
+
+/* Saves and frees persistent cache of hashes if it was loaded. */
+static void
+close_hash_cache(void)
+{
+	if(hash_cache != NULL)
+	{
+		(void)hcache_save(hash_cache);
+		hcache_free(hash_cache);
+		hash_cache = NULL;
+	}
+}
+
 /* Composes two views containing only files that are unique to each of them.
  * Assumes that both lists are sorted by id. */
 static void
@@ -612,9 +745,11 @@ compare_one_pane(view_t *view, CompareType ct, ListType lt, int flags)
 
 	trie_t *trie = trie_create(&free_compare_records);
 	ui_cancellation_push_on();
+	open_hash_cache(ct);
 
 	curr = make_diff_list(trie, view, &next_id, ct, /*dups_only=*/0, flags);
 
+	close_hash_cache();
 	ui_cancellation_pop();
 	trie_free(trie);
 
@@ -763,31 +898,257 @@ make_diff_list(trie_t *trie, view_t *view, int *next_id, CompareType ct,
 		}
 
 		entry->tag = i;
-		entry->id = add_file_to_diff(trie, path, entry, ct, dups_only, flags,
-				next_id);
+
+		progress = (i*100)/files.nitems;
+		if(progress != last_progress)
+		{
+			char progress_msg[128];
+
+			last_progress = progress;
+			snprintf(progress_msg, sizeof(progress_msg), "Querying... %d (%2d%%)", i,
+					progress);
+			show_progress(progress_msg, -1);
+		}
+	}
+
+	trie_t *const hashes = (ct == CT_CONTENTS)
+	                     ? hash_contents(trie, r, files.items)
+	                     : NULL;
+
+	show_progress("Comparing...", 0);
+	last_progress = 0;
+
+	int n = 0;
+	for(i = 0; i < r.nentries; ++i)
+	{
+		dir_entry_t *const entry = &r.entries[i];
+
+		/* Entries that weren't processed because of cancellation are dropped. */
+		entry->id = ui_cancellation_requested()
+		          ? -1
+		          : add_file_to_diff(trie, hashes, files.items[entry->tag], entry,
+		                             ct, dups_only, flags, next_id);
 
 		if(entry->id == -1)
 		{
 			fentry_free(entry);
-			--r.nentries;
+			continue;
 		}
 
-		progress = (i*100)/files.nitems;
+		r.entries[n++] = *entry;
+
+		const int progress = (i*100)/r.nentries;
 		if(progress != last_progress)
 		{
 			char progress_msg[128];
 
 			last_progress = progress;
-			snprintf(progress_msg, sizeof(progress_msg), "Querying... %d (%2d%%)", i,
-					progress);
+			snprintf(progress_msg, sizeof(progress_msg), "Comparing... %d (%2d%%)",
+					i, progress);
 			show_progress(progress_msg, -1);
 		}
 	}
+	r.nentries = n;
 
+	trie_free(hashes);
 	free_string_array(files.items, files.nitems);
 	return r;
 }
 
+/* Computes contents fingerprints of files that are going to need them on
+ * several threads.  Returns trie that maps paths to fingerprints or NULL. */
+static trie_t *
+hash_contents(trie_t *trie, entries_t files, char *paths[])
+{
+	int i;
+	hash_job_t *jobs = NULL;
+	int njobs = 0;
+	trie_t *const hashes = trie_create(&free);
+
+	for(i = 0; i < files.nentries; ++i)
+	{
+		const dir_entry_t *const entry = &files.entries[i];
+		if(!filetype_is_readable(entry->type))
+		{
+			continue;
+		}
+
+		(void)add_hash_job(hashes, &jobs, &njobs, paths[entry->tag], entry->size);
+	}
+
+	/* A file is going to need contents fingerprint if there is another file of
+	 * the same size in this list or among files that were processed before. */
+	safe_qsort(jobs, njobs, sizeof(*jobs), &size_sorter);
+	const int nfiles = njobs;
+	for(i = 0; i < nfiles; ++i)
+	{
+		const int first = i;
+		while(i + 1 < nfiles && jobs[i + 1].size == jobs[first].size)
+		{
+			++i;
+		}
+
+		char size_str[32];
+		snprintf(size_str, sizeof(size_str), "%" PRINTF_ULL, jobs[first].size);
+
+		void *data = NULL;
+		(void)trie_get(trie, size_str, &data);
+		const compare_record_t *const record = data;
+		if(record == NULL && first == i)
+		{
+			continue;
+		}
+
+		int j;
+		for(j = first; j <= i; ++j)
+		{
+			jobs[j].needed = 1;
+		}
+
+		/* Fingerprint of a file with the same size from the other list hasn't been
+		 * computed yet. */
+		if(record != NULL && record->is_partial && record->is_readable)
+		{
+			hash_job_t *const job = add_hash_job(hashes, &jobs, &njobs, record->path,
+					jobs[first].size);
+			if(job != NULL)
+			{
+				job->needed = 1;
+			}
+		}
+	}
+
+	/* Only files that need fingerprints are processed further. */
+	int nneeded = 0;
+	for(i = 0; i < njobs; ++i)
+	{
+		if(jobs[i].needed)
+		{
+			jobs[nneeded++] = jobs[i];
+		}
+	}
+
+	hash_batch_t batch = { .jobs = jobs, .njobs = nneeded, .msg = "Identifying" };
+	show_progress("Identifying...", 0);
+	if(par_for(nneeded, par_nthreads(), &key_job, &hash_poll, &batch) == 0)
+	{
+		/* Reading files in the order of their placement reduces seeking. */
+		safe_qsort(jobs, nneeded, sizeof(*jobs), &location_sorter);
+
+		batch.msg = "Hashing";
+		show_progress("Hashing...", 0);
+		(void)par_for(nneeded, par_nthreads(), &hash_job, &hash_poll, &batch);
+	}
+
+	for(i = 0; i < nneeded; ++i)
+	{
+		const hash_job_t *const job = &jobs[i];
+		if(!job->hashed)
+		{
+			continue;
+		}
+
+		if(job->has_key && hash_cache != NULL)
+		{
+			hcache_put(hash_cache, &job->key, &job->hash);
+		}
+
+		char *const fingerprint = format_fingerprint(job->size, &job->hash);
+		if(fingerprint != NULL && trie_set(hashes, job->path, fingerprint) < 0)
+		{
+			free(fingerprint);
+		}
+	}
+
+	free(jobs);
+	return hashes;
+}
+
+/* Adds job for computing fingerprint of the file unless it's already there.
+ * The job isn't marked as needed.  Returns the job or NULL if it's not
+ * added. */
+static hash_job_t *
+add_hash_job(trie_t *hashes, hash_job_t **jobs, int *njobs, const char path[],
+		unsigned long long size)
+{
+	if(trie_set(hashes, path, NULL) != 0)
+	{
+		return NULL;
+	}
+
+	hash_job_t *const new_jobs = reallocarray(*jobs, *njobs + 1, sizeof(**jobs));
+	if(new_jobs == NULL)
+	{
+		return NULL;
+	}
+
+	*jobs = new_jobs;
+	new_jobs[*njobs] = (hash_job_t){ .path = path, .size = size };
+	return &new_jobs[(*njobs)++];
+}
+
+/* Sorts hash jobs by size of files.  Returns standard -1, 0, 1 for
+ * comparisons. */
+static int
+size_sorter(const void *first, const void *second)
+{
+	const hash_job_t *const a = first;
+	const hash_job_t *const b = second;
+	return (a->size > b->size) - (a->size < b->size);
+}
+
+/* Sorts hash jobs by device and then by inode numbers of files.  Returns
+ * standard -1, 0, 1 for comparisons. */
+static int
+location_sorter(const void *first, const void *second)
+{
+	const hash_job_t *const a = first;
+	const hash_job_t *const b = second;
+	if(a->key.dev != b->key.dev)
+	{
+		return (a->key.dev > b->key.dev) - (a->key.dev < b->key.dev);
+	}
+	return (a->key.inode > b->key.inode) - (a->key.inode < b->key.inode);
+}
+
+/* par_for() callback that identifies a single file and looks up its hash in
+ * persistent cache.  Key must be obtained before reading the file, so that
+ * changes made while it's being read invalidate the key. */
+static void
+key_job(size_t idx, void *arg)
+{
+	hash_job_t *const job = &((hash_batch_t *)arg)->jobs[idx];
+	job->has_key = (hcache_make_key(job->path, &job->key) == 0);
+	job->hashed = (job->has_key && hash_cache != NULL &&
+			hcache_get(hash_cache, &job->key, &job->hash) == 0);
+}
+
+/* par_for() callback that computes hash of a single file unless it was found
+ * in persistent cache. */
+static void
+hash_job(size_t idx, void *arg)
+{
+	hash_job_t *const job = &((hash_batch_t *)arg)->jobs[idx];
+	if(!job->hashed)
+	{
+		job->hashed = (hash_path(job->path, &job->hash) == 0);
+	}
+}
+
+/* par_for() callback that reports progress of processing of hash jobs and
+ * checks for cancellation.  Returns non-zero to cancel. */
+static int
+hash_poll(size_t ndone, void *arg)
+{
+	const hash_batch_t *const batch = arg;
+
+	char progress_msg[128];
+	snprintf(progress_msg, sizeof(progress_msg), "%s... %d of %d", batch->msg,
+			(int)ndone, batch->njobs);
+	show_progress(progress_msg, -1);
+	return ui_cancellation_requested();
+}
+
 /* Fills the list with entries of the view in hierarchical order (pre-order tree
  * traversal). */
 static void
@@ -831,10 +1192,28 @@ append_valid_nodes(const char name[], int valid, const void *parent_data,
 	return 0;
 }
 
-/* Collects files under specified file system tree. */
+/* Collects files under specified file system tree.  Files of each directory
+ * are sorted by name and follow files of its subdirectories. */
 static void
 list_files_recursively(const view_t *view, const char path[],
 		int skip_dot_files, int flags, strlist_t *list)
+{
+#ifndef _WIN32
+	/* Checking mime-type isn't thread-safe. */
+	if(!matcher_is_mime(view->manual_filter))
+	{
+		list_files_in_parallel(view, path, skip_dot_files, flags, list);
+		return;
+	}
+#endif
+
+	list_files_serially(view, path, skip_dot_files, flags, list);
+}
+
+/* Collects files under specified file system tree one directory at a time. */
+static void
+list_files_serially(const view_t *view, const char path[],
+		int skip_dot_files, int flags, strlist_t *list)
 {
 	int i;
 
@@ -846,18 +1225,7 @@ list_files_recursively(const view_t *view, const char path[],
 		return;
 	}
 
-	if(flags & CF_IGNORE_CASE)
-	{
-		safe_qsort(lst, len, sizeof(*lst), &strcasesorter);
-	}
-	else if(flags & CF_RESPECT_CASE)
-	{
-		safe_qsort(lst, len, sizeof(*lst), &strsorter);
-	}
-	else
-	{
-		safe_qsort(lst, len, sizeof(*lst), &strossorter);
-	}
+	safe_qsort(lst, len, sizeof(*lst), get_name_sorter(flags));
 
 	/* Visit all subdirectories ignoring symbolic links to directories. */
 	for(i = 0; i < len && !ui_cancellation_requested(); ++i)
@@ -881,7 +1249,7 @@ list_files_recursively(const view_t *view, const char path[],
 		{
 			if(!is_symlink(full_path))
 			{
-				list_files_recursively(view, full_path, skip_dot_files, flags, list);
+				list_files_serially(view, full_path, skip_dot_files, flags, list);
 			}
 			free(full_path);
 			update_string(&lst[i], NULL);
@@ -907,14 +1275,258 @@ list_files_recursively(const view_t *view, const char path[],
 	free(lst);
 }
 
+#ifndef _WIN32
+
+/* Collects files under specified file system tree by reading its directories
+ * on several threads. */
+static void
+list_files_in_parallel(const view_t *view, const char path[],
+		int skip_dot_files, int flags, strlist_t *list)
+{
+	listed_dir_t *const root = alloc_listed_dir(strdup(path));
+	if(root == NULL)
+	{
+		return;
+	}
+
+	listing_t listing = {
+		.view = view,
+		.skip_dot_files = skip_dot_files,
+		.sorter = get_name_sorter(flags),
+	};
+
+	/* On cancellation some directories remain unread and are skipped. */
+	(void)par_run(root, par_nthreads(), &list_dir, &list_poll, &listing);
+
+	collect_listed_files(root, list);
+}
+
+/* par_run() callback that reads single directory and spawns tasks for its
+ * subdirectories. */
+static void
+list_dir(par_tasks_t *tasks, int worker, void *task, void *arg)
+{
+	const listing_t *const listing = arg;
+	listed_dir_t *const dir = task;
+
+	DIR *const d = os_opendir(dir->path);
+	if(d == NULL)
+	{
+		return;
+	}
+
+	read_listed_dir(listing, dir, d);
+	os_closedir(d);
+
+	safe_qsort(dir->items, dir->nitems, sizeof(*dir->items), listing->sorter);
+
+	int i;
+	for(i = 0; i < dir->nitems; ++i)
+	{
+		listed_item_t *const item = &dir->items[i];
+		char *const full_path = join_paths(dir->path, item->name);
+		update_string(&item->name, NULL);
+
+		if(!item->is_dir)
+		{
+			item->name = full_path;
+			continue;
+		}
+
+		item->subdir = alloc_listed_dir(full_path);
+		if(item->subdir != NULL && par_spawn(tasks, worker, item->subdir) != 0)
+		{
+			/* Subdirectory can't be queued, so read it right away. */
+			list_dir(tasks, worker, item->subdir, arg);
+		}
+	}
+}
+
+/* Reads visible entries of a directory leaving out symbolic links to
+ * directories.  Type of entries is taken from dirent when it's available.
+ * Reading stops early if memory runs out. */
+static void
+read_listed_dir(const listing_t *listing, listed_dir_t *dir, DIR *d)
+{
+	const int dir_fd = dirfd(d);
+
+	struct dirent *entry;
+	while((entry = os_readdir(d)) != NULL)
+	{
+		const char *const name = entry->d_name;
+		if(is_builtin_dir(name) || (listing->skip_dot_files && name[0] == '.'))
+		{
+			continue;
+		}
+
+		const int type = get_listed_type(dir_fd, entry);
+		if(type < 0)
+		{
+			continue;
+		}
+
+		if(!filters_file_is_visible(listing->view, dir->path, name, type, 1))
+		{
+			continue;
+		}
+
+		void *const p = reallocarray(dir->items, dir->nitems + 1,
+				sizeof(*dir->items));
+		if(p == NULL)
+		{
+			break;
+		}
+		dir->items = p;
+
+		listed_item_t *const item = &dir->items[dir->nitems];
+		item->name = strdup(name);
+		item->subdir = NULL;
+		item->is_dir = type;
+		if(item->name == NULL)
+		{
+			break;
+		}
+		++dir->nitems;
+	}
+}
+
+/* Determines type of a directory entry querying file system only if dirent
+ * doesn't have the information or the entry is a symbolic link.  Returns 1 for
+ * directories, 0 for other files and -1 for symbolic links to directories. */
+static int
+get_listed_type(int dir_fd, const struct dirent *d)
+{
+#if defined(HAVE_STRUCT_DIRENT_D_TYPE) && HAVE_STRUCT_DIRENT_D_TYPE
+	if(d->d_type == DT_DIR)
+	{
+		return 1;
+	}
+	if(d->d_type != DT_UNKNOWN && d->d_type != DT_LNK)
+	{
+		return 0;
+	}
+#endif
+
+	struct stat s;
+	if(fstatat(dir_fd, d->d_name, &s, AT_SYMLINK_NOFOLLOW) != 0)
+	{
+		return 0;
+	}
+	if(S_ISDIR(s.st_mode))
+	{
+		return 1;
+	}
+	if(!S_ISLNK(s.st_mode))
+	{
+		return 0;
+	}
+
+	return (fstatat(dir_fd, d->d_name, &s, 0) == 0 && S_ISDIR(s.st_mode))
+	     ? -1
+	     : 0;
+}
+
+/* par_run() callback that reports progress of listing and checks for
+ * cancellation.  Returns non-zero to cancel. */
+static int
+list_poll(size_t ndone, void *arg)
+{
+	char progress_msg[128];
+	snprintf(progress_msg, sizeof(progress_msg), "Listing... %d", (int)ndone);
+	show_progress(progress_msg, -1);
+	return ui_cancellation_requested();
+}
+
+/* Moves paths of files of the tree into the list in the order in which
+ * list_files_serially() would have produced them and frees the tree. */
+static void
+collect_listed_files(listed_dir_t *dir, strlist_t *list)
+{
+	int i;
+	for(i = 0; i < dir->nitems; ++i)
+	{
+		if(dir->items[i].subdir != NULL)
+		{
+			collect_listed_files(dir->items[i].subdir, list);
+			dir->items[i].subdir = NULL;
+		}
+	}
+
+	for(i = 0; i < dir->nitems; ++i)
+	{
+		char *const path = dir->items[i].name;
+		if(path != NULL)
+		{
+			list->nitems = put_into_string_array(&list->items, list->nitems, path);
+			dir->items[i].name = NULL;
+		}
+	}
+
+	free_listed_dir(dir);
+}
+
+/* Allocates a directory for listing taking ownership of the path.  Returns the
+ * directory or NULL on error. */
+static listed_dir_t *
+alloc_listed_dir(char path[])
+{
+	listed_dir_t *const dir = (path == NULL ? NULL : calloc(1, sizeof(*dir)));
+	if(dir == NULL)
+	{
+		free(path);
+		return NULL;
+	}
+
+	dir->path = path;
+	return dir;
+}
+
+/* Frees a directory for listing along with all of its subdirectories. */
+static void
+free_listed_dir(listed_dir_t *dir)
+{
+	int i;
+	for(i = 0; i < dir->nitems; ++i)
+	{
+		free(dir->items[i].name);
+		if(dir->items[i].subdir != NULL)
+		{
+			free_listed_dir(dir->items[i].subdir);
+		}
+	}
+
+	free(dir->items);
+	free(dir->path);
+	free(dir);
+}
+
+#endif
+
+/* Picks comparer of file names according to comparison flags.  Returns the
+ * comparer. */
+static name_sorter_func
+get_name_sorter(int flags)
+{
+	if(flags & CF_IGNORE_CASE)
+	{
+		return &strcasesorter;
+	}
+	if(flags & CF_RESPECT_CASE)
+	{
+		return &strsorter;
+	}
+	return &strossorter;
+}
+
 /* Computes fingerprint of the file specified by path and entry.  Type of the
  * fingerprint is determined by ct parameter.  Lazy fingerprint is an
  * optimization which prevents computing contents fingerprint until there is
- * more than one file of the given size.  Returns newly allocated string with
+ * more than one file of the given size.  hashes holds precomputed contents
+ * fingerprints and can be NULL.  Returns newly allocated string with
  * the fingerprint, which is empty or NULL on error. */
 static char *
-get_file_fingerprint(const char path[], const dir_entry_t *entry,
-		CompareType ct, int flags, int lazy)
+get_file_fingerprint(trie_t *hashes, const char path[],
+		const dir_entry_t *entry, CompareType ct, int flags, int lazy)
 {
 	switch(ct)
 	{
@@ -955,51 +1567,151 @@ get_file_fingerprint(const char path[], const dir_entry_t *entry,
 
 				return format_str("%" PRINTF_ULL, (unsigned long long)entry->size);
 			}
-			return get_contents_fingerprint(path, filetype_is_readable(entry->type),
-					entry->size);
+			return get_cached_fingerprint(hashes, path,
+					filetype_is_readable(entry->type), entry->size);
 	}
 	assert(0 && "Unexpected diffing type.");
 	return strdup("");
 }
 
-/* Makes fingerprint of file contents (all or of its fixed-size prefix,
- * whichever is smaller).  Returns the fingerprint as a string, which is empty
- * or NULL on error. */
+/* Retrieves contents fingerprint of the file computed by hash_contents() or
+ * computes it if there is none.  hashes can be NULL.  Returns the fingerprint
+ * as a string, which is empty or NULL on error. */
+static char *
+get_cached_fingerprint(trie_t *hashes, const char path[], int is_readable,
+		unsigned long long size)
+{
+	void *data;
+	if(trie_get(hashes, path, &data) == 0 && data != NULL)
+	{
+		return strdup(data);
+	}
+	return get_contents_fingerprint(path, is_readable, size);
+}
+
+/* Makes fingerprint of file contents.  Returns the fingerprint as a string,
+ * which is empty or NULL on error. */
 static char *
 get_contents_fingerprint(const char path[], int is_readable,
 		unsigned long long size)
 {
-	char contents[PREFIX_SIZE];
-	size_t len;
+	hcache_key_t key;
+	int has_key;
+	hcache_hash_t hash;
+	if(get_contents_hash(path, is_readable, &key, &has_key, &hash) != 0)
+	{
+		return strdup("");
+	}
 
-	if(is_readable)
+	if(has_key && hash_cache != NULL)
 	{
-		FILE *in = os_fopen(path, "rb");
-		if(in == NULL)
-		{
-			return strdup("");
-		}
-		len = fread(&contents, 1, sizeof(contents), in);
-		fclose(in);
+		hcache_put(hash_cache, &key, &hash);
 	}
-	else
+	return format_fingerprint(size, &hash);
+}
+
+/* Retrieves hash of file contents from persistent cache or computes it.  Sets
+ * *has_key to indicate whether *key was filled in and the hash can be stored in
+ * the cache.  Doesn't modify the cache and thus can be called from multiple
+ * threads at the same time.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+get_contents_hash(const char path[], int is_readable, hcache_key_t *key,
+		int *has_key, hcache_hash_t *hash)
+{
+	/* Key must be obtained before reading the file, so that changes made while
+	 * it's being read invalidate the key. */
+	*has_key = (hash_cache != NULL && is_readable &&
+			hcache_make_key(path, key) == 0);
+	if(*has_key && hcache_get(hash_cache, key, hash) == 0)
+	{
+		return 0;
+	}
+
+	if(!is_readable)
 	{
 		/* This isn't an error, just treat such files (e.g., pipes and sockets) as
 		 * empty. */
-		len = 0;
+		const XXH128_hash_t digest = XXH3_128bits(NULL, 0);
+		hash->high = digest.high64;
+		hash->low = digest.low64;
+		return 0;
+	}
+
+	return hash_path(path, hash);
+}
+
+/* Computes hash of the whole contents of a file.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+hash_path(const char path[], hcache_hash_t *hash)
+{
+	FILE *in = os_fopen(path, "rb");
+	if(in == NULL)
+	{
+		return 1;
+	}
+	const int error = hash_file(in, hash);
+	fclose(in);
+	return error;
+}
+
+/* Computes hash of the whole contents of an open file.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+hash_file(FILE *file, hcache_hash_t *hash)
+{
+	char *const block = malloc(HASH_BLOCK_SIZE);
+	if(block == NULL)
+	{
+		return 1;
 	}
 
-	const unsigned long long digest = XXH3_64bits(contents, len);
-	return format_str("%" PRINTF_ULL "|%" PRINTF_ULL, size, digest);
+#ifndef _WIN32
+	/* Files are read from start to end and only once. */
+	(void)posix_fadvise(fileno(file), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+	XXH3_state_t state;
+	(void)XXH3_128bits_reset(&state);
+
+	size_t len;
+	while((len = fread(block, 1, HASH_BLOCK_SIZE, file)) != 0U)
+	{
+		(void)XXH3_128bits_update(&state, block, len);
+	}
+
+	free(block);
+
+	if(ferror(file))
+	{
+		return 1;
+	}
+
+	const XXH128_hash_t digest = XXH3_128bits_digest(&state);
+	hash->high = digest.high64;
+	hash->low = digest.low64;
+	return 0;
+}
+
+/* Formats fingerprint of file contents.  Returns newly allocated string or
+ * NULL on error. */
+static char *
+format_fingerprint(unsigned long long size, const hcache_hash_t *hash)
+{
+	return format_str("%" PRINTF_ULL "|%016" PRIx64 "%016" PRIx64, size,
+			hash->high, hash->low);
 }
 
 /* Looks up file in the trie by its fingerprint.  Returns id for the file or -1
  * if it should be skipped. */
 static int
-add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
-		CompareType ct, int dups_only, int flags, int *next_id)
+add_file_to_diff(trie_t *trie, trie_t *hashes, const char path[],
+		dir_entry_t *entry, CompareType ct, int dups_only, int flags,
+		int *next_id)
 {
-	char *fingerprint = get_file_fingerprint(path, entry, ct, flags, /*lazy=*/1);
+	char *fingerprint = get_file_fingerprint(hashes, path, entry, ct, flags,
+			/*lazy=*/1);
 	if(is_null_or_empty(fingerprint))
 	{
 		/* In case we couldn't obtain fingerprint (e.g., comparing by contents and
@@ -1022,7 +1734,8 @@ add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
 		free(fingerprint);
 		is_partial = 0;
 
-		fingerprint = get_file_fingerprint(path, entry, ct, flags, /*lazy=*/0);
+		fingerprint = get_file_fingerprint(hashes, path, entry, ct, flags,
+				/*lazy=*/0);
 		if(is_null_or_empty(fingerprint))
 		{
 			/* In case we couldn't obtain fingerprint (e.g., comparing by contents and
@@ -1037,9 +1750,9 @@ add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
 			 * hasn't been computed yet.  Do it here.  Using `entry->size` is valid
 			 * because partial hash is just the size, so both entries must share
 			 * it. */
-			char *other_fingerprint = get_contents_fingerprint(record->path,
+			char *other_fingerprint = get_cached_fingerprint(hashes, record->path,
 					record->is_readable, entry->size);
-			if(is_null_or_empty(fingerprint))
+			if(is_null_or_empty(other_fingerprint))
 			{
 				/* That other file has issues, don't update it and skip any other file
 				 * that can conflict with it by size.  The file itself won't be skipped
@@ -1057,12 +1770,13 @@ add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
 		}
 
 		/* Repeat trie lookup with contents fingerprint. */
+		data = NULL;
 		(void)trie_get(trie, fingerprint, &data);
 		record = data;
 
 		/* Fingerprint does not guarantee a match, go through files and find file
 		 * with identical contents. */
-		do
+		while(record != NULL)
 		{
 			if(files_are_identical(path, is_readable, record->path,
 						record->is_readable))
@@ -1071,7 +1785,6 @@ add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
 			}
 			record = record->next;
 		}
-		while(record != NULL);
 	}
 
 	if(record != NULL)
@@ -1335,9 +2048,10 @@ compare_move_entry(ops_t *ops, view_t *from, view_t *to, int idx)
 	/* Try to update id of the other entry by computing fingerprint of both files
 	 * and checking if they match. */
 
-	from_fingerprint = get_file_fingerprint(from_path, curr, ct, flags,
+	from_fingerprint = get_file_fingerprint(NULL, from_path, curr, ct, flags,
+			/*lazy=*/0);
+	to_fingerprint = get_file_fingerprint(NULL, to_path, other, ct, flags,
 			/*lazy=*/0);
-	to_fingerprint = get_file_fingerprint(to_path, other, ct, flags, /*lazy=*/0);
 
 	if(!is_null_or_empty(from_fingerprint) && !is_null_or_empty(to_fingerprint))
 	{
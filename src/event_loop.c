@@ -27,6 +27,7 @@
 #include <stddef.h> /* NULL size_t wchar_t */
 #include <stdlib.h> /* free() */
 #include <string.h> /* memmove() strncpy() */
+#include <time.h> /* CLOCK_MONOTONIC clock_gettime() timespec */
 #include <wchar.h> /* wint_t wcslen() wcscmp() wcsncat() wmemmove() */
 
 #include "cfg/config.h"
@@ -63,6 +64,7 @@ static int ensure_term_is_ready(void);
 static int get_char_async_loop(WINDOW *win, wint_t *c, int timeout,
 		int process_callbacks);
 static int is_previewed(const char path[]);
+static int load_postponed_meta(int ms);
 static void process_scheduled_updates(void);
 TSTATIC int process_scheduled_updates_of_view(view_t *view);
 static void update_hardware_cursor(void);
@@ -390,6 +392,7 @@ ensure_term_is_ready(void)
  * performing the following tasks while waiting for input:
  *  - checks for new IPC messages;
  *  - checks whether contents of displayed directories changed;
+ *  - reads directory under cursor in advance;
  *  - redraws UI if requested.
  * Returns KEY_CODE_YES for functional keys (preprocesses *c in this case), OK
  * for wide character and ERR otherwise (e.g. after timeout). */
@@ -398,6 +401,9 @@ get_char_async_loop(WINDOW *win, wint_t *c, int timeout, int process_callbacks)
 {
 	const int IPC_F = ipc_enabled() ? 10 : 1;
 
+	/* Whether there was no input for at least one iteration of the loop. */
+	int idle = 0;
+
 	do
 	{
 		int i;
@@ -420,6 +426,15 @@ get_char_async_loop(WINDOW *win, wint_t *c, int timeout, int process_callbacks)
 
 		if(should_check_views_for_changes())
 		{
+			/* Pick up file lists that were read in background. */
+			flist_finish_loading(curr_view);
+			flist_finish_loading(other_view);
+
+			/* Directory under cursor is read in advance only after cursor rests on
+			 * it for a bit. */
+			flist_prefetch(curr_view, /*start=*/idle);
+			flist_prefetch(other_view, /*start=*/0);
+
 			check_view_for_changes(curr_view);
 			check_view_for_changes(other_view);
 		}
@@ -444,7 +459,10 @@ get_char_async_loop(WINDOW *win, wint_t *c, int timeout, int process_callbacks)
 				vlua_process_callbacks(curr_stats.vlua);
 			}
 
-			wtimeout(win, delay_slice);
+			/* Time of waiting for input is used to load postponed meta-data of
+			 * files, so don't wait if there is more of it. */
+			const int busy = load_postponed_meta(delay_slice);
+			wtimeout(win, busy ? 0 : delay_slice);
 			timeout -= delay_slice;
 
 			if(suggestions_are_visible)
@@ -507,6 +525,8 @@ get_char_async_loop(WINDOW *win, wint_t *c, int timeout, int process_callbacks)
 
 			process_scheduled_updates();
 		}
+
+		idle = 1;
 	}
 	while(timeout > 0);
 
@@ -527,6 +547,34 @@ is_previewed(const char path[])
 	return (fview_previews(curr_view, path) || fview_previews(other_view, path));
 }
 
+/* Spends up to about ms milliseconds on loading postponed meta-data of files
+ * of the views.  Returns non-zero if there is more to load, otherwise zero is
+ * returned. */
+static int
+load_postponed_meta(int ms)
+{
+	struct timespec start, now;
+	const int timed = (clock_gettime(CLOCK_MONOTONIC, &start) == 0);
+
+	int more;
+	do
+	{
+		/* Current view goes first as it's the one user is looking at. */
+		more = flist_load_postponed_meta(curr_view)
+		    || flist_load_postponed_meta(other_view);
+
+		/* Do a single step if time can't be measured. */
+		if(!more || !timed || clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+		{
+			break;
+		}
+	}
+	while((now.tv_sec - start.tv_sec)*1000L +
+			(now.tv_nsec - start.tv_nsec)/(1000L*1000L) < ms);
+
+	return more;
+}
+
 /* Updates TUI or its elements if something is scheduled. */
 static void
 process_scheduled_updates(void)
@@ -28,22 +28,33 @@
 
 #include <curses.h>
 
-#include <sys/stat.h> /* stat */
+#ifndef _WIN32
+#include <fcntl.h> /* AT_FDCWD AT_SYMLINK_NOFOLLOW O_* open() */
+#include <unistd.h> /* close() read() */
+#endif
+#include <sys/stat.h> /* fstatat() stat */
+#include <sys/types.h> /* pid_t */
+#include <poll.h> /* POLLIN poll() pollfd */
 
 #include <assert.h> /* assert() */
 #include <errno.h> /* errno */
 #include <limits.h> /* INT_MAX INT_MIN */
+#include <signal.h> /* SIGINT SIGKILL SIGTERM kill() */
 #include <stddef.h> /* NULL size_t */
 #include <stdint.h> /* intptr_t uint64_t */
-#include <stdio.h> /* snprintf() */
-#include <stdlib.h> /* calloc() free() */
-#include <string.h> /* memcmp() memcpy() memset() strcat() strcmp() strcpy()
-                       strdup() strlen() */
+#include <stdio.h> /* FILE fclose() fileno() fwrite() rewind() snprintf()
+                       tmpfile() */
+#include <stdlib.h> /* calloc() free() realloc() */
+#include <string.h> /* memchr() memcmp() memcpy() memmove() memset() strcat()
+                       strcmp() strcpy() strdup() strlen() */
+#include <time.h> /* CLOCK_MONOTONIC CLOCK_REALTIME clock_gettime()
+                      timespec */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
 #include "compat/os.h"
 #include "compat/pthread.h"
+#include "compat/reallocarray.h"
 #include "engine/autocmds.h"
 #include "engine/mode.h"
 #include "int/fuse.h"
@@ -59,22 +70,28 @@
 #include "ui/ui.h"
 #include "utils/dynarray.h"
 #include "utils/env.h"
+#include "utils/filemon.h"
 #include "utils/fs.h"
 #include "utils/fsdata.h"
 #include "utils/fswatch.h"
 #include "utils/log.h"
 #include "utils/macros.h"
 #include "utils/matcher.h"
+#include "utils/parallel.h"
 #include "utils/path.h"
 #include "utils/regexp.h"
 #include "utils/str.h"
+#include "utils/str_arena.h"
 #include "utils/string_array.h"
 #include "utils/test_helpers.h"
 #include "utils/trie.h"
 #include "utils/utf8.h"
 #include "utils/utils.h"
 #include "filtering.h"
+#include "flist_cache.h"
 #include "flist_hist.h"
+#include "flist_index.h"
+#include "flist_snap.h"
 #include "flist_pos.h"
 #include "flist_sel.h"
 #include "fops_misc.h"
@@ -99,17 +116,189 @@ typedef enum
 }
 FoldState;
 
+/* State of reading a directory in background.  It's shared by a view and a
+ * worker thread, whichever of them is the last one to use it frees it. */
+typedef struct dir_loader_t
+{
+	char *path; /* Directory that is being read. */
+	int reload; /* Whether this is a reload of the same directory. */
+
+	char *snaps_dir; /* Where to save snapshot of the listing or NULL. */
+	int snap_min;    /* Minimal number of files to save a snapshot. */
+
+	int max_entries; /* Reading fails on more files than this, if non-zero. */
+	int nthreads;    /* Number of threads to use for loading meta-data. */
+	int detached;    /* Whether no view waits for the result, so it's only saved
+	                    as a snapshot and worker frees the loader. */
+
+	/* Entries can be filled by the view, then directory isn't read and only
+	 * meta-data that's missing is loaded. */
+	int prefilled; /* Whether entries are provided instead of being read. */
+	int *pending;  /* Indexes of provided entries that lack meta-data. */
+	int npending;  /* Number of elements in the pending array. */
+
+	pthread_mutex_t lock; /* Protects the two fields below. */
+	int finished;         /* Whether worker thread is done. */
+	int cancelled;        /* Whether the view doesn't need the result anymore. */
+
+	/* These fields belong to the worker until it's finished. */
+	str_arena_t *arena;   /* Storage of names of the entries. */
+	dir_entry_t *entries; /* Files of the directory (origins aren't set). */
+	int nentries;         /* Number of elements in the entries array. */
+	int error;            /* Whether reading directory has failed. */
+	filemon_t mon;        /* State of the directory before reading it. */
+}
+dir_loader_t;
+
+/* State of checking whether a directory responds.  It's shared by the caller
+ * and a worker thread, whichever of them is the last one to use it frees it. */
+typedef struct
+{
+	pthread_mutex_t lock; /* Protects the two fields below. */
+	pthread_cond_t done;  /* Signaled by the worker once it's finished. */
+	int finished;         /* Whether worker thread is done. */
+	int abandoned;        /* Whether the caller has stopped waiting. */
+
+	char path[];          /* Directory that is being checked. */
+}
+dir_probe_t;
+
+/* Portion of paths received from a command which is ready to be added to a
+ * view. */
+typedef struct
+{
+	str_arena_t *arena;   /* Storage of names and origins of the entries. */
+	dir_entry_t *entries; /* Entries with meta-data. */
+	int nentries;         /* Number of elements in the entries array. */
+}
+cv_batch_t;
+
+/* State of populating custom view with output of a command in background.  It's
+ * shared by a view and a worker thread, whichever of them is the last one to
+ * use it frees it. */
+typedef struct cv_loader_t
+{
+	char *title; /* Title of the custom view. */
+	char *cwd;   /* Base for relative paths. */
+	int very;    /* Whether the list is to be left unsorted. */
+	pid_t pid;   /* Process of the command, which also identifies its group. */
+	FILE *err;   /* Error stream of the command, which is replaced by the worker
+	                with a file that holds its contents. */
+	int shown;   /* Whether the view displays the list (used only by the view). */
+
+	pthread_mutex_t lock; /* Protects the four fields below. */
+	int finished;         /* Whether worker thread is done. */
+	int cancelled;        /* Whether the view doesn't need the result anymore. */
+	cv_batch_t *batches;  /* Batches that weren't taken by the view yet. */
+	int nbatches;         /* Number of elements in the batches array. */
+
+	/* These fields belong to the worker. */
+	FILE *out;     /* Output stream of the command. */
+	trie_t *paths; /* Paths seen so far to skip duplicates. */
+}
+cv_loader_t;
+
+/* Directory of a tree read in advance by scan_tree().  Entries of all
+ * directories read by the same thread are stored in a buffer of that thread. */
+typedef struct tree_dir_t
+{
+	char *path;  /* Full path to the directory. */
+	int depth;   /* Nesting level limit for the directory. */
+	int read;    /* Whether the directory has been read. */
+	int error;   /* Whether reading the directory has failed. */
+	int worker;  /* Index of the thread that has read the directory. */
+	int first;   /* Index of the first entry in the buffer of the thread. */
+	int count;   /* Number of entries of the directory. */
+
+	dir_entry_t *entries;        /* Entries (origins aren't set), available once
+	                                reading of the whole tree is over. */
+	struct tree_dir_t **subdirs; /* Subdirectory for each entry or NULL, can be
+	                                NULL itself. */
+}
+tree_dir_t;
+
+/* Entries read by a single thread of scan_tree(). */
+typedef struct
+{
+	str_arena_t *arena;   /* Storage of names of the entries. */
+	dir_entry_t *entries; /* Entries of all directories read by the thread. */
+	int nentries;         /* Number of elements in the entries array. */
+}
+tree_buf_t;
+
+/* State of reading a tree by several threads. */
+typedef struct
+{
+	view_t *view;           /* View for which the tree is being built. */
+	trie_t *excluded_paths; /* Paths that shouldn't be read. */
+	trie_t *folded_paths;   /* States of folds. */
+	int check_filters;      /* Whether filters can be checked by threads. */
+
+	tree_buf_t *bufs; /* Buffers of threads. */
+	int nbufs;        /* Number of threads and elements in bufs array. */
+	tree_dir_t *root; /* Top directory of the tree or NULL. */
+}
+tree_scan_t;
+
 static void init_flist(view_t *view);
 static void reset_view(view_t *view);
 static void init_view_history(view_t *view);
 static int navigate_to_file_in_custom_view(view_t *view, const char dir[],
 		const char file[]);
 static int fill_dir_entry_by_path(dir_entry_t *entry, const char path[]);
+static int enter_dir(view_t *view, const char path[], int location_changed);
 static void on_custom_view_leave(view_t *view);
+static int dir_responds(const char path[]);
 #ifndef _WIN32
-static int fill_dir_entry(dir_entry_t *entry, const char path[],
-		const struct dirent *d);
+static void load_entries_meta(view_t *view, int dir_fd, int first);
+static int collect_pending_meta(view_t *view, int from, int to, int indexes[],
+		int count, int max);
+static int sorting_needs_meta(const view_t *view);
+static void load_entry_meta(size_t idx, void *arg);
+static int fill_dir_entry(dir_entry_t *entry, const struct stat *s,
+		FileType type_hint);
+static void fill_link_info(dir_entry_t *entry, const char path[]);
+static void fill_link_info_at(dir_entry_t *entry, int dir_fd);
 static int data_is_dir_entry(const struct dirent *d, const char path[]);
+static int dirent_type_is_known(const struct dirent *d);
+static void stop_loading(view_t *view);
+static void * dir_loader_thread(void *arg);
+static int read_dir_in_background(dir_loader_t *loader);
+static int dir_loader_poll(size_t ndone, void *arg);
+static int dir_loader_cancelled(dir_loader_t *loader);
+static dir_loader_t * alloc_dir_loader(const char path[]);
+static int launch_dir_loader(dir_loader_t *loader);
+static int dir_loader_finished(dir_loader_t *loader);
+static void cancel_dir_loader(dir_loader_t *loader);
+static void free_dir_loader(dir_loader_t *loader);
+static void * dir_probe_thread(void *arg);
+static void free_dir_probe(dir_probe_t *probe);
+static int get_prefetch_target(view_t *view, char buf[], size_t buf_len);
+static int start_prefetching(view_t *view, const char path[]);
+static void collect_prefetched(view_t *view);
+static void stop_prefetching(view_t *view);
+static int prefetch_column(view_t *view, cached_entries_t *cache,
+		const char path[]);
+static void * cv_loader_thread(void *arg);
+static int read_streamed_paths(cv_loader_t *loader);
+static int read_streamed_errors(int fd, FILE *errors);
+static void stop_cv_command(cv_loader_t *loader);
+static int wait_for_closed_output(int fd, int timeout);
+static size_t parse_cmd_output(cv_loader_t *loader, char text[], size_t len,
+		int null_sep);
+static void add_cmd_output_line(cv_loader_t *loader, cv_batch_t *batch,
+		const char line[]);
+static void publish_cv_batch(cv_loader_t *loader, cv_batch_t *batch);
+static int cv_loader_cancelled(cv_loader_t *loader);
+static void take_streamed_paths(view_t *view);
+static void apply_cv_batches(view_t *view, cv_loader_t *loader,
+		cv_batch_t batches[], int nbatches);
+static dir_entry_t * add_streamed_entry(view_t *view, dir_entry_t **list,
+		int *list_size, const dir_entry_t *entry);
+static void stop_streaming(view_t *view, int keep);
+static void cancel_cv_loader(cv_loader_t *loader);
+static void free_cv_loader(cv_loader_t *loader);
+static void free_cv_batch(cv_batch_t *batch);
 #else
 static int fill_dir_entry(dir_entry_t *entry, const char path[],
 		const WIN32_FIND_DATAW *ffd);
@@ -126,10 +315,20 @@ static int got_excluded(view_t *view, const dir_entry_t *entry, void *arg);
 static int exclude_temporary_entries(view_t *view);
 static int is_temporary(view_t *view, const dir_entry_t *entry, void *arg);
 static void flist_custom_drop_save(view_t *view);
+static void apply_loaded_list(view_t *view, dir_entry_t *entries,
+		int nentries, int reload, const filemon_t *mon);
+static int fill_column_from_cache(view_t *view, cached_entries_t *cache,
+		const char path[]);
 static uint64_t recalc_entry_size(const dir_entry_t *entry, uint64_t old_size);
 static uint64_t entry_calc_nitems(const dir_entry_t *entry);
 static void load_dir_list_internal(view_t *view, int reload, int draw_only);
 static int populate_dir_list_internal(view_t *view, int reload);
+static void prepare_list_caching(view_t *view);
+static char * make_list_sig(const view_t *view);
+static void cache_list(view_t *view);
+static int restore_cached_list(view_t *view);
+static int load_snapshot(view_t *view);
+static int start_loading(view_t *view, int reload);
 static int populate_custom_view(view_t *view, int reload);
 static void re_apply_folds(view_t *view, trie_t *folded_paths);
 static int entry_exists(view_t *view, const dir_entry_t *entry, void *arg);
@@ -145,27 +344,38 @@ static void fix_tree_links(dir_entry_t *entries, dir_entry_t *entry,
 		int old_idx, int new_idx, int displacement, int correction);
 static int is_dir_big(const char path[]);
 static void free_view_entries(view_t *view);
-static int update_dir_list(view_t *view, int reload);
+static int start_snapshotting(view_t *view, const strlist_t *filtered);
+static int update_dir_list(view_t *view, int reload, strlist_t *filtered);
 static void start_dir_list_change(view_t *view, dir_entry_t **entries, int *len,
 		int reload);
 static void finish_dir_list_change(view_t *view, dir_entry_t *entries, int len);
 static int add_file_entry_to_view(const char name[], const void *data,
 		void *param);
 static void sort_dir_list(int msg, view_t *view);
+static void sort_new_list(view_t *view, const dir_entry_t prev[], int prev_len,
+		int msg);
 static void merge_lists(view_t *view, dir_entry_t *entries, int len);
 TSTATIC void check_file_uniqueness(view_t *view);
-static void add_to_trie(trie_t *trie, view_t *view, dir_entry_t *entry);
-static int is_in_trie(trie_t *trie, view_t *view, dir_entry_t *entry,
-		void **data);
 static void merge_entries(dir_entry_t *new, const dir_entry_t *prev);
 static int correct_pos(view_t *view, int pos, int dist, int closest);
 static int rescue_from_empty_filelist(view_t *view);
 static void add_parent_entry(view_t *view, dir_entry_t **entries, int *count);
 static void init_dir_entry(view_t *view, dir_entry_t *entry, const char name[]);
+static int set_entry_origin(view_t *view, dir_entry_t *entry,
+		const char origin[]);
+static char * copy_entry_str(view_t *view, const dir_entry_t *entry,
+		const char str[], int intern);
+static void free_entry_str(const dir_entry_t *entry, char str[]);
+static str_arena_t * get_arena(view_t *view);
 static dir_entry_t * alloc_dir_entry(dir_entry_t **list, int list_size);
+static int apply_file_changes(view_t *view, const strlist_t *changes);
+static int update_changed_file(view_t *view, const char name[]);
 static int tree_has_changed(const dir_entry_t *entries, size_t nchildren);
 static FSWatchState poll_watcher(fswatch_t *watch, const char path[]);
 static void remove_child_entries(view_t *view, dir_entry_t *entry);
+static int load_child_entries(view_t *view, int pos, const char path[]);
+static int build_subtree(view_t *view, const char path[],
+		dir_entry_t **entries, int *nentries);
 static void find_dir_in_cdpath(const char base_dir[], const char dst[],
 		char buf[], size_t buf_size);
 static entries_t list_sibling_dirs(view_t *view);
@@ -177,6 +387,7 @@ static int iter_entries(view_t *view, dir_entry_t **entry, entry_predicate pred,
 		int valid_only);
 static int mark_selected(view_t *view);
 static int set_position_by_path(view_t *view, const char path[]);
+static int is_entry_at(const dir_entry_t *entry, const char path[]);
 static int flist_load_tree_internal(view_t *view, const char path[], int reload,
 		int depth);
 static int make_tree(view_t *view, const char path[], int reload,
@@ -186,13 +397,34 @@ static int complete_tree(const char name[], int valid, const void *parent_data,
 		void *data, void *arg);
 static void reset_entry_list(view_t *view, dir_entry_t **entries, int *count);
 static void drop_tops(dir_entry_t *entries, int *nentries, int extra);
+static void scan_tree(tree_scan_t *scan, view_t *view, const char path[],
+		trie_t *excluded_paths, trie_t *folded_paths, int depth);
+#ifndef _WIN32
+static void scan_tree_dir(par_tasks_t *tasks, int worker, void *task,
+		void *arg);
+static int read_tree_entry_meta(dir_entry_t *entry, int dir_fd);
+static void spawn_tree_subdirs(par_tasks_t *tasks, int worker,
+		tree_scan_t *scan, tree_dir_t *node);
+static int tree_subdir_is_needed(tree_scan_t *scan, const tree_dir_t *node,
+		FoldState parent_fold, const char name[], const char full_path[]);
+static int scan_tree_poll(size_t ndone, void *arg);
+static void resolve_tree_dir(tree_scan_t *scan, tree_dir_t *node);
+#endif
+static void free_tree_scan(tree_scan_t *scan);
+static tree_dir_t * alloc_tree_dir(char path[], int depth);
+static void free_tree_dir(tree_dir_t *node);
 static int add_files_recursively(view_t *view, const char path[],
-		trie_t *excluded_paths, trie_t *folded_paths, int parent_pos,
-		int no_direct_parent, int depth);
+		trie_t *excluded_paths, trie_t *folded_paths, tree_dir_t *node,
+		int parent_pos, int no_direct_parent, int depth);
+static dir_entry_t * add_scanned_entry(view_t *view, const char path[],
+		dir_entry_t *scanned);
 static FoldState get_fold_state(trie_t *folded_paths, const char full_path[]);
 static int set_fold_state(trie_t *folded_paths, const char full_path[],
 		FoldState state);
 static int entry_is_visible(view_t *view, const char name[], const void *data);
+#ifndef _WIN32
+static int loaded_entry_is_visible(view_t *view, const dir_entry_t *entry);
+#endif
 static int tree_candidate_is_visible(view_t *view, const char path[],
 		const char name[], int is_dir, int apply_local_filter);
 static int add_directory_leaf(view_t *view, const char path[], int parent_pos);
@@ -232,7 +464,15 @@ init_flist(view_t *view)
 	view->history_num = 0;
 	view->history_pos = 0;
 	view->on_slow_fs = 0;
+	view->unresponsive = 0;
+	view->slow_below = 0;
 	view->has_dups = 0;
+	view->loader = NULL;
+	view->prefetcher = NULL;
+	view->prefetch_watch = NULL;
+	view->arena = NULL;
+	filemon_reset(&view->list_mon);
+	view->cache_sig = NULL;
 
 	view->watched_dir = NULL;
 	view->last_dir = NULL;
@@ -260,8 +500,14 @@ flist_free_view(view_t *view)
 	/* For the application, we don't need to zero out fields after freeing them,
 	 * but doing so allows reusing this function in tests. */
 
+#ifndef _WIN32
+	stop_loading(view);
+	stop_streaming(view, /*keep=*/0);
+	stop_prefetching(view);
+#endif
 	free_dir_entries(&view->dir_entry, &view->list_rows);
 	free_dir_entries(&view->custom.entries, &view->custom.entry_count);
+	flist_index_reset(view);
 
 	update_string(&view->custom.next_title, NULL);
 	update_string(&view->custom.orig_dir, NULL);
@@ -286,6 +532,13 @@ flist_free_view(view_t *view)
 	free(view->local_filter.poshist);
 	view->local_filter.poshist = NULL;
 
+	/* Strings of entries don't depend on lifetime of the arena. */
+	str_arena_free(view->arena);
+	view->arena = NULL;
+
+	filemon_reset(&view->list_mon);
+	update_string(&view->cache_sig, NULL);
+
 	filter_dispose(&view->local_filter.filter);
 	filter_dispose(&view->auto_filter);
 	matcher_free(view->manual_filter);
@@ -596,7 +849,12 @@ change_directory(view_t *view, const char directory[])
 
 	system_to_internal_slashes(dir_dup);
 
-	if(cfg.chase_links)
+	/* Directory on a hung file system is entered without checks, reading it in
+	 * background reports errors instead. */
+	const int unresponsive = curr_stats.load_stage >= 3 &&
+		is_on_slow_fs(dir_dup, cfg.slow_fs_list) && !dir_responds(dir_dup);
+
+	if(cfg.chase_links && !unresponsive)
 	{
 		char real_path[PATH_MAX + 1];
 		if(os_realpath(dir_dup, real_path) == real_path)
@@ -611,7 +869,7 @@ change_directory(view_t *view, const char directory[])
 	if(!is_root_dir(dir_dup))
 		chosp(dir_dup);
 
-	if(!is_valid_dir(dir_dup))
+	if(!unresponsive && !is_valid_dir(dir_dup))
 	{
 		show_error_msgf("Directory Access Error", "Cannot open %s", dir_dup);
 		copy_str(view->curr_dir, sizeof(view->curr_dir), dir_dup);
@@ -648,51 +906,8 @@ change_directory(view_t *view, const char directory[])
 	if(view->last_dir != NULL && !is_root_dir(view->last_dir))
 		chosp(view->last_dir);
 
-#ifndef _WIN32
-	if(!path_exists(dir_dup, DEREF))
-#else
-	if(!is_valid_dir(dir_dup))
-#endif
-	{
-		LOG_SERROR_MSG(errno, "Can't access \"%s\"", dir_dup);
-		log_cwd();
-
-		show_error_msgf("Directory Access Error", "Cannot open %s", dir_dup);
-
-		flist_sel_stash(view);
-		return -1;
-	}
-
-	if(os_access(dir_dup, X_OK) != 0 && !is_unc_root(dir_dup))
-	{
-		LOG_SERROR_MSG(errno, "Can't access(, X_OK) \"%s\"", dir_dup);
-		log_cwd();
-
-		show_error_msgf("Directory Access Error",
-				"You do not have execute access on %s", dir_dup);
-
-		flist_sel_stash(view);
-		return -1;
-	}
-
-	if(os_access(dir_dup, R_OK) != 0 && !is_unc_root(dir_dup))
-	{
-		LOG_SERROR_MSG(errno, "Can't access(, R_OK) \"%s\"", dir_dup);
-		log_cwd();
-
-		if(location_changed)
-		{
-			show_error_msgf("Directory Access Error",
-					"You do not have read access on %s", dir_dup);
-		}
-	}
-
-	if(vifm_chdir(dir_dup) != 0 && !is_unc_root(dir_dup))
+	if(!unresponsive && enter_dir(view, dir_dup, location_changed) != 0)
 	{
-		LOG_SERROR_MSG(errno, "Can't chdir() \"%s\"", dir_dup);
-		log_cwd();
-
-		show_error_msgf("Change Directory Error", "Couldn't open %s", dir_dup);
 		return -1;
 	}
 
@@ -709,11 +924,14 @@ change_directory(view_t *view, const char directory[])
 
 	if(location_changed)
 	{
+		prepare_list_caching(view);
 		replace_string(&view->last_dir, flist_get_dir(view));
 		view->on_slow_fs = is_on_slow_fs(dir_dup, cfg.slow_fs_list);
+		view->slow_below = has_slow_fs_below(dir_dup, cfg.slow_fs_list);
 	}
 
 	copy_str(view->curr_dir, sizeof(view->curr_dir), dir_dup);
+	view->unresponsive = unresponsive;
 
 	if(is_dir_list_loaded(view))
 	{
@@ -736,6 +954,62 @@ change_directory(view_t *view, const char directory[])
 	return 0;
 }
 
+/* Checks that directory can be visited and makes it current working directory
+ * of the process.  Returns zero on success, otherwise non-zero is returned. */
+static int
+enter_dir(view_t *view, const char path[], int location_changed)
+{
+#ifndef _WIN32
+	if(!path_exists(path, DEREF))
+#else
+	if(!is_valid_dir(path))
+#endif
+	{
+		LOG_SERROR_MSG(errno, "Can't access \"%s\"", path);
+		log_cwd();
+
+		show_error_msgf("Directory Access Error", "Cannot open %s", path);
+
+		flist_sel_stash(view);
+		return 1;
+	}
+
+	if(os_access(path, X_OK) != 0 && !is_unc_root(path))
+	{
+		LOG_SERROR_MSG(errno, "Can't access(, X_OK) \"%s\"", path);
+		log_cwd();
+
+		show_error_msgf("Directory Access Error",
+				"You do not have execute access on %s", path);
+
+		flist_sel_stash(view);
+		return 1;
+	}
+
+	if(os_access(path, R_OK) != 0 && !is_unc_root(path))
+	{
+		LOG_SERROR_MSG(errno, "Can't access(, R_OK) \"%s\"", path);
+		log_cwd();
+
+		if(location_changed)
+		{
+			show_error_msgf("Directory Access Error",
+					"You do not have read access on %s", path);
+		}
+	}
+
+	if(vifm_chdir(path) != 0 && !is_unc_root(path))
+	{
+		LOG_SERROR_MSG(errno, "Can't chdir() \"%s\"", path);
+		log_cwd();
+
+		show_error_msgf("Change Directory Error", "Couldn't open %s", path);
+		return 1;
+	}
+
+	return 0;
+}
+
 /* Performs additional actions on leaving custom view. */
 static void
 on_custom_view_leave(view_t *view)
@@ -764,6 +1038,10 @@ on_custom_view_leave(view_t *view)
 
 	trie_free(view->custom.folded_paths);
 	view->custom.folded_paths = NULL;
+
+#ifndef _WIN32
+	stop_streaming(view, /*keep=*/0);
+#endif
 }
 
 int
@@ -856,6 +1134,11 @@ flist_custom_active(const view_t *view)
 void
 flist_custom_start(view_t *view, const char title[])
 {
+#ifndef _WIN32
+	/* New list replaces the one that's being populated. */
+	stop_streaming(view, /*keep=*/0);
+#endif
+
 	free_dir_entries(&view->custom.entries, &view->custom.entry_count);
 	(void)replace_string(&view->custom.next_title, title);
 
@@ -908,8 +1191,7 @@ flist_custom_add_separator(view_t *view, int id)
 	if(dir_entry != NULL)
 	{
 		init_dir_entry(view, dir_entry, "");
-		dir_entry->origin = strdup(flist_get_dir(view));
-		dir_entry->owns_origin = 1;
+		(void)set_entry_origin(view, dir_entry, flist_get_dir(view));
 		dir_entry->id = id;
 		++view->custom.entry_count;
 	}
@@ -917,19 +1199,21 @@ flist_custom_add_separator(view_t *view, int id)
 
 #ifndef _WIN32
 
-/* Fills directory entry with information about file specified by the path.
- * Returns non-zero on error, otherwise zero is returned. */
-static int
-fill_dir_entry_by_path(dir_entry_t *entry, const char path[])
+/* Data shared by threads of load_entries_meta(). */
+typedef struct
 {
-	return fill_dir_entry(entry, path, NULL);
+	dir_entry_t *entries; /* Entries to be filled. */
+	const int *map;       /* Maps item indexes to entry indexes, can be NULL. */
+	int dir_fd;           /* Descriptor of directory that contains the entries or
+	                         AT_FDCWD to use full paths. */
+	dir_loader_t *owner;  /* Background loader to check for cancellation. */
 }
+meta_loader_t;
 
-/* Fills fields of the entry from stat information of the file specified by its
- * path.  d is optional source of file type.  Returns zero on success, otherwise
- * non-zero is returned. */
+/* Fills directory entry with information about file specified by the path.
+ * Returns non-zero on error, otherwise zero is returned. */
 static int
-fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
+fill_dir_entry_by_path(dir_entry_t *entry, const char path[])
 {
 	struct stat s;
 
@@ -940,130 +1224,1753 @@ fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
 		return 1;
 	}
 
-	entry->type = get_type_from_mode(s.st_mode);
-	if(entry->type == FT_UNK)
-	{
-		entry->type = (d == NULL) ? FT_UNK : type_from_dir_entry(d, path);
-	}
-	if(entry->type == FT_UNK)
+	if(fill_dir_entry(entry, &s, FT_UNK) != 0)
 	{
 		LOG_ERROR_MSG("Can't determine type of \"%s\"", path);
 		return 1;
 	}
 
-	entry->size = (uintmax_t)s.st_size;
-	entry->uid = s.st_uid;
-	entry->gid = s.st_gid;
-	entry->mode = s.st_mode;
-	entry->inode = s.st_ino;
-	entry->mtime = s.st_mtime;
-	entry->atime = s.st_atime;
-	entry->ctime = s.st_ctime;
-	entry->nlinks = s.st_nlink;
-
 	if(entry->type == FT_LINK)
 	{
-		struct stat s;
-
-		const SymLinkType symlink_type = get_symlink_type(path);
-		entry->dir_link = (symlink_type != SLT_UNKNOWN);
-		entry->slow_target = (symlink_type == SLT_SLOW);
-
-		/* Query mode of symbolic link target. */
-		if(!entry->slow_target && os_stat(entry->name, &s) == 0)
-		{
-			entry->mode = s.st_mode;
-		}
+		fill_link_info(entry, path);
 	}
 
 	return 0;
 }
 
-/* Checks whether file is a directory.  Returns non-zero if so, otherwise zero
- * is returned. */
-static int
-data_is_dir_entry(const struct dirent *d, const char path[])
+/* Loads meta-data of view entries starting with the first one.  Files are
+ * queried relative to the dir_fd by several threads to not wait for each reply
+ * of a (possibly network) file system in turn.  Entries for which this fails
+ * are removed from the list, order of the rest is preserved.  For large lists
+ * loading of most of meta-data is postponed (see flist_load_postponed_meta()),
+ * names and types from directory entries are enough to display and sort
+ * them. */
+static void
+load_entries_meta(view_t *view, int dir_fd, int first)
 {
-	return is_dirent_targets_dir(path, d);
-}
+	/* Starting a thread costs about as much as querying several local files. */
+	enum { MIN_FILES_PER_THREAD = 64 };
+	/* Starting from this size, listing is shown before meta-data is known. */
+	enum { MIN_FILES_TO_POSTPONE = 10000 };
 
-#else
+	const int count = view->list_rows - first;
+	if(count == 0)
+	{
+		return;
+	}
 
-/* Fills directory entry with information about file specified by the path.
- * Returns non-zero on error, otherwise zero is returned. */
-static int
-fill_dir_entry_by_path(dir_entry_t *entry, const char path[])
-{
-	wchar_t *utf16_path;
-	HANDLE hfind;
-	WIN32_FIND_DATAW ffd;
+	dir_entry_t *const entries = &view->dir_entry[first];
 
-	utf16_path = utf8_to_utf16(path);
-	hfind = FindFirstFileW(utf16_path, &ffd);
-	free(utf16_path);
+	/* Files of unknown type weren't filtered yet, remember them before their
+	 * type is determined. */
+	unsigned char *unfiltered = NULL;
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		if(entries[i].type == FT_UNK)
+		{
+			if(unfiltered == NULL)
+			{
+				unfiltered = calloc(count, sizeof(*unfiltered));
+				if(unfiltered == NULL)
+				{
+					break;
+				}
+			}
+			unfiltered[i] = 1;
+		}
+	}
 
-	if(hfind == INVALID_HANDLE_VALUE)
+	int nitems = count;
+	int *map = NULL;
+	if(count >= MIN_FILES_TO_POSTPONE)
 	{
-		return 1;
+		map = reallocarray(NULL, count, sizeof(*map));
 	}
 
-	fill_dir_entry(entry, path, &ffd);
+	if(map != NULL)
+	{
+		/* Symbolic links are still loaded here, because their targets affect
+		 * sorting and processing them needs current directory.  Files of unknown
+		 * type are needed for filtering. */
+		nitems = 0;
+		for(i = 0; i < count; ++i)
+		{
+			if(entries[i].type == FT_LINK || entries[i].type == FT_UNK)
+			{
+				map[nitems++] = i;
+			}
+			else
+			{
+				entries[i].meta_pending = 1;
+				entries[i].tag = 0;
+			}
+		}
 
-	FindClose(hfind);
+		view->meta_pending = 1;
+		view->meta_pending_pos = first;
+	}
 
-	return 0;
+	meta_loader_t loader = { .entries = entries, .map = map, .dir_fd = dir_fd };
+	const int nthreads = MIN(par_nthreads(), 1 + nitems/MIN_FILES_PER_THREAD);
+	(void)par_for(nitems, nthreads, &load_entry_meta, /*poll_func=*/NULL,
+			&loader);
+	free(map);
+
+	/* Symbolic links are handled here because their processing isn't limited to
+	 * the file system and needs current directory. */
+	int j = 0;
+	for(i = 0; i < count; ++i)
+	{
+		dir_entry_t *const entry = &entries[i];
+
+		if(entry->tag != 0)
+		{
+			if(entry->tag > 0)
+			{
+				LOG_SERROR_MSG(entry->tag, "Can't lstat() \"%s/%s\"", entry->origin,
+						entry->name);
+			}
+			else
+			{
+				LOG_ERROR_MSG("Can't determine type of \"%s/%s\"", entry->origin,
+						entry->name);
+			}
+			fentry_free(entry);
+			continue;
+		}
+
+		entry->tag = -1;
+		if(entry->type == FT_LINK)
+		{
+			char full_path[PATH_MAX + 1];
+			get_full_path_of(entry, sizeof(full_path), full_path);
+			fill_link_info(entry, full_path);
+		}
+
+		if(unfiltered != NULL && unfiltered[i] &&
+				!loaded_entry_is_visible(view, entry))
+		{
+			++view->filtered;
+			fentry_free(entry);
+			continue;
+		}
+
+		if(i != j)
+		{
+			entries[j] = *entry;
+		}
+		++j;
+	}
+	free(unfiltered);
+
+	view->list_rows = first + j;
 }
 
-/* Fills fields of the entry from *ffd fields for the file specified by its
- * path.  type_hint is additional source of file type.  Returns zero on success,
- * Returns zero on success, otherwise non-zero is returned. */
+/* Picks entries in the [from; to) range that lack meta-data and appends their
+ * indexes to the array of at most max elements, which already has count
+ * items.  Picked entries are no longer considered pending.  Returns new number
+ * of items in the array. */
 static int
-fill_dir_entry(dir_entry_t *entry, const char path[],
-		const WIN32_FIND_DATAW *ffd)
+collect_pending_meta(view_t *view, int from, int to, int indexes[], int count,
+		int max)
 {
-	entry->size = (ffd->nFileSizeHigh*((uint64_t)MAXDWORD + 1))
-	            + ffd->nFileSizeLow;
-	entry->attrs = ffd->dwFileAttributes;
-	entry->mtime = win_to_unix_time(ffd->ftLastWriteTime);
-	entry->atime = win_to_unix_time(ffd->ftLastAccessTime);
-	entry->ctime = win_to_unix_time(ffd->ftCreationTime);
-
-	if(is_win_symlink(ffd->dwFileAttributes, ffd->dwReserved0))
+	int i;
+	for(i = from; i < to && count < max; ++i)
 	{
-		const SymLinkType symlink_type = get_symlink_type(path);
-		entry->dir_link = (symlink_type != SLT_UNKNOWN);
-		entry->slow_target = (symlink_type == SLT_SLOW);
-
-		entry->type = FT_LINK;
+		dir_entry_t *const entry = &view->dir_entry[i];
+		if(entry->meta_pending)
+		{
+			entry->meta_pending = 0;
+			indexes[count++] = i;
+		}
 	}
-	else if(ffd->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+	return count;
+}
+
+/* Checks whether current sorting of the view depends on meta-data of files.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+sorting_needs_meta(const view_t *view)
+{
+	static const char meta_keys[] = {
+		SK_BY_GROUP_ID, SK_BY_GROUP_NAME, SK_BY_MODE, SK_BY_OWNER_ID,
+		SK_BY_OWNER_NAME, SK_BY_SIZE, SK_BY_TIME_ACCESSED, SK_BY_TIME_CHANGED,
+		SK_BY_TIME_MODIFIED, SK_BY_PERMISSIONS, SK_BY_NLINKS, SK_BY_INODE,
+	};
+
+	size_t i;
+	for(i = 0U; i < ARRAY_LEN(meta_keys); ++i)
+	{
+		if(ui_view_sort_list_contains(view->sort, meta_keys[i]))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* par_for() callback that loads meta-data of a single entry.  Uses tag field of
+ * the entry to report errno on failure, -1 on unknown file type and zero on
+ * success. */
+static void
+load_entry_meta(size_t idx, void *arg)
+{
+	meta_loader_t *const loader = arg;
+	dir_entry_t *const entry = (loader->map == NULL)
+	                         ? &loader->entries[idx]
+	                         : &loader->entries[loader->map[idx]];
+
+	char full_path[PATH_MAX + 1];
+	const char *path = entry->name;
+	if(loader->dir_fd == AT_FDCWD)
+	{
+		get_full_path_of(entry, sizeof(full_path), full_path);
+		path = full_path;
+	}
+
+	struct stat s;
+	if(fstatat(loader->dir_fd, path, &s, AT_SYMLINK_NOFOLLOW) != 0)
+	{
+		entry->tag = (errno > 0 ? errno : EIO);
+		return;
+	}
+
+	/* Type of the entry at this point was taken from directory entry. */
+	const FileType type = entry->type;
+	entry->tag = (fill_dir_entry(entry, &s, type) == 0 ? 0 : -1);
+
+	if(entry->type != type)
+	{
+		/* Cached values depend on type of the file. */
+		entry->hi_num = -1;
+		entry->name_dec_num = -1;
+	}
+}
+
+/* Fills fields of the entry from stat information of a file.  type_hint is used
+ * if file mode doesn't identify type of the file.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+fill_dir_entry(dir_entry_t *entry, const struct stat *s, FileType type_hint)
+{
+	entry->type = get_type_from_mode(s->st_mode);
+	if(entry->type == FT_UNK)
+	{
+		entry->type = type_hint;
+	}
+	if(entry->type == FT_UNK)
+	{
+		return 1;
+	}
+
+	entry->size = (uintmax_t)s->st_size;
+	entry->uid = s->st_uid;
+	entry->gid = s->st_gid;
+	entry->mode = s->st_mode;
+	entry->inode = s->st_ino;
+	entry->mtime = s->st_mtime;
+	entry->atime = s->st_atime;
+	entry->ctime = s->st_ctime;
+	entry->nlinks = s->st_nlink;
+	return 0;
+}
+
+/* Fills symbolic link specific fields of the entry.  The path is a path to the
+ * link. */
+static void
+fill_link_info(dir_entry_t *entry, const char path[])
+{
+	struct stat s;
+
+	const SymLinkType symlink_type = get_symlink_type(path);
+	entry->dir_link = (symlink_type != SLT_UNKNOWN);
+	entry->slow_target = (symlink_type == SLT_SLOW);
+
+	/* Query mode of symbolic link target. */
+	if(!entry->slow_target && os_stat(path, &s) == 0)
+	{
+		entry->mode = s.st_mode;
+	}
+}
+
+/* Fills symbolic link specific fields of the entry by querying link target
+ * relative to the dir_fd.  Unlike fill_link_info() this doesn't consult
+ * 'slowfs' or current directory and can be used outside of the main thread. */
+static void
+fill_link_info_at(dir_entry_t *entry, int dir_fd)
+{
+	struct stat s;
+	if(fstatat(dir_fd, entry->name, &s, 0) == 0)
+	{
+		entry->dir_link = (S_ISDIR(s.st_mode) != 0);
+		entry->mode = s.st_mode;
+	}
+}
+
+/* Checks whether file is a directory.  Returns non-zero if so, otherwise zero
+ * is returned. */
+static int
+data_is_dir_entry(const struct dirent *d, const char path[])
+{
+	return is_dirent_targets_dir(path, d);
+}
+
+/* Checks whether directory entry specifies type of the file, so that it can be
+ * determined without querying file system.  Returns non-zero if so, otherwise
+ * zero is returned. */
+static int
+dirent_type_is_known(const struct dirent *d)
+{
+#if defined(HAVE_STRUCT_DIRENT_D_TYPE) && HAVE_STRUCT_DIRENT_D_TYPE
+	return (d->d_type != DT_UNKNOWN);
+#else
+	return 0;
+#endif
+}
+
+#else
+
+/* Fills directory entry with information about file specified by the path.
+ * Returns non-zero on error, otherwise zero is returned. */
+static int
+fill_dir_entry_by_path(dir_entry_t *entry, const char path[])
+{
+	wchar_t *utf16_path;
+	HANDLE hfind;
+	WIN32_FIND_DATAW ffd;
+
+	utf16_path = utf8_to_utf16(path);
+	hfind = FindFirstFileW(utf16_path, &ffd);
+	free(utf16_path);
+
+	if(hfind == INVALID_HANDLE_VALUE)
+	{
+		return 1;
+	}
+
+	fill_dir_entry(entry, path, &ffd);
+
+	FindClose(hfind);
+
+	return 0;
+}
+
+/* Fills fields of the entry from *ffd fields for the file specified by its
+ * path.  type_hint is additional source of file type.  Returns zero on success,
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+fill_dir_entry(dir_entry_t *entry, const char path[],
+		const WIN32_FIND_DATAW *ffd)
+{
+	entry->size = (ffd->nFileSizeHigh*((uint64_t)MAXDWORD + 1))
+	            + ffd->nFileSizeLow;
+	entry->attrs = ffd->dwFileAttributes;
+	entry->mtime = win_to_unix_time(ffd->ftLastWriteTime);
+	entry->atime = win_to_unix_time(ffd->ftLastAccessTime);
+	entry->ctime = win_to_unix_time(ffd->ftCreationTime);
+
+	if(is_win_symlink(ffd->dwFileAttributes, ffd->dwReserved0))
+	{
+		const SymLinkType symlink_type = get_symlink_type(path);
+		entry->dir_link = (symlink_type != SLT_UNKNOWN);
+		entry->slow_target = (symlink_type == SLT_SLOW);
+
+		entry->type = FT_LINK;
+	}
+	else if(ffd->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+	{
+		/* Windows doesn't like returning size of directories when it can. */
+		entry->size = get_file_size(entry->name);
+		entry->type = FT_DIR;
+	}
+	else if(is_win_executable(path))
+	{
+		entry->type = FT_EXEC;
+	}
+	else
+	{
+		entry->type = FT_REG;
+	}
+
+	return 0;
+}
+
+/* Checks whether file is a directory.  Returns non-zero if so, otherwise zero
+ * is returned. */
+static int
+data_is_dir_entry(const WIN32_FIND_DATAW *ffd, const char path[])
+{
+	return (ffd->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+}
+
+#endif
+
+int
+flist_load_postponed_meta(view_t *view)
+{
+#ifndef _WIN32
+	/* Big enough to make use of threads, small enough to not delay input. */
+	enum { CHUNK_SIZE = 1024 };
+
+	if(!view->meta_pending)
+	{
+		return 0;
+	}
+
+	int indexes[CHUNK_SIZE];
+	int count = 0;
+
+	/* Entries that are displayed go first. */
+	const int top = MAX(view->top_line, 0);
+	const int bottom = MIN(view->list_rows, top + view->window_cells);
+	count = collect_pending_meta(view, top, bottom, indexes, count, CHUNK_SIZE);
+	count = collect_pending_meta(view, view->list_pos, view->list_pos + 1,
+			indexes, count, CHUNK_SIZE);
+	const int visible = (count != 0);
+
+	const int pos = MIN(view->meta_pending_pos, view->list_rows);
+	count = collect_pending_meta(view, pos, view->list_rows, indexes, count,
+			CHUNK_SIZE);
+	count = collect_pending_meta(view, 0, pos, indexes, count, CHUNK_SIZE);
+	const int done = (count < CHUNK_SIZE);
+
+	if(count != 0)
+	{
+		view->meta_pending_pos = indexes[count - 1] + 1;
+
+		int dir_fd = AT_FDCWD;
+		if(!flist_custom_active(view))
+		{
+			dir_fd = open(view->curr_dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			if(dir_fd == -1)
+			{
+				dir_fd = AT_FDCWD;
+			}
+		}
+
+		meta_loader_t loader = {
+			.entries = view->dir_entry,
+			.map = indexes,
+			.dir_fd = dir_fd,
+		};
+		(void)par_for(count, par_nthreads(), &load_entry_meta,
+				/*poll_func=*/NULL, &loader);
+
+		if(dir_fd != AT_FDCWD)
+		{
+			close(dir_fd);
+		}
+
+		/* Failures are ignored here, file must have been removed and watcher will
+		 * report that. */
+		int i;
+		for(i = 0; i < count; ++i)
+		{
+			view->dir_entry[indexes[i]].tag = -1;
+		}
+	}
+
+	if(done)
+	{
+		view->meta_pending = 0;
+		if(sorting_needs_meta(view))
+		{
+			resort_dir_list(/*msg=*/0, view);
+		}
+	}
+
+	if(visible || done)
+	{
+		ui_view_schedule_redraw(view);
+	}
+
+	return !done;
+#else
+	return 0;
+#endif
+}
+
+int
+flist_is_loading(const view_t *view)
+{
+	return (view->loader != NULL || view->custom.loader != NULL);
+}
+
+void
+flist_finish_loading(view_t *view)
+{
+#ifndef _WIN32
+	take_streamed_paths(view);
+
+	dir_loader_t *const loader = view->loader;
+	if(loader == NULL)
+	{
+		return;
+	}
+
+	if(!dir_loader_finished(loader))
+	{
+		return;
+	}
+
+	view->loader = NULL;
+
+	/* Just in case, the list is of no use if location has changed. */
+	if(flist_custom_active(view) || stroscmp(loader->path, view->curr_dir) != 0)
+	{
+		free_dir_loader(loader);
+		return;
+	}
+
+	if(loader->error)
+	{
+		/* We don't have read access, only execute, or there were other problems. */
+		free_view_entries(view);
+		add_parent_dir(view);
+
+		if(view->unresponsive)
+		{
+			/* Accessibility of the directory wasn't checked on entering it. */
+			show_error_msgf("Directory Access Error", "Cannot open %s",
+					view->curr_dir);
+		}
+	}
+	else
+	{
+		apply_loaded_list(view, loader->entries, loader->nentries, loader->reload,
+				&loader->mon);
+		loader->entries = NULL;
+		loader->nentries = 0;
+	}
+
+	const int reload = loader->reload;
+	free_dir_loader(loader);
+
+	if(view->unresponsive)
+	{
+		/* Directory has responded, so it's safe to do what was skipped. */
+		view->unresponsive = 0;
+		if(view == curr_view)
+		{
+			(void)vifm_chdir(view->curr_dir);
+		}
+		update_dir_watcher(view);
+	}
+
+	fview_update_geometry(view);
+
+	if(!reload)
+	{
+		flist_hist_lookup(view, view);
+	}
+
+	fview_list_updated(view);
+	ui_view_schedule_redraw(view);
+#endif
+}
+
+void
+flist_cancel_loading(view_t *view)
+{
+#ifndef _WIN32
+	stop_loading(view);
+	stop_streaming(view, /*keep=*/1);
+#endif
+}
+
+void
+flist_prefetch(view_t *view, int start)
+{
+#ifndef _WIN32
+	char path[PATH_MAX + 1];
+	const int has_target = (get_prefetch_target(view, path, sizeof(path)) == 0);
+
+	dir_loader_t *const loader = view->prefetcher;
+	if(loader != NULL && (!has_target || stroscmp(loader->path, path) != 0))
+	{
+		/* Cursor has moved on. */
+		stop_prefetching(view);
+	}
+
+	if(view->prefetcher != NULL)
+	{
+		collect_prefetched(view);
+	}
+	else if(start && has_target && !flist_cache_has(path))
+	{
+		(void)start_prefetching(view, path);
+	}
+#endif
+}
+
+/* Checks whether directory responds to queries in a reasonable amount of time,
+ * leaving a worker thread behind if it doesn't.  Returns non-zero if so,
+ * otherwise zero is returned. */
+static int
+dir_responds(const char path[])
+{
+#ifndef _WIN32
+	/* Long enough to not be triggered by a loaded file system, but short enough
+	 * to not be annoying. */
+	enum { TIMEOUT_MS = 200 };
+
+	struct timespec deadline;
+	if(clock_gettime(CLOCK_REALTIME, &deadline) != 0)
+	{
+		return 1;
+	}
+	deadline.tv_nsec += TIMEOUT_MS*1000L*1000L;
+	deadline.tv_sec += deadline.tv_nsec/(1000L*1000L*1000L);
+	deadline.tv_nsec %= 1000L*1000L*1000L;
+
+	const size_t len = strlen(path);
+	dir_probe_t *const probe = malloc(sizeof(*probe) + len + 1U);
+	if(probe == NULL)
+	{
+		return 1;
+	}
+
+	probe->finished = 0;
+	probe->abandoned = 0;
+	memcpy(probe->path, path, len + 1U);
+
+	if(pthread_mutex_init(&probe->lock, NULL) != 0)
+	{
+		free(probe);
+		return 1;
+	}
+	if(pthread_cond_init(&probe->done, NULL) != 0)
+	{
+		pthread_mutex_destroy(&probe->lock);
+		free(probe);
+		return 1;
+	}
+
+	pthread_t id;
+	if(pthread_create(&id, NULL, &dir_probe_thread, probe) != 0)
+	{
+		free_dir_probe(probe);
+		return 1;
+	}
+	(void)pthread_detach(id);
+
+	pthread_mutex_lock(&probe->lock);
+	while(!probe->finished)
+	{
+		if(pthread_cond_timedwait(&probe->done, &probe->lock, &deadline) ==
+				ETIMEDOUT)
+		{
+			break;
+		}
+	}
+	const int finished = probe->finished;
+	probe->abandoned = !finished;
+	pthread_mutex_unlock(&probe->lock);
+
+	/* Otherwise worker thread will free the probe on exit. */
+	if(finished)
+	{
+		free_dir_probe(probe);
+	}
+	else
+	{
+		LOG_INFO_MSG("\"%s\" doesn't respond", path);
+	}
+	return finished;
+#else
+	return 1;
+#endif
+}
+
+#ifndef _WIN32
+
+/* Cancels reading current directory of the view in background if it's in
+ * progress. */
+static void
+stop_loading(view_t *view)
+{
+	dir_loader_t *const loader = view->loader;
+	if(loader != NULL)
+	{
+		view->loader = NULL;
+		cancel_dir_loader(loader);
+	}
+}
+
+/* Entry point of a thread that reads a directory.  Returns NULL. */
+static void *
+dir_loader_thread(void *arg)
+{
+	dir_loader_t *const loader = arg;
+
+	block_all_thread_signals();
+
+	const int error = read_dir_in_background(loader);
+
+	pthread_mutex_lock(&loader->lock);
+	loader->error = error;
+	loader->finished = 1;
+	const int cancelled = loader->cancelled;
+	pthread_mutex_unlock(&loader->lock);
+
+	if(cancelled || loader->detached)
+	{
+		free_dir_loader(loader);
+	}
+	return NULL;
+}
+
+/* Reads list of files of a directory along with their meta-data.  Checks for
+ * cancellation along the way.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+read_dir_in_background(dir_loader_t *loader)
+{
+	if(!loader->prefilled)
+	{
+		/* Changes that happen while we're reading should make snapshot stale. */
+		(void)filemon_from_file(loader->path, FMT_MODIFIED, &loader->mon);
+	}
+
+	DIR *const dir = os_opendir(loader->path);
+	if(dir == NULL)
+	{
+		LOG_SERROR_MSG(errno, "Can't opendir() \"%s\"", loader->path);
+		return 1;
+	}
+
+	struct dirent *d;
+	while(!loader->prefilled && !dir_loader_cancelled(loader) &&
+			(d = os_readdir(dir)) != NULL)
+	{
+		/* Always ignore the "." and ".." directories. */
+		if(strcmp(d->d_name, ".") == 0 || strcmp(d->d_name, "..") == 0)
+		{
+			continue;
+		}
+
+		if(loader->nentries == loader->max_entries && loader->max_entries != 0)
+		{
+			os_closedir(dir);
+			return 1;
+		}
+
+		dir_entry_t *const entry = alloc_dir_entry(&loader->entries,
+				loader->nentries);
+		if(entry == NULL)
+		{
+			os_closedir(dir);
+			return 1;
+		}
+
+		/* Type is determined from meta-data, which is always loaded here. */
+		fentry_init(loader->arena, entry, d->d_name);
+		++loader->nentries;
+	}
+
+	const int dir_fd = dirfd(dir);
+	meta_loader_t meta_loader = {
+		.entries = loader->entries,
+		.map = (loader->prefilled ? loader->pending : NULL),
+		.dir_fd = dir_fd,
+		.owner = loader,
+	};
+
+	const int nitems = (loader->prefilled ? loader->npending : loader->nentries);
+	if(dir_loader_cancelled(loader) ||
+			par_for(nitems, loader->nthreads, &load_entry_meta, &dir_loader_poll,
+				&meta_loader) != 0)
+	{
+		os_closedir(dir);
+		return 1;
+	}
+
+	int i, j = 0;
+	for(i = 0; i < loader->nentries; ++i)
+	{
+		dir_entry_t *const entry = &loader->entries[i];
+
+		if(entry->tag != 0)
+		{
+			LOG_ERROR_MSG("Can't query \"%s/%s\"", loader->path, entry->name);
+			fentry_free(entry);
+			continue;
+		}
+
+		entry->tag = -1;
+		if(entry->type == FT_LINK)
+		{
+			fill_link_info_at(entry, dir_fd);
+		}
+
+		if(i != j)
+		{
+			loader->entries[j] = *entry;
+		}
+		++j;
+	}
+	loader->nentries = j;
+
+	os_closedir(dir);
+
+	if(loader->snaps_dir != NULL && loader->nentries >= loader->snap_min &&
+			filemon_is_set(&loader->mon) && !dir_loader_cancelled(loader))
+	{
+		(void)flist_snap_save(loader->snaps_dir, loader->path, &loader->mon,
+				loader->entries, loader->nentries);
+	}
+
+	return 0;
+}
+
+/* par_for() callback that requests cancellation of loading meta-data if view
+ * has lost interest in it.  Returns non-zero to cancel. */
+static int
+dir_loader_poll(size_t ndone, void *arg)
+{
+	const meta_loader_t *const meta_loader = arg;
+	return dir_loader_cancelled(meta_loader->owner);
+}
+
+/* Checks whether reading of a directory was cancelled.  Returns non-zero if
+ * so, otherwise zero is returned. */
+static int
+dir_loader_cancelled(dir_loader_t *loader)
+{
+	pthread_mutex_lock(&loader->lock);
+	const int cancelled = loader->cancelled;
+	pthread_mutex_unlock(&loader->lock);
+	return cancelled;
+}
+
+/* Allocates loader of the directory, which reads it with a single thread and
+ * without limits by default.  Returns the loader or NULL on error. */
+static dir_loader_t *
+alloc_dir_loader(const char path[])
+{
+	dir_loader_t *const loader = calloc(1, sizeof(*loader));
+	if(loader == NULL)
+	{
+		return NULL;
+	}
+
+	loader->path = strdup(path);
+	loader->arena = str_arena_create();
+	loader->nthreads = 1;
+	if(loader->path == NULL || loader->arena == NULL ||
+			pthread_mutex_init(&loader->lock, NULL) != 0)
+	{
+		str_arena_free(loader->arena);
+		free(loader->path);
+		free(loader);
+		return NULL;
+	}
+
+	return loader;
+}
+
+/* Starts a worker thread for the loader.  The loader is freed on failure.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+launch_dir_loader(dir_loader_t *loader)
+{
+	pthread_t id;
+	if(pthread_create(&id, NULL, &dir_loader_thread, loader) != 0)
+	{
+		free_dir_loader(loader);
+		return 1;
+	}
+	(void)pthread_detach(id);
+	return 0;
+}
+
+/* Checks whether worker thread of the loader is done.  Returns non-zero if so,
+ * otherwise zero is returned. */
+static int
+dir_loader_finished(dir_loader_t *loader)
+{
+	pthread_mutex_lock(&loader->lock);
+	const int finished = loader->finished;
+	pthread_mutex_unlock(&loader->lock);
+	return finished;
+}
+
+/* Tells worker thread of the loader that its result isn't needed.  The loader
+ * shouldn't be used after this call. */
+static void
+cancel_dir_loader(dir_loader_t *loader)
+{
+	pthread_mutex_lock(&loader->lock);
+	loader->cancelled = 1;
+	const int finished = loader->finished;
+	pthread_mutex_unlock(&loader->lock);
+
+	/* Otherwise worker thread will free the loader on exit. */
+	if(finished)
+	{
+		free_dir_loader(loader);
+	}
+}
+
+/* Frees the loader along with all data it owns. */
+static void
+free_dir_loader(dir_loader_t *loader)
+{
+	free_dir_entries(&loader->entries, &loader->nentries);
+	str_arena_free(loader->arena);
+	pthread_mutex_destroy(&loader->lock);
+	free(loader->pending);
+	free(loader->snaps_dir);
+	free(loader->path);
+	free(loader);
+}
+
+/* Entry point of a thread that queries a directory on behalf of
+ * dir_responds().  Returns NULL. */
+static void *
+dir_probe_thread(void *arg)
+{
+	dir_probe_t *const probe = arg;
+
+	block_all_thread_signals();
+
+	/* This also caches information needed to enter the directory. */
+	struct stat s;
+	(void)os_stat(probe->path, &s);
+
+	pthread_mutex_lock(&probe->lock);
+	probe->finished = 1;
+	const int abandoned = probe->abandoned;
+	pthread_cond_signal(&probe->done);
+	pthread_mutex_unlock(&probe->lock);
+
+	if(abandoned)
+	{
+		free_dir_probe(probe);
+	}
+	return NULL;
+}
+
+/* Frees the probe. */
+static void
+free_dir_probe(dir_probe_t *probe)
+{
+	pthread_cond_destroy(&probe->done);
+	pthread_mutex_destroy(&probe->lock);
+	free(probe);
+}
+
+/* Determines directory under the cursor which is worth reading in advance.
+ * Returns zero and fills the buffer if there is one, otherwise non-zero is
+ * returned. */
+static int
+get_prefetch_target(view_t *view, char buf[], size_t buf_len)
+{
+	if(cfg.prefetch_max == 0 || cfg.list_cache_size == 0 ||
+			flist_is_loading(view))
+	{
+		return 1;
+	}
+
+	const dir_entry_t *const entry = get_current_entry(view);
+	if(entry == NULL || !fentry_is_valid(entry) || !fentry_is_dir(entry))
+	{
+		return 1;
+	}
+
+	/* Speculative requests to slow file systems would compete with requests the
+	 * user is waiting for. */
+	if(view->on_slow_fs || entry->slow_target)
+	{
+		return 1;
+	}
+
+	get_full_path_of(entry, buf_len, buf);
+
+	/* Entries of custom views can come from anywhere, otherwise list of mounts
+	 * needs to be consulted only if some of them are under current directory. */
+	if(!path_starts_with(entry->origin, flist_get_dir(view)) ||
+			view->slow_below)
+	{
+		return is_on_slow_fs(buf, cfg.slow_fs_list);
+	}
+	return 0;
+}
+
+/* Starts reading the directory in background.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+start_prefetching(view_t *view, const char path[])
+{
+	/* Creating watcher beforehand makes sure that no change goes unnoticed. */
+	fswatch_t *const watch = fswatch_create(path);
+	if(watch == NULL)
+	{
+		return 1;
+	}
+
+	dir_loader_t *const loader = alloc_dir_loader(path);
+	if(loader == NULL)
+	{
+		fswatch_free(watch);
+		return 1;
+	}
+
+	/* A single thread and a limit keep this from competing with the rest of the
+	 * application. */
+	loader->max_entries = cfg.prefetch_max;
+	if(launch_dir_loader(loader) != 0)
+	{
+		fswatch_free(watch);
+		return 1;
+	}
+
+	view->prefetcher = loader;
+	view->prefetch_watch = watch;
+	return 0;
+}
+
+/* Puts directory read in advance into cache of lists if reading is over. */
+static void
+collect_prefetched(view_t *view)
+{
+	dir_loader_t *const loader = view->prefetcher;
+	if(view->prefetch_watch == NULL || !dir_loader_finished(loader))
+	{
+		return;
+	}
+
+	if(loader->error)
+	{
+		fswatch_free(view->prefetch_watch);
+	}
+	else
+	{
+		flist_cache_put(loader->path, /*sig=*/NULL, &loader->mon,
+				view->prefetch_watch, loader->entries, loader->nentries,
+				/*filtered=*/0);
+		loader->entries = NULL;
+		loader->nentries = 0;
+	}
+
+	/* Loader is kept to not read the same directory again while cursor is on
+	 * it. */
+	view->prefetch_watch = NULL;
+
+	if(view->right_column.pending)
+	{
+		ui_view_schedule_redraw(view);
+	}
+}
+
+/* Cancels reading directory in advance if it's in progress. */
+static void
+stop_prefetching(view_t *view)
+{
+	if(view->prefetcher != NULL)
+	{
+		fswatch_free(view->prefetch_watch);
+		view->prefetch_watch = NULL;
+
+		cancel_dir_loader(view->prefetcher);
+		view->prefetcher = NULL;
+	}
+}
+
+/* Fills side column with entries of a directory read in advance or starts such
+ * reading.  Returns zero if the column is taken care of, otherwise non-zero is
+ * returned. */
+static int
+prefetch_column(view_t *view, cached_entries_t *cache, const char path[])
+{
+	flist_prefetch(view, /*start=*/1);
+
+	dir_loader_t *const loader = view->prefetcher;
+	if(loader == NULL || stroscmp(loader->path, path) != 0)
+	{
+		return 1;
+	}
+
+	if(view->prefetch_watch == NULL)
+	{
+		/* Reading is over, but its result is either gone or never existed. */
+		return fill_column_from_cache(view, cache, path);
+	}
+
+	/* Column will be filled on the next redraw after reading is done. */
+	cache->pending = 1;
+	return 0;
+}
+
+/* Entry point of a thread that reads output of a command.  Returns NULL. */
+static void *
+cv_loader_thread(void *arg)
+{
+	cv_loader_t *const loader = arg;
+
+	block_all_thread_signals();
+
+	if(!read_streamed_paths(loader))
+	{
+		stop_cv_command(loader);
+	}
+
+	/* Command that's still writing should get SIGPIPE. */
+	fclose(loader->out);
+	loader->out = NULL;
+
+	pthread_mutex_lock(&loader->lock);
+	loader->finished = 1;
+	const int cancelled = loader->cancelled;
+	pthread_mutex_unlock(&loader->lock);
+
+	if(cancelled)
+	{
+		free_cv_loader(loader);
+	}
+	return NULL;
+}
+
+/* Reads paths printed by a command and hands them over to the view in batches
+ * as they arrive.  Error stream of the command is drained at the same time to
+ * not let the command block on writing to it.  Checks for cancellation along
+ * the way even if the command prints nothing.  Returns non-zero if the command
+ * has closed its output, otherwise zero is returned. */
+static int
+read_streamed_paths(cv_loader_t *loader)
+{
+	/* Amount of data read at once, which also limits size of a batch. */
+	enum { CHUNK_SIZE = 64*1024 };
+	/* Interval of checking for cancellation in milliseconds. */
+	enum { CANCEL_CHECK_MS = 100 };
+
+	/* Like read_stream_lines() does for the whole output, paths are separated by
+	 * null characters if there are any in the first piece of the output and by
+	 * newlines otherwise.  -1 means that it's not known yet. */
+	int null_sep = -1;
+
+	/* Errors are collected in a file for the view to show them at the end. */
+	FILE *const errors = tmpfile();
+
+	struct pollfd fds[2] = {
+		{ .fd = fileno(loader->out), .events = POLLIN },
+		{ .fd = (loader->err == NULL ? -1 : fileno(loader->err)),
+		  .events = POLLIN },
+	};
+
+	char *text = NULL;
+	size_t len = 0U, capacity = 0U;
+	int closed = 0;
+	while(!closed && !cv_loader_cancelled(loader))
+	{
+		if(poll(fds, ARRAY_LEN(fds), CANCEL_CHECK_MS) < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			break;
+		}
+
+		if(fds[1].revents != 0 && read_streamed_errors(fds[1].fd, errors) != 0)
+		{
+			/* Negative descriptors are ignored by poll(). */
+			fds[1].fd = -1;
+		}
+
+		if(fds[0].revents == 0)
+		{
+			continue;
+		}
+
+		if(len + CHUNK_SIZE + 1U > capacity)
+		{
+			char *const new_text = realloc(text, len + CHUNK_SIZE + 1U);
+			if(new_text == NULL)
+			{
+				break;
+			}
+			text = new_text;
+			capacity = len + CHUNK_SIZE + 1U;
+		}
+
+		const ssize_t nread = read(fds[0].fd, text + len, CHUNK_SIZE);
+		if(nread < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if(nread <= 0)
+		{
+			closed = 1;
+			continue;
+		}
+
+		if(null_sep < 0)
+		{
+			if(memchr(text + len, '\0', nread) != NULL)
+			{
+				null_sep = 1;
+			}
+			else if(memchr(text + len, '\n', nread) != NULL ||
+					memchr(text + len, '\r', nread) != NULL)
+			{
+				null_sep = 0;
+			}
+		}
+		len += nread;
+
+		if(null_sep >= 0)
+		{
+			const size_t used = parse_cmd_output(loader, text, len, null_sep);
+			len -= used;
+			memmove(text, text + used, len);
+		}
+	}
+
+	if(len != 0U && !cv_loader_cancelled(loader))
+	{
+		/* The last path might lack a separator. */
+		text[len++] = (null_sep == 1 ? '\0' : '\n');
+		(void)parse_cmd_output(loader, text, len, null_sep == 1);
+	}
+
+	free(text);
+
+	/* Output is over, but error stream could have been inherited by a process
+	 * that's still running, so only what's already there is collected. */
+	while(fds[1].fd >= 0 && poll(&fds[1], 1, 0) > 0 &&
+			read_streamed_errors(fds[1].fd, errors) == 0)
+	{
+	}
+
+	if(loader->err != NULL)
+	{
+		fclose(loader->err);
+	}
+	loader->err = errors;
+	if(errors != NULL)
+	{
+		rewind(errors);
+	}
+
+	return closed;
+}
+
+/* Moves available data from the descriptor to the file, which can be NULL to
+ * discard the data.  Returns zero if more data might follow, otherwise
+ * non-zero is returned. */
+static int
+read_streamed_errors(int fd, FILE *errors)
+{
+	char buf[4096];
+	const ssize_t nread = read(fd, buf, sizeof(buf));
+	if(nread < 0)
+	{
+		return (errno != EINTR);
+	}
+	if(nread == 0)
+	{
+		return 1;
+	}
+
+	if(errors != NULL)
+	{
+		(void)fwrite(buf, 1, nread, errors);
+	}
+	return 0;
+}
+
+/* Makes the command stop by signaling its process group with increasingly
+ * forceful signals until the command closes its output. */
+static void
+stop_cv_command(cv_loader_t *loader)
+{
+	/* How long to wait for the command to react to a signal in milliseconds. */
+	enum { SIGNAL_TIMEOUT_MS = 1000 };
+
+	static const int signals[] = { SIGINT, SIGTERM, SIGKILL };
+
+	size_t i;
+	for(i = 0U; i < ARRAY_LEN(signals); ++i)
+	{
+		if(kill(-loader->pid, signals[i]) != 0)
+		{
+			LOG_SERROR_MSG(errno, "Failed to send signal %d to group %" PRINTF_ULL,
+					signals[i], (unsigned long long)loader->pid);
+			break;
+		}
+
+		if(wait_for_closed_output(fileno(loader->out), SIGNAL_TIMEOUT_MS))
+		{
+			break;
+		}
+	}
+}
+
+/* Discards data read from the descriptor until it's closed by the other end or
+ * timeout (in milliseconds) expires.  Returns non-zero if the descriptor got
+ * closed, otherwise zero is returned. */
+static int
+wait_for_closed_output(int fd, int timeout)
+{
+	struct timespec start;
+	if(clock_gettime(CLOCK_MONOTONIC, &start) != 0)
+	{
+		return 0;
+	}
+
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+	int left = timeout;
+	while(left > 0)
+	{
+		const int ready = poll(&pfd, 1, left);
+		if(ready < 0 && errno != EINTR)
+		{
+			return 0;
+		}
+		if(ready > 0 && read_streamed_errors(fd, /*errors=*/NULL) != 0)
+		{
+			return 1;
+		}
+
+		struct timespec now;
+		if(clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+		{
+			return 0;
+		}
+		left = timeout - (int)((now.tv_sec - start.tv_sec)*1000 +
+				(now.tv_nsec - start.tv_nsec)/1000000);
+	}
+	return 0;
+}
+
+/* Turns complete lines of the text into a batch of entries, which is then
+ * handed over to the view.  Returns number of consumed bytes. */
+static size_t
+parse_cmd_output(cv_loader_t *loader, char text[], size_t len, int null_sep)
+{
+	cv_batch_t batch = { .arena = str_arena_create() };
+	if(batch.arena == NULL)
+	{
+		return 0U;
+	}
+
+	size_t start = 0U;
+	size_t i;
+	for(i = 0U; i < len; ++i)
+	{
+		const int is_sep = null_sep ? (text[i] == '\0')
+		                            : (text[i] == '\n' || text[i] == '\r');
+		if(is_sep)
+		{
+			text[i] = '\0';
+			add_cmd_output_line(loader, &batch, &text[start]);
+			start = i + 1U;
+		}
+	}
+
+	publish_cv_batch(loader, &batch);
+	return start;
+}
+
+/* Parses a line of output of a command and adds a path it contains to the
+ * batch unless it's a duplicate. */
+static void
+add_cmd_output_line(cv_loader_t *loader, cv_batch_t *batch, const char line[])
+{
+	char *const path = parse_line_for_path(line, loader->cwd);
+	if(path == NULL)
 	{
-		/* Windows doesn't like returning size of directories when it can. */
-		entry->size = get_file_size(entry->name);
-		entry->type = FT_DIR;
+		return;
 	}
-	else if(is_win_executable(path))
+
+	char canonic_path[PATH_MAX + 1];
+	to_canonic_path(path, loader->cwd, canonic_path, sizeof(canonic_path));
+	free(path);
+
+	/* Don't add duplicates. */
+	if(trie_put(loader->paths, canonic_path) != 0)
 	{
-		entry->type = FT_EXEC;
+		return;
 	}
-	else
+
+	dir_entry_t *const entry = alloc_dir_entry(&batch->entries,
+			batch->nentries);
+	if(entry == NULL)
 	{
-		entry->type = FT_REG;
+		return;
 	}
 
-	return 0;
+	fentry_init(batch->arena, entry, get_last_path_component(canonic_path));
+	remove_last_path_component(canonic_path);
+	entry->origin = str_arena_intern(batch->arena, canonic_path);
+	entry->owns_origin = 1;
+
+	if(entry->name == NULL || entry->origin == NULL)
+	{
+		fentry_free(entry);
+		return;
+	}
+
+	++batch->nentries;
 }
 
-/* Checks whether file is a directory.  Returns non-zero if so, otherwise zero
- * is returned. */
+/* Loads meta-data of entries of the batch using several threads and passes the
+ * batch to the view.  Takes ownership of the batch. */
+static void
+publish_cv_batch(cv_loader_t *loader, cv_batch_t *batch)
+{
+	/* Starting a thread costs about as much as querying several local files. */
+	enum { MIN_FILES_PER_THREAD = 64 };
+
+	meta_loader_t meta_loader = {
+		.entries = batch->entries,
+		.map = NULL,
+		.dir_fd = AT_FDCWD,
+	};
+	const int nthreads = MIN(par_nthreads(),
+			1 + batch->nentries/MIN_FILES_PER_THREAD);
+	(void)par_for(batch->nentries, nthreads, &load_entry_meta,
+			/*poll_func=*/NULL, &meta_loader);
+
+	int i, j = 0;
+	for(i = 0; i < batch->nentries; ++i)
+	{
+		dir_entry_t *const entry = &batch->entries[i];
+
+		if(entry->tag != 0)
+		{
+			LOG_ERROR_MSG("Can't query \"%s/%s\"", entry->origin, entry->name);
+			fentry_free(entry);
+			continue;
+		}
+
+		entry->tag = -1;
+		if(i != j)
+		{
+			batch->entries[j] = *entry;
+		}
+		++j;
+	}
+	batch->nentries = j;
+
+	int published = 0;
+	if(batch->nentries != 0)
+	{
+		pthread_mutex_lock(&loader->lock);
+		cv_batch_t *const batches = reallocarray(loader->batches,
+				loader->nbatches + 1, sizeof(*batches));
+		if(batches != NULL)
+		{
+			loader->batches = batches;
+			loader->batches[loader->nbatches++] = *batch;
+			published = 1;
+		}
+		pthread_mutex_unlock(&loader->lock);
+	}
+
+	if(!published)
+	{
+		free_cv_batch(batch);
+	}
+}
+
+/* Checks whether populating custom view was cancelled.  Returns non-zero if
+ * so, otherwise zero is returned. */
 static int
-data_is_dir_entry(const WIN32_FIND_DATAW *ffd, const char path[])
+cv_loader_cancelled(cv_loader_t *loader)
 {
-	return (ffd->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+	pthread_mutex_lock(&loader->lock);
+	const int cancelled = loader->cancelled;
+	pthread_mutex_unlock(&loader->lock);
+	return cancelled;
+}
+
+/* Moves paths received from a command into custom view of the view and
+ * finishes populating it once the command is done. */
+static void
+take_streamed_paths(view_t *view)
+{
+	cv_loader_t *const loader = view->custom.loader;
+	if(loader == NULL)
+	{
+		return;
+	}
+
+	/* Changing the list under interactive filtering or visual selection would
+	 * confuse them. */
+	if(view->local_filter.in_progress ||
+			(view == curr_view && vle_mode_is(VISUAL_MODE)))
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&loader->lock);
+	cv_batch_t *const batches = loader->batches;
+	const int nbatches = loader->nbatches;
+	const int finished = loader->finished;
+	loader->batches = NULL;
+	loader->nbatches = 0;
+	pthread_mutex_unlock(&loader->lock);
+
+	apply_cv_batches(view, loader, batches, nbatches);
+
+	if(!finished)
+	{
+		return;
+	}
+
+	view->custom.loader = NULL;
+	/* To update title of the view. */
+	ui_view_schedule_redraw(view);
+
+	show_errors_from_file(loader->err, "Loading custom view");
+	loader->err = NULL;
+
+	if(!loader->shown)
+	{
+		show_error_msg("Custom view", "Ignoring empty list of files");
+	}
+
+	free_cv_loader(loader);
+}
+
+/* Adds entries of the batches to the view turning it into a custom view if
+ * it's not one yet.  Frees the batches. */
+static void
+apply_cv_batches(view_t *view, cv_loader_t *loader, cv_batch_t batches[],
+		int nbatches)
+{
+	int i, j;
+
+	if(nbatches == 0)
+	{
+		free(batches);
+		return;
+	}
+
+	if(!loader->shown)
+	{
+		free_dir_entries(&view->custom.entries, &view->custom.entry_count);
+		for(i = 0; i < nbatches; ++i)
+		{
+			for(j = 0; j < batches[i].nentries; ++j)
+			{
+				(void)add_streamed_entry(view, &view->custom.entries,
+						&view->custom.entry_count, &batches[i].entries[j]);
+			}
+		}
+
+		(void)replace_string(&view->custom.next_title, loader->title);
+		const CVType type = (loader->very ? CV_VERY : CV_REGULAR);
+		if(flist_custom_finish(view, type, /*allow_empty=*/0) == 0)
+		{
+			loader->shown = 1;
+			fpos_set_pos(view, 0);
+		}
+	}
+	else
+	{
+		/* Entries that don't pass local filter go only to the full list when it's
+		 * saved. */
+		const int saved = (view->custom.full.nentries != 0);
+		for(i = 0; i < nbatches; ++i)
+		{
+			for(j = 0; j < batches[i].nentries; ++j)
+			{
+				const dir_entry_t *const entry = &batches[i].entries[j];
+				if(saved)
+				{
+					(void)add_streamed_entry(view, &view->custom.full.entries,
+							&view->custom.full.nentries, entry);
+				}
+
+				if(saved && !local_filter_matches(view, entry))
+				{
+					++view->filtered;
+					continue;
+				}
+
+				(void)add_streamed_entry(view, &view->dir_entry, &view->list_rows,
+						entry);
+			}
+		}
+
+		if(!cv_unsorted(view->custom.type))
+		{
+			resort_dir_list(0, view);
+		}
+
+		fview_list_updated(view);
+		ui_view_schedule_redraw(view);
+	}
+
+	for(i = 0; i < nbatches; ++i)
+	{
+		free_cv_batch(&batches[i]);
+	}
+	free(batches);
+}
+
+/* Appends copy of an entry received from a command to the list.  Strings of the
+ * copy are allocated in the arena of the view.  Returns pointer to the added
+ * entry or NULL on error. */
+static dir_entry_t *
+add_streamed_entry(view_t *view, dir_entry_t **list, int *list_size,
+		const dir_entry_t *entry)
+{
+	dir_entry_t *const copy = alloc_dir_entry(list, *list_size);
+	if(copy == NULL)
+	{
+		return NULL;
+	}
+
+	*copy = *entry;
+	copy->name = copy_entry_str(view, copy, entry->name, /*intern=*/0);
+	copy->origin = copy_entry_str(view, copy, entry->origin, /*intern=*/1);
+	if(copy->name == NULL || copy->origin == NULL)
+	{
+		fentry_free(copy);
+		return NULL;
+	}
+
+	if(copy->type == FT_LINK)
+	{
+		char full_path[PATH_MAX + 1];
+		get_full_path_of(copy, sizeof(full_path), full_path);
+		/* This takes 'slowfs' into account, hence isn't done by the worker. */
+		fill_link_info(copy, full_path);
+	}
+
+	++*list_size;
+	return copy;
+}
+
+/* Stops populating custom view of the view with output of a command if it's in
+ * progress.  Non-zero keep adds paths received so far to the view. */
+static void
+stop_streaming(view_t *view, int keep)
+{
+	if(keep)
+	{
+		take_streamed_paths(view);
+	}
+
+	cv_loader_t *const loader = view->custom.loader;
+	if(loader != NULL)
+	{
+		view->custom.loader = NULL;
+		cancel_cv_loader(loader);
+	}
+}
+
+/* Tells worker thread of the loader that its result isn't needed, which makes
+ * it stop the command.  The loader shouldn't be used after this call. */
+static void
+cancel_cv_loader(cv_loader_t *loader)
+{
+	pthread_mutex_lock(&loader->lock);
+	loader->cancelled = 1;
+	const int finished = loader->finished;
+	pthread_mutex_unlock(&loader->lock);
+
+	/* Otherwise worker thread will free the loader after stopping the
+	 * command. */
+	if(finished)
+	{
+		free_cv_loader(loader);
+	}
+}
+
+/* Frees the loader along with all data it owns. */
+static void
+free_cv_loader(cv_loader_t *loader)
+{
+	int i;
+	for(i = 0; i < loader->nbatches; ++i)
+	{
+		free_cv_batch(&loader->batches[i]);
+	}
+	free(loader->batches);
+
+	if(loader->out != NULL)
+	{
+		fclose(loader->out);
+	}
+	if(loader->err != NULL)
+	{
+		fclose(loader->err);
+	}
+
+	trie_free(loader->paths);
+	pthread_mutex_destroy(&loader->lock);
+	free(loader->cwd);
+	free(loader->title);
+	free(loader);
+}
+
+/* Frees entries of the batch along with storage of their strings. */
+static void
+free_cv_batch(cv_batch_t *batch)
+{
+	free_dir_entries(&batch->entries, &batch->nentries);
+	str_arena_free(batch->arena);
+	batch->arena = NULL;
 }
 
 #endif
 
+/* Replaces file list of the view with unfiltered list of files of its current
+ * directory, which were read in background or from a snapshot.  Takes
+ * ownership of the entries. */
+static void
+apply_loaded_list(view_t *view, dir_entry_t *entries, int nentries, int reload,
+		const filemon_t *mon)
+{
+	dir_entry_t *prev_dir_entries;
+	int prev_list_rows;
+
+	start_dir_list_change(view, &prev_dir_entries, &prev_list_rows, reload);
+
+	/* Filters are applied here, because they could have changed while directory
+	 * was being read. */
+	view->filtered = 0;
+	int i, j = 0;
+	for(i = 0; i < nentries; ++i)
+	{
+		dir_entry_t *const entry = &entries[i];
+
+		if(!tree_candidate_is_visible(view, view->curr_dir, entry->name,
+					fentry_is_dir(entry), /*apply_local_filter=*/1))
+		{
+			++view->filtered;
+			fentry_free(entry);
+			continue;
+		}
+
+		entry->origin = &view->curr_dir[0];
+		entries[j++] = *entry;
+	}
+
+	view->dir_entry = entries;
+	view->list_rows = j;
+
+	if(cfg_parent_dir_is_visible(is_root_dir(view->curr_dir)) ||
+			view->list_rows == 0)
+	{
+		add_parent_dir(view);
+	}
+
+	sort_new_list(view, prev_dir_entries, prev_list_rows, !reload);
+
+	/* Merging must be performed after sorting so that list position remains fixed
+	 * (sorting doesn't preserve it). */
+	finish_dir_list_change(view, prev_dir_entries, prev_list_rows);
+
+	view->list_mon = *mon;
+}
+
 int
 flist_custom_finish(view_t *view, CVType type, int allow_empty)
 {
@@ -1105,8 +3012,7 @@ flist_custom_finish_internal(view_t *view, CVType type, int reload,
 		{
 			init_dir_entry(view, dir_entry, "..");
 			dir_entry->type = FT_DIR;
-			dir_entry->origin = strdup(dir);
-			dir_entry->owns_origin = 1;
+			(void)set_entry_origin(view, dir_entry, dir);
 			++view->custom.entry_count;
 		}
 	}
@@ -1401,8 +3307,11 @@ flist_custom_clone(view_t *to, const view_t *from, int as_tree)
 		}
 
 		dst[j] = src[i];
-		dst[j].name = strdup(dst[j].name);
-		dst[j].origin = (dst[j].owns_origin ? strdup(dst[j].origin) : to->curr_dir);
+		dst[j].in_arena = 1;
+		dst[j].name = copy_entry_str(to, &dst[j], dst[j].name, /*intern=*/0);
+		dst[j].origin = (dst[j].owns_origin
+		               ? copy_entry_str(to, &dst[j], dst[j].origin, /*intern=*/1)
+		               : to->curr_dir);
 
 		if(!dst_is_tree)
 		{
@@ -1420,6 +3329,8 @@ flist_custom_clone(view_t *to, const view_t *from, int as_tree)
 	free_dir_entries(&to->dir_entry, &to->list_rows);
 	to->dir_entry = dst;
 	to->list_rows = j;
+	to->meta_pending = from->meta_pending;
+	to->meta_pending_pos = from->meta_pending_pos;
 
 	to->filtered = 0;
 
@@ -1563,19 +3474,33 @@ entry_from_path(view_t *view, dir_entry_t *entries, int count,
 			sizeof(canonic_path));
 
 	fname = get_last_path_component(canonic_path);
-	for(i = 0; i < count; ++i)
-	{
-		char full_path[PATH_MAX + 1];
-		dir_entry_t *const entry = &entries[i];
 
-		if(stroscmp(entry->name, fname) != 0)
+	const int indexed = (entries == view->dir_entry && count == view->list_rows);
+	const flist_index_t *const index = (indexed ? flist_index_of(view) : NULL);
+	if(index != NULL)
+	{
+		int iter = 0;
+		int pos;
+		while((pos = flist_index_next(index, fname, &iter)) != -1)
 		{
-			continue;
+			if(is_entry_at(&entries[pos], canonic_path))
+			{
+				return &entries[pos];
+			}
 		}
+	}
 
-		get_full_path_of(entry, sizeof(full_path), full_path);
-		if(stroscmp(full_path, canonic_path) == 0)
+	/* Entries might have been changed in place after the index was built, so
+	 * don't trust its negative answer. */
+	for(i = 0; i < count; ++i)
+	{
+		dir_entry_t *const entry = &entries[i];
+		if(stroscmp(entry->name, fname) == 0 && is_entry_at(entry, canonic_path))
 		{
+			if(index != NULL)
+			{
+				flist_index_reset(view);
+			}
 			return entry;
 		}
 	}
@@ -1583,6 +3508,15 @@ entry_from_path(view_t *view, dir_entry_t *entries, int count,
 	return NULL;
 }
 
+/* Checks whether entry corresponds to the path.  Returns non-zero if so. */
+static int
+is_entry_at(const dir_entry_t *entry, const char path[])
+{
+	char full_path[PATH_MAX + 1];
+	get_full_path_of(entry, sizeof(full_path), full_path);
+	return (stroscmp(full_path, path) == 0);
+}
+
 uint64_t
 fentry_get_nitems(const view_t *view, const dir_entry_t *entry)
 {
@@ -1711,6 +3645,27 @@ populate_dir_list_internal(view_t *view, int reload)
 {
 	char *saved_cwd;
 
+	if(reload)
+	{
+		/* List is about to be replaced by the list of the current directory. */
+		update_string(&view->cache_sig, NULL);
+	}
+	else
+	{
+		cache_list(view);
+	}
+
+	/* Whatever was being read in background is out of date now. */
+#ifndef _WIN32
+	stop_loading(view);
+	if(!reload && !flist_custom_active(view))
+	{
+		/* Navigation cancels custom view that hasn't received any paths yet,
+		 * otherwise the first paths would replace the new location. */
+		stop_streaming(view, /*keep=*/0);
+	}
+#endif
+
 	view->filtered = 0;
 
 	/* List reload usually implies that something related to file list has
@@ -1727,7 +3682,14 @@ populate_dir_list_internal(view_t *view, int reload)
 		return populate_custom_view(view, reload);
 	}
 
-	if(!reload && is_dir_big(view->curr_dir) && !modes_is_cmdline_like())
+	/* Anything done synchronously with a directory that doesn't respond hangs
+	 * user interface. */
+	view->unresponsive = view->unresponsive || (view->on_slow_fs &&
+			curr_stats.load_stage >= 3 && !dir_responds(view->curr_dir));
+	const int unresponsive = view->unresponsive;
+
+	if(!reload && !unresponsive && is_dir_big(view->curr_dir) &&
+			!modes_is_cmdline_like())
 	{
 		ui_sb_quick_msgf("%s", "Reading directory...");
 	}
@@ -1739,7 +3701,8 @@ populate_dir_list_internal(view_t *view, int reload)
 
 	saved_cwd = save_cwd();
 	/* this is needed for lstat() below */
-	if(vifm_chdir(view->curr_dir) != 0 && !is_unc_root(view->curr_dir))
+	if(!unresponsive && vifm_chdir(view->curr_dir) != 0 &&
+			!is_unc_root(view->curr_dir))
 	{
 		LOG_SERROR_MSG(errno, "Can't chdir() into \"%s\"", view->curr_dir);
 		restore_cwd(saved_cwd);
@@ -1747,13 +3710,18 @@ populate_dir_list_internal(view_t *view, int reload)
 	}
 
 	/* If directory didn't change. */
-	if(view->watch != NULL && view->watched_dir != NULL &&
+	if(!unresponsive && view->watch != NULL && view->watched_dir != NULL &&
 			stroscmp(view->watched_dir, view->curr_dir) == 0)
 	{
 		/* Drain all events that happened before this point. */
 		(void)poll_watcher(view->watch, view->curr_dir);
 	}
 
+	/* Snapshot of a newly visited directory is made out of its listing. */
+	const int snapshot = !reload && cfg.snapshot_min > 0 &&
+		curr_stats.load_stage > 0;
+	strlist_t filtered = {};
+
 	if(is_unc_root(view->curr_dir))
 	{
 #ifdef _WIN32
@@ -1771,7 +3739,7 @@ populate_dir_list_internal(view_t *view, int reload)
 					"Can't load list of shares of %s", view->curr_dir);
 
 			leave_invalid_dir(view);
-			if(update_dir_list(view, reload) != 0)
+			if(update_dir_list(view, reload, /*filtered=*/NULL) != 0)
 			{
 				/* We don't have read access, only execute, or there were other
 				 * problems. */
@@ -1781,12 +3749,44 @@ populate_dir_list_internal(view_t *view, int reload)
 		}
 #endif
 	}
-	else if(update_dir_list(view, reload) != 0)
+	else if(unresponsive)
+	{
+		if(start_loading(view, reload) != 0)
+		{
+			free_view_entries(view);
+			add_parent_dir(view);
+		}
+	}
+	else if(!reload && restore_cached_list(view) == 0)
+	{
+		/* List of recently visited directory is still up to date. */
+	}
+	else if(!reload && load_snapshot(view) == 0)
+	{
+		/* Snapshot is being reconciled with the directory in background. */
+	}
+	else if(view->on_slow_fs && curr_stats.load_stage >= 3 &&
+			start_loading(view, reload) == 0)
+	{
+		/* File list will be replaced by flist_finish_loading(). */
+	}
+	else if(update_dir_list(view, reload, (snapshot ? &filtered : NULL)) != 0)
 	{
 		/* We don't have read access, only execute, or there were other problems. */
 		free_view_entries(view);
 		add_parent_dir(view);
 	}
+	else if(snapshot && view->list_rows + view->filtered >= cfg.snapshot_min)
+	{
+		/* Names of files that were filtered out by their meta-data aren't known,
+		 * in which case snapshot is made by reading the directory once more. */
+		if(filtered.nitems != view->filtered ||
+				start_snapshotting(view, &filtered) != 0)
+		{
+			(void)start_loading(view, /*reload=*/1);
+		}
+	}
+	free_string_array(filtered.items, filtered.nitems);
 
 	if(!reload && !modes_is_cmdline_like())
 	{
@@ -1826,7 +3826,10 @@ populate_dir_list_internal(view_t *view, int reload)
 	 * update will happen anyway afterwards.  We shouldn't drain change event
 	 * here, because it makes it possible to skip an update (when directory was
 	 * changed while we were reading from it). */
-	update_dir_watcher(view);
+	if(!unresponsive)
+	{
+		update_dir_watcher(view);
+	}
 
 	if(view->location_changed)
 	{
@@ -2005,7 +4008,7 @@ zap_compare_view(view_t *view, view_t *other, zap_filter filter, void *arg)
 				}
 				continue;
 			}
-			replace_string(&entry->name, "");
+			(void)fentry_set_name(view, entry, "");
 			entry->type = FT_UNK;
 			entry->id = other->dir_entry[i].id;
 		}
@@ -2207,8 +4210,8 @@ zap_entries(view_t *view, dir_entry_t *entries, int *count, zap_filter filter,
 			char *path = format_str("%s/..", full_path);
 			init_parent_entry(view, &entries[j], path);
 			remove_last_path_component(path);
-			entries[j].origin = path;
-			entries[j].owns_origin = 1;
+			(void)set_entry_origin(view, &entries[j], path);
+			free(path);
 			entries[j].child_pos = 1;
 
 			/* Since we are now adding back one entry, increase parent counts and
@@ -2287,24 +4290,374 @@ static void
 free_view_entries(view_t *view)
 {
 	free_dir_entries(&view->dir_entry, &view->list_rows);
+	flist_index_reset(view);
 }
 
-/* Updates file list with files from current directory.  Returns zero on
- * success, otherwise non-zero is returned. */
+/* Remembers how list of the view is filtered and sorted before leaving its
+ * directory, because that can change before the list is put into cache. */
+static void
+prepare_list_caching(view_t *view)
+{
+	if(view->cache_sig != NULL || !filemon_is_set(&view->list_mon) ||
+			flist_custom_active(view) || view->meta_pending ||
+			flist_is_loading(view))
+	{
+		return;
+	}
+
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		/* Lists that include files from elsewhere can't be cached. */
+		if(view->dir_entry[i].owns_origin)
+		{
+			return;
+		}
+	}
+
+	view->cache_sig = make_list_sig(view);
+}
+
+/* Builds description of how list of the view is filtered and sorted.  Returns
+ * newly allocated string or NULL on error. */
+static char *
+make_list_sig(const view_t *view)
+{
+	char sort[SK_COUNT*5 + 1];
+	size_t len = 0U;
+	int i;
+	for(i = 0; i < SK_COUNT; ++i)
+	{
+		len += snprintf(sort + len, sizeof(sort) - len, "%d,", view->sort[i]);
+	}
+
+	const char *const manual_filter = (view->manual_filter == NULL)
+	                                ? ""
+	                                : matcher_get_expr(view->manual_filter);
+
+	return format_str("%d\n%d\n%d\n%d\n%s\n%s\n%s\n%s\n%s", view->hide_dot,
+			view->invert, cfg.dot_dirs, cfg.sort_numbers, sort,
+			view->sort_groups == NULL ? "" : view->sort_groups, manual_filter,
+			view->auto_filter.raw == NULL ? "" : view->auto_filter.raw,
+			view->local_filter.filter.raw == NULL ? "" :
+			view->local_filter.filter.raw);
+}
+
+/* Puts list of the view into cache if it was prepared for that on leaving its
+ * directory. */
+static void
+cache_list(view_t *view)
+{
+	char *const sig = view->cache_sig;
+	view->cache_sig = NULL;
+
+	if(sig == NULL || view->watch == NULL || view->watched_dir == NULL ||
+			stroscmp(view->watched_dir, view->curr_dir) == 0 ||
+			!filemon_is_set(&view->list_mon) || view->list_rows == 0 ||
+			fswatch_poll(view->watch) != FSWS_UNCHANGED)
+	{
+		free(sig);
+		return;
+	}
+
+	/* Selection and search matches are specific to a visit. */
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		dir_entry_t *const entry = &view->dir_entry[i];
+		entry->selected = 0;
+		entry->was_selected = 0;
+		entry->marked = 0;
+		entry->search_match = 0;
+	}
+
+	flist_cache_put(view->watched_dir, sig, &view->list_mon, view->watch,
+			view->dir_entry, view->list_rows, view->filtered);
+	free(sig);
+
+	view->watch = NULL;
+	update_string(&view->watched_dir, NULL);
+	view->dir_entry = NULL;
+	view->list_rows = 0;
+	view->selected_files = 0;
+	view->matches = 0;
+	filemon_reset(&view->list_mon);
+}
+
+/* Fills the view with cached list of its current directory if it's still up to
+ * date.  Returns zero on success, otherwise non-zero is returned. */
+static int
+restore_cached_list(view_t *view)
+{
+	char *const sig = make_list_sig(view);
+	if(sig == NULL)
+	{
+		return 1;
+	}
+
+	filemon_t mon;
+	fswatch_t *watch;
+	dir_entry_t *entries;
+	int nentries, filtered, unfiltered;
+	const int error = flist_cache_take(view->curr_dir, sig, &mon, &watch,
+			&entries, &nentries, &filtered, &unfiltered);
+	free(sig);
+	if(error)
+	{
+		return 1;
+	}
+
+	if(unfiltered)
+	{
+		/* The list was read in advance. */
+		apply_loaded_list(view, entries, nentries, /*reload=*/0, &mon);
+	}
+	else
+	{
+		dir_entry_t *prev_dir_entries;
+		int prev_list_rows;
+		start_dir_list_change(view, &prev_dir_entries, &prev_list_rows,
+				/*reload=*/0);
+
+		int i;
+		for(i = 0; i < nentries; ++i)
+		{
+			entries[i].origin = &view->curr_dir[0];
+		}
+
+		view->dir_entry = entries;
+		view->list_rows = nentries;
+		view->filtered = filtered;
+		finish_dir_list_change(view, prev_dir_entries, prev_list_rows);
+	}
+
+	fswatch_free(view->watch);
+	view->watch = watch;
+	replace_string(&view->watched_dir, view->curr_dir);
+
+	view->list_mon = mon;
+	return 0;
+}
+
+/* Fills the view with files from snapshot of its current directory and starts
+ * reconciling it with the directory in background.  Snapshot is always
+ * reconciled, because state of the directory doesn't reflect changes of
+ * meta-data of its files.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+load_snapshot(view_t *view)
+{
+#ifndef _WIN32
+	if(cfg.snapshot_min == 0 || curr_stats.load_stage <= 0)
+	{
+		return 1;
+	}
+
+	filemon_t snap_mon;
+	dir_entry_t *entries;
+	int nentries;
+	if(flist_snap_load(cfg.snapshots_dir, view->curr_dir, get_arena(view),
+				&snap_mon, &entries, &nentries) != 0)
+	{
+		return 1;
+	}
+
+	apply_loaded_list(view, entries, nentries, /*reload=*/0, &snap_mon);
+
+	if(start_loading(view, /*reload=*/1) != 0)
+	{
+		if(update_dir_list(view, /*reload=*/1, /*filtered=*/NULL) != 0)
+		{
+			free_view_entries(view);
+			add_parent_dir(view);
+		}
+	}
+
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+/* Starts reading current directory of the view in background to not block user
+ * interface while waiting for a slow file system.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+start_loading(view_t *view, int reload)
+{
+#ifndef _WIN32
+	dir_loader_t *const loader = alloc_dir_loader(view->curr_dir);
+	if(loader == NULL)
+	{
+		return 1;
+	}
+
+	loader->reload = reload;
+	/* Requests to slow file systems are mostly waiting, hence as many threads as
+	 * possible. */
+	loader->nthreads = par_nthreads();
+	if(cfg.snapshot_min > 0)
+	{
+		loader->snaps_dir = strdup(cfg.snapshots_dir);
+		loader->snap_min = cfg.snapshot_min;
+	}
+
+	if(launch_dir_loader(loader) != 0)
+	{
+		return 1;
+	}
+
+	view->loader = loader;
+
+	/* Reload keeps displaying current list until the new one is ready, but
+	 * files of previous location shouldn't be shown. */
+	if(!reload)
+	{
+		free_view_entries(view);
+		add_parent_dir(view);
+	}
+
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+/* Starts saving snapshot of current directory of the view out of its list of
+ * files, which was just read.  filtered lists names of files that were
+ * filtered out, their meta-data is loaded along with meta-data that was
+ * postponed.  Returns zero on success, otherwise non-zero is returned. */
+static int
+start_snapshotting(view_t *view, const strlist_t *filtered)
+{
+#ifndef _WIN32
+	dir_loader_t *const loader = alloc_dir_loader(view->curr_dir);
+	if(loader == NULL)
+	{
+		return 1;
+	}
+
+	loader->detached = 1;
+	loader->prefilled = 1;
+	loader->nthreads = par_nthreads();
+	loader->snaps_dir = strdup(cfg.snapshots_dir);
+	loader->snap_min = cfg.snapshot_min;
+	loader->mon = view->list_mon;
+
+	const int total = view->list_rows + filtered->nitems;
+	loader->entries = dynarray_extend(NULL, total*sizeof(*loader->entries));
+	loader->pending = reallocarray(NULL, total, sizeof(*loader->pending));
+	if(loader->snaps_dir == NULL || loader->entries == NULL ||
+			loader->pending == NULL)
+	{
+		free_dir_loader(loader);
+		return 1;
+	}
+
+	int i;
+	for(i = 0; i < total; ++i)
+	{
+		const int is_filtered = (i >= view->list_rows);
+		const dir_entry_t *const src = (is_filtered ? NULL : &view->dir_entry[i]);
+		const char *const name = (is_filtered
+		                        ? filtered->items[i - view->list_rows]
+		                        : src->name);
+		if(!is_filtered && is_parent_dir(name))
+		{
+			continue;
+		}
+
+		dir_entry_t *const entry = &loader->entries[loader->nentries];
+		fentry_init(loader->arena, entry, name);
+		if(entry->name == NULL)
+		{
+			free_dir_loader(loader);
+			return 1;
+		}
+
+		if(is_filtered || src->meta_pending)
+		{
+			loader->pending[loader->npending++] = loader->nentries;
+		}
+
+		if(!is_filtered)
+		{
+			entry->size = src->size;
+			entry->uid = src->uid;
+			entry->gid = src->gid;
+			entry->mode = src->mode;
+			entry->inode = src->inode;
+			entry->mtime = src->mtime;
+			entry->atime = src->atime;
+			entry->ctime = src->ctime;
+			entry->type = src->type;
+			entry->nlinks = src->nlinks;
+			entry->dir_link = src->dir_link;
+			entry->slow_target = src->slow_target;
+			entry->tag = 0;
+		}
+
+		++loader->nentries;
+	}
+
+	return launch_dir_loader(loader);
+#else
+	return 1;
+#endif
+}
+
+/* Updates file list with files from current directory.  Names of files that
+ * were filtered out are appended to the filtered list, if it's not NULL.
+ * Returns zero on success, otherwise non-zero is returned. */
 static int
-update_dir_list(view_t *view, int reload)
+update_dir_list(view_t *view, int reload, strlist_t *filtered)
 {
 	dir_entry_t *prev_dir_entries;
 	int prev_list_rows;
 
 	start_dir_list_change(view, &prev_dir_entries, &prev_list_rows, reload);
 
+	/* Changes that happen while we're reading should make cached list stale. */
+	filemon_t mon;
+	(void)filemon_from_file(view->curr_dir, FMT_MODIFIED, &mon);
+
+#ifndef _WIN32
+	/* Not using enum_dir_content() to be able to use descriptor of the directory
+	 * while it's open. */
+	DIR *const dir = os_opendir(view->curr_dir);
+	if(dir == NULL)
+	{
+		LOG_SERROR_MSG(errno, "Can't opendir() \"%s\"", view->curr_dir);
+		free_dir_entries(&prev_dir_entries, &prev_list_rows);
+		return 1;
+	}
+
+	struct dirent *d;
+	while((d = os_readdir(dir)) != NULL)
+	{
+		const int filtered_before = view->filtered;
+		if(add_file_entry_to_view(d->d_name, d, view) != 0)
+		{
+			break;
+		}
+
+		if(filtered != NULL && view->filtered != filtered_before)
+		{
+			filtered->nitems = add_to_string_array(&filtered->items,
+					filtered->nitems, d->d_name);
+		}
+	}
+
+	load_entries_meta(view, dirfd(dir), 0);
+	os_closedir(dir);
+#else
 	if(enum_dir_content(view->curr_dir, &add_file_entry_to_view, view) != 0)
 	{
 		LOG_SERROR_MSG(errno, "Can't opendir() \"%s\"", view->curr_dir);
 		free_dir_entries(&prev_dir_entries, &prev_list_rows);
 		return 1;
 	}
+#endif
 
 	if(cfg_parent_dir_is_visible(is_root_dir(view->curr_dir)) ||
 			view->list_rows == 0)
@@ -2312,12 +4665,13 @@ update_dir_list(view_t *view, int reload)
 		add_parent_dir(view);
 	}
 
-	sort_dir_list(!reload, view);
+	sort_new_list(view, prev_dir_entries, prev_list_rows, !reload);
 
 	/* Merging must be performed after sorting so that list position remains fixed
 	 * (sorting doesn't preserve it). */
 	finish_dir_list_change(view, prev_dir_entries, prev_list_rows);
 
+	view->list_mon = mon;
 	return 0;
 }
 
@@ -2342,6 +4696,8 @@ start_dir_list_change(view_t *view, dir_entry_t **entries, int *len, int reload)
 
 	view->matches = 0;
 	view->selected_files = 0;
+	view->meta_pending = 0;
+	filemon_reset(&view->list_mon);
 }
 
 /* Finishes file list update, possibly merging information from old entries into
@@ -2374,7 +4730,17 @@ add_file_entry_to_view(const char name[], const void *data, void *param)
 		return 0;
 	}
 
-	if(!entry_is_visible(view, name, data))
+#ifndef _WIN32
+	/* Visibility of files of unknown type depends on whether they are
+	 * directories, it's checked by load_entries_meta() once their meta-data is
+	 * loaded instead of querying them one by one here. */
+	const int type_known = dirent_type_is_known(data);
+	const int visible = type_known ? entry_is_visible(view, name, data)
+	                               : !(view->hide_dot && name[0] == '.');
+#else
+	const int visible = entry_is_visible(view, name, data);
+#endif
+	if(!visible)
 	{
 		++view->filtered;
 		return 0;
@@ -2389,6 +4755,12 @@ add_file_entry_to_view(const char name[], const void *data, void *param)
 
 	init_dir_entry(view, entry, name);
 
+#ifndef _WIN32
+	/* The rest of meta-data is loaded by load_entries_meta() for all files at
+	 * once. */
+	entry->type = type_known ? type_from_dir_entry(data, entry->name) : FT_UNK;
+	++view->list_rows;
+#else
 	if(fill_dir_entry(entry, entry->name, data) == 0)
 	{
 		++view->list_rows;
@@ -2397,6 +4769,7 @@ add_file_entry_to_view(const char name[], const void *data, void *param)
 	{
 		fentry_free(entry);
 	}
+#endif
 
 	return 0;
 }
@@ -2438,6 +4811,41 @@ sort_dir_list(int msg, view_t *view)
 	}
 }
 
+/* Sorts list of the view that has just been read reusing order of its previous
+ * version if there is one and only a small part of entries has changed.  msg
+ * parameter controls whether to show "Sorting..." status bar message. */
+static void
+sort_new_list(view_t *view, const dir_entry_t prev[], int prev_len, int msg)
+{
+	if(prev == NULL || view->list_rows == 0 || flist_custom_active(view))
+	{
+		sort_dir_list(msg, view);
+		return;
+	}
+
+	int done = 0;
+	int *const prev_pos = reallocarray(NULL, view->list_rows, sizeof(*prev_pos));
+	flist_index_t *const prev_index = flist_index_create(prev, prev_len);
+	if(prev_pos != NULL && prev_index != NULL)
+	{
+		int i;
+		for(i = 0; i < view->list_rows; ++i)
+		{
+			prev_pos[i] = flist_index_find(prev_index, view->dir_entry[i].name,
+					/*dir=*/NULL);
+		}
+
+		done = (sort_view_incremental(view, prev, prev_len, prev_pos) == 0);
+	}
+	flist_index_free(prev_index);
+	free(prev_pos);
+
+	if(!done)
+	{
+		sort_dir_list(msg, view);
+	}
+}
+
 /* Merges elements from previous list into the new one. */
 static void
 merge_lists(view_t *view, dir_entry_t *entries, int len)
@@ -2445,39 +4853,33 @@ merge_lists(view_t *view, dir_entry_t *entries, int len)
 	int i;
 	int closest_dist;
 	const int prev_pos = view->list_pos;
-	trie_t *prev_names = trie_create(/*free_func=*/NULL);
-
-	for(i = 0; i < len; ++i)
-	{
-		add_to_trie(prev_names, view, &entries[i]);
-
-		/* We won't use the name later, so free some memory. */
-		update_string(&entries[i].name, NULL);
-	}
+	const int custom = flist_custom_active(view);
+	flist_index_t *const prev_index = flist_index_create(entries, len);
 
 	closest_dist = INT_MIN;
-	for(i = 0; i < view->list_rows; ++i)
+	for(i = 0; i < view->list_rows && prev_index != NULL; ++i)
 	{
 		int dist;
-		void *data;
 		dir_entry_t *const entry = &view->dir_entry[i];
-		if(!is_in_trie(prev_names, view, entry, &data))
+		const int pos = flist_index_find(prev_index, entry->name,
+				custom ? entry->origin : NULL);
+		if(pos == -1)
 		{
 			continue;
 		}
 
 		/* Transfer information from previous entry to the new one. */
-		merge_entries(entry, data);
+		merge_entries(entry, &entries[pos]);
 
 		/* Update number of selected files (should have been zeroed beforehand). */
 		view->selected_files += (entry->selected != 0);
 
 		/* Update cursor position in a smart way. */
-		dist = (dir_entry_t *)data - entries - prev_pos;
+		dist = pos - prev_pos;
 		closest_dist = correct_pos(view, i, dist, closest_dist);
 	}
 
-	trie_free(prev_names);
+	flist_index_free(prev_index);
 }
 
 /* Checks that entries don't have the same name (for non-cv).  And if there are
@@ -2486,74 +4888,45 @@ merge_lists(view_t *view, dir_entry_t *entries, int len)
 TSTATIC void
 check_file_uniqueness(view_t *view)
 {
-	trie_t *file_names = trie_create(/*free_func=*/NULL);
+	const int custom = flist_custom_active(view);
+	flist_index_t *const index = flist_index_create(view->dir_entry,
+			view->list_rows);
 
 	int had_dups = view->has_dups;
 
 	int i;
-	for(i = 0; i < view->list_rows; ++i)
-	{
-		add_to_trie(file_names, view, &view->dir_entry[i]);
-	}
-
-	trie_free(file_names);
-
-	if(view->has_dups)
+	for(i = 0; i < view->list_rows && index != NULL; ++i)
 	{
-		(void)exclude_temporary_entries(view);
-		if(!had_dups)
+		dir_entry_t *const entry = &view->dir_entry[i];
+		if(flist_index_find(index, entry->name, /*dir=*/NULL) == i)
 		{
-			show_error_msg("Broken File System", "Underlying file system seems to "
-					"report duplicated file names.  Only one entry will be shown.");
+			continue;
 		}
-	}
-}
-
-/* Adds view entry into the trie mapping its name to entry structure.
- * Duplicated entries of a non-custom view are marked as temporary. */
-static void
-add_to_trie(trie_t *trie, view_t *view, dir_entry_t *entry)
-{
-	if(flist_custom_active(view))
-	{
-		char full_path[PATH_MAX + 1];
-		get_full_path_of(entry, sizeof(full_path), full_path);
 
-		int error = trie_set(trie, full_path, entry);
-		assert(error == 0 && "Duplicated file names in the list?");
-		(void)error;
-		return;
-	}
+		if(custom)
+		{
+			assert(flist_index_find(index, entry->name, entry->origin) == i &&
+					"Duplicated file names in the list?");
+			continue;
+		}
 
-	if(trie_set(trie, entry->name, entry) != 0)
-	{
 		LOG_INFO_MSG("Duplicated entry is `%s` in `%s`", entry->name,
 				entry->origin);
 		entry->temporary = 1;
 		view->has_dups = 1;
 	}
-}
-
-/* Looks up entry in the trie by its name.  Retrieves directory entry stored by
- * add_to_trie() into *data (unchanged on lookup failure).  Returns non-zero if
- * item was successfully retrieved and zero otherwise. */
-static int
-is_in_trie(trie_t *trie, view_t *view, dir_entry_t *entry, void **data)
-{
-	int error;
-
-	if(flist_custom_active(view))
-	{
-		char full_path[PATH_MAX + 1];
-		get_full_path_of(entry, sizeof(full_path), full_path);
-		error = trie_get(trie, full_path, data);
-	}
-	else
-	{
-		error = trie_get(trie, entry->name, data);
-	}
 
-	return (error == 0);
+	flist_index_free(index);
+
+	if(view->has_dups)
+	{
+		(void)exclude_temporary_entries(view);
+		if(!had_dups)
+		{
+			show_error_msg("Broken File System", "Underlying file system seems to "
+					"report duplicated file names.  Only one entry will be shown.");
+		}
+	}
 }
 
 /* Merges data from previous entry into the new one.  Both entries should
@@ -2652,8 +5025,15 @@ add_parent_entry(view_t *view, dir_entry_t **entries, int *count)
 static void
 init_dir_entry(view_t *view, dir_entry_t *entry, const char name[])
 {
-	entry->name = strdup(name);
+	fentry_init(get_arena(view), entry, name);
 	entry->origin = &view->curr_dir[0];
+}
+
+void
+fentry_init(str_arena_t *arena, dir_entry_t *entry, const char name[])
+{
+	entry->name = str_arena_dup(arena, name);
+	entry->origin = NULL;
 
 	entry->size = 0ULL;
 #ifndef _WIN32
@@ -2687,6 +5067,8 @@ init_dir_entry(view_t *view, dir_entry_t *entry, const char name[])
 	entry->temporary = 0;
 	entry->owns_origin = 0;
 	entry->folded = 0;
+	entry->meta_pending = 0;
+	entry->in_arena = 1;
 
 	entry->tag = -1;
 	entry->id = -1;
@@ -2712,8 +5094,9 @@ replace_dir_entries(view_t *view, dir_entry_t **entries, int *count,
 	{
 		dir_entry_t *const entry = &new[i];
 
-		entry->name = strdup(entry->name);
-		entry->origin = strdup(entry->origin);
+		entry->in_arena = 1;
+		entry->name = copy_entry_str(view, entry, entry->name, /*intern=*/0);
+		entry->origin = copy_entry_str(view, entry, entry->origin, /*intern=*/1);
 		entry->owns_origin = 1;
 
 		if(entry->name == NULL || entry->origin == NULL)
@@ -2746,16 +5129,98 @@ free_dir_entries(dir_entry_t **entries, int *count)
 void
 fentry_free(dir_entry_t *entry)
 {
-	free(entry->name);
+	free_entry_str(entry, entry->name);
 	entry->name = NULL;
 
 	if(entry->owns_origin)
 	{
-		free(entry->origin);
+		free_entry_str(entry, entry->origin);
 		entry->origin = NULL;
 	}
 }
 
+int
+fentry_set_name(view_t *view, dir_entry_t *entry, const char name[])
+{
+	char *const copy = copy_entry_str(view, entry, name, /*intern=*/0);
+	if(copy == NULL)
+	{
+		return 1;
+	}
+
+	free_entry_str(entry, entry->name);
+	entry->name = copy;
+	return 0;
+}
+
+int
+fentry_set_origin(view_t *view, dir_entry_t *entry, const char origin[])
+{
+	return set_entry_origin(view, entry, origin);
+}
+
+/* Replaces origin of the entry with a copy of the string.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+set_entry_origin(view_t *view, dir_entry_t *entry, const char origin[])
+{
+	char *const copy = copy_entry_str(view, entry, origin, /*intern=*/1);
+	if(copy == NULL)
+	{
+		return 1;
+	}
+
+	if(entry->owns_origin)
+	{
+		free_entry_str(entry, entry->origin);
+	}
+	entry->origin = copy;
+	entry->owns_origin = 1;
+	return 0;
+}
+
+/* Copies a string for the entry allocating it in the same way as other strings
+ * of the entry.  Origins are worth interning as they repeat a lot.  Returns
+ * the copy or NULL on error. */
+static char *
+copy_entry_str(view_t *view, const dir_entry_t *entry, const char str[],
+		int intern)
+{
+	if(!entry->in_arena)
+	{
+		return strdup(str);
+	}
+
+	return intern ? str_arena_intern(get_arena(view), str)
+	              : str_arena_dup(get_arena(view), str);
+}
+
+/* Frees a string of the entry.  str can be NULL. */
+static void
+free_entry_str(const dir_entry_t *entry, char str[])
+{
+	if(entry->in_arena)
+	{
+		str_arena_release(str);
+	}
+	else
+	{
+		free(str);
+	}
+}
+
+/* Retrieves arena for strings of entries of the view creating it on first
+ * use.  Returns the arena or NULL on error. */
+static str_arena_t *
+get_arena(view_t *view)
+{
+	if(view->arena == NULL)
+	{
+		view->arena = str_arena_create();
+	}
+	return view->arena;
+}
+
 dir_entry_t *
 add_dir_entry(dir_entry_t **list, size_t *list_size, const dir_entry_t *entry)
 {
@@ -2782,9 +5247,15 @@ entry_list_add(view_t *view, dir_entry_t **list, int *list_size,
 
 	init_dir_entry(view, dir_entry, get_last_path_component(path));
 
-	dir_entry->origin = strdup(path);
-	dir_entry->owns_origin = 1;
-	remove_last_path_component(dir_entry->origin);
+	char *const origin = strdup(path);
+	if(origin == NULL)
+	{
+		fentry_free(dir_entry);
+		return NULL;
+	}
+	remove_last_path_component(origin);
+	(void)set_entry_origin(view, dir_entry, origin);
+	free(origin);
 
 	if(fill_dir_entry_by_path(dir_entry, path) != 0)
 	{
@@ -2815,6 +5286,7 @@ void
 check_if_filelist_has_changed(view_t *view)
 {
 	int failed, changed;
+	const strlist_t *changes = NULL;
 	const char *const curr_dir = flist_get_dir(view);
 
 	if(view->on_slow_fs ||
@@ -2837,6 +5309,10 @@ check_if_filelist_has_changed(view_t *view)
 		FSWatchState state = poll_watcher(view->watch, curr_dir);
 		changed = (state != FSWS_UNCHANGED);
 		failed = (state == FSWS_ERRORED);
+		if(state == FSWS_UPDATED)
+		{
+			changes = fswatch_get_changes(view->watch);
+		}
 	}
 
 	/* Check if we still have permission to visit this directory. */
@@ -2860,7 +5336,10 @@ check_if_filelist_has_changed(view_t *view)
 
 	if(changed)
 	{
-		ui_view_schedule_reload(view);
+		if(changes == NULL || apply_file_changes(view, changes) != 0)
+		{
+			ui_view_schedule_reload(view);
+		}
 	}
 	else if(flist_custom_active(view) && cv_tree(view->custom.type))
 	{
@@ -2880,6 +5359,147 @@ check_if_filelist_has_changed(view_t *view)
 	}
 }
 
+/* Updates file list in place according to changes of individual files, which
+ * is much cheaper than a reload for large directories.  Returns non-zero if the
+ * list needs to be reloaded instead, otherwise zero is returned. */
+static int
+apply_file_changes(view_t *view, const strlist_t *changes)
+{
+	/* Lookups are linear, so a reload becomes cheaper at some point. */
+	enum { MAX_CHANGES = 64 };
+
+	if(flist_custom_active(view) || view->local_filter.in_progress ||
+			view->has_dups || changes->nitems > MAX_CHANGES)
+	{
+		return 1;
+	}
+
+	if(changes->nitems == 0)
+	{
+		return 0;
+	}
+
+	int i;
+	for(i = 0; i < changes->nitems; ++i)
+	{
+		if(update_changed_file(view, changes->items[i]) != 0)
+		{
+			return 1;
+		}
+	}
+
+	(void)zap_entries(view, view->dir_entry, &view->list_rows, &is_temporary,
+			NULL, /*allow_empty_list=*/1, /*remove_subtrees=*/0);
+	fpos_ensure_valid_pos(view);
+
+	/* Corner cases of empty directory are handled by a reload. */
+	const int show_parent =
+		cfg_parent_dir_is_visible(is_root_dir(view->curr_dir));
+	if(!show_parent && (view->list_rows == 0 ||
+				(view->list_rows > 1 && fpos_find_by_name(view, "..") != -1)))
+	{
+		return 1;
+	}
+
+	/* There can be new entries at the end and updated entries that need to be
+	 * moved, so restore order while keeping cursor on the same file. */
+	resort_dir_list(/*msg=*/0, view);
+
+	fview_list_updated(view);
+	ui_view_schedule_redraw(view);
+	return 0;
+}
+
+/* Updates, adds or marks for removal (via temporary flag) entry of a single
+ * file.  Returns non-zero if the change can't be applied in place, otherwise
+ * zero is returned. */
+static int
+update_changed_file(view_t *view, const char name[])
+{
+	char full_path[PATH_MAX + 1 + NAME_MAX + 1];
+	snprintf(full_path, sizeof(full_path), "%s/%s", view->curr_dir, name);
+
+	dir_entry_t new_entry;
+	init_dir_entry(view, &new_entry, name);
+	if(new_entry.name == NULL)
+	{
+		return 1;
+	}
+
+	const int exists = (fill_dir_entry_by_path(&new_entry, full_path) == 0);
+	const int pos = fpos_find_by_name(view, name);
+
+	if(!exists)
+	{
+		fentry_free(&new_entry);
+
+		if(pos == -1)
+		{
+			/* The file was either filtered out, which needs an update of the
+			 * counter, or never made it into the list. */
+			const int was_visible =
+				tree_candidate_is_visible(view, view->curr_dir, name, 0, 1) &&
+				tree_candidate_is_visible(view, view->curr_dir, name, 1, 1);
+			return !was_visible;
+		}
+
+		view->dir_entry[pos].temporary = 1;
+		return 0;
+	}
+
+	if(!tree_candidate_is_visible(view, view->curr_dir, name,
+				fentry_is_dir(&new_entry), 1))
+	{
+		fentry_free(&new_entry);
+		if(pos == -1)
+		{
+			/* Can't tell a new file from a changed one that was already counted as
+			 * filtered out. */
+			return 1;
+		}
+
+		view->dir_entry[pos].temporary = 1;
+		++view->filtered;
+		return 0;
+	}
+
+	if(pos == -1)
+	{
+		/* The file could have been filtered out as a file of another type (e.g.,
+		 * a directory replaced by a file), which can't be told apart from a new
+		 * file without updating the counter. */
+		if(view->filtered != 0 &&
+				!tree_candidate_is_visible(view, view->curr_dir, name,
+					!fentry_is_dir(&new_entry), 1))
+		{
+			fentry_free(&new_entry);
+			return 1;
+		}
+
+		dir_entry_t *const entry = alloc_dir_entry(&view->dir_entry,
+				view->list_rows);
+		if(entry == NULL)
+		{
+			fentry_free(&new_entry);
+			return 1;
+		}
+
+		*entry = new_entry;
+		++view->list_rows;
+		return 0;
+	}
+
+	dir_entry_t *const entry = &view->dir_entry[pos];
+	merge_entries(&new_entry, entry);
+	if(entry->search_match)
+	{
+		--view->matches;
+	}
+	fentry_free(entry);
+	*entry = new_entry;
+	return 0;
+}
+
 /* Checks whether tree-view needs a reload (any of subdirectories were changed).
  * Returns non-zero if so, otherwise zero is returned. */
 static int
@@ -2939,13 +5559,104 @@ flist_update_cache(view_t *view, cached_entries_t *cache, const char path[])
 		update = 1;
 	}
 
-	if(poll_watcher(cache->watch, path) != FSWS_UNCHANGED || update)
+	if(poll_watcher(cache->watch, path) != FSWS_UNCHANGED || update ||
+			cache->pending)
 	{
+		const int was_pending = cache->pending;
+		cache->pending = 0;
 		free_dir_entries(&cache->entries.entries, &cache->entries.nentries);
-		cache->entries = flist_list_in(view, path, 0, 1);
+
+#ifndef _WIN32
+		if(cache == &view->right_column &&
+				prefetch_column(view, cache, path) == 0)
+		{
+			/* Nothing has changed if the column is still waiting for its
+			 * entries. */
+			return !(was_pending && cache->pending);
+		}
+#endif
+
+		if(fill_column_from_cache(view, cache, path) != 0)
+		{
+			cache->entries = flist_list_in(view, path, 0, 1);
+		}
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Fills side column with entries of an unfiltered list from the cache of
+ * lists.  Returns zero on success, otherwise non-zero is returned. */
+static int
+fill_column_from_cache(view_t *view, cached_entries_t *cache,
+		const char path[])
+{
+	int nentries;
+	const dir_entry_t *const entries = flist_cache_peek(path, &nentries);
+	if(entries == NULL)
+	{
+		return 1;
+	}
+
+	entries_t column = {};
+
+	int i;
+	for(i = 0; i < nentries; ++i)
+	{
+		const dir_entry_t *const entry = &entries[i];
+
+		if((view->hide_dot && entry->name[0] == '.') ||
+				!filters_file_is_visible(view, path, entry->name, fentry_is_dir(entry),
+					/*apply_local_filter=*/0))
+		{
+			continue;
+		}
+
+		dir_entry_t *const copy = alloc_dir_entry(&column.entries,
+				column.nentries);
+		if(copy == NULL)
+		{
+			break;
+		}
+
+		*copy = *entry;
+		copy->in_arena = 1;
+		copy->owns_origin = 0;
+		copy->name = copy_entry_str(view, copy, entry->name, /*intern=*/0);
+		if(copy->name == NULL)
+		{
+			break;
+		}
+
+		if(set_entry_origin(view, copy, path) != 0)
+		{
+			fentry_free(copy);
+			break;
+		}
+
+		++column.nentries;
+	}
+
+	if(i != nentries)
+	{
+		free_dir_entries(&column.entries, &column.nentries);
 		return 1;
 	}
 
+	if(cfg_parent_dir_is_visible(is_root_dir(path)))
+	{
+		char *const full_path = format_str("%s/..", path);
+		if(full_path != NULL)
+		{
+			/* Failure to add parent directory entry is by no means critical. */
+			(void)entry_list_add(view, &column.entries, &column.nentries,
+					full_path);
+			free(full_path);
+		}
+	}
+
+	cache->entries = column;
 	return 0;
 }
 
@@ -2980,6 +5691,7 @@ flist_free_cache(cached_entries_t *cache)
 	update_string(&cache->dir, NULL);
 	fswatch_free(cache->watch);
 	cache->watch = NULL;
+	cache->pending = 0;
 }
 
 void
@@ -3030,6 +5742,16 @@ flist_toggle_fold(view_t *view)
 	if(set_fold_state(view->custom.folded_paths, full_path, state))
 	{
 		curr->folded = !curr->folded;
+
+		/* Children of a folded directory aren't loaded, so only they need to be
+		 * loaded on unfolding. */
+		if(!curr->folded && view->custom.type == CV_TREE &&
+				load_child_entries(view, view->list_pos, full_path) == 0)
+		{
+			ui_view_schedule_redraw(view);
+			return;
+		}
+
 		/* We reload even on folding to update number of filtered entries
 		 * properly. */
 		ui_view_schedule_reload(view);
@@ -3054,10 +5776,102 @@ remove_child_entries(view_t *view, dir_entry_t *entry)
 
 	fix_tree_links(view->dir_entry, entry, pos, pos, 0, -child_count);
 
-	memmove(entry + 1, entry + 1 + child_count,
-			sizeof(*entry)*(view->list_rows - (pos + 1 + child_count)));
-	view->list_rows -= child_count;
-	entry->child_count = 0;
+	memmove(entry + 1, entry + 1 + child_count,
+			sizeof(*entry)*(view->list_rows - (pos + 1 + child_count)));
+	view->list_rows -= child_count;
+	entry->child_count = 0;
+}
+
+/* Unfolds a single entry of a tree by loading its children from file system
+ * and inserting them right after it.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+load_child_entries(view_t *view, int pos, const char path[])
+{
+	dir_entry_t *subtree;
+	int nsubtree;
+	const int nfiltered = build_subtree(view, path, &subtree, &nsubtree);
+	if(nfiltered < 0)
+	{
+		return 1;
+	}
+
+	/* The first entry of the subtree is the directory itself. */
+	const int nchildren = nsubtree - 1;
+	dir_entry_t *const entries = dynarray_extend(view->dir_entry,
+			nchildren*sizeof(*entries));
+	if(entries == NULL)
+	{
+		free_dir_entries(&subtree, &nsubtree);
+		return 1;
+	}
+	view->dir_entry = entries;
+
+	dir_entry_t *const entry = &entries[pos];
+	fix_tree_links(entries, entry, pos, pos, 0, nchildren);
+
+	memmove(entry + 1 + nchildren, entry + 1,
+			sizeof(*entry)*(view->list_rows - (pos + 1)));
+	memcpy(entry + 1, subtree + 1, sizeof(*entry)*nchildren);
+	view->list_rows += nchildren;
+	entry->child_count = nchildren;
+	view->filtered += nfiltered;
+
+	fentry_free(&subtree[0]);
+	dynarray_free(subtree);
+
+	resort_dir_list(/*msg=*/0, view);
+	return 0;
+}
+
+/* Builds part of a tree at the path using current state of folds and
+ * exclusions of the view.  The directory itself is the first entry of the
+ * result.  Returns number of filtered out files on success and negative value
+ * on error or cancellation. */
+static int
+build_subtree(view_t *view, const char path[], dir_entry_t **entries,
+		int *nentries)
+{
+	/* Custom list of the view is unused after the tree is built. */
+	free_dir_entries(&view->custom.entries, &view->custom.entry_count);
+	trie_free(view->custom.paths_cache);
+	view->custom.paths_cache = trie_create(/*free_func=*/NULL);
+	if(view->custom.paths_cache == NULL)
+	{
+		return -1;
+	}
+
+	show_progress("Building tree...", 0);
+
+	int nfiltered = -1;
+	ui_cancellation_push_on();
+	if(flist_custom_add(view, path) != NULL)
+	{
+		tree_scan_t scan;
+		scan_tree(&scan, view, path, view->custom.excluded_paths,
+				view->custom.folded_paths, INT_MAX);
+		nfiltered = add_files_recursively(view, path, view->custom.excluded_paths,
+				view->custom.folded_paths, scan.root, 0, 0, INT_MAX);
+		free_tree_scan(&scan);
+	}
+	ui_cancellation_pop();
+
+	ui_sb_quick_msg_clear();
+
+	trie_free(view->custom.paths_cache);
+	view->custom.paths_cache = NULL;
+
+	*entries = view->custom.entries;
+	*nentries = view->custom.entry_count;
+	view->custom.entries = NULL;
+	view->custom.entry_count = 0;
+
+	if(nfiltered < 0 || ui_cancellation_requested())
+	{
+		free_dir_entries(entries, nentries);
+		return -1;
+	}
+	return nfiltered;
 }
 
 int
@@ -3809,6 +6623,57 @@ flist_custom_set(view_t *view, const char title[], const char path[],
 	flist_custom_end(view, 1);
 }
 
+int
+flist_custom_stream(view_t *view, const char title[], pid_t pid, FILE *out,
+		FILE *err, int very)
+{
+#ifndef _WIN32
+	stop_streaming(view, /*keep=*/0);
+
+	cv_loader_t *const loader = calloc(1, sizeof(*loader));
+	if(loader == NULL)
+	{
+		fclose(out);
+		fclose(err);
+		return 1;
+	}
+
+	loader->title = strdup(title);
+	loader->cwd = strdup(flist_get_dir(view));
+	loader->very = very;
+	loader->pid = pid;
+	loader->out = out;
+	loader->err = err;
+	loader->paths = trie_create(/*free_func=*/NULL);
+	if(loader->title == NULL || loader->cwd == NULL || loader->paths == NULL ||
+			pthread_mutex_init(&loader->lock, NULL) != 0)
+	{
+		trie_free(loader->paths);
+		free(loader->cwd);
+		free(loader->title);
+		free(loader);
+		fclose(out);
+		fclose(err);
+		return 1;
+	}
+
+	pthread_t id;
+	if(pthread_create(&id, NULL, &cv_loader_thread, loader) != 0)
+	{
+		free_cv_loader(loader);
+		return 1;
+	}
+	(void)pthread_detach(id);
+
+	view->custom.loader = loader;
+	return 0;
+#else
+	fclose(out);
+	fclose(err);
+	return 1;
+#endif
+}
+
 void
 flist_custom_add_spec(view_t *view, const char line[])
 {
@@ -3840,7 +6705,7 @@ fentry_rename(view_t *view, dir_entry_t *entry, const char to[])
 	/* Rename file in internal structures for correct positioning of cursor
 	 * after reloading, as cursor will be positioned on the file with the same
 	 * name. */
-	entry->name = strdup(to);
+	entry->name = copy_entry_str(view, entry, to, /*intern=*/0);
 	if(entry->name == NULL)
 	{
 		entry->name = old_name;
@@ -3873,12 +6738,8 @@ fentry_rename(view_t *view, dir_entry_t *entry, const char to[])
 				char *const new_origin = format_str("%s/%s%s", entry->origin, to,
 						e->origin + root_len);
 				chosp(new_origin);
-				if(e->owns_origin)
-				{
-					free(e->origin);
-				}
-				e->origin = new_origin;
-				e->owns_origin = 1;
+				(void)set_entry_origin(view, e, new_origin);
+				free(new_origin);
 
 				/* Clone visible child folds. */
 				e->folded = 0;
@@ -3908,7 +6769,7 @@ fentry_rename(view_t *view, dir_entry_t *entry, const char to[])
 		}
 	}
 
-	free(old_name);
+	free_entry_str(entry, old_name);
 }
 
 int
@@ -4075,8 +6936,11 @@ make_tree(view_t *view, const char path[], int reload, trie_t *excluded_paths,
 	}
 	else
 	{
+		tree_scan_t scan;
+		scan_tree(&scan, view, path, excluded_paths, folded_paths, depth);
 		nfiltered = add_files_recursively(view, path, excluded_paths, folded_paths,
-				-1, 0, depth);
+				scan.root, -1, 0, depth);
+		free_tree_scan(&scan);
 		type = CV_TREE;
 	}
 	ui_cancellation_pop();
@@ -4195,15 +7059,14 @@ complete_tree(const char name[], int valid, const void *parent_data, void *data,
 				 * as a storage of path prefix and is removed afterwards in
 				 * drop_tops(). */
 				init_dir_entry(view, dir_entry, "");
-				dir_entry->origin = strdup(name);
+				(void)set_entry_origin(view, dir_entry, name);
 			}
 			else
 			{
 				init_dir_entry(view, dir_entry, name);
-				dir_entry->origin = strdup("/");
+				(void)set_entry_origin(view, dir_entry, "/");
 			}
 			free(typed_path);
-			dir_entry->owns_origin = 1;
 		}
 		else
 		{
@@ -4212,8 +7075,7 @@ complete_tree(const char name[], int valid, const void *parent_data, void *data,
 			init_dir_entry(view, dir_entry, name);
 			get_full_path_of(&(*entries)[*parent_idx], sizeof(parent_path),
 					parent_path);
-			dir_entry->origin = strdup(parent_path);
-			dir_entry->owns_origin = 1;
+			(void)set_entry_origin(view, dir_entry, parent_path);
 		}
 
 		get_full_path_of(dir_entry, sizeof(full_path), full_path);
@@ -4270,26 +7132,356 @@ drop_tops(dir_entry_t *entries, int *nentries, int extra)
 	}
 }
 
-/* Adds custom view entries corresponding to file system tree.  parent_pos is
- * expected to be negative for the outermost invocation.  The depth parameter
- * is used to limit nesting level, when it's negative, parent node is just
- * marked as folded.  Returns number of filtered out files on success or partial
- * success and negative value on serious error. */
+#ifndef _WIN32
+
+/* Reads directories of a tree that are likely to be needed to build it by
+ * several threads, which share directories to read via a work-stealing queue.
+ * Sets scan->root to NULL if this wasn't done.  The result should be freed
+ * with free_tree_scan(). */
+static void
+scan_tree(tree_scan_t *scan, view_t *view, const char path[],
+		trie_t *excluded_paths, trie_t *folded_paths, int depth)
+{
+	scan->view = view;
+	scan->excluded_paths = excluded_paths;
+	scan->folded_paths = folded_paths;
+	scan->check_filters = !matcher_is_mime(view->manual_filter);
+	scan->nbufs = par_nthreads();
+	scan->bufs = calloc(scan->nbufs, sizeof(*scan->bufs));
+	scan->root = alloc_tree_dir(strdup(path), depth);
+
+	if(scan->bufs == NULL || scan->root == NULL)
+	{
+		free_tree_scan(scan);
+		return;
+	}
+
+	int i;
+	for(i = 0; i < scan->nbufs; ++i)
+	{
+		scan->bufs[i].arena = str_arena_create();
+		if(scan->bufs[i].arena == NULL)
+		{
+			free_tree_scan(scan);
+			return;
+		}
+	}
+
+	/* On cancellation some directories remain unread, building of the tree will
+	 * be stopped soon anyway. */
+	(void)par_run(scan->root, scan->nbufs, &scan_tree_dir, &scan_tree_poll,
+			scan);
+
+	/* Buffers won't grow anymore, so pointers into them are stable now. */
+	resolve_tree_dir(scan, scan->root);
+}
+
+/* par_run() callback that reads single directory of a tree and spawns tasks
+ * for its subdirectories. */
+static void
+scan_tree_dir(par_tasks_t *tasks, int worker, void *task, void *arg)
+{
+	tree_scan_t *const scan = arg;
+	tree_dir_t *const node = task;
+	tree_buf_t *const buf = &scan->bufs[worker];
+
+	DIR *const dir = os_opendir(node->path);
+	if(dir == NULL)
+	{
+		LOG_SERROR_MSG(errno, "Can't opendir() \"%s\"", node->path);
+		node->error = 1;
+		return;
+	}
+
+	const int dir_fd = dirfd(dir);
+
+	node->worker = worker;
+	node->first = buf->nentries;
+
+	struct dirent *d;
+	while((d = os_readdir(dir)) != NULL)
+	{
+		if(is_builtin_dir(d->d_name))
+		{
+			continue;
+		}
+
+		dir_entry_t *const entry = alloc_dir_entry(&buf->entries, buf->nentries);
+		if(entry == NULL)
+		{
+			node->error = 1;
+			break;
+		}
+
+		fentry_init(buf->arena, entry, d->d_name);
+		if(entry->name == NULL || read_tree_entry_meta(entry, dir_fd) != 0)
+		{
+			LOG_ERROR_MSG("Can't query \"%s/%s\"", node->path, d->d_name);
+			fentry_free(entry);
+			continue;
+		}
+
+		++buf->nentries;
+	}
+
+	os_closedir(dir);
+
+	node->count = buf->nentries - node->first;
+	if(!node->error)
+	{
+		node->read = 1;
+		spawn_tree_subdirs(tasks, worker, scan, node);
+	}
+}
+
+/* Fills meta-data of an entry of a tree relative to the dir_fd.  Returns zero
+ * on success, otherwise non-zero is returned. */
+static int
+read_tree_entry_meta(dir_entry_t *entry, int dir_fd)
+{
+	struct stat s;
+	if(fstatat(dir_fd, entry->name, &s, AT_SYMLINK_NOFOLLOW) != 0 ||
+			fill_dir_entry(entry, &s, FT_UNK) != 0)
+	{
+		return 1;
+	}
+
+	if(entry->type == FT_LINK)
+	{
+		fill_link_info_at(entry, dir_fd);
+	}
+	return 0;
+}
+
+/* Spawns tasks for reading subdirectories of a directory that was just read.
+ * Only those subdirectories which are going to be traversed while building the
+ * tree are read, some extra ones might be read as well. */
+static void
+spawn_tree_subdirs(par_tasks_t *tasks, int worker, tree_scan_t *scan,
+		tree_dir_t *node)
+{
+	if(node->depth == 0)
+	{
+		return;
+	}
+
+	const dir_entry_t *const entries = &scan->bufs[worker].entries[node->first];
+	const FoldState parent_fold = get_fold_state(scan->folded_paths, node->path);
+
+	int i;
+	for(i = 0; i < node->count; ++i)
+	{
+		/* Symbolic links to directories are never traversed. */
+		if(entries[i].type != FT_DIR)
+		{
+			continue;
+		}
+
+		char *const full_path = format_str("%s/%s", node->path, entries[i].name);
+		if(full_path == NULL ||
+				!tree_subdir_is_needed(scan, node, parent_fold, entries[i].name,
+					full_path))
+		{
+			free(full_path);
+			continue;
+		}
+
+		if(node->subdirs == NULL)
+		{
+			node->subdirs = calloc(node->count, sizeof(*node->subdirs));
+			if(node->subdirs == NULL)
+			{
+				free(full_path);
+				return;
+			}
+		}
+
+		/* Directories that failed to be spawned are read later on demand. */
+		tree_dir_t *const subdir = alloc_tree_dir(full_path, node->depth - 1);
+		if(subdir != NULL && par_spawn(tasks, worker, subdir) == 0)
+		{
+			node->subdirs[i] = subdir;
+		}
+		else
+		{
+			free_tree_dir(subdir);
+		}
+	}
+}
+
+/* Checks whether subdirectory of a tree might be traversed by
+ * add_files_recursively().  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+tree_subdir_is_needed(tree_scan_t *scan, const tree_dir_t *node,
+		FoldState parent_fold, const char name[], const char full_path[])
+{
+	void *dummy;
+	if(trie_get(scan->excluded_paths, full_path, &dummy) == 0)
+	{
+		return 0;
+	}
+
+	/* Local filter doesn't prevent traversing directories. */
+	if(scan->check_filters)
+	{
+		if(!tree_candidate_is_visible(scan->view, node->path, name, 1, 0))
+		{
+			return 0;
+		}
+	}
+	else if(scan->view->hide_dot && name[0] == '.')
+	{
+		return 0;
+	}
+
+	const FoldState state = get_fold_state(scan->folded_paths, full_path);
+	return state != FOLD_USER_CLOSED
+	    && state != FOLD_AUTO_CLOSED
+	    && (state != FOLD_UNDEFINED || parent_fold != FOLD_AUTO_OPENED);
+}
+
+/* par_run() callback that reports progress of reading a tree and checks for
+ * cancellation.  Returns non-zero to cancel. */
+static int
+scan_tree_poll(size_t ndone, void *arg)
+{
+	char msg[64];
+	snprintf(msg, sizeof(msg), "Reading tree... %d", (int)ndone);
+	show_progress(msg, 1);
+	return ui_cancellation_requested();
+}
+
+/* Points directories of the tree to their entries in buffers of threads. */
+static void
+resolve_tree_dir(tree_scan_t *scan, tree_dir_t *node)
+{
+	if(!node->read)
+	{
+		return;
+	}
+
+	node->entries = &scan->bufs[node->worker].entries[node->first];
+
+	int i;
+	for(i = 0; i < node->count && node->subdirs != NULL; ++i)
+	{
+		if(node->subdirs[i] != NULL)
+		{
+			resolve_tree_dir(scan, node->subdirs[i]);
+		}
+	}
+}
+
+#else
+
+/* Reading a tree in advance isn't implemented on Windows.  Sets scan->root to
+ * NULL. */
+static void
+scan_tree(tree_scan_t *scan, view_t *view, const char path[],
+		trie_t *excluded_paths, trie_t *folded_paths, int depth)
+{
+	scan->bufs = NULL;
+	scan->nbufs = 0;
+	scan->root = NULL;
+}
+
+#endif
+
+/* Frees result of scan_tree() along with entries that weren't taken from
+ * it. */
+static void
+free_tree_scan(tree_scan_t *scan)
+{
+	free_tree_dir(scan->root);
+	scan->root = NULL;
+
+	int i;
+	for(i = 0; i < scan->nbufs && scan->bufs != NULL; ++i)
+	{
+		tree_buf_t *const buf = &scan->bufs[i];
+		free_dir_entries(&buf->entries, &buf->nentries);
+		str_arena_free(buf->arena);
+	}
+	free(scan->bufs);
+	scan->bufs = NULL;
+}
+
+/* Allocates a directory of a tree taking ownership of the path.  Returns the
+ * directory or NULL on error. */
+static tree_dir_t *
+alloc_tree_dir(char path[], int depth)
+{
+	tree_dir_t *const node = (path == NULL ? NULL : calloc(1, sizeof(*node)));
+	if(node == NULL)
+	{
+		free(path);
+		return NULL;
+	}
+
+	node->path = path;
+	node->depth = depth;
+	return node;
+}
+
+/* Frees a directory of a tree along with its subdirectories.  node can be
+ * NULL. */
+static void
+free_tree_dir(tree_dir_t *node)
+{
+	if(node == NULL)
+	{
+		return;
+	}
+
+	int i;
+	for(i = 0; i < node->count && node->subdirs != NULL; ++i)
+	{
+		free_tree_dir(node->subdirs[i]);
+	}
+	free(node->subdirs);
+	free(node->path);
+	free(node);
+}
+
+/* Adds custom view entries corresponding to file system tree.  node is result
+ * of reading the path in advance or NULL.  parent_pos is expected to be
+ * negative for the outermost invocation.  The depth parameter is used to limit
+ * nesting level, when it's negative, parent node is just marked as folded.
+ * Returns number of filtered out files on success or partial success and
+ * negative value on serious error. */
 static int
 add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
-		trie_t *folded_paths, int parent_pos, int no_direct_parent, int depth)
+		trie_t *folded_paths, tree_dir_t *node, int parent_pos,
+		int no_direct_parent, int depth)
 {
 	int i;
 	const int prev_count = view->custom.entry_count;
 	int nfiltered = 0;
 
-	int len;
-	char **lst = list_all_files(path, &len);
-	if(len < 0)
+	if(node != NULL && node->error)
 	{
 		return -1;
 	}
 
+	/* Directories that weren't read in advance are read here. */
+	const int scanned = (node != NULL && node->read);
+
+	int len;
+	char **lst = NULL;
+	if(scanned)
+	{
+		len = node->count;
+	}
+	else
+	{
+		lst = list_all_files(path, &len);
+		if(len < 0)
+		{
+			return -1;
+		}
+	}
+
 	FoldState parent_fold = get_fold_state(folded_paths, path);
 
 	for(i = 0; i < len && !ui_cancellation_requested(); ++i)
@@ -4297,7 +7489,11 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 		int dir;
 		void *dummy;
 		dir_entry_t *entry;
-		char *const full_path = format_str("%s/%s", path, lst[i]);
+		const char *const name = (scanned ? node->entries[i].name : lst[i]);
+		char *const full_path = format_str("%s/%s", path, name);
+		tree_dir_t *const subdir = (scanned && node->subdirs != NULL)
+		                         ? node->subdirs[i]
+		                         : NULL;
 
 		if(trie_get(excluded_paths, full_path, &dummy) == 0)
 		{
@@ -4305,10 +7501,11 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 			continue;
 		}
 
-		dir = is_dir(full_path);
-		if(!tree_candidate_is_visible(view, path, lst[i], dir, 1))
+		dir = (scanned ? fentry_is_dir(&node->entries[i]) : is_dir(full_path));
+		if(!tree_candidate_is_visible(view, path, name, dir, 1))
 		{
-			const int real_dir = (dir && !is_symlink(full_path));
+			const int real_dir = scanned ? (node->entries[i].type == FT_DIR)
+			                             : (dir && !is_symlink(full_path));
 
 			FoldState state;
 			if(real_dir)
@@ -4329,12 +7526,12 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 			/* Traverse directory (but not symlink to it) even if we're skipping it,
 			 * because we might need files that are inside of it. */
 			if(real_dir && depth > 0 &&
-					tree_candidate_is_visible(view, path, lst[i], dir, 0))
+					tree_candidate_is_visible(view, path, name, dir, 0))
 			{
 				if(state != FOLD_AUTO_CLOSED && state != FOLD_USER_CLOSED)
 				{
 					nfiltered += add_files_recursively(view, full_path, excluded_paths,
-							folded_paths, parent_pos, 1, depth - 1);
+							folded_paths, subdir, parent_pos, 1, depth - 1);
 				}
 			}
 
@@ -4343,11 +7540,15 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 			continue;
 		}
 
-		entry = flist_custom_add(view, full_path);
+		entry = scanned ? add_scanned_entry(view, full_path, &node->entries[i])
+		                : flist_custom_add(view, full_path);
 		if(entry == NULL)
 		{
 			free(full_path);
-			free_string_array(lst, len);
+			if(!scanned)
+			{
+				free_string_array(lst, len);
+			}
 			return -1;
 		}
 
@@ -4376,7 +7577,7 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 			{
 				const int idx = view->custom.entry_count - 1;
 				const int filtered = add_files_recursively(view, full_path,
-						excluded_paths, folded_paths, idx, 0, depth - 1);
+						excluded_paths, folded_paths, subdir, idx, 0, depth - 1);
 				/* Keep going in case of error and load partial list. */
 				if(filtered >= 0)
 				{
@@ -4394,7 +7595,10 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 		show_progress("Building tree...", 1000);
 	}
 
-	free_string_array(lst, len);
+	if(!scanned)
+	{
+		free_string_array(lst, len);
+	}
 
 	/* The prev_count != 0 check is to make sure that we won't create leaf instead
 	 * of the whole tree (this is handled in flist_custom_finish()). */
@@ -4413,6 +7617,51 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 	return nfiltered;
 }
 
+/* Moves entry of a directory read in advance to the custom list which is being
+ * built.  Returns pointer to the added entry or NULL on error. */
+static dir_entry_t *
+add_scanned_entry(view_t *view, const char path[], dir_entry_t *scanned)
+{
+	char canonic_path[PATH_MAX + 1];
+	to_canonic_path(path, flist_get_dir(view), canonic_path,
+			sizeof(canonic_path));
+
+	/* Don't add duplicates. */
+	if(trie_put(view->custom.paths_cache, canonic_path) != 0)
+	{
+		return NULL;
+	}
+
+	dir_entry_t *const entry = alloc_dir_entry(&view->custom.entries,
+			view->custom.entry_count);
+	if(entry == NULL)
+	{
+		return NULL;
+	}
+
+	*entry = *scanned;
+	/* Name is owned by the new entry now. */
+	scanned->name = NULL;
+
+	remove_last_path_component(canonic_path);
+	if(set_entry_origin(view, entry, canonic_path) != 0)
+	{
+		fentry_free(entry);
+		return NULL;
+	}
+
+#ifndef _WIN32
+	if(entry->type == FT_LINK)
+	{
+		/* Unlike reading in advance, this takes 'slowfs' into account. */
+		fill_link_info(entry, path);
+	}
+#endif
+
+	++view->custom.entry_count;
+	return entry;
+}
+
 /* Retrieves state of the fold if present.  Returns the state or
  * FOLD_UNDEFINED. */
 static FoldState
@@ -4452,6 +7701,19 @@ entry_is_visible(view_t *view, const char name[], const void *data)
 			/*apply_local_filter=*/1);
 }
 
+#ifndef _WIN32
+
+/* Same as entry_is_visible(), but for an entry whose meta-data is already
+ * loaded.  Returns non-zero if so, otherwise zero is returned. */
+static int
+loaded_entry_is_visible(view_t *view, const dir_entry_t *entry)
+{
+	return filters_file_is_visible(view, flist_get_dir(view), entry->name,
+			fentry_is_dir(entry), /*apply_local_filter=*/1);
+}
+
+#endif
+
 /* Checks whether a candidate for adding to a tree is visible according to
  * filters.  Returns non-zero if so, otherwise zero is returned. */
 static int
@@ -4497,8 +7759,8 @@ add_directory_leaf(view_t *view, const char path[], int parent_pos)
 	}
 
 	remove_last_path_component(full_path);
-	entry->origin = full_path;
-	entry->owns_origin = 1;
+	(void)set_entry_origin(view, entry, full_path);
+	free(full_path);
 
 	if(parent_pos >= 0)
 	{
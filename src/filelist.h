@@ -20,9 +20,10 @@
 #ifndef VIFM__FILELIST_H__
 #define VIFM__FILELIST_H__
 
-#include <sys/types.h> /* ssize_t */
+#include <sys/types.h> /* pid_t ssize_t */
 
 #include <stddef.h> /* size_t */
+#include <stdio.h> /* FILE */
 #include <stdint.h> /* uint64_t */
 
 #include "ui/ui.h"
@@ -136,6 +137,13 @@ int flist_custom_finish(view_t *view, CVType type, int allow_empty);
 /* A more high level version of flist_custom_finish(), which takes care of error
  * handling and cursor position. */
 void flist_custom_end(view_t *view, int very);
+/* Starts populating custom view of the view with paths printed by a command in
+ * background.  The view turns into custom view on receiving the first path and
+ * grows as more paths arrive (see flist_finish_loading()).  Takes ownership of
+ * output and error streams of the command.  Returns zero on success, otherwise
+ * non-zero is returned. */
+int flist_custom_stream(view_t *view, const char title[], pid_t pid, FILE *out,
+		FILE *err, int very);
 /* Loads list of paths (absolute or relative to the path) into custom view.
  * Exists with error message on failed attempt. */
 void flist_custom_set(view_t *view, const char title[], const char path[],
@@ -280,8 +288,18 @@ dir_entry_t * entry_list_add(view_t *view, dir_entry_t **list, int *list_size,
 		const char path[]);
 /* Frees list of directory entries.  Sets *entries and *count to safe values. */
 void free_dir_entries(dir_entry_t **entries, int *count);
+/* Initializes directory entry with name allocated in the arena and all other
+ * fields with default values except for origin, which is left unset. */
+void fentry_init(struct str_arena_t *arena, dir_entry_t *entry,
+		const char name[]);
 /* Frees single directory entry. */
 void fentry_free(dir_entry_t *entry);
+/* Replaces name of the entry with a copy of the string.  Returns zero on
+ * success, otherwise non-zero is returned. */
+int fentry_set_name(view_t *view, dir_entry_t *entry, const char name[]);
+/* Replaces origin of the entry with a copy of the string making the entry own
+ * its origin.  Returns zero on success, otherwise non-zero is returned. */
+int fentry_set_origin(view_t *view, dir_entry_t *entry, const char origin[]);
 /* Adds parent directory entry (..) to filelist. */
 void add_parent_dir(view_t *view);
 /* Changes name of a file entry, performing additional required updates. */
@@ -316,6 +334,24 @@ void flist_free_cache(cached_entries_t *cache);
 /* Updates non-heap-allocated origin pointers of entries in file list
  * entries. */
 void flist_update_origins(view_t *view);
+/* Loads next portion of meta-data which loading was postponed for a large
+ * directory.  Entries that are on the screen are processed first.  Returns
+ * non-zero if there is more to load, otherwise zero is returned. */
+int flist_load_postponed_meta(view_t *view);
+/* Checks whether file list of the view is being read in background.  Returns
+ * non-zero if so, otherwise zero is returned. */
+int flist_is_loading(const view_t *view);
+/* Replaces file list of the view with the one read in background if reading is
+ * over.  Also adds paths that were received by custom view from a command. */
+void flist_finish_loading(view_t *view);
+/* Stops reading file list of the view in background if it's in progress.  File
+ * list is left as is, custom view keeps paths received so far. */
+void flist_cancel_loading(view_t *view);
+/* Reads directory under the cursor in background to make entering it or
+ * displaying it in a side column fast.  Reading is cancelled if cursor has
+ * moved elsewhere and its result is put into cache of lists once it's done.
+ * start enables starting new reading. */
+void flist_prefetch(view_t *view, int start);
 /* Toggles fold of the current entry if applicable. */
 void flist_toggle_fold(view_t *view);
 /* Checks whether file list synchronizes with FS.  Returns non-zero if so,
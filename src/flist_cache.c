@@ -0,0 +1,296 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "flist_cache.h"
+
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* free() */
+#include <string.h> /* strcmp() strdup() strlen() */
+
+#include "cfg/config.h"
+#include "utils/macros.h"
+#include "utils/str.h"
+#include "filelist.h"
+
+/* Maximum number of listings in the cache.  Each of them holds a watcher,
+ * which might be a limited resource. */
+#define MAX_LISTINGS 16
+
+/* Single cached listing. */
+typedef struct
+{
+	char *path;            /* Path to the directory. */
+	char *sig;             /* Signature of filtering and sorting or NULL. */
+	filemon_t mon;         /* State of the directory before it was read. */
+	fswatch_t *watch;      /* Watcher of the directory. */
+	dir_entry_t *entries;  /* Entries of the listing. */
+	int nentries;          /* Number of entries. */
+	int filtered;          /* Number of filtered out files. */
+	size_t size;           /* Approximate size of the listing in bytes. */
+	unsigned long long use; /* Sequential number of the last use. */
+}
+listing_t;
+
+static size_t get_capacity(void);
+static size_t calc_size(const dir_entry_t entries[], int nentries);
+static int find_listing(const char path[]);
+static int is_up_to_date(listing_t *listing);
+static void evict_lru(void);
+static listing_t take_listing(int idx);
+static void free_listing(listing_t *listing);
+
+/* Cached listings. */
+static listing_t listings[MAX_LISTINGS];
+/* Number of elements of listings array in use. */
+static int nlistings;
+/* Sum of sizes of all listings. */
+static size_t used_size;
+/* Source of sequential numbers of uses. */
+static unsigned long long use_counter;
+/* Lookup statistics. */
+static int hits, misses;
+
+void
+flist_cache_put(const char path[], const char sig[], const filemon_t *mon,
+		fswatch_t *watch, dir_entry_t *entries, int nentries, int filtered)
+{
+	listing_t listing = {
+		.path = strdup(path),
+		.sig = (sig == NULL ? NULL : strdup(sig)),
+		.mon = *mon,
+		.watch = watch,
+		.entries = entries,
+		.nentries = nentries,
+		.filtered = filtered,
+		.size = calc_size(entries, nentries),
+		.use = ++use_counter,
+	};
+
+	const int idx = find_listing(path);
+	if(idx >= 0)
+	{
+		listing_t old = take_listing(idx);
+		free_listing(&old);
+	}
+
+	if(listing.path == NULL || (sig != NULL && listing.sig == NULL) ||
+			listing.size > get_capacity())
+	{
+		free_listing(&listing);
+		return;
+	}
+
+	while(nlistings == MAX_LISTINGS || used_size + listing.size > get_capacity())
+	{
+		evict_lru();
+	}
+
+	listings[nlistings++] = listing;
+	used_size += listing.size;
+}
+
+int
+flist_cache_take(const char path[], const char sig[], filemon_t *mon,
+		fswatch_t **watch, dir_entry_t **entries, int *nentries, int *filtered,
+		int *unfiltered)
+{
+	if(get_capacity() == 0U)
+	{
+		return 1;
+	}
+
+	const int idx = find_listing(path);
+	if(idx < 0)
+	{
+		++misses;
+		return 1;
+	}
+
+	listing_t listing = take_listing(idx);
+
+	if((listing.sig != NULL && strcmp(listing.sig, sig) != 0) ||
+			!is_up_to_date(&listing))
+	{
+		free_listing(&listing);
+		++misses;
+		return 1;
+	}
+
+	++hits;
+
+	*mon = listing.mon;
+	*watch = listing.watch;
+	*entries = listing.entries;
+	*nentries = listing.nentries;
+	*filtered = listing.filtered;
+	*unfiltered = (listing.sig == NULL);
+
+	free(listing.path);
+	free(listing.sig);
+	return 0;
+}
+
+const dir_entry_t *
+flist_cache_peek(const char path[], int *nentries)
+{
+	const int idx = find_listing(path);
+	if(idx < 0 || listings[idx].sig != NULL)
+	{
+		return NULL;
+	}
+
+	if(!is_up_to_date(&listings[idx]))
+	{
+		listing_t listing = take_listing(idx);
+		free_listing(&listing);
+		return NULL;
+	}
+
+	listings[idx].use = ++use_counter;
+	*nentries = listings[idx].nentries;
+	return listings[idx].entries;
+}
+
+int
+flist_cache_has(const char path[])
+{
+	return (find_listing(path) >= 0);
+}
+
+void
+flist_cache_trim(void)
+{
+	while(nlistings != 0 && used_size > get_capacity())
+	{
+		evict_lru();
+	}
+}
+
+void
+flist_cache_clear(void)
+{
+	while(nlistings != 0)
+	{
+		evict_lru();
+	}
+
+	hits = 0;
+	misses = 0;
+}
+
+void
+flist_cache_get_stats(flist_cache_stats_t *stats)
+{
+	stats->hits = hits;
+	stats->misses = misses;
+	stats->listings = nlistings;
+	stats->size = used_size;
+	stats->capacity = get_capacity();
+}
+
+/* Retrieves maximum size of the cache.  Returns the size in bytes. */
+static size_t
+get_capacity(void)
+{
+	return (size_t)MAX(cfg.list_cache_size, 0)*1024U;
+}
+
+/* Estimates amount of memory occupied by a listing.  Returns the estimate in
+ * bytes. */
+static size_t
+calc_size(const dir_entry_t entries[], int nentries)
+{
+	size_t size = nentries*sizeof(*entries);
+
+	int i;
+	for(i = 0; i < nentries; ++i)
+	{
+		size += strlen(entries[i].name) + 1U;
+	}
+
+	return size;
+}
+
+/* Looks up listing of a directory.  Returns its index or -1. */
+static int
+find_listing(const char path[])
+{
+	int i;
+	for(i = 0; i < nlistings; ++i)
+	{
+		if(stroscmp(listings[i].path, path) == 0)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+/* Checks whether the listing still matches its directory.  Returns non-zero if
+ * so, otherwise zero is returned. */
+static int
+is_up_to_date(listing_t *listing)
+{
+	/* Watcher catches changes of files, while monitor catches changes that
+	 * happened before the watcher was created. */
+	filemon_t current;
+	return filemon_from_file(listing->path, FMT_MODIFIED, &current) == 0
+	    && filemon_equal(&current, &listing->mon)
+	    && fswatch_poll(listing->watch) == FSWS_UNCHANGED;
+}
+
+/* Removes least recently used listing from the cache. */
+static void
+evict_lru(void)
+{
+	int lru = 0;
+	int i;
+	for(i = 1; i < nlistings; ++i)
+	{
+		if(listings[i].use < listings[lru].use)
+		{
+			lru = i;
+		}
+	}
+
+	listing_t listing = take_listing(lru);
+	free_listing(&listing);
+}
+
+/* Removes listing from the cache without freeing it.  Returns the listing. */
+static listing_t
+take_listing(int idx)
+{
+	listing_t listing = listings[idx];
+	used_size -= listing.size;
+	listings[idx] = listings[--nlistings];
+	return listing;
+}
+
+/* Frees all resources owned by the listing. */
+static void
+free_listing(listing_t *listing)
+{
+	free(listing->path);
+	free(listing->sig);
+	fswatch_free(listing->watch);
+	free_dir_entries(&listing->entries, &listing->nentries);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,87 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__FLIST_CACHE_H__
+#define VIFM__FLIST_CACHE_H__
+
+/* Bounded LRU cache of listings of recently visited directories.  Every
+ * listing is coupled with a watcher of its directory, which must report no
+ * changes for the listing to be reused.  Size of the cache is limited by
+ * 'listcache' option.
+ *
+ * A listing is either filtered and sorted list of a view or a complete list of
+ * a directory read in advance, which suits any filters and sorting. */
+
+#include <stddef.h> /* size_t */
+
+#include "ui/ui.h"
+#include "utils/filemon.h"
+#include "utils/fswatch.h"
+
+/* Statistics of the cache. */
+typedef struct
+{
+	int hits;        /* Number of successful lookups. */
+	int misses;      /* Number of failed lookups. */
+	int listings;    /* Number of listings in the cache. */
+	size_t size;     /* Approximate amount of memory used by listings in
+	                    bytes. */
+	size_t capacity; /* Maximum size in bytes. */
+}
+flist_cache_stats_t;
+
+/* Puts listing of a directory into the cache evicting least recently used
+ * ones if necessary.  Takes ownership of the watch and the entries.  The sig
+ * describes how the listing was filtered and sorted, NULL means that the
+ * listing is unfiltered and unsorted.  mon is state of the directory before it
+ * was read. */
+void flist_cache_put(const char path[], const char sig[], const filemon_t *mon,
+		fswatch_t *watch, dir_entry_t *entries, int nentries, int filtered);
+
+/* Removes listing of the directory from the cache and gives it to the caller if
+ * it's still up to date and has matching signature or is unfiltered.  On
+ * success sets all output parameters, *unfiltered is set to non-zero for
+ * unfiltered listings, origins of entries are left unset.  Returns zero on
+ * success, otherwise non-zero is returned. */
+int flist_cache_take(const char path[], const char sig[], filemon_t *mon,
+		fswatch_t **watch, dir_entry_t **entries, int *nentries, int *filtered,
+		int *unfiltered);
+
+/* Looks up unfiltered listing of the directory that is still up to date
+ * without removing it from the cache.  Returns the entries, which remain valid
+ * until the next call of any other function of this unit, or NULL if there is
+ * no such listing. */
+const dir_entry_t * flist_cache_peek(const char path[], int *nentries);
+
+/* Checks whether the cache has a listing of the directory without validating
+ * it.  Returns non-zero if so, otherwise zero is returned. */
+int flist_cache_has(const char path[]);
+
+/* Evicts listings until size of the cache satisfies current limit. */
+void flist_cache_trim(void);
+
+/* Empties the cache and resets its statistics. */
+void flist_cache_clear(void);
+
+/* Retrieves statistics of the cache. */
+void flist_cache_get_stats(flist_cache_stats_t *stats);
+
+#endif /* VIFM__FLIST_CACHE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
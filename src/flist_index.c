@@ -0,0 +1,193 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "flist_index.h"
+
+#include <ctype.h> /* tolower() */
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint32_t */
+#include <stdlib.h> /* free() malloc() reallocarray() */
+
+#include "compat/reallocarray.h"
+#include "ui/ui.h"
+#include "utils/str.h"
+
+/* Minimal number of slots in a table. */
+#define MIN_SLOTS 8U
+
+/* Single slot of the table. */
+typedef struct
+{
+	uint32_t hash; /* Hash of the name. */
+	int pos;       /* Position of the entry or -1 for an empty slot. */
+}
+slot_t;
+
+/* Open addressing hash table with linear probing.  Since entries are never
+ * removed and are inserted in order, entries with the same name are met in
+ * the order of their positions while probing. */
+struct flist_index_t
+{
+	const dir_entry_t *entries; /* Indexed entries. */
+	int nentries;               /* Number of indexed entries. */
+	slot_t *slots;              /* Table of mask + 1 slots. */
+	size_t mask;                /* Mask to turn a hash into slot number. */
+};
+
+static uint32_t hash_name(const char name[]);
+
+flist_index_t *
+flist_index_create(const dir_entry_t entries[], int nentries)
+{
+	flist_index_t *const index = malloc(sizeof(*index));
+	if(index == NULL)
+	{
+		return NULL;
+	}
+
+	/* Keep load factor at or below one half. */
+	size_t nslots = MIN_SLOTS;
+	while(nslots < 2U*(size_t)nentries)
+	{
+		nslots *= 2U;
+	}
+
+	index->entries = entries;
+	index->nentries = nentries;
+	index->mask = nslots - 1U;
+	index->slots = reallocarray(NULL, nslots, sizeof(*index->slots));
+	if(index->slots == NULL)
+	{
+		free(index);
+		return NULL;
+	}
+
+	size_t i;
+	for(i = 0U; i < nslots; ++i)
+	{
+		index->slots[i].pos = -1;
+	}
+
+	int pos;
+	for(pos = 0; pos < nentries; ++pos)
+	{
+		const uint32_t hash = hash_name(entries[pos].name);
+
+		i = hash & index->mask;
+		while(index->slots[i].pos != -1)
+		{
+			i = (i + 1U) & index->mask;
+		}
+
+		index->slots[i].hash = hash;
+		index->slots[i].pos = pos;
+	}
+
+	return index;
+}
+
+void
+flist_index_free(flist_index_t *index)
+{
+	if(index != NULL)
+	{
+		free(index->slots);
+		free(index);
+	}
+}
+
+int
+flist_index_find(const flist_index_t *index, const char name[],
+		const char dir[])
+{
+	int iter = 0;
+	int pos;
+	while((pos = flist_index_next(index, name, &iter)) != -1)
+	{
+		if(dir == NULL || stroscmp(index->entries[pos].origin, dir) == 0)
+		{
+			break;
+		}
+	}
+	return pos;
+}
+
+int
+flist_index_next(const flist_index_t *index, const char name[], int *iter)
+{
+	const uint32_t hash = hash_name(name);
+
+	size_t i = (hash + (size_t)*iter) & index->mask;
+	while(index->slots[i].pos != -1)
+	{
+		const slot_t *const slot = &index->slots[i];
+
+		i = (i + 1U) & index->mask;
+		++*iter;
+
+		if(slot->hash == hash &&
+				stroscmp(index->entries[slot->pos].name, name) == 0)
+		{
+			return slot->pos;
+		}
+	}
+	return -1;
+}
+
+const flist_index_t *
+flist_index_of(view_t *view)
+{
+	flist_index_t *index = view->name_index;
+	if(index != NULL && index->entries == view->dir_entry &&
+			index->nentries == view->list_rows)
+	{
+		return index;
+	}
+
+	flist_index_free(index);
+	view->name_index = flist_index_create(view->dir_entry, view->list_rows);
+	return view->name_index;
+}
+
+void
+flist_index_reset(view_t *view)
+{
+	flist_index_free(view->name_index);
+	view->name_index = NULL;
+}
+
+/* Computes FNV-1a hash of the name in a way that's consistent with
+ * stroscmp().  Returns the hash. */
+static uint32_t
+hash_name(const char name[])
+{
+	uint32_t hash = 2166136261U;
+	while(*name != '\0')
+	{
+#ifndef _WIN32
+		hash ^= (unsigned char)*name++;
+#else
+		hash ^= (unsigned char)tolower((unsigned char)*name++);
+#endif
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
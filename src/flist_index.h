@@ -0,0 +1,58 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__FLIST_INDEX_H__
+#define VIFM__FLIST_INDEX_H__
+
+/* Hash index of file list entries by their names.  Names are compared in the
+ * same way stroscmp() does it.  An index doesn't own entries and must be
+ * rebuilt when they change. */
+
+#include "ui/ui.h"
+
+/* Opaque declaration of index structure. */
+typedef struct flist_index_t flist_index_t;
+
+/* Builds index of nentries entries.  Returns the index or NULL on error. */
+flist_index_t * flist_index_create(const dir_entry_t entries[], int nentries);
+
+/* Frees the index.  The index can be NULL. */
+void flist_index_free(flist_index_t *index);
+
+/* Finds first entry with the name, which also originates from the dir if it's
+ * not NULL.  Returns position of the entry or -1 if there is no such entry. */
+int flist_index_find(const flist_index_t *index, const char name[],
+		const char dir[]);
+
+/* Enumerates entries with the name in the order of their positions.  *iter
+ * must be zero on the first call.  Returns position of the next entry or -1
+ * when there are no more of them. */
+int flist_index_next(const flist_index_t *index, const char name[], int *iter);
+
+/* Retrieves index of current list of files of the view building it if
+ * necessary.  Returns the index or NULL on error. */
+const flist_index_t * flist_index_of(view_t *view);
+
+/* Drops index of the view.  Should be called when entries are reordered or
+ * renamed in place. */
+void flist_index_reset(view_t *view);
+
+#endif /* VIFM__FLIST_INDEX_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
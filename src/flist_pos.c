@@ -37,6 +37,7 @@
 #include "utils/utils.h"
 #include "filelist.h"
 #include "filtering.h"
+#include "flist_index.h"
 #include "types.h"
 
 static int get_curr_col(const view_t *view);
@@ -60,6 +61,19 @@ fpos_find_by_name(const view_t *view, const char name[])
 int
 fpos_find_entry(const view_t *view, const char name[], const char dir[])
 {
+	/* The index is a cache and updating it doesn't change the view. */
+	const flist_index_t *const index = flist_index_of((view_t *)view);
+	if(index != NULL)
+	{
+		const int pos = flist_index_find(index, name, dir);
+		if(pos != -1)
+		{
+			return pos;
+		}
+	}
+
+	/* Entries might have been changed in place after the index was built, so
+	 * don't trust its negative answer. */
 	int i;
 	for(i = 0; i < view->list_rows; ++i)
 	{
@@ -70,6 +84,10 @@ fpos_find_entry(const view_t *view, const char name[], const char dir[])
 
 		if(stroscmp(view->dir_entry[i].name, name) == 0)
 		{
+			if(index != NULL)
+			{
+				flist_index_reset((view_t *)view);
+			}
 			return i;
 		}
 	}
@@ -0,0 +1,503 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "flist_snap.h"
+
+#ifndef _WIN32
+#include <sys/mman.h> /* MAP_* PROT_* mmap() munmap() */
+#include <sys/stat.h> /* S_IRWXU S_ISREG() fstat() futimens() stat */
+#include <dirent.h> /* DIR closedir() opendir() readdir() */
+#include <fcntl.h> /* O_RDONLY open() */
+#include <unistd.h> /* close() unlink() */
+#endif
+
+#include <errno.h> /* errno */
+#include <limits.h> /* INT_MAX */
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* int64_t uint8_t uint32_t uint64_t */
+#include <stdio.h> /* FILE fclose() fdopen() fwrite() snprintf() */
+#include <stdlib.h> /* free() mkstemp() qsort() */
+#include <string.h> /* memcmp() memcpy() memset() strchr() strcmp() strdup()
+                       strlen() */
+#include <time.h> /* time_t */
+
+#include "compat/fs_limits.h"
+#include "compat/os.h"
+#include "compat/reallocarray.h"
+#include "utils/dynarray.h"
+#include "utils/fs.h"
+#include "utils/log.h"
+#include "utils/str_arena.h"
+#include "filelist.h"
+#include "types.h"
+
+/* Use xxhash as a header-only library like compare.c does. */
+#define XXH_PRIVATE_API
+#include "utils/xxhash.h"
+
+/*
+ * Layout of a snapshot file:
+ *  - header (snap_header_t);
+ *  - path of the directory padded with null characters to a multiple of 8;
+ *  - array of records (snap_entry_t);
+ *  - null-terminated names of files referenced by the records.
+ *
+ * Entries are stored in the order they are passed in and without filtering, so
+ * that changes of filters don't invalidate snapshots.
+ */
+
+/* Identifies snapshot files and version of their format. */
+#define SNAP_MAGIC "VIFMSNP1"
+
+/* Rounds size up to keep records aligned. */
+#define ALIGN(size) (((size) + 7U)/8U*8U)
+
+/* Total size of snapshots after which least recently used ones are removed. */
+#define MAX_SNAPS_SIZE (256ULL*1024ULL*1024ULL)
+
+/* Header of a snapshot file. */
+typedef struct
+{
+	char magic[8];       /* SNAP_MAGIC without terminating null. */
+	uint32_t hdr_size;   /* Size of this structure to detect ABI changes. */
+	uint32_t entry_size; /* Size of snap_entry_t to detect ABI changes. */
+	filemon_t mon;       /* State of the directory before it was read. */
+	uint64_t path_len;   /* Length of path of the directory. */
+	uint64_t nentries;   /* Number of records. */
+	uint64_t names_size; /* Size of area with names. */
+}
+snap_header_t;
+
+/* Single entry of a snapshot. */
+typedef struct
+{
+	uint64_t size;     /* File size in bytes. */
+	int64_t mtime;     /* Modification time. */
+	int64_t atime;     /* Access time. */
+	int64_t ctime;     /* Change time. */
+	uint64_t inode;    /* Inode number. */
+	uint64_t name;     /* Offset of the name in area of names. */
+	uint32_t uid;      /* Owning user id. */
+	uint32_t gid;      /* Owning group id. */
+	uint32_t mode;     /* Mode of the file. */
+	int32_t nlinks;    /* Number of hard links to the entry. */
+	uint8_t type;      /* File type. */
+	uint8_t dir_link;  /* Whether this is symlink to a directory. */
+	uint8_t slow_link; /* Whether this symlink has a slow target. */
+	uint8_t pad[5];    /* Explicit padding to not write garbage. */
+}
+snap_entry_t;
+
+/* Snapshot file as seen by pruning. */
+typedef struct
+{
+	char *name;              /* Name of the file. */
+	time_t mtime;            /* Time of the last use of the snapshot. */
+	unsigned long long size; /* Size of the file. */
+}
+snap_file_t;
+
+#ifndef _WIN32
+
+static void prune_snaps(const char snaps_dir[], unsigned long long max_size,
+		const char keep[]);
+static int snap_file_mtime_cmp(const void *a, const void *b);
+static void get_snap_path(const char snaps_dir[], const char path[],
+		char buf[], size_t buf_len);
+static int write_snap(FILE *fp, const char path[], const filemon_t *mon,
+		const dir_entry_t entries[], int nentries);
+static int parse_snap(const char data[], size_t size, const char path[],
+		struct str_arena_t *arena, filemon_t *mon, dir_entry_t **entries,
+		int *nentries);
+
+#endif
+
+int
+flist_snap_save(const char snaps_dir[], const char path[],
+		const filemon_t *mon, const dir_entry_t entries[], int nentries)
+{
+#ifndef _WIN32
+	if(make_path(snaps_dir, S_IRWXU) != 0)
+	{
+		return 1;
+	}
+
+	char snap_path[PATH_MAX + 1];
+	get_snap_path(snaps_dir, path, snap_path, sizeof(snap_path));
+
+	/* Writing to a temporary file and renaming it makes update of a snapshot
+	 * atomic for concurrent readers and writers. */
+	char tmp_path[PATH_MAX + 16];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.XXXXXX", snap_path);
+	const int fd = mkstemp(tmp_path);
+	if(fd == -1)
+	{
+		LOG_SERROR_MSG(errno, "Can't create \"%s\"", tmp_path);
+		return 1;
+	}
+
+	FILE *const fp = fdopen(fd, "wb");
+	if(fp == NULL)
+	{
+		close(fd);
+		(void)unlink(tmp_path);
+		return 1;
+	}
+
+	int error = write_snap(fp, path, mon, entries, nentries);
+	error |= (fclose(fp) != 0);
+	error = error || (os_rename(tmp_path, snap_path) != 0);
+	if(error)
+	{
+		LOG_ERROR_MSG("Failed to write snapshot of \"%s\"", path);
+		(void)unlink(tmp_path);
+		return 1;
+	}
+
+	prune_snaps(snaps_dir, MAX_SNAPS_SIZE, snap_path);
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+int
+flist_snap_load(const char snaps_dir[], const char path[],
+		struct str_arena_t *arena, filemon_t *mon, dir_entry_t **entries,
+		int *nentries)
+{
+#ifndef _WIN32
+	char snap_path[PATH_MAX + 1];
+	get_snap_path(snaps_dir, path, snap_path, sizeof(snap_path));
+
+	const int fd = open(snap_path, O_RDONLY);
+	if(fd == -1)
+	{
+		return 1;
+	}
+
+	struct stat s;
+	if(fstat(fd, &s) != 0 || s.st_size < (off_t)sizeof(snap_header_t))
+	{
+		close(fd);
+		return 1;
+	}
+
+	const size_t size = s.st_size;
+	void *const data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(data == MAP_FAILED)
+	{
+		LOG_SERROR_MSG(errno, "Can't mmap() \"%s\"", snap_path);
+		close(fd);
+		return 1;
+	}
+
+	const int error = parse_snap(data, size, path, arena, mon, entries,
+			nentries);
+	munmap(data, size);
+
+	if(error)
+	{
+		LOG_INFO_MSG("Ignoring invalid snapshot of \"%s\"", path);
+	}
+	else
+	{
+		/* Modification time serves as time of the last use for pruning. */
+		(void)futimens(fd, NULL);
+	}
+	close(fd);
+	return error;
+#else
+	return 1;
+#endif
+}
+
+void
+flist_snap_prune(const char snaps_dir[], unsigned long long max_size)
+{
+#ifndef _WIN32
+	prune_snaps(snaps_dir, max_size, /*keep=*/NULL);
+#endif
+}
+
+#ifndef _WIN32
+
+/* Removes least recently used snapshots until their total size doesn't exceed
+ * max_size.  The keep parameter specifies path to a snapshot that shouldn't be
+ * removed and can be NULL.  Errors are ignored. */
+static void
+prune_snaps(const char snaps_dir[], unsigned long long max_size,
+		const char keep[])
+{
+	DIR *const dir = os_opendir(snaps_dir);
+	if(dir == NULL)
+	{
+		return;
+	}
+
+	snap_file_t *files = NULL;
+	int nfiles = 0;
+	unsigned long long total = 0ULL;
+
+	struct dirent *d;
+	while((d = os_readdir(dir)) != NULL)
+	{
+		/* Skip "." and "..", as well as temporary files that are being written. */
+		if(strchr(d->d_name, '.') != NULL)
+		{
+			continue;
+		}
+
+		char path[PATH_MAX + 1];
+		snprintf(path, sizeof(path), "%s/%s", snaps_dir, d->d_name);
+
+		struct stat s;
+		if(os_lstat(path, &s) != 0 || !S_ISREG(s.st_mode))
+		{
+			continue;
+		}
+
+		snap_file_t *const new_files = reallocarray(files, nfiles + 1,
+				sizeof(*files));
+		if(new_files == NULL)
+		{
+			break;
+		}
+		files = new_files;
+
+		files[nfiles].name = strdup(d->d_name);
+		if(files[nfiles].name == NULL)
+		{
+			break;
+		}
+		files[nfiles].mtime = s.st_mtime;
+		files[nfiles].size = s.st_size;
+		total += s.st_size;
+		++nfiles;
+	}
+	os_closedir(dir);
+
+	qsort(files, nfiles, sizeof(*files), &snap_file_mtime_cmp);
+
+	int i;
+	for(i = 0; i < nfiles; ++i)
+	{
+		char path[PATH_MAX + 1];
+		snprintf(path, sizeof(path), "%s/%s", snaps_dir, files[i].name);
+
+		if(total > max_size && (keep == NULL || strcmp(path, keep) != 0) &&
+				unlink(path) == 0)
+		{
+			total -= files[i].size;
+		}
+		free(files[i].name);
+	}
+	free(files);
+}
+
+/* qsort() callback that orders snapshot files from the least recently used.
+ * Returns standard -1, 0, 1 for comparisons. */
+static int
+snap_file_mtime_cmp(const void *a, const void *b)
+{
+	const snap_file_t *const first = a;
+	const snap_file_t *const second = b;
+	return (first->mtime > second->mtime) - (first->mtime < second->mtime);
+}
+
+/* Forms path to snapshot file of the directory. */
+static void
+get_snap_path(const char snaps_dir[], const char path[], char buf[],
+		size_t buf_len)
+{
+	const unsigned long long hash = XXH3_64bits(path, strlen(path));
+	snprintf(buf, buf_len, "%s/%016llx", snaps_dir, hash);
+}
+
+/* Writes snapshot into a file.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+write_snap(FILE *fp, const char path[], const filemon_t *mon,
+		const dir_entry_t entries[], int nentries)
+{
+	int i;
+	const size_t path_len = strlen(path);
+
+	snap_header_t header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SNAP_MAGIC, sizeof(header.magic));
+	header.hdr_size = sizeof(header);
+	header.entry_size = sizeof(snap_entry_t);
+	memcpy(&header.mon, mon, sizeof(*mon));
+	header.path_len = path_len;
+	header.nentries = nentries;
+	for(i = 0; i < nentries; ++i)
+	{
+		header.names_size += strlen(entries[i].name) + 1U;
+	}
+
+	static const char zeroes[8];
+	if(fwrite(&header, sizeof(header), 1, fp) != 1 ||
+			fwrite(path, path_len, 1, fp) != 1 ||
+			fwrite(zeroes, ALIGN(path_len + 1U) - path_len, 1, fp) != 1)
+	{
+		return 1;
+	}
+
+	uint64_t name_offset = 0U;
+	for(i = 0; i < nentries; ++i)
+	{
+		const dir_entry_t *const entry = &entries[i];
+
+		snap_entry_t record;
+		memset(&record, 0, sizeof(record));
+		record.size = entry->size;
+		record.mtime = entry->mtime;
+		record.atime = entry->atime;
+		record.ctime = entry->ctime;
+		record.inode = entry->inode;
+		record.name = name_offset;
+		record.uid = entry->uid;
+		record.gid = entry->gid;
+		record.mode = entry->mode;
+		record.nlinks = entry->nlinks;
+		record.type = entry->type;
+		record.dir_link = entry->dir_link;
+		record.slow_link = entry->slow_target;
+
+		if(fwrite(&record, sizeof(record), 1, fp) != 1)
+		{
+			return 1;
+		}
+
+		name_offset += strlen(entry->name) + 1U;
+	}
+
+	for(i = 0; i < nentries; ++i)
+	{
+		const char *const name = entries[i].name;
+		if(fwrite(name, strlen(name) + 1U, 1, fp) != 1)
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/* Validates contents of a snapshot file and turns it into list of entries.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+parse_snap(const char data[], size_t size, const char path[],
+		struct str_arena_t *arena, filemon_t *mon, dir_entry_t **entries,
+		int *nentries)
+{
+	snap_header_t header;
+	memcpy(&header, data, sizeof(header));
+
+	if(memcmp(header.magic, SNAP_MAGIC, sizeof(header.magic)) != 0 ||
+			header.hdr_size != sizeof(header) ||
+			header.entry_size != sizeof(snap_entry_t) ||
+			header.path_len != strlen(path) ||
+			header.nentries > (uint64_t)INT_MAX)
+	{
+		return 1;
+	}
+
+	const uint64_t path_size = ALIGN(header.path_len + 1U);
+	const uint64_t records_size = header.nentries*sizeof(snap_entry_t);
+	if(size - sizeof(header) < path_size ||
+			(size - sizeof(header) - path_size)/sizeof(snap_entry_t) <
+			header.nentries ||
+			size - sizeof(header) - path_size - records_size != header.names_size)
+	{
+		return 1;
+	}
+
+	const char *const stored_path = data + sizeof(header);
+	const char *const records = stored_path + path_size;
+	const char *const names = records + records_size;
+
+	/* This guards against collisions of hashes. */
+	if(memcmp(stored_path, path, header.path_len + 1U) != 0)
+	{
+		return 1;
+	}
+
+	/* Checking that the last name is terminated makes all names safe to use. */
+	if(header.names_size != 0U && names[header.names_size - 1U] != '\0')
+	{
+		return 1;
+	}
+
+	dir_entry_t *list = dynarray_extend(NULL, header.nentries*sizeof(*list));
+	if(list == NULL && header.nentries != 0U)
+	{
+		return 1;
+	}
+
+	int count = 0;
+	uint64_t i;
+	for(i = 0U; i < header.nentries; ++i)
+	{
+		snap_entry_t record;
+		memcpy(&record, records + i*sizeof(record), sizeof(record));
+
+		if(record.name >= header.names_size || record.type >= FT_COUNT)
+		{
+			break;
+		}
+
+		dir_entry_t *const entry = &list[count];
+		fentry_init(arena, entry, names + record.name);
+		if(entry->name == NULL)
+		{
+			break;
+		}
+		++count;
+
+		entry->size = record.size;
+		entry->mtime = record.mtime;
+		entry->atime = record.atime;
+		entry->ctime = record.ctime;
+		entry->inode = record.inode;
+		entry->uid = record.uid;
+		entry->gid = record.gid;
+		entry->mode = record.mode;
+		entry->nlinks = record.nlinks;
+		entry->type = record.type;
+		entry->dir_link = (record.dir_link != 0);
+		entry->slow_target = (record.slow_link != 0);
+	}
+
+	if(i != header.nentries)
+	{
+		free_dir_entries(&list, &count);
+		return 1;
+	}
+
+	memcpy(mon, &header.mon, sizeof(*mon));
+	*entries = list;
+	*nentries = count;
+	return 0;
+}
+
+#endif
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,54 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__FLIST_SNAP_H__
+#define VIFM__FLIST_SNAP_H__
+
+/* Snapshots of directory listings stored on disk.  A snapshot is a binary
+ * file with all entries of a directory along with their meta-data and state
+ * of the directory at the moment it was read.  Snapshots are specific to the
+ * system they were created on and are discarded on any mismatch. */
+
+#include "ui/ui.h"
+#include "utils/filemon.h"
+
+struct str_arena_t;
+
+/* Writes snapshot of the listing of the directory at path into snaps_dir
+ * (created if missing) replacing previous one.  mon describes state of the
+ * directory before it was read.  Returns zero on success, otherwise non-zero
+ * is returned. */
+int flist_snap_save(const char snaps_dir[], const char path[],
+		const filemon_t *mon, const dir_entry_t entries[], int nentries);
+
+/* Reads snapshot of the listing of the directory at path from snaps_dir.  Names
+ * of entries are allocated from the arena, origins are left unset.  On success
+ * sets *mon, *entries and *nentries.  Returns zero on success, otherwise
+ * non-zero is returned. */
+int flist_snap_load(const char snaps_dir[], const char path[],
+		struct str_arena_t *arena, filemon_t *mon, dir_entry_t **entries,
+		int *nentries);
+
+/* Removes least recently used snapshots from snaps_dir until their total size
+ * doesn't exceed max_size bytes.  Saving a snapshot does this automatically. */
+void flist_snap_prune(const char snaps_dir[], unsigned long long max_size);
+
+#endif /* VIFM__FLIST_SNAP_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
@@ -0,0 +1,421 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "hash_cache.h"
+
+#include <sys/stat.h> /* S_ISREG stat */
+#ifndef _WIN32
+#include <unistd.h> /* close() unlink() */
+#endif
+
+#include <errno.h> /* errno */
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* int64_t uint32_t uint64_t */
+#include <stdio.h> /* FILE fclose() fdopen() fread() fwrite() snprintf() */
+#include <stdlib.h> /* calloc() free() mkstemp() qsort() */
+#include <string.h> /* memcmp() memcpy() memset() strdup() */
+#include <time.h> /* time() */
+
+#include "compat/fs_limits.h"
+#include "compat/os.h"
+#include "compat/reallocarray.h"
+#include "utils/log.h"
+#include "utils/macros.h"
+
+/* Identifies cache files and version of their format. */
+#define CACHE_MAGIC "VIFMHSH1"
+
+/* Minimal number of slots in the table. */
+#define MIN_SLOTS 64U
+
+/* Header of a cache file. */
+typedef struct
+{
+	char magic[8];        /* CACHE_MAGIC without terminating null. */
+	uint32_t hdr_size;    /* Size of this structure to detect ABI changes. */
+	uint32_t record_size; /* Size of record_t to detect ABI changes. */
+	uint64_t nrecords;    /* Number of records that follow the header. */
+}
+cache_header_t;
+
+/* Single entry of the cache both in memory and on disk. */
+typedef struct
+{
+	hcache_key_t key;   /* State of the file. */
+	hcache_hash_t hash; /* Hash of its contents. */
+	uint64_t used;      /* Logical time of the last use of the entry. */
+}
+record_t;
+
+/* Records along with an open addressing hash table keyed by device and inode
+ * numbers. */
+struct hcache_t
+{
+	char *path;        /* Path to the file of the cache. */
+	int max_entries;   /* Maximum number of records to write to the file. */
+	record_t *records; /* Storage of records. */
+	size_t nrecords;   /* Number of records. */
+	size_t capacity;   /* Number of allocated records. */
+	int *slots;        /* Indexes of records or -1 for empty slots. */
+	size_t mask;       /* Mask to turn a hash into slot number. */
+	uint64_t clock;    /* Logical time, which never goes back. */
+	int modified;      /* Whether the cache needs to be written. */
+};
+
+static void read_records(hcache_t *cache, FILE *fp);
+static record_t * add_record(hcache_t *cache, const hcache_key_t *key);
+static int grow_table(hcache_t *cache);
+static void rehash(hcache_t *cache);
+static size_t find_slot(const hcache_t *cache, const hcache_key_t *key);
+static uint64_t hash_key(const hcache_key_t *key);
+static int write_records(hcache_t *cache, FILE *fp);
+static int usage_sorter(const void *first, const void *second);
+
+hcache_t *
+hcache_load(const char path[], int max_entries)
+{
+	hcache_t *const cache = calloc(1, sizeof(*cache));
+	if(cache == NULL)
+	{
+		return NULL;
+	}
+
+	cache->path = strdup(path);
+	cache->max_entries = max_entries;
+	if(cache->path == NULL || grow_table(cache) != 0)
+	{
+		hcache_free(cache);
+		return NULL;
+	}
+
+	/* Seconds since epoch make entries that weren't used for a while be older
+	 * even if they were used many times. */
+	cache->clock = time(NULL);
+
+	FILE *const fp = os_fopen(path, "rb");
+	if(fp != NULL)
+	{
+		read_records(cache, fp);
+		fclose(fp);
+	}
+
+	return cache;
+}
+
+/* Reads records from a cache file ignoring its contents if it's invalid. */
+static void
+read_records(hcache_t *cache, FILE *fp)
+{
+	cache_header_t header;
+	if(fread(&header, sizeof(header), 1, fp) != 1 ||
+			memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+			header.hdr_size != sizeof(header) ||
+			header.record_size != sizeof(record_t))
+	{
+		LOG_INFO_MSG("Ignoring invalid hash cache at \"%s\"", cache->path);
+		return;
+	}
+
+	uint64_t i;
+	for(i = 0U; i < header.nrecords; ++i)
+	{
+		record_t record;
+		if(fread(&record, sizeof(record), 1, fp) != 1)
+		{
+			break;
+		}
+
+		record_t *const added = add_record(cache, &record.key);
+		if(added == NULL)
+		{
+			break;
+		}
+		*added = record;
+
+		cache->clock = MAX(cache->clock, record.used);
+	}
+}
+
+int
+hcache_save(hcache_t *cache)
+{
+	if(!cache->modified)
+	{
+		return 0;
+	}
+
+#ifndef _WIN32
+	/* Writing to a temporary file and renaming it makes update of the cache
+	 * atomic for concurrent readers and writers. */
+	char tmp_path[PATH_MAX + 16];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.XXXXXX", cache->path);
+	const int fd = mkstemp(tmp_path);
+	if(fd == -1)
+	{
+		LOG_SERROR_MSG(errno, "Can't create \"%s\"", tmp_path);
+		return 1;
+	}
+
+	FILE *const fp = fdopen(fd, "wb");
+	if(fp == NULL)
+	{
+		close(fd);
+		(void)unlink(tmp_path);
+		return 1;
+	}
+
+	int error = write_records(cache, fp);
+	error |= (fclose(fp) != 0);
+	error = error || (os_rename(tmp_path, cache->path) != 0);
+	if(error)
+	{
+		LOG_ERROR_MSG("Failed to write hash cache to \"%s\"", cache->path);
+		(void)unlink(tmp_path);
+		return 1;
+	}
+
+	cache->modified = 0;
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+/* Drops least recently used records above the limit and writes the rest into
+ * the file.  Returns zero on success, otherwise non-zero is returned. */
+static int
+write_records(hcache_t *cache, FILE *fp)
+{
+	if(cache->nrecords > (size_t)cache->max_entries)
+	{
+		qsort(cache->records, cache->nrecords, sizeof(*cache->records),
+				&usage_sorter);
+		cache->nrecords = cache->max_entries;
+		rehash(cache);
+	}
+
+	const size_t nrecords = cache->nrecords;
+
+	cache_header_t header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+	header.hdr_size = sizeof(header);
+	header.record_size = sizeof(record_t);
+	header.nrecords = nrecords;
+
+	return fwrite(&header, sizeof(header), 1, fp) != 1
+	    || fwrite(cache->records, sizeof(record_t), nrecords, fp) != nrecords;
+}
+
+/* Sorts records so that recently used ones come first.  Returns standard -1,
+ * 0, 1 for comparisons. */
+static int
+usage_sorter(const void *first, const void *second)
+{
+	const record_t *const a = first;
+	const record_t *const b = second;
+	return (a->used < b->used) - (a->used > b->used);
+}
+
+void
+hcache_free(hcache_t *cache)
+{
+	if(cache != NULL)
+	{
+		free(cache->path);
+		free(cache->records);
+		free(cache->slots);
+		free(cache);
+	}
+}
+
+int
+hcache_make_key(const char path[], hcache_key_t *key)
+{
+#ifndef _WIN32
+	struct stat s;
+	if(os_stat(path, &s) != 0 || !S_ISREG(s.st_mode))
+	{
+		return 1;
+	}
+
+	key->dev = s.st_dev;
+	key->inode = s.st_ino;
+	key->size = s.st_size;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+	key->mtime = (int64_t)s.st_mtim.tv_sec*1000000000 + s.st_mtim.tv_nsec;
+	key->ctime = (int64_t)s.st_ctim.tv_sec*1000000000 + s.st_ctim.tv_nsec;
+#else
+	key->mtime = (int64_t)s.st_mtime*1000000000;
+	key->ctime = (int64_t)s.st_ctime*1000000000;
+#endif
+	return 0;
+#else
+	/* Inode numbers aren't available. */
+	return 1;
+#endif
+}
+
+int
+hcache_get(const hcache_t *cache, const hcache_key_t *key, hcache_hash_t *hash)
+{
+	const int idx = cache->slots[find_slot(cache, key)];
+	if(idx == -1)
+	{
+		return 1;
+	}
+
+	/* Entry for a different state of the file is useless. */
+	const record_t *const record = &cache->records[idx];
+	if(memcmp(&record->key, key, sizeof(*key)) != 0)
+	{
+		return 1;
+	}
+
+	*hash = record->hash;
+	return 0;
+}
+
+void
+hcache_put(hcache_t *cache, const hcache_key_t *key, const hcache_hash_t *hash)
+{
+	record_t *record;
+	const int idx = cache->slots[find_slot(cache, key)];
+	if(idx != -1)
+	{
+		record = &cache->records[idx];
+	}
+	else
+	{
+		record = add_record(cache, key);
+		if(record == NULL)
+		{
+			return;
+		}
+	}
+
+	record->key = *key;
+	record->hash = *hash;
+	record->used = ++cache->clock;
+	cache->modified = 1;
+}
+
+/* Adds a record for a file that isn't in the cache yet.  Returns the record or
+ * NULL on error. */
+static record_t *
+add_record(hcache_t *cache, const hcache_key_t *key)
+{
+	if((cache->nrecords + 1U)*2U > cache->mask + 1U && grow_table(cache) != 0)
+	{
+		return NULL;
+	}
+
+	if(cache->nrecords == cache->capacity)
+	{
+		const size_t capacity = cache->capacity*2U + 64U;
+		record_t *const records = reallocarray(cache->records, capacity,
+				sizeof(*records));
+		if(records == NULL)
+		{
+			return NULL;
+		}
+		cache->records = records;
+		cache->capacity = capacity;
+	}
+
+	const size_t slot = find_slot(cache, key);
+	if(cache->slots[slot] != -1)
+	{
+		/* Duplicated records can come from a damaged file. */
+		return NULL;
+	}
+
+	record_t *const record = &cache->records[cache->nrecords];
+	memset(record, 0, sizeof(*record));
+	record->key = *key;
+	cache->slots[slot] = cache->nrecords++;
+	return record;
+}
+
+/* Doubles size of the table and rehashes its contents.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+grow_table(hcache_t *cache)
+{
+	const size_t nslots = (cache->slots == NULL ? MIN_SLOTS
+	                                            : (cache->mask + 1U)*2U);
+	int *const slots = reallocarray(NULL, nslots, sizeof(*slots));
+	if(slots == NULL)
+	{
+		return 1;
+	}
+
+	free(cache->slots);
+	cache->slots = slots;
+	cache->mask = nslots - 1U;
+	rehash(cache);
+	return 0;
+}
+
+/* Rebuilds the table from records. */
+static void
+rehash(hcache_t *cache)
+{
+	size_t i;
+	for(i = 0U; i <= cache->mask; ++i)
+	{
+		cache->slots[i] = -1;
+	}
+
+	for(i = 0U; i < cache->nrecords; ++i)
+	{
+		cache->slots[find_slot(cache, &cache->records[i].key)] = i;
+	}
+}
+
+/* Finds slot of the file or an empty slot where it should be put.  Returns
+ * index of the slot. */
+static size_t
+find_slot(const hcache_t *cache, const hcache_key_t *key)
+{
+	size_t i = hash_key(key) & cache->mask;
+	while(cache->slots[i] != -1)
+	{
+		const record_t *const record = &cache->records[cache->slots[i]];
+		if(record->key.dev == key->dev && record->key.inode == key->inode)
+		{
+			break;
+		}
+		i = (i + 1U) & cache->mask;
+	}
+	return i;
+}
+
+/* Mixes device and inode numbers of the file.  Returns the hash. */
+static uint64_t
+hash_key(const hcache_key_t *key)
+{
+	uint64_t h = key->inode ^ (key->dev*0x9e3779b97f4a7c15ULL);
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	return h;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
@@ -0,0 +1,79 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__HASH_CACHE_H__
+#define VIFM__HASH_CACHE_H__
+
+/* Cache of hashes of file contents which is stored on disk.  A hash is
+ * associated with device and inode numbers of a file and is valid as long as
+ * its size, modification and change times remain the same.  Number of entries
+ * is bounded and the least recently used ones are dropped on saving. */
+
+#include <stdint.h> /* int64_t uint64_t */
+
+/* Identifies file along with the state of its contents. */
+typedef struct
+{
+	uint64_t dev;   /* Device number. */
+	uint64_t inode; /* Inode number. */
+	uint64_t size;  /* File size in bytes. */
+	int64_t mtime;  /* Modification time in nanoseconds. */
+	int64_t ctime;  /* Change time in nanoseconds. */
+}
+hcache_key_t;
+
+/* 128-bit hash of file contents. */
+typedef struct
+{
+	uint64_t high; /* Upper half of the hash. */
+	uint64_t low;  /* Lower half of the hash. */
+}
+hcache_hash_t;
+
+/* Opaque declaration of cache structure. */
+typedef struct hcache_t hcache_t;
+
+/* Reads cache from the file, which might not exist.  The cache is to hold at
+ * most max_entries entries.  Returns the cache or NULL on error. */
+hcache_t * hcache_load(const char path[], int max_entries);
+
+/* Writes cache to the file it was loaded from if it was changed.  Returns zero
+ * on success, otherwise non-zero is returned. */
+int hcache_save(hcache_t *cache);
+
+/* Frees the cache.  The cache can be NULL. */
+void hcache_free(hcache_t *cache);
+
+/* Makes key of the file (symbolic links are followed).  Returns zero on
+ * success, otherwise non-zero is returned. */
+int hcache_make_key(const char path[], hcache_key_t *key);
+
+/* Looks up hash of the file.  Doesn't change the cache and can be called from
+ * multiple threads at the same time.  Returns zero and sets *hash if the hash
+ * is found, otherwise non-zero is returned. */
+int hcache_get(const hcache_t *cache, const hcache_key_t *key,
+		hcache_hash_t *hash);
+
+/* Stores hash of the file or marks existing one as recently used. */
+void hcache_put(hcache_t *cache, const hcache_key_t *key,
+		const hcache_hash_t *hash);
+
+#endif /* VIFM__HASH_CACHE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
@@ -18,13 +18,13 @@
 
 #include "ioeta.h"
 
-#include <assert.h> /* assert() */
 #include <stddef.h> /* NULL size_t */
 #include <stdint.h> /* uint64_t */
 #include <stdlib.h> /* calloc() free() */
 
 #include "private/ioc.h"
 #include "private/ioeta.h"
+#include "private/manifest.h"
 #include "private/traverser.h"
 
 static VisitResult eta_visitor(const char full_path[], VisitAction action,
@@ -63,7 +63,14 @@ ioeta_calculate(ioeta_estim_t *estim, const char path[], int shallow, int deep)
 	}
 	else
 	{
-		(void)traverse(path, deep, &eta_visitor, estim);
+		if(estim->manifest == NULL)
+		{
+			estim->manifest = manifest_alloc();
+		}
+
+		manifest_begin(estim->manifest, path, deep);
+		const IoRes result = traverse(path, deep, &eta_visitor, estim);
+		manifest_end(estim->manifest, result == IO_RES_SUCCEEDED);
 	}
 }
 
@@ -79,17 +86,19 @@ eta_visitor(const char full_path[], VisitAction action, int deep, void *param)
 		return VR_CANCELLED;
 	}
 
+	manifest_record(estim->manifest, full_path, action, deep);
+
 	switch(action)
 	{
 		case VA_DIR_ENTER:
 			ioeta_add_dir(estim, full_path);
-			return VR_SKIP_DIR_LEAVE;
+			break;
 		case VA_FILE:
 			ioeta_add_file(estim, full_path, deep);
-			return VR_OK;
+			break;
 		case VA_DIR_LEAVE:
-			assert(0 && "Can't get here because of VR_SKIP_DIR_LEAVE.");
-			return VR_OK;
+			/* Only needed for recording the walk. */
+			break;
 	}
 
 	return VR_OK;
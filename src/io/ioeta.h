@@ -68,6 +68,10 @@ typedef struct ioeta_estim_t
 
 	/* Provides means for cancellation checking. */
 	io_cancellation_t cancellation;
+
+	/* Walks over subtrees done by estimation, which are reused by operations
+	 * instead of reading file system again.  Can be NULL. */
+	struct manifest_t *manifest;
 }
 ioeta_estim_t;
 
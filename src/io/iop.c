@@ -25,13 +25,20 @@
 #ifndef _WIN32
 #include <sys/ioctl.h> /* ioctl() */
 #endif
+#ifdef __linux__
+#include <sys/sendfile.h> /* sendfile() */
+#include <sys/syscall.h> /* __NR_copy_file_range */
+#endif
 #include <sys/stat.h> /* stat */
 #include <sys/types.h> /* mode_t */
-#include <unistd.h> /* symlink() unlink() */
+#include <unistd.h> /* SEEK_* ftruncate() lseek() read() ssize_t symlink()
+                       syscall() unlink() write() */
 
 #include <assert.h> /* assert() */
-#include <errno.h> /* EEXIST ENOENT EISDIR errno */
+#include <errno.h> /* EBADF EEXIST EINTR EINVAL EISDIR ENOENT ENOSYS ENOTSUP
+                       ENXIO EOPNOTSUPP EPERM ETXTBSY EXDEV errno */
 #include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* UINT64_MAX uint64_t */
 #include <stdio.h> /* FILE fpos_t fclose() fgetpos() fflush() fread() fseek()
                       fsetpos() fwrite() snprintf() */
 #include <stdlib.h> /* free() */
@@ -44,6 +51,7 @@
 #include "../utils/macros.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
+#include "../utils/test_helpers.h"
 #include "../utils/utf8.h"
 #include "../utils/utils.h"
 #include "private/ioc.h"
@@ -54,18 +62,54 @@
 /* Amount of data to transfer at once. */
 #define BLOCK_SIZE 32*1024
 
+/* Amount of data to transfer at once when copying is done by the kernel. */
+#define KERNEL_BLOCK_SIZE 4*1024*1024
+
 /* Amount of data after which data flush should be performed. */
 #define FLUSH_SIZE 256*1024*1024
 
 /* Type of io function used by retry_wrapper(). */
 typedef IoRes (*iop_func)(io_args_t *args);
 
+/* Result of copying file data by the kernel. */
+typedef enum
+{
+	KC_DONE,        /* All of the data was copied. */
+	KC_FAILED,      /* Copying has failed or was cancelled. */
+	KC_UNSUPPORTED, /* The method isn't applicable to the files, nothing was
+	                   copied. */
+}
+KernelCopyRes;
+
+/* Type of function that copies up to len bytes from current position of src_fd
+ * to current position of dst_fd advancing both.  Returns number of copied
+ * bytes, zero at the end of input or -1 on error with errno set. */
+typedef ssize_t (*kernel_copy_func)(int dst_fd, int src_fd, size_t len);
+
 static IoRes iop_mkfile_internal(io_args_t *args);
 static IoRes iop_mkdir_internal(io_args_t *args);
 static IoRes iop_rmfile_internal(io_args_t *args);
 static IoRes iop_rmdir_internal(io_args_t *args);
 static IoRes iop_cp_internal(io_args_t *args);
 static int clone_file(int dst_fd, int src_fd);
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+static int is_sparse(const struct stat *st);
+static KernelCopyRes copy_sparse(io_args_t *args, int dst_fd, int src_fd,
+		uint64_t size);
+static KernelCopyRes copy_extent(io_args_t *args, int dst_fd, int src_fd,
+		uint64_t len);
+#endif
+static KernelCopyRes copy_in_kernel(io_args_t *args, int dst_fd, int src_fd,
+		uint64_t len);
+#ifdef __linux__
+static KernelCopyRes kernel_copy_loop(io_args_t *args, int dst_fd, int src_fd,
+		uint64_t len, kernel_copy_func copy_func);
+static int is_copy_unsupported_error(int error);
+#ifdef __NR_copy_file_range
+static ssize_t copy_range_chunk(int dst_fd, int src_fd, size_t len);
+#endif
+static ssize_t sendfile_chunk(int dst_fd, int src_fd, size_t len);
+#endif
 #ifdef _WIN32
 static DWORD CALLBACK win_progress_cb(LARGE_INTEGER total,
 		LARGE_INTEGER transferred, LARGE_INTEGER stream_size,
@@ -76,6 +120,9 @@ static IoRes iop_ln_internal(io_args_t *args);
 static IoRes retry_wrapper(iop_func func, io_args_t *args);
 static IoRes io_res_from_code(int code);
 
+/* Number of invocations of copy_range_chunk() for tests. */
+TSTATIC int copy_range_calls;
+
 IoRes
 iop_mkfile(io_args_t *args)
 {
@@ -304,7 +351,7 @@ iop_cp_internal(io_args_t *args)
 
 	FILE *in, *out;
 	int error;
-	int cloned;
+	int copied;
 	struct stat src_st;
 	const char *open_mode = "wb";
 
@@ -520,7 +567,7 @@ iop_cp_internal(io_args_t *args)
 	}
 
 	error = 0;
-	cloned = 0;
+	copied = 0;
 
 	if(crs == IO_CRS_APPEND_TO_FILES)
 	{
@@ -543,13 +590,31 @@ iop_cp_internal(io_args_t *args)
 	{
 		if(clone_file(fileno(out), fileno(in)) == 0)
 		{
-			cloned = 1;
+			copied = 1;
 		}
 	}
 
-	/* TODO: use sendfile() if platform supports it. */
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+	/* Nothing has been read or written through the streams yet, so their file
+	 * descriptors can be used directly here and below. */
+	if(!error && !copied && crs != IO_CRS_APPEND_TO_FILES && is_sparse(&st))
+	{
+		const KernelCopyRes res = copy_sparse(args, fileno(out), fileno(in),
+				st.st_size);
+		error = (res == KC_FAILED);
+		copied = (res == KC_DONE);
+	}
+#endif
 
-	if(!error && !cloned)
+	if(!error && !copied)
+	{
+		const KernelCopyRes res = copy_in_kernel(args, fileno(out), fileno(in),
+				UINT64_MAX);
+		error = (res == KC_FAILED);
+		copied = (res == KC_DONE);
+	}
+
+	if(!error && !copied)
 	{
 		char block[BLOCK_SIZE];
 		/* Suppress possible false-positive compiler warning. */
@@ -671,6 +736,293 @@ clone_file(int dst_fd, int src_fd)
 #endif
 }
 
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+
+/* Checks whether file occupies less space than its size implies, that is it
+ * has holes.  Returns non-zero if so, otherwise zero is returned. */
+static int
+is_sparse(const struct stat *st)
+{
+	return S_ISREG(st->st_mode)
+	    && (uint64_t)st->st_blocks*512U < (uint64_t)st->st_size;
+}
+
+/* Copies only data extents of a file leaving holes in the destination.  Holes
+ * are reported as progress as if they were copied.  Destination must be empty.
+ * Returns status of the operation. */
+static KernelCopyRes
+copy_sparse(io_args_t *args, int dst_fd, int src_fd, uint64_t size)
+{
+	const char *const src = args->arg1.src;
+	uint64_t pos = 0U;
+
+	while(pos < size)
+	{
+		if(io_cancelled(args))
+		{
+			return KC_FAILED;
+		}
+
+		off_t data = lseek(src_fd, pos, SEEK_DATA);
+		if(data < 0 && errno == ENXIO)
+		{
+			/* The rest of the file is a hole. */
+			data = size;
+		}
+		else if(data < 0)
+		{
+			/* File system doesn't report holes or something is wrong with it, let
+			 * regular copying handle it. */
+			if(pos == 0U)
+			{
+				return KC_UNSUPPORTED;
+			}
+			(void)ioe_errlst_append(&args->result.errors, src, errno,
+					"Failed to find data in source file");
+			return KC_FAILED;
+		}
+
+		off_t hole = size;
+		if((uint64_t)data < size)
+		{
+			hole = lseek(src_fd, data, SEEK_HOLE);
+			if(hole < 0)
+			{
+				(void)ioe_errlst_append(&args->result.errors, src, errno,
+						"Failed to find hole in source file");
+				return KC_FAILED;
+			}
+		}
+
+		/* The file could have been extended while it's being copied, but only the
+		 * data that was there at the start is copied. */
+		data = MIN((uint64_t)data, size);
+		hole = MIN((uint64_t)hole, size);
+
+		ioeta_update(args->estim, NULL, NULL, 0, data - pos);
+
+		if(data < hole)
+		{
+			if(lseek(src_fd, data, SEEK_SET) < 0 || lseek(dst_fd, data, SEEK_SET) < 0)
+			{
+				(void)ioe_errlst_append(&args->result.errors, src, errno,
+						"Failed to seek to data of a file");
+				return KC_FAILED;
+			}
+
+			if(copy_extent(args, dst_fd, src_fd, hole - data) != KC_DONE)
+			{
+				return KC_FAILED;
+			}
+		}
+
+		pos = hole;
+	}
+
+	/* Skipped holes at the end don't change file size on their own. */
+	if(ftruncate(dst_fd, size) != 0)
+	{
+		(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, errno,
+				"Failed to set size of destination file");
+		return KC_FAILED;
+	}
+
+	return KC_DONE;
+}
+
+/* Copies len bytes from current position of src_fd to current position of
+ * dst_fd preferably in kernel.  Returns status of the operation, which is never
+ * KC_UNSUPPORTED. */
+static KernelCopyRes
+copy_extent(io_args_t *args, int dst_fd, int src_fd, uint64_t len)
+{
+	KernelCopyRes res = copy_in_kernel(args, dst_fd, src_fd, len);
+	if(res != KC_UNSUPPORTED)
+	{
+		return res;
+	}
+
+	char block[BLOCK_SIZE];
+	while(len != 0U)
+	{
+		if(io_cancelled(args))
+		{
+			return KC_FAILED;
+		}
+
+		const ssize_t nread = read(src_fd, block, MIN(len, sizeof(block)));
+		if(nread < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if(nread < 0)
+		{
+			(void)ioe_errlst_append(&args->result.errors, args->arg1.src, errno,
+					"Read from source file failed");
+			return KC_FAILED;
+		}
+		if(nread == 0)
+		{
+			/* The file was truncated, the rest is assumed to be zeroes. */
+			break;
+		}
+
+		ssize_t nwritten = 0;
+		while(nwritten != nread)
+		{
+			const ssize_t n = write(dst_fd, block + nwritten, nread - nwritten);
+			if(n < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if(n < 0)
+			{
+				(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, errno,
+						"Write to destination file failed");
+				return KC_FAILED;
+			}
+			nwritten += n;
+		}
+
+		len -= nread;
+		ioeta_update(args->estim, NULL, NULL, 0, nread);
+	}
+
+	return KC_DONE;
+}
+
+#endif
+
+/* Copies up to len bytes of data between two files without passing it through
+ * user space (copy_file_range() and then sendfile()) if possible.
+ * copy_file_range() makes copy-on-write copies on some file systems, so it's
+ * used only if fast file cloning is enabled.  Returns status of the
+ * operation. */
+static KernelCopyRes
+copy_in_kernel(io_args_t *args, int dst_fd, int src_fd, uint64_t len)
+{
+	KernelCopyRes res = KC_UNSUPPORTED;
+#ifdef __linux__
+#ifdef __NR_copy_file_range
+	if(args->arg4.fast_file_cloning)
+	{
+		res = kernel_copy_loop(args, dst_fd, src_fd, len, &copy_range_chunk);
+	}
+#endif
+	/* sendfile() is implemented via splice() and works between regular files
+	 * since Linux 2.6.33, so there is no point in calling splice() directly. */
+	if(res == KC_UNSUPPORTED)
+	{
+		res = kernel_copy_loop(args, dst_fd, src_fd, len, &sendfile_chunk);
+	}
+#else
+	(void)args;
+	(void)dst_fd;
+	(void)src_fd;
+	(void)len;
+#endif
+	return res;
+}
+
+#ifdef __linux__
+
+/* Copies up to len bytes between files in chunks using the specified
+ * function, updates progress and checks for cancellation after each chunk.
+ * Returns status of the operation. */
+static KernelCopyRes
+kernel_copy_loop(io_args_t *args, int dst_fd, int src_fd, uint64_t len,
+		kernel_copy_func copy_func)
+{
+	const int data_sync = args->arg4.data_sync;
+	uint64_t total = 0U;
+	uint64_t ncopied = 0U;
+
+	while(total != len)
+	{
+		if(io_cancelled(args))
+		{
+			return KC_FAILED;
+		}
+
+		const ssize_t n = copy_func(dst_fd, src_fd,
+				MIN(len - total, (uint64_t)KERNEL_BLOCK_SIZE));
+		if(n < 0)
+		{
+			if(total == 0U && is_copy_unsupported_error(errno))
+			{
+				return KC_UNSUPPORTED;
+			}
+
+			(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, errno,
+					"Copying data to destination file failed");
+			return KC_FAILED;
+		}
+
+		if(n == 0)
+		{
+			/* Files of some pseudo file systems look empty to the kernel, let reading
+			 * them in user space figure out whether that's true. */
+			return (total == 0U ? KC_UNSUPPORTED : KC_DONE);
+		}
+
+		total += n;
+		ioeta_update(args->estim, NULL, NULL, 0, n);
+
+		/* Force flushing data to disk to not pollute RAM with this data too
+		 * much. */
+		ncopied += n;
+		if(data_sync && ncopied >= FLUSH_SIZE)
+		{
+			(void)os_fdatasync(dst_fd);
+			ncopied -= FLUSH_SIZE;
+		}
+	}
+
+	return KC_DONE;
+}
+
+/* Checks whether error of a kernel copy function means that it can't handle
+ * this pair of files rather than that copying has failed.  Returns non-zero if
+ * so, otherwise zero is returned. */
+static int
+is_copy_unsupported_error(int error)
+{
+	return error == ENOSYS
+	    || error == EXDEV
+	    || error == EINVAL
+	    || error == EBADF
+	    || error == EOPNOTSUPP
+	    || error == ENOTSUP
+	    || error == ETXTBSY
+	    /* Can be returned by seccomp filters of containers. */
+	    || error == EPERM;
+}
+
+#ifdef __NR_copy_file_range
+
+/* Copies a chunk of data with copy_file_range(), which can reflink or copy on
+ * server side for network file systems.  It's invoked via syscall() because
+ * C library might lack a wrapper for it.  Returns number of copied bytes, zero
+ * at the end of input or -1 on error. */
+static ssize_t
+copy_range_chunk(int dst_fd, int src_fd, size_t len)
+{
+	++copy_range_calls;
+	return syscall(__NR_copy_file_range, src_fd, NULL, dst_fd, NULL, len, 0U);
+}
+
+#endif
+
+/* Copies a chunk of data with sendfile().  Returns number of copied bytes, zero
+ * at the end of input or -1 on error. */
+static ssize_t
+sendfile_chunk(int dst_fd, int src_fd, size_t len)
+{
+	return sendfile(dst_fd, src_fd, NULL, len);
+}
+
+#endif
+
 #ifdef _WIN32
 
 static DWORD CALLBACK win_progress_cb(LARGE_INTEGER total,
@@ -19,6 +19,7 @@
 #ifndef VIFM__IO__IOP_H__
 #define VIFM__IO__IOP_H__
 
+#include "../utils/test_helpers.h"
 #include "ioc.h"
 
 /* iop - I/O primitive - Input/Output primitive */
@@ -58,6 +59,10 @@ IoRes iop_chmod(io_args_t *args);
  * link. */
 IoRes iop_ln(io_args_t *args);
 
+TSTATIC_DEFS(
+	int copy_range_calls;
+)
+
 #endif /* VIFM__IO__IOP_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -22,15 +22,19 @@
 #include <unistd.h> /* unlink() */
 
 #include <errno.h> /* EEXIST EISDIR ENOTEMPTY EXDEV errno */
-#include <stddef.h> /* NULL */
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
 #include <stdio.h> /* remove() snprintf() */
 #include <stdlib.h> /* free() */
-#include <string.h> /* strlen() */
+#include <string.h> /* strdup() strlen() */
 
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
+#include "../compat/pthread.h"
+#include "../compat/reallocarray.h"
 #include "../utils/fs.h"
 #include "../utils/log.h"
+#include "../utils/parallel.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
 #include "../utils/utils.h"
@@ -42,8 +46,60 @@
 #include "ioc.h"
 #include "iop.h"
 
+/* Files smaller than this are copied by a pool of threads, larger ones are
+ * copied one by one with detailed progress. */
+#define SMALL_FILE_SIZE (1024*1024)
+
+/* Maximum number of small files collected before they are copied. */
+#define CP_BATCH_SIZE 4096
+
+/* Small file that is copied by a pool of threads. */
+typedef struct
+{
+	char *src;           /* Path to the source file. */
+	char *dst;           /* Path to the destination file. */
+	uint64_t size;       /* Size of the file for progress reporting. */
+	int deep;            /* Whether symbolic links can be dereferenced. */
+	IoRes result;        /* Result of copying. */
+	ioe_errlst_t errors; /* Errors that occurred while copying. */
+}
+cp_job_t;
+
+/* State of copying a tree with small files copied concurrently. */
+typedef struct
+{
+	io_args_t *args; /* Arguments of ior_cp(). */
+
+	cp_job_t *jobs; /* Files collected for copying. */
+	size_t njobs;   /* Number of elements in jobs array. */
+
+	char **dirs;  /* Source directories that were left by traversal before all
+	                 of their files were copied. */
+	size_t ndirs; /* Number of elements in dirs array. */
+
+	pthread_mutex_t lock;   /* Protects fields below. */
+	size_t nfinished;       /* Number of copied jobs. */
+	uint64_t finished_size; /* Total size of copied jobs. */
+	size_t last_finished;   /* Index of the last copied job. */
+
+	size_t nreported;       /* Number of copied jobs reported as progress. */
+	uint64_t reported_size; /* Size of copied jobs reported as progress. */
+}
+cp_state_t;
+
 static VisitResult rm_visitor(const char full_path[], VisitAction action,
 		int deep, void *param);
+static IoRes cp_concurrently(io_args_t *args);
+static VisitResult cp_concurrent_visitor(const char full_path[],
+		VisitAction action, int deep, void *param);
+static VisitResult add_cp_job(cp_state_t *state, const char full_path[],
+		uint64_t size, int deep);
+static VisitResult finish_dir(cp_state_t *state, const char full_path[]);
+static VisitResult run_cp_jobs(cp_state_t *state);
+static void cp_job(size_t idx, void *arg);
+static int cp_poll(size_t ndone, void *arg);
+static void report_cp_progress(cp_state_t *state);
+static void drop_cp_jobs(cp_state_t *state);
 static VisitResult cp_visitor(const char full_path[], VisitAction action,
 		int deep, void *param);
 static IoRes mv_by_copy(io_args_t *args, int confirmed);
@@ -54,13 +110,14 @@ static VisitResult mv_visitor(const char full_path[], VisitAction action,
 		int deep, void *param);
 static VisitResult cp_mv_visitor(const char full_path[], VisitAction action,
 		void *param, int cp, int deep);
+static char * make_dst_path(const io_args_t *args, const char full_path[]);
 static VisitResult vr_from_io_res(IoRes result);
 
 IoRes
 ior_rm(io_args_t *args)
 {
 	const char *const path = args->arg1.path;
-	return traverse(path, /*deep=*/0, &rm_visitor, args);
+	return ioeta_traverse(args->estim, path, /*deep=*/0, &rm_visitor, args);
 }
 
 /* Implementation of traverse() visitor for subtree removal.  Returns 0 on
@@ -155,7 +212,296 @@ ior_cp(io_args_t *args)
 		}
 	}
 
-	return traverse(src, deep_copying, &cp_visitor, args);
+	/* Small files are copied concurrently only if user doesn't need to be
+	 * asked anything, which is the case for background operations. */
+	if(args->confirm == NULL && args->result.errors_cb == NULL)
+	{
+		return cp_concurrently(args);
+	}
+
+	return ioeta_traverse(args->estim, src, deep_copying, &cp_visitor, args);
+}
+
+/* Copies a tree creating directories in traversal order, while small files are
+ * copied in batches by a pool of threads.  Metadata of a directory is set
+ * after all of its files are copied.  Returns status. */
+static IoRes
+cp_concurrently(io_args_t *args)
+{
+	cp_state_t state = { .args = args };
+	if(pthread_mutex_init(&state.lock, NULL) != 0)
+	{
+		return ioeta_traverse(args->estim, args->arg1.src,
+				args->arg4.deep_copying, &cp_visitor, args);
+	}
+
+	IoRes result = ioeta_traverse(args->estim, args->arg1.src,
+			args->arg4.deep_copying, &cp_concurrent_visitor, &state);
+
+	/* Files visited before an error are still copied, just like they would be
+	 * without batching. */
+	if(result != IO_RES_ABORTED)
+	{
+		switch(run_cp_jobs(&state))
+		{
+			case VR_OK:
+			case VR_SKIP_DIR_LEAVE:
+				break;
+			case VR_ERROR:
+				result = IO_RES_FAILED;
+				break;
+			case VR_CANCELLED:
+				result = IO_RES_ABORTED;
+				break;
+		}
+	}
+
+	drop_cp_jobs(&state);
+	free(state.jobs);
+
+	size_t i;
+	for(i = 0U; i < state.ndirs; ++i)
+	{
+		free(state.dirs[i]);
+	}
+	free(state.dirs);
+
+	pthread_mutex_destroy(&state.lock);
+	return result;
+}
+
+/* Implementation of traverse() visitor for subtree copying that postpones
+ * copying of small files.  Returns 0 on success, otherwise non-zero is
+ * returned. */
+static VisitResult
+cp_concurrent_visitor(const char full_path[], VisitAction action, int deep,
+		void *param)
+{
+	cp_state_t *const state = param;
+
+	if(io_cancelled(state->args))
+	{
+		return VR_CANCELLED;
+	}
+
+	switch(action)
+	{
+		case VA_DIR_ENTER:
+			break;
+		case VA_FILE:
+			{
+				const int deref = deep && state->args->arg4.deep_copying;
+				const uint64_t size = deref ? get_target_file_size(full_path)
+				                            : get_file_size(full_path);
+				if(size < SMALL_FILE_SIZE)
+				{
+					return add_cp_job(state, full_path, size, deep);
+				}
+				break;
+			}
+		case VA_DIR_LEAVE:
+			return finish_dir(state, full_path);
+	}
+
+	return cp_mv_visitor(full_path, action, state->args, /*cp=*/1, deep);
+}
+
+/* Schedules copying of a small file, copies the whole batch when it's full.
+ * Returns result of the visit. */
+static VisitResult
+add_cp_job(cp_state_t *state, const char full_path[], uint64_t size, int deep)
+{
+	void *const p = reallocarray(state->jobs, state->njobs + 1,
+			sizeof(*state->jobs));
+	if(p == NULL)
+	{
+		(void)ioe_errlst_append(&state->args->result.errors, full_path, errno,
+				"Not enough memory");
+		return VR_ERROR;
+	}
+	state->jobs = p;
+
+	cp_job_t *const job = &state->jobs[state->njobs];
+	job->src = strdup(full_path);
+	job->dst = make_dst_path(state->args, full_path);
+	job->size = size;
+	job->deep = deep;
+	job->result = IO_RES_FAILED;
+	ioe_errlst_init(&job->errors);
+	job->errors.active = state->args->result.errors.active;
+	++state->njobs;
+
+	if(job->src == NULL || job->dst == NULL)
+	{
+		(void)ioe_errlst_append(&state->args->result.errors, full_path, errno,
+				"Not enough memory");
+		return VR_ERROR;
+	}
+
+	return (state->njobs < CP_BATCH_SIZE ? VR_OK : run_cp_jobs(state));
+}
+
+/* Sets metadata of a copied directory right away if none of its files are
+ * waiting to be copied, otherwise postpones it.  Returns result of the
+ * visit. */
+static VisitResult
+finish_dir(cp_state_t *state, const char full_path[])
+{
+	if(state->njobs == 0U)
+	{
+		return cp_mv_visitor(full_path, VA_DIR_LEAVE, state->args, /*cp=*/1,
+				/*deep=*/0);
+	}
+
+	char *const dir = strdup(full_path);
+	void *const p = reallocarray(state->dirs, state->ndirs + 1,
+			sizeof(*state->dirs));
+	if(dir == NULL || p == NULL)
+	{
+		free(dir);
+		(void)ioe_errlst_append(&state->args->result.errors, full_path, errno,
+				"Not enough memory");
+		return VR_ERROR;
+	}
+
+	state->dirs = p;
+	state->dirs[state->ndirs++] = dir;
+	return VR_OK;
+}
+
+/* Copies collected small files on several threads, merges their errors in
+ * traversal order and sets metadata of directories that were waiting for
+ * them.  Returns result of the visit. */
+static VisitResult
+run_cp_jobs(cp_state_t *state)
+{
+	state->nfinished = 0U;
+	state->finished_size = 0U;
+	state->nreported = 0U;
+	state->reported_size = 0U;
+
+	const int cancelled = par_for(state->njobs, par_nthreads(), &cp_job,
+			&cp_poll, state);
+	report_cp_progress(state);
+
+	VisitResult result = (cancelled ? VR_CANCELLED : VR_OK);
+
+	size_t i;
+	for(i = 0U; i < state->njobs; ++i)
+	{
+		cp_job_t *const job = &state->jobs[i];
+		ioe_errlst_splice(&state->args->result.errors, &job->errors);
+
+		if(result == VR_OK && job->result == IO_RES_FAILED)
+		{
+			result = VR_ERROR;
+		}
+		else if(job->result == IO_RES_ABORTED)
+		{
+			result = VR_CANCELLED;
+		}
+	}
+
+	drop_cp_jobs(state);
+
+	/* Like without batching, leaving directories after cancellation doesn't
+	 * happen. */
+	for(i = 0U; i < state->ndirs; ++i)
+	{
+		if(result != VR_CANCELLED)
+		{
+			const VisitResult dir_result = cp_mv_visitor(state->dirs[i],
+					VA_DIR_LEAVE, state->args, /*cp=*/1, /*deep=*/0);
+			if(result == VR_OK)
+			{
+				result = dir_result;
+			}
+		}
+		free(state->dirs[i]);
+	}
+	state->ndirs = 0U;
+
+	return result;
+}
+
+/* par_for() callback that copies a single small file. */
+static void
+cp_job(size_t idx, void *arg)
+{
+	cp_state_t *const state = arg;
+	cp_job_t *const job = &state->jobs[idx];
+	const io_args_t *const cp_args = state->args;
+
+	/* Progress is reported by the calling thread and there are no callbacks to
+	 * invoke. */
+	io_args_t args = {
+		.arg1.src = job->src,
+		.arg2.dst = job->dst,
+		.arg3.crs = cp_args->arg3.crs,
+		.arg4.fast_file_cloning = cp_args->arg4.fast_file_cloning,
+		.arg4.data_sync = cp_args->arg4.data_sync,
+		/* Deep copying may be suppressed for links that can't be copied. */
+		.arg4.deep_copying = job->deep && cp_args->arg4.deep_copying,
+
+		.cancellation = cp_args->cancellation,
+
+		.result.errors = job->errors,
+	};
+
+	job->result = (io_cancelled(&args) ? IO_RES_ABORTED : iop_cp(&args));
+	job->errors = args.result.errors;
+
+	pthread_mutex_lock(&state->lock);
+	++state->nfinished;
+	state->finished_size += job->size;
+	state->last_finished = idx;
+	pthread_mutex_unlock(&state->lock);
+}
+
+/* par_for() callback that reports progress of copying small files and checks
+ * for cancellation.  Returns non-zero to cancel. */
+static int
+cp_poll(size_t ndone, void *arg)
+{
+	cp_state_t *const state = arg;
+	report_cp_progress(state);
+	return io_cancelled(state->args);
+}
+
+/* Updates estimation with small files copied since the last update. */
+static void
+report_cp_progress(cp_state_t *state)
+{
+	pthread_mutex_lock(&state->lock);
+	const size_t nfinished = state->nfinished;
+	const uint64_t finished_size = state->finished_size;
+	const size_t last = state->last_finished;
+	pthread_mutex_unlock(&state->lock);
+
+	if(nfinished == state->nreported)
+	{
+		return;
+	}
+
+	ioeta_update_finished(state->args->estim, state->jobs[last].src,
+			state->jobs[last].dst, nfinished - state->nreported,
+			finished_size - state->reported_size);
+	state->nreported = nfinished;
+	state->reported_size = finished_size;
+}
+
+/* Frees collected small files along with their errors. */
+static void
+drop_cp_jobs(cp_state_t *state)
+{
+	size_t i;
+	for(i = 0U; i < state->njobs; ++i)
+	{
+		free(state->jobs[i].src);
+		free(state->jobs[i].dst);
+		ioe_errlst_free(&state->jobs[i].errors);
+	}
+	state->njobs = 0U;
 }
 
 /* Implementation of traverse() visitor for subtree copying.  Returns 0 on
@@ -361,7 +707,7 @@ mv_replacing_files(io_args_t *args)
 		}
 	}
 
-	return traverse(src, /*deep=*/0, &mv_visitor, args);
+	return ioeta_traverse(args->estim, src, /*deep=*/0, &mv_visitor, args);
 }
 
 /* Checks that path points to a file or symbolic link.  Returns non-zero if so,
@@ -388,21 +734,20 @@ cp_mv_visitor(const char full_path[], VisitAction action, void *param, int cp,
 		int deep)
 {
 	io_args_t *const cp_args = param;
-	const char *dst_full_path;
-	char *free_me = NULL;
 	VisitResult result = VR_OK;
-	const char *rel_part;
 
 	if(io_cancelled(cp_args))
 	{
 		return VR_CANCELLED;
 	}
 
-	/* TODO: come up with something better than this. */
-	rel_part = full_path + strlen(cp_args->arg1.src);
-	dst_full_path = (rel_part[0] == '\0')
-	              ? cp_args->arg2.dst
-	              : (free_me = join_paths(cp_args->arg2.dst, rel_part));
+	char *const dst_full_path = make_dst_path(cp_args, full_path);
+	if(dst_full_path == NULL)
+	{
+		(void)ioe_errlst_append(&cp_args->result.errors, full_path, errno,
+				"Not enough memory");
+		return VR_ERROR;
+	}
 
 	switch(action)
 	{
@@ -487,11 +832,23 @@ cp_mv_visitor(const char full_path[], VisitAction action, void *param, int cp,
 			}
 	}
 
-	free(free_me);
+	free(dst_full_path);
 
 	return result;
 }
 
+/* Maps path of a file of the tree being copied or moved to its destination.
+ * Returns newly allocated string or NULL on error. */
+static char *
+make_dst_path(const io_args_t *args, const char full_path[])
+{
+	/* TODO: come up with something better than this. */
+	const char *const rel_part = full_path + strlen(args->arg1.src);
+	return (rel_part[0] == '\0')
+	     ? strdup(args->arg2.dst)
+	     : join_paths(args->arg2.dst, rel_part);
+}
+
 /* Turns IoRes into VisitResult.  Returns VisitResult. */
 static VisitResult
 vr_from_io_res(IoRes result)
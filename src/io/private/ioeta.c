@@ -18,7 +18,7 @@
 
 #include "ioeta.h"
 
-#include <stddef.h> /* NULL */
+#include <stddef.h> /* NULL size_t */
 #include <stdint.h> /* uint64_t */
 #include <stdlib.h> /* free() */
 #include <string.h> /* strdup() */
@@ -27,12 +27,15 @@
 #include "../../utils/str.h"
 #include "../ioeta.h"
 #include "ionotif.h"
+#include "manifest.h"
+#include "traverser.h"
 
 void
 ioeta_release(ioeta_estim_t *estim)
 {
 	free(estim->item);
 	free(estim->target);
+	manifest_free(estim->manifest);
 }
 
 void
@@ -114,6 +117,44 @@ ioeta_update(ioeta_estim_t *estim, const char path[], const char target[],
 	ionotif_notify(IO_PS_IN_PROGRESS, estim);
 }
 
+void
+ioeta_update_finished(ioeta_estim_t *estim, const char path[],
+		const char target[], size_t count, uint64_t bytes)
+{
+	if(estim == NULL || estim->silent || count == 0U)
+	{
+		return;
+	}
+
+	estim->current_byte += bytes;
+	if(estim->current_byte > estim->total_bytes)
+	{
+		/* Estimations are out of date, update them. */
+		estim->total_bytes = estim->current_byte;
+	}
+
+	estim->current_item += count;
+	if(estim->current_item > estim->total_items)
+	{
+		/* Estimations are out of date, update them. */
+		estim->total_items = estim->current_item;
+	}
+	estim->current_file_byte = 0U;
+	estim->total_file_bytes = 0U;
+
+	if(path != NULL)
+	{
+		replace_string(&estim->item, path);
+	}
+
+	if(target != NULL)
+	{
+		replace_string(&estim->target, target);
+	}
+
+	ionotif_notify(IO_PS_IN_PROGRESS, estim);
+}
+
 int
 ioeta_silent_on(ioeta_estim_t *estim)
 {
@@ -144,6 +185,8 @@ ioeta_save(const ioeta_estim_t *estim)
 	ioeta_estim_t copy = *estim;
 	copy.item = (copy.item == NULL ? NULL : strdup(copy.item));
 	copy.target = (copy.target == NULL ? NULL : strdup(copy.target));
+	/* Recorded walks aren't part of the progress and stay with the original. */
+	copy.manifest = NULL;
 
 	return copy;
 }
@@ -153,6 +196,7 @@ ioeta_restore(ioeta_estim_t *estim, const ioeta_estim_t *save)
 {
 	char *item = estim->item;
 	char *target = estim->target;
+	struct manifest_t *manifest = estim->manifest;
 
 	if(estim->silent)
 	{
@@ -165,6 +209,20 @@ ioeta_restore(ioeta_estim_t *estim, const ioeta_estim_t *save)
 	*estim = *save;
 	estim->item = item;
 	estim->target = target;
+	estim->manifest = manifest;
+}
+
+IoRes
+ioeta_traverse(const ioeta_estim_t *estim, const char path[], int deep,
+		subtree_visitor visitor, void *param)
+{
+	IoRes result;
+	if(estim != NULL && manifest_replay(estim->manifest, path, deep, visitor,
+				param, &result) == 0)
+	{
+		return result;
+	}
+	return traverse(path, deep, visitor, param);
 }
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
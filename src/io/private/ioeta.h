@@ -19,9 +19,12 @@
 #ifndef VIFM__IO__PRIVATE__IOETA_H__
 #define VIFM__IO__PRIVATE__IOETA_H__
 
+#include <stddef.h> /* size_t */
 #include <stdint.h> /* uint64_t */
 
+#include "../ioc.h"
 #include "../ioeta.h"
+#include "traverser.h"
 
 /* ioeta - private functions of Input/Output estimation */
 
@@ -48,6 +51,13 @@ void ioeta_add_dir(ioeta_estim_t *estim, const char path[]);
 void ioeta_update(ioeta_estim_t *estim, const char path[], const char target[],
 		int finished, uint64_t bytes);
 
+/* Marks count items as processed in full at once, bytes is their total size.
+ * path and target are those of the last of the items and can be NULL.  When
+ * estim is NULL or count is zero, the function just returns.  Calls progress
+ * changed notification handler once. */
+void ioeta_update_finished(ioeta_estim_t *estim, const char path[],
+		const char target[], size_t count, uint64_t bytes);
+
 /* Silence future progress reports.  Returns previous state to be passed to
  * ioeta_silent_set() later.  If estim is NULL, returns zero. */
 int ioeta_silent_on(ioeta_estim_t *estim);
@@ -63,6 +73,12 @@ ioeta_estim_t ioeta_save(const ioeta_estim_t *estim);
 /* Restores estimation to its previous state. */
 void ioeta_restore(ioeta_estim_t *estim, const ioeta_estim_t *save);
 
+/* Same as traverse(), but replays walk recorded by ioeta_calculate() if there
+ * is one for the path instead of reading file system again.  estim can be
+ * NULL.  Returns status of traversal. */
+IoRes ioeta_traverse(const ioeta_estim_t *estim, const char path[], int deep,
+		subtree_visitor visitor, void *param);
+
 #endif /* VIFM__IO__PRIVATE__IOETA_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
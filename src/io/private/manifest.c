@@ -0,0 +1,466 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "manifest.h"
+
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint8_t uint32_t */
+#include <stdlib.h> /* calloc() free() malloc() */
+#include <string.h> /* memcpy() strcmp() strcpy() strdup() strlen() */
+#include <time.h> /* time() time_t */
+
+#include "../../compat/reallocarray.h"
+#include "../../utils/filemon.h"
+#include "../../utils/macros.h"
+
+/* Recording stops after this many entries in total, which is tens of megabytes
+ * of memory.  Larger subtrees are walked by operations anew. */
+#define MAX_ENTRIES (4U*1024U*1024U)
+
+/* Directories changed less than this many seconds before being recorded are
+ * always read anew, because their next change might not update the timestamp
+ * of change on file systems with coarse timestamps. */
+#define RACY_SECS 2
+
+/* Single recorded visit. */
+typedef struct
+{
+	uint32_t name;  /* Offset in the pool of names of the part of path that
+	                   follows path of the parent (whole path for the root). */
+	uint32_t leave; /* For VA_DIR_ENTER, index of matching VA_DIR_LEAVE. */
+	uint32_t mon;   /* For VA_DIR_ENTER, index of monitor of the directory. */
+	uint8_t action; /* VisitAction of the visit. */
+}
+entry_t;
+
+/* Recorded walk over a subtree. */
+typedef struct
+{
+	char *root;       /* Path at which the walk was started. */
+	size_t first;     /* Index of the first entry of the walk. */
+	size_t first_mon; /* Index of the first monitor of the walk. */
+	size_t max_path; /* Length of the longest path of the walk. */
+}
+walk_t;
+
+/* Directory whose VA_DIR_LEAVE wasn't recorded yet. */
+typedef struct
+{
+	size_t entry; /* Index of VA_DIR_ENTER entry. */
+	size_t len;   /* Length of path to the directory. */
+}
+dir_t;
+
+/* Recorded walks.  Entries and names of all walks share the same storage. */
+struct manifest_t
+{
+	entry_t *entries;   /* Visits of all walks. */
+	size_t nentries;    /* Number of elements in entries array. */
+	size_t entries_cap; /* Capacity of entries array. */
+
+	char *names;      /* Pool of null-terminated parts of paths. */
+	size_t names_len; /* Used length of names. */
+	size_t names_cap; /* Capacity of names. */
+
+	filemon_t *mons; /* States of directories at the time of recording. */
+	size_t nmons;    /* Number of elements in mons array. */
+	size_t mons_cap; /* Capacity of mons array. */
+
+	walk_t *walks;    /* Complete walks. */
+	size_t nwalks;    /* Number of elements in walks array. */
+	size_t walks_cap; /* Capacity of walks array. */
+
+	/* State of walk that's being recorded. */
+	walk_t walk;     /* The walk, its root is NULL if not recording. */
+	int failed;      /* Whether recording has failed. */
+	dir_t *dirs;     /* Stack of unfinished directories. */
+	size_t ndirs;    /* Depth of the stack. */
+	size_t dirs_cap; /* Capacity of the stack. */
+};
+
+static int add_entry(manifest_t *manifest, const char name[],
+		VisitAction action);
+static int add_mon(manifest_t *manifest, const char path[]);
+static int push_dir(manifest_t *manifest, size_t entry, size_t len);
+static int ensure_capacity(void **array, size_t *cap, size_t size,
+		size_t elem_size);
+static VisitResult replay_entry(const manifest_t *manifest, size_t *idx,
+		char path[], size_t len, subtree_visitor visitor, void *param);
+
+manifest_t *
+manifest_alloc(void)
+{
+	return calloc(1, sizeof(manifest_t));
+}
+
+void
+manifest_free(manifest_t *manifest)
+{
+	if(manifest == NULL)
+	{
+		return;
+	}
+
+	size_t i;
+	for(i = 0U; i < manifest->nwalks; ++i)
+	{
+		free(manifest->walks[i].root);
+	}
+	free(manifest->walks);
+
+	free(manifest->walk.root);
+	free(manifest->entries);
+	free(manifest->names);
+	free(manifest->mons);
+	free(manifest->dirs);
+	free(manifest);
+}
+
+void
+manifest_begin(manifest_t *manifest, const char root[], int deep)
+{
+	if(manifest == NULL)
+	{
+		return;
+	}
+
+	free(manifest->walk.root);
+	manifest->walk.root = NULL;
+
+	/* Whether a symbolic link makes a cycle depends on all of its parents, so
+	 * deep walks aren't recorded instead of replaying checks for cycles. */
+	if(deep)
+	{
+		return;
+	}
+
+	manifest->walk.root = strdup(root);
+	manifest->walk.first = manifest->nentries;
+	manifest->walk.first_mon = manifest->nmons;
+	manifest->walk.max_path = 0U;
+	manifest->failed = (manifest->walk.root == NULL);
+	manifest->ndirs = 0U;
+}
+
+void
+manifest_record(manifest_t *manifest, const char full_path[],
+		VisitAction action, int deep)
+{
+	if(manifest == NULL || manifest->walk.root == NULL || manifest->failed)
+	{
+		return;
+	}
+
+	const size_t len = strlen(full_path);
+	manifest->walk.max_path = MAX(manifest->walk.max_path, len);
+
+	if(action == VA_DIR_LEAVE)
+	{
+		if(manifest->ndirs == 0U || add_entry(manifest, "", action) != 0)
+		{
+			manifest->failed = 1;
+			return;
+		}
+
+		--manifest->ndirs;
+		manifest->entries[manifest->dirs[manifest->ndirs].entry].leave =
+			manifest->nentries - 1U;
+		return;
+	}
+
+	/* Only the part that isn't already known from the parent is stored, which
+	 * makes replaying yield the very same paths. */
+	size_t parent_len = 0U;
+	if(manifest->ndirs != 0U)
+	{
+		parent_len = manifest->dirs[manifest->ndirs - 1U].len;
+		if(len < parent_len)
+		{
+			manifest->failed = 1;
+			return;
+		}
+	}
+
+	if(add_entry(manifest, full_path + parent_len, action) != 0)
+	{
+		manifest->failed = 1;
+		return;
+	}
+
+	if(action == VA_DIR_ENTER)
+	{
+		manifest->entries[manifest->nentries - 1U].mon = manifest->nmons;
+		if(add_mon(manifest, full_path) != 0 ||
+				push_dir(manifest, manifest->nentries - 1U, len) != 0)
+		{
+			manifest->failed = 1;
+		}
+	}
+}
+
+void
+manifest_end(manifest_t *manifest, int complete)
+{
+	if(manifest == NULL || manifest->walk.root == NULL)
+	{
+		return;
+	}
+
+	/* Walk over a single file saves nothing. */
+	const int keep = complete && !manifest->failed && manifest->ndirs == 0U &&
+		manifest->nentries != manifest->walk.first &&
+		manifest->entries[manifest->walk.first].action == VA_DIR_ENTER &&
+		ensure_capacity((void **)&manifest->walks, &manifest->walks_cap,
+				manifest->nwalks + 1U, sizeof(*manifest->walks)) == 0;
+	if(keep)
+	{
+		manifest->walks[manifest->nwalks++] = manifest->walk;
+	}
+	else
+	{
+		/* Drop everything that was recorded for the walk. */
+		free(manifest->walk.root);
+		if(manifest->walk.first < manifest->nentries)
+		{
+			manifest->names_len = manifest->entries[manifest->walk.first].name;
+		}
+		manifest->nentries = manifest->walk.first;
+		manifest->nmons = manifest->walk.first_mon;
+	}
+
+	manifest->walk.root = NULL;
+	manifest->ndirs = 0U;
+}
+
+/* Appends an entry.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+add_entry(manifest_t *manifest, const char name[], VisitAction action)
+{
+	const size_t name_len = strlen(name) + 1U;
+	if(manifest->nentries >= MAX_ENTRIES ||
+			manifest->names_len + name_len > UINT32_MAX)
+	{
+		return 1;
+	}
+
+	if(ensure_capacity((void **)&manifest->entries, &manifest->entries_cap,
+				manifest->nentries + 1U, sizeof(*manifest->entries)) != 0)
+	{
+		return 1;
+	}
+	if(ensure_capacity((void **)&manifest->names, &manifest->names_cap,
+				manifest->names_len + name_len, 1U) != 0)
+	{
+		return 1;
+	}
+
+	entry_t *const entry = &manifest->entries[manifest->nentries++];
+	entry->name = manifest->names_len;
+	entry->leave = 0U;
+	entry->mon = 0U;
+	entry->action = action;
+
+	memcpy(manifest->names + manifest->names_len, name, name_len);
+	manifest->names_len += name_len;
+	return 0;
+}
+
+/* Appends state of a directory, which is captured before its entries are read
+ * by traverse().  Returns zero on success, otherwise non-zero is returned. */
+static int
+add_mon(manifest_t *manifest, const char path[])
+{
+	if(ensure_capacity((void **)&manifest->mons, &manifest->mons_cap,
+				manifest->nmons + 1U, sizeof(*manifest->mons)) != 0)
+	{
+		return 1;
+	}
+
+	filemon_t *const mon = &manifest->mons[manifest->nmons++];
+	if(filemon_from_file(path, FMT_CHANGED, mon) != 0)
+	{
+		return 0;
+	}
+
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+	const time_t changed = mon->ts.tv_sec;
+#else
+	const time_t changed = mon->ts;
+#endif
+	if(changed > time(NULL) - RACY_SECS)
+	{
+		filemon_reset(mon);
+	}
+	return 0;
+}
+
+/* Pushes directory onto the stack of unfinished ones.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+push_dir(manifest_t *manifest, size_t entry, size_t len)
+{
+	if(ensure_capacity((void **)&manifest->dirs, &manifest->dirs_cap,
+				manifest->ndirs + 1U, sizeof(*manifest->dirs)) != 0)
+	{
+		return 1;
+	}
+
+	dir_t *const dir = &manifest->dirs[manifest->ndirs++];
+	dir->entry = entry;
+	dir->len = len;
+	return 0;
+}
+
+/* Makes sure that array has room for at least size elements growing it
+ * geometrically.  Returns zero on success, otherwise non-zero is returned. */
+static int
+ensure_capacity(void **array, size_t *cap, size_t size, size_t elem_size)
+{
+	if(size <= *cap)
+	{
+		return 0;
+	}
+
+	const size_t new_cap = MAX(size, *cap*2U);
+	void *const p = reallocarray(*array, new_cap, elem_size);
+	if(p == NULL)
+	{
+		return 1;
+	}
+
+	*array = p;
+	*cap = new_cap;
+	return 0;
+}
+
+int
+manifest_replay(const manifest_t *manifest, const char root[], int deep,
+		subtree_visitor visitor, void *param, IoRes *result)
+{
+	if(manifest == NULL || deep)
+	{
+		return 1;
+	}
+
+	const walk_t *walk = NULL;
+	size_t i;
+	for(i = 0U; i < manifest->nwalks; ++i)
+	{
+		if(strcmp(manifest->walks[i].root, root) == 0)
+		{
+			walk = &manifest->walks[i];
+			break;
+		}
+	}
+	if(walk == NULL)
+	{
+		return 1;
+	}
+
+	char *const path = malloc(walk->max_path + 1U);
+	if(path == NULL)
+	{
+		return 1;
+	}
+
+	size_t idx = walk->first;
+	const VisitResult visit_result = replay_entry(manifest, &idx, path, 0U,
+			visitor, param);
+	free(path);
+
+	switch(visit_result)
+	{
+		case VR_OK:        *result = IO_RES_SUCCEEDED; break;
+		case VR_CANCELLED: *result = IO_RES_ABORTED; break;
+		default:           *result = IO_RES_FAILED; break;
+	}
+	return 0;
+}
+
+/* Replays an entry at *idx and everything under it if it's a directory.  path
+ * holds path of the parent, which is len characters long.  Directories that
+ * have changed since recording are traversed anew.  Advances *idx past the
+ * replayed entries.  Returns status of visitation. */
+static VisitResult
+replay_entry(const manifest_t *manifest, size_t *idx, char path[], size_t len,
+		subtree_visitor visitor, void *param)
+{
+	const entry_t *const entry = &manifest->entries[*idx];
+	const char *const name = manifest->names + entry->name;
+	const size_t path_len = len + strlen(name);
+	strcpy(path + len, name);
+
+	if(entry->action == VA_FILE)
+	{
+		++*idx;
+		return visitor(path, VA_FILE, /*deep=*/0, param);
+	}
+
+	const size_t leave = entry->leave;
+	*idx = leave + 1U;
+
+	/* Unchanged directory has the same entries and permissions, so it can still
+	 * be read, while changes of its subdirectories are checked on entering
+	 * them. */
+	filemon_t mon;
+	if(filemon_from_file(path, FMT_CHANGED, &mon) != 0 ||
+			!filemon_equal(&mon, &manifest->mons[entry->mon]))
+	{
+		switch(traverse(path, /*deep=*/0, visitor, param))
+		{
+			case IO_RES_SUCCEEDED: return VR_OK;
+			case IO_RES_ABORTED:   return VR_CANCELLED;
+
+			default:               return VR_ERROR;
+		}
+	}
+
+	/* Failing to enter a directory is reported as an error even on cancellation
+	 * by traverse(). */
+	const VisitResult enter_result = visitor(path, VA_DIR_ENTER, /*deep=*/0,
+			param);
+	if(enter_result == VR_ERROR || enter_result == VR_CANCELLED)
+	{
+		return VR_ERROR;
+	}
+
+	VisitResult result = VR_OK;
+	size_t child = (entry - manifest->entries) + 1U;
+	while(child < leave)
+	{
+		result = replay_entry(manifest, &child, path, path_len, visitor, param);
+		if(result != VR_OK)
+		{
+			break;
+		}
+	}
+
+	/* Children have appended their names to the path. */
+	path[path_len] = '\0';
+
+	if(result == VR_OK && enter_result != VR_SKIP_DIR_LEAVE)
+	{
+		result = visitor(path, VA_DIR_LEAVE, /*deep=*/0, param);
+	}
+
+	return result;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
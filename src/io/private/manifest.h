@@ -0,0 +1,59 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__IO__PRIVATE__MANIFEST_H__
+#define VIFM__IO__PRIVATE__MANIFEST_H__
+
+#include "../ioc.h"
+#include "traverser.h"
+
+/* manifest - recorded walks over file system subtrees */
+
+/* Opaque declaration of structure holding recorded walks. */
+typedef struct manifest_t manifest_t;
+
+/* Allocates empty manifest.  Returns NULL on error. */
+manifest_t * manifest_alloc(void);
+
+/* Frees the manifest.  manifest can be NULL. */
+void manifest_free(manifest_t *manifest);
+
+/* Starts recording a walk over subtree at root.  Only one walk can be recorded
+ * at a time.  Deep walks aren't recorded.  manifest can be NULL. */
+void manifest_begin(manifest_t *manifest, const char root[], int deep);
+
+/* Records a single visit of traverse() that is being recorded.  manifest can be
+ * NULL. */
+void manifest_record(manifest_t *manifest, const char full_path[],
+		VisitAction action, int deep);
+
+/* Finishes recording.  The walk is kept only if it's complete and recording
+ * didn't fail.  manifest can be NULL. */
+void manifest_end(manifest_t *manifest, int complete);
+
+/* Replays recorded walk over subtree at root exactly as traverse() would visit
+ * it.  Unchanged directories aren't read again, changed ones are traversed
+ * anew.  Returns non-zero if there is no matching walk, otherwise stores result
+ * of replaying in *result and returns zero. */
+int manifest_replay(const manifest_t *manifest, const char root[], int deep,
+		subtree_visitor visitor, void *param, IoRes *result);
+
+#endif /* VIFM__IO__PRIVATE__MANIFEST_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
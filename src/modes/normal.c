@@ -526,10 +526,11 @@ cmd_ctrl_b(key_info_t key_info, keys_info_t *keys_info)
 	fview_scroll_page_up(curr_view);
 }
 
-/* Resets selection and search highlight. */
+/* Resets selection and search highlight, cancels reading of a directory. */
 static void
 cmd_ctrl_c(key_info_t key_info, keys_info_t *keys_info)
 {
+	flist_cancel_loading(curr_view);
 	reset_search_results(curr_view);
 	flist_sel_stash(curr_view);
 	redraw_current_view();
@@ -49,6 +49,7 @@
 #include "utils/string_array.h"
 #include "utils/utils.h"
 #include "filelist.h"
+#include "flist_cache.h"
 #include "flist_hist.h"
 #include "registers.h"
 #include "search.h"
@@ -127,6 +128,9 @@ static const char * pick_out_decoration(char classify_item[], FileType *type,
 static int validate_decorations(const char prefix[], const char suffix[]);
 static void free_file_decs(file_dec_t *name_decs, int count);
 static void columns_handler(OPT_OP op, optval_t val);
+#ifndef _WIN32
+static void comparecache_handler(OPT_OP op, optval_t val);
+#endif
 static void confirm_handler(OPT_OP op, optval_t val);
 static void cpoptions_handler(OPT_OP op, optval_t val);
 static void cvoptions_handler(OPT_OP op, optval_t val);
@@ -153,6 +157,7 @@ static void iooptions_handler(OPT_OP op, optval_t val);
 static void keepsel_handler(OPT_OP op, optval_t val);
 static void laststatus_handler(OPT_OP op, optval_t val);
 static void lines_handler(OPT_OP op, optval_t val);
+static void listcache_handler(OPT_OP op, optval_t val);
 static void locateprg_handler(OPT_OP op, optval_t val);
 #ifndef _WIN32
 static void mediaprg_handler(OPT_OP op, optval_t val);
@@ -161,6 +166,9 @@ static void mintimeoutlen_handler(OPT_OP op, optval_t val);
 static void scroll_line_down(view_t *view);
 static void mouse_handler(OPT_OP op, optval_t val);
 static void navoptions_handler(OPT_OP op, optval_t val);
+#ifndef _WIN32
+static void prefetchmax_handler(OPT_OP op, optval_t val);
+#endif
 static void previewoptions_handler(OPT_OP op, optval_t val);
 static void quickview_handler(OPT_OP op, optval_t val);
 static void rulerformat_handler(OPT_OP op, optval_t val);
@@ -177,6 +185,9 @@ static optval_t make_sizefmt_value(void);
 static void slowfs_handler(OPT_OP op, optval_t val);
 #endif
 static void smartcase_handler(OPT_OP op, optval_t val);
+#ifndef _WIN32
+static void snapshotmin_handler(OPT_OP op, optval_t val);
+#endif
 static void sortnumbers_handler(OPT_OP op, optval_t val);
 static void dotfiles_global(OPT_OP op, optval_t val);
 static void dotfiles_local(OPT_OP op, optval_t val);
@@ -632,6 +643,12 @@ options[] = {
 	  OPT_INT, 0, NULL, &columns_handler, NULL,
 	  { .ref.int_val = &cfg.columns },
 	},
+#ifndef _WIN32
+	{ "comparecache", "", "max number of cached hashes of files",
+	  OPT_INT, 0, NULL, &comparecache_handler, NULL,
+	  { .ref.int_val = &cfg.compare_cache },
+	},
+#endif
 	{ "confirm", "cf", "confirm file operations",
 	  OPT_SET, ARRAY_LEN(confirm_vals), confirm_vals, &confirm_handler, NULL,
 	  { .ref.bool_val = &cfg.confirm },
@@ -739,6 +756,10 @@ options[] = {
 	  OPT_INT, 0, NULL, &lines_handler, NULL,
 	  { .ref.int_val = &cfg.lines },
 	},
+	{ "listcache", "", "memory for lists of recently visited directories",
+	  OPT_INT, 0, NULL, &listcache_handler, NULL,
+	  { .ref.int_val = &cfg.list_cache_size },
+	},
 	{ "locateprg", "", ":locate invocation format",
 	  OPT_STR, 0, NULL, &locateprg_handler, NULL,
 	  { .ref.str_val = &cfg.locate_prg },
@@ -762,6 +783,12 @@ options[] = {
 	  &navoptions_handler, NULL,
 	  { .init = &init_navoptions },
 	},
+#ifndef _WIN32
+	{ "prefetchmax", "", "max size of directories to read in advance",
+	  OPT_INT, 0, NULL, &prefetchmax_handler, NULL,
+	  { .ref.int_val = &cfg.prefetch_max },
+	},
+#endif
 	{ "previewoptions", "", "tweaks for how preview is done",
 	  OPT_STRLIST, ARRAY_LEN(previewoptions_vals), previewoptions_vals,
 	  &previewoptions_handler, NULL,
@@ -824,6 +851,12 @@ options[] = {
 	  OPT_BOOL, 0, NULL, &smartcase_handler, NULL,
 	  { .ref.bool_val = &cfg.smart_case },
 	},
+#ifndef _WIN32
+	{ "snapshotmin", "", "min size of directories to snapshot on disk",
+	  OPT_INT, 0, NULL, &snapshotmin_handler, NULL,
+	  { .ref.int_val = &cfg.snapshot_min },
+	},
+#endif
 	{ "sortnumbers", "", "version sorting for files",
 	  OPT_BOOL, 0, NULL, &sortnumbers_handler, NULL,
 	  { .ref.bool_val = &cfg.sort_numbers },
@@ -2097,6 +2130,24 @@ columns_handler(OPT_OP op, optval_t val)
 	vle_opts_assign("columns", val, OPT_GLOBAL);
 }
 
+#ifndef _WIN32
+/* Maximal number of hashes of file contents kept on disk for :compare. */
+static void
+comparecache_handler(OPT_OP op, optval_t val)
+{
+	if(val.int_val < 0)
+	{
+		vle_tb_append_linef(vle_err, "Argument must be >= 0: %d", val.int_val);
+		error = 1;
+		val.int_val = 0;
+		vle_opts_assign("comparecache", val, OPT_GLOBAL);
+		return;
+	}
+
+	cfg.compare_cache = val.int_val;
+}
+#endif
+
 static void
 confirm_handler(OPT_OP op, optval_t val)
 {
@@ -2472,6 +2523,23 @@ lines_handler(OPT_OP op, optval_t val)
 	vle_opts_assign("lines", val, OPT_GLOBAL);
 }
 
+/* Size of cache of directory lists in KiB. */
+static void
+listcache_handler(OPT_OP op, optval_t val)
+{
+	if(val.int_val < 0)
+	{
+		vle_tb_append_linef(vle_err, "Argument must be >= 0: %d", val.int_val);
+		error = 1;
+		val.int_val = 0;
+		vle_opts_assign("listcache", val, OPT_GLOBAL);
+		return;
+	}
+
+	cfg.list_cache_size = val.int_val;
+	flist_cache_trim();
+}
+
 /* Handles updates of the 'locateprg' option. */
 static void
 locateprg_handler(OPT_OP op, optval_t val)
@@ -2596,6 +2664,24 @@ navoptions_handler(OPT_OP op, optval_t val)
 	}
 }
 
+#ifndef _WIN32
+/* Maximal size of directories under cursor that are read in advance. */
+static void
+prefetchmax_handler(OPT_OP op, optval_t val)
+{
+	if(val.int_val < 0)
+	{
+		vle_tb_append_linef(vle_err, "Argument must be >= 0: %d", val.int_val);
+		error = 1;
+		val.int_val = 0;
+		vle_opts_assign("prefetchmax", val, OPT_GLOBAL);
+		return;
+	}
+
+	cfg.prefetch_max = val.int_val;
+}
+#endif
+
 /* Handles updates of the 'previewoptions' option. */
 static void
 previewoptions_handler(OPT_OP op, optval_t val)
@@ -2890,6 +2976,24 @@ smartcase_handler(OPT_OP op, optval_t val)
 	cfg.smart_case = val.bool_val;
 }
 
+#ifndef _WIN32
+/* Minimal size of directories for which listings are saved on disk. */
+static void
+snapshotmin_handler(OPT_OP op, optval_t val)
+{
+	if(val.int_val < 0)
+	{
+		vle_tb_append_linef(vle_err, "Argument must be >= 0: %d", val.int_val);
+		error = 1;
+		val.int_val = 0;
+		vle_opts_assign("snapshotmin", val, OPT_GLOBAL);
+		return;
+	}
+
+	cfg.snapshot_min = val.int_val;
+}
+#endif
+
 static void
 sortnumbers_handler(OPT_OP op, optval_t val)
 {
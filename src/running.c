@@ -42,6 +42,7 @@
 #include "cfg/info.h"
 #include "compat/fs_limits.h"
 #include "compat/os.h"
+#include "engine/keys.h"
 #include "int/file_magic.h"
 #include "int/fuse.h"
 #include "int/path_env.h"
@@ -127,6 +128,10 @@ static void output_to_statusbar(const char cmd[], view_t *view,
 static int output_to_preview(view_t *view, const char cmd[], MacroFlags flags);
 static void run_in_split(const view_t *view, const char cmd[], int vert_split,
 		int pause);
+#ifndef _WIN32
+static int stream_flist(view_t *view, const char cmd[], const char title[],
+		int user_sh, MacroFlags flags, int very);
+#endif
 static void path_handler(const char line[], void *arg);
 static void line_handler(const char line[], void *arg);
 
@@ -1471,6 +1476,21 @@ rn_for_flist(view_t *view, const char cmd[], const char title[], int user_sh,
 			curr_stats.ellipsis);
 	free(escaped_title);
 
+#ifndef _WIN32
+	/* List is shown as it comes only when there is a user interface to show it
+	 * and nothing that follows expects the list to be complete, which isn't the
+	 * case for scripts and mappings. */
+	if(!interactive && curr_stats.load_stage >= 3 &&
+			curr_stats.sourcing_state == SOURCING_NONE &&
+			vle_keys_mapping_state() == 0)
+	{
+		const int result = stream_flist(view, cmd, final_title, user_sh, flags,
+				very);
+		free(final_title);
+		return result;
+	}
+#endif
+
 	flist_custom_start(view, final_title);
 	free(final_title);
 
@@ -1501,6 +1521,42 @@ rn_for_flist(view_t *view, const char cmd[], const char title[], int user_sh,
 	return 0;
 }
 
+#ifndef _WIN32
+
+/* Runs the command in background and populates custom view of the view with
+ * its output as it arrives.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+stream_flist(view_t *view, const char cmd[], const char title[], int user_sh,
+		MacroFlags flags, int very)
+{
+	LOG_INFO_MSG("Streaming output of the command: %s", cmd);
+
+	FILE *input_tmp = make_in_file(view, flags);
+
+	FILE *out, *err;
+	setup_shellout_env();
+	const pid_t pid = bg_run_and_capture_group((char *)cmd, user_sh, input_tmp,
+			&out, &err);
+	cleanup_shellout_env();
+
+	if(input_tmp != NULL)
+	{
+		fclose(input_tmp);
+	}
+
+	if(pid == (pid_t)-1 ||
+			flist_custom_stream(view, title, pid, out, err, very) != 0)
+	{
+		show_error_msgf("Trouble running command", "Unable to run: %s", cmd);
+		return 1;
+	}
+
+	return 0;
+}
+
+#endif
+
 /* Implements process_cmd_output() callback that loads paths into custom
  * view. */
 static void
@@ -23,8 +23,9 @@
 
 #include <assert.h> /* assert() */
 #include <ctype.h>
-#include <stdlib.h> /* abs() */
-#include <string.h> /* strcmp() strrchr() */
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* abs() free() */
+#include <string.h> /* memcpy() strcmp() strdup() strrchr() */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
@@ -34,6 +35,7 @@
 #include "utils/fs.h"
 #include "utils/fsdata.h"
 #include "utils/macros.h"
+#include "utils/parallel.h"
 #include "utils/path.h"
 #include "utils/regexp.h"
 #include "utils/str.h"
@@ -43,6 +45,7 @@
 #include "utils/utils.h"
 #include "filelist.h"
 #include "filtering.h"
+#include "flist_index.h"
 #include "status.h"
 #include "types.h"
 
@@ -81,34 +84,145 @@ const char *sort_enum[] = {
 };
 ARRAY_GUARD(sort_enum, SK_TOTAL);
 
+/* Minimal number of entries for which sorting is performed by several
+ * threads. */
+#define PARALLEL_SORT_MIN 16384
+
+/* Minimal number of entries for which radix sort is used when all keys are
+ * integers. */
+#define RADIX_SORT_MIN 1024
+
+/* Minimal number of entries for which sorting after reload can reuse previous
+ * order. */
+#define INCREMENTAL_SORT_MIN 64
+
+/* Previous order isn't reused if more than one of this many entries has
+ * changed. */
+#define INCREMENTAL_SORT_RATIO 8
+
+/* Single key of sorting, keys are compared one after another until they
+ * differ. */
+typedef struct
+{
+	SortingKey type; /* What to compare. */
+	int descending;  /* Whether result of comparison is reversed. */
+	regex_t *regex;  /* Regular expression of SK_BY_GROUPS or NULL. */
+	int own_regex;   /* Whether regex was compiled for this key. */
+}
+sort_level_t;
+
+/* Value of a single key of an entry that is computed once per sorting to avoid
+ * deriving it from the entry on every comparison. */
+typedef struct
+{
+	const char *str;         /* String part of the key or NULL. */
+	const char *ext;         /* Extension inside of str or NULL. */
+	uint64_t num;            /* Numeric part of the key. */
+	unsigned int dot : 1;    /* Whether str starts with a dot. */
+	unsigned int owned : 1;  /* Whether str should be freed. */
+}
+sort_key_t;
+
+/* Entry as seen by sorting. */
+typedef struct
+{
+	sort_key_t *keys;          /* Values of all levels of sorting. */
+	const dir_entry_t *entry;  /* Entry itself. */
+	int pos;                   /* Position of the entry before sorting. */
+	unsigned int parent : 1;   /* Whether this is the ".." entry. */
+	unsigned int dir : 1;      /* Whether this is a directory. */
+}
+sort_item_t;
+
+/* Arguments of par_for() callback that fills items. */
+typedef struct
+{
+	const dir_entry_t *entries; /* Entries being sorted. */
+	sort_item_t *items;         /* Items to be filled. */
+	sort_key_t *keys;           /* Storage of keys of the items. */
+}
+item_maker_t;
+
+/* State of parallel merge sort. */
+typedef struct
+{
+	sort_item_t *src; /* Sorted runs of items. */
+	sort_item_t *dst; /* Destination of merged runs. */
+	size_t *bounds;   /* Boundaries of runs, nruns + 1 elements. */
+	int nruns;        /* Number of sorted runs. */
+}
+merge_state_t;
+
+/* Element of radix sort, which is an item along with its integer key for the
+ * current round of sorting. */
+typedef struct
+{
+	uint64_t key;       /* Key of the item, items are sorted in its order. */
+	sort_item_t *item;  /* Item being sorted. */
+}
+radix_rec_t;
+
+/* Task of sorting a subtree, argument of sort_tree_task(). */
+typedef struct
+{
+	dir_entry_t *entries;        /* Destination of sorted subtree. */
+	const dir_entry_t *children; /* Unsorted subtree. */
+	size_t nchildren;            /* Size of the subtree. */
+	int root;                    /* Whether this is the whole tree. */
+}
+tree_task_t;
+
 static void sort_tree_slice(dir_entry_t *entries, const dir_entry_t *children,
-		size_t nchildren, int root);
+		size_t nchildren, int root, par_tasks_t *tasks, int worker);
+static void sort_tree_task(par_tasks_t *tasks, int worker, void *task,
+		void *arg);
 static int prepare_for_sorting(view_t *v, int local);
-static int setup_linking(dir_entry_t *entries, int nentries);
-static void cleanup_linking(void);
+static int setup_keys(int nentries);
+static int setup_levels(void);
+static int add_level(SortingKey type, int descending, regex_t *regex,
+		int own_regex);
+static void add_group_levels(signed char key);
+static void cleanup_keys(void);
+static int is_changed(const dir_entry_t *entry, const dir_entry_t *prev);
+static int is_ordered(const sort_item_t items[], size_t nitems);
+static void merge_changed(const sort_item_t kept[], size_t nkept,
+		const sort_item_t changed[], size_t nchanged, sort_item_t out[]);
 static void sort_sequence(dir_entry_t *entries, size_t nentries);
-static void sort_by_groups(dir_entry_t *entries, signed char key,
+static void free_key_strs(sort_key_t keys[], size_t nkeys);
+static void make_item(size_t idx, void *arg);
+static void make_sort_key(const sort_level_t *level, sort_key_t *key,
+		const dir_entry_t *entry, int is_dir);
+static void set_key_str(sort_key_t *key, char str[], const char fallback[]);
+static char * get_group_str(const char name[], const regex_t *regex);
+static char * get_target_str(const dir_entry_t *entry);
+static uint64_t time_key(time_t time);
+static void parallel_sort(sort_item_t *items, size_t nitems, int nthreads);
+static int is_integer_key(SortingKey type);
+static int radix_sort(sort_item_t *items, size_t nitems);
+static uint64_t radix_key(const sort_item_t *item, int level);
+static radix_rec_t * radix_round(radix_rec_t *recs, radix_rec_t *tmp,
+		size_t nrecs);
+static void sort_run(size_t idx, void *arg);
+static void merge_runs(size_t idx, void *arg);
+static void permute_entries(dir_entry_t *entries, sort_item_t *items,
 		size_t nentries);
-static void sort_by_key(dir_entry_t *entries, size_t nentries, signed char key,
-		void *data);
 static char * map_ascii_clone(const char str[], int ignore_case);
 static char * map_ascii(const char str[], int ignore_case);
 static char * lowerdup(const char str[]);
-static int sort_dir_list(const void *one, const void *two);
+static int compare_items(const void *one, const void *two);
+static int compare_levels(const sort_item_t *first, const sort_item_t *second);
+static int compare_keys(const sort_level_t *level, const sort_item_t *f,
+		const sort_item_t *s, int i);
 TSTATIC int strnumcmp(const char s[], const char t[]);
 #if HAVE_STRVERSCMP_FUNC
 static char * skip_leading_zeros(const char str[]);
 #endif
-static int compare_file_names(const dir_entry_t *f, const dir_entry_t *s,
-		SortingKey sort_type);
-static int compare_file_exts(const dir_entry_t *f, int f_dir,
-		const dir_entry_t *s, int s_dir, SortingKey sort_type);
+static int compare_file_names(const sort_level_t *level, const sort_item_t *f,
+		const sort_key_t *fk, const sort_item_t *s, const sort_key_t *sk);
+static int compare_file_exts(const sort_level_t *level, const sort_item_t *f,
+		const sort_key_t *fk, const sort_item_t *s, const sort_key_t *sk);
 static int compare_name_part(const char s[], const char t[]);
-static int compare_file_sizes(const dir_entry_t *f, const dir_entry_t *s);
-static int compare_item_count(const dir_entry_t *f, int fdir,
-		const dir_entry_t *s, int sdir);
-static int compare_group(const char f[], const char s[], regex_t *regex);
-static int compare_targets(const dir_entry_t *f, const dir_entry_t *s);
+static int compare_targets(const sort_key_t *f, const sort_key_t *s);
 
 /* The following variables are set by prepare_for_sorting(). */
 
@@ -121,34 +235,33 @@ static const char *view_sort_groups;
 /* Whether the view displays custom file list. */
 static int custom_view;
 
-/* The following variables are set up by setup_linking() and managed by
- * sort_by_key(). */
-
-/* A key per entry in a currently processed sequence of entries.  The value in
- * principle can be anything, but it's either name or short path at the moment.
- *
- * An entry can be NULL in which case original entry's value should be used.
- * The check for NULL seems to work measurably faster (not using NULLs doubles
- * Unicode decomposition overhead from around 3% to 6%), otherwise NULLs could
- * be replaced by those values.  This probably happens because CPU doesn't need
- * to actually store that NULL anywhere on a check and data to use instead of
- * NULL is already available in CPU's cache. */
-static char **cached_keys;
-
-/* The following variables are set by sort_by_key(). */
-
-/* Whether it's descending sort. */
-static int sort_descending;
-/* Key used to sort entries in current sorting round. */
-static SortingKey sort_type;
-/* Sorting key specific data. */
-static void *sort_data;
+/* The following variables are set up by setup_keys() and freed by
+ * cleanup_keys().  They are only read during sorting. */
+
+/* Keys of sorting in the order of decreasing priority. */
+static sort_level_t *levels;
+/* Number of elements in the levels array. */
+static int nlevels;
+/* Items for all entries, which are what's actually sorted.  Entries are then
+ * rearranged to match the order of items. */
+static sort_item_t *sort_items;
+/* Keys of all entries, nlevels per entry. */
+static sort_key_t *sort_keys;
+/* Whether keys can be computed by several threads at the same time. */
+static int parallel_keys;
+/* Whether all keys are integers, which allows for using radix sort. */
+static int integer_keys;
+/* Start of the array that is being sorted, used to locate storage of items and
+ * keys for its parts. */
+static const dir_entry_t *sort_base;
 
 void
 sort_view(view_t *v)
 {
 	dir_entry_t *unsorted_list;
 
+	flist_index_reset(v);
+
 	if(prepare_for_sorting(v, /*local=*/1) != 0)
 	{
 		return;
@@ -158,10 +271,11 @@ sort_view(view_t *v)
 	 * resources, so skip it if we can. */
 	if(!custom_view || !cv_tree(v->custom.type))
 	{
-		if(setup_linking(v->dir_entry, v->list_rows) == 0)
+		if(setup_keys(v->list_rows) == 0)
 		{
+			sort_base = v->dir_entry;
 			sort_sequence(v->dir_entry, v->list_rows);
-			cleanup_linking();
+			cleanup_keys();
 		}
 		return;
 	}
@@ -175,7 +289,7 @@ sort_view(view_t *v)
 	}
 
 	/* This must be done after uncompressing custom tree. */
-	if(setup_linking(v->dir_entry, v->list_rows) != 0)
+	if(setup_keys(v->list_rows) != 0)
 	{
 		/* Compress custom tree back. */
 		filters_drop_temporaries(v, /*entries=*/NULL);
@@ -186,7 +300,30 @@ sort_view(view_t *v)
 	v->dir_entry = dynarray_extend(NULL, v->list_rows*sizeof(*v->dir_entry));
 	if(v->dir_entry != NULL)
 	{
-		sort_tree_slice(v->dir_entry, unsorted_list, v->list_rows, 1);
+		sort_base = v->dir_entry;
+
+		const int nthreads = par_nthreads();
+		tree_task_t *const task = malloc(sizeof(*task));
+		if(task != NULL && parallel_keys && nthreads > 1 &&
+				v->list_rows >= PARALLEL_SORT_MIN)
+		{
+			/* Subtrees are independent, so they are sorted concurrently.  Without
+			 * polling failure means that processing didn't even start. */
+			*task = (tree_task_t){ v->dir_entry, unsorted_list, v->list_rows, 1 };
+			if(par_run(task, nthreads, &sort_tree_task, /*poll_func=*/NULL,
+						/*arg=*/NULL) != 0)
+			{
+				free(task);
+				sort_tree_slice(v->dir_entry, unsorted_list, v->list_rows, 1,
+						/*tasks=*/NULL, /*worker=*/0);
+			}
+		}
+		else
+		{
+			free(task);
+			sort_tree_slice(v->dir_entry, unsorted_list, v->list_rows, 1,
+					/*tasks=*/NULL, /*worker=*/0);
+		}
 	}
 	else
 	{
@@ -195,246 +332,1023 @@ sort_view(view_t *v)
 		unsorted_list = NULL;
 	}
 
-	/* Done with linking data by now. */
-	cleanup_linking();
+	/* Done with the keys by now. */
+	cleanup_keys();
 
 	if(filter_is_empty(&v->local_filter.filter))
 	{
 		dynarray_free(unsorted_list);
 	}
-	else
+	else
+	{
+		/* This undoes effect of flist_custom_uncompress_tree() from above. */
+		filters_drop_temporaries(v, unsorted_list);
+	}
+}
+
+/* Sorts one level of a tree per invocation, sorting all nested trees either
+ * recursively or by spawning tasks if tasks isn't NULL. */
+static void
+sort_tree_slice(dir_entry_t *entries, const dir_entry_t *children,
+		size_t nchildren, int root, par_tasks_t *tasks, int worker)
+{
+	int i = 0;
+	size_t pos = 0U;
+	/* Copy all first-level nodes of the current tree forming a sequence for
+	 * sorting. */
+	while(pos < nchildren)
+	{
+		entries[i] = children[pos];
+		entries[i].child_pos = pos;
+		pos += children[pos].child_count + 1;
+		++i;
+	}
+
+	sort_sequence(entries, i);
+
+	/* Finish sorting of this level by placing nodes at their corresponding
+	 * position starting with the last one.  Each subtree is then sorted. */
+	pos = nchildren;
+	while(--i >= 0)
+	{
+		pos -= entries[i].child_count + 1;
+		entries[pos] = entries[i];
+		if(entries[pos].child_count != 0)
+		{
+			dir_entry_t *const sub_entries = &entries[pos + 1U];
+			const dir_entry_t *const sub_children =
+				&children[entries[pos].child_pos + 1];
+			const size_t sub_count = entries[pos].child_count;
+
+			tree_task_t *const task = (tasks == NULL ? NULL : malloc(sizeof(*task)));
+			if(task != NULL)
+			{
+				*task = (tree_task_t){ sub_entries, sub_children, sub_count, 0 };
+			}
+
+			/* Subtrees that failed to be spawned are sorted right away. */
+			if(task == NULL || par_spawn(tasks, worker, task) != 0)
+			{
+				free(task);
+				sort_tree_slice(sub_entries, sub_children, sub_count, 0, tasks,
+						worker);
+			}
+		}
+		entries[pos].child_pos = root ? 0 : pos + 1;
+	}
+}
+
+/* par_run() callback that sorts a subtree spawning tasks for its subtrees. */
+static void
+sort_tree_task(par_tasks_t *tasks, int worker, void *task, void *arg)
+{
+	tree_task_t *const tree_task = task;
+	sort_tree_slice(tree_task->entries, tree_task->children,
+			tree_task->nchildren, tree_task->root, tasks, worker);
+	free(tree_task);
+}
+
+void
+sort_entries(view_t *v, entries_t entries)
+{
+	if(prepare_for_sorting(v, /*local=*/0) != 0)
+	{
+		return;
+	}
+
+	if(setup_keys(entries.nentries) == 0)
+	{
+		sort_base = entries.entries;
+		sort_sequence(entries.entries, entries.nentries);
+		cleanup_keys();
+	}
+}
+
+int
+sort_view_incremental(view_t *v, const dir_entry_t prev_list[], int prev_len,
+		const int prev[])
+{
+	const size_t nentries = v->list_rows;
+
+	flist_index_reset(v);
+
+	if(nentries < INCREMENTAL_SORT_MIN ||
+			prepare_for_sorting(v, /*local=*/1) != 0)
+	{
+		return 1;
+	}
+	if(custom_view && cv_tree(v->custom.type))
+	{
+		return 1;
+	}
+	if(setup_keys(nentries) != 0)
+	{
+		return 1;
+	}
+
+	dir_entry_t *const entries = v->dir_entry;
+	sort_base = entries;
+
+	/* Maps previous position of an unchanged entry to its current position. */
+	int *const by_prev = reallocarray(NULL, MAX(prev_len, 1), sizeof(*by_prev));
+	sort_item_t *const kept = reallocarray(NULL, nentries, sizeof(*kept));
+	sort_item_t *const changed = reallocarray(NULL, nentries, sizeof(*changed));
+	if(by_prev == NULL || kept == NULL || changed == NULL)
+	{
+		free(by_prev);
+		free(kept);
+		free(changed);
+		cleanup_keys();
+		return 1;
+	}
+
+	size_t i;
+	for(i = 0U; i < (size_t)prev_len; ++i)
+	{
+		by_prev[i] = -1;
+	}
+	for(i = 0U; i < nentries; ++i)
+	{
+		if(prev[i] >= 0 && !is_changed(&entries[i], &prev_list[prev[i]]))
+		{
+			by_prev[prev[i]] = i;
+		}
+	}
+
+	item_maker_t maker = {
+		.entries = entries,
+		.items = sort_items,
+		.keys = sort_keys,
+	};
+	for(i = 0U; i < nentries; ++i)
+	{
+		make_item(i, &maker);
+	}
+
+	size_t nkept = 0U, nchanged = 0U;
+	for(i = 0U; i < (size_t)prev_len; ++i)
+	{
+		if(by_prev[i] >= 0)
+		{
+			kept[nkept++] = sort_items[by_prev[i]];
+		}
+	}
+	for(i = 0U; i < nentries; ++i)
+	{
+		if(prev[i] < 0 || by_prev[prev[i]] != (int)i)
+		{
+			changed[nchanged++] = sort_items[i];
+		}
+	}
+
+	/* Previous order is checked because it could have been produced with
+	 * different settings. */
+	const int reuse = (nchanged*INCREMENTAL_SORT_RATIO <= nentries)
+	               && is_ordered(kept, nkept);
+	if(reuse)
+	{
+		safe_qsort(changed, nchanged, sizeof(*changed), &compare_items);
+		merge_changed(kept, nkept, changed, nchanged, sort_items);
+	}
+
+	free_key_strs(sort_keys, nentries*nlevels);
+
+	if(reuse)
+	{
+		permute_entries(entries, sort_items, nentries);
+	}
+
+	free(by_prev);
+	free(kept);
+	free(changed);
+	cleanup_keys();
+	return !reuse;
+}
+
+/* Checks whether entry might compare differently than its previous version.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+is_changed(const dir_entry_t *entry, const dir_entry_t *prev)
+{
+	if(entry->type != prev->type || entry->dir_link != prev->dir_link ||
+			entry->size != prev->size || entry->mtime != prev->mtime ||
+			entry->atime != prev->atime || entry->ctime != prev->ctime)
+	{
+		return 1;
+	}
+
+#ifndef _WIN32
+	if(entry->mode != prev->mode || entry->inode != prev->inode ||
+			entry->uid != prev->uid || entry->gid != prev->gid ||
+			entry->nlinks != prev->nlinks)
+	{
+		return 1;
+	}
+#endif
+
+	/* Some keys aren't stored in entries and might have changed on their own. */
+	int i;
+	for(i = 0; i < nlevels; ++i)
+	{
+		switch(levels[i].type)
+		{
+			case SK_BY_SIZE:
+			case SK_BY_NITEMS:
+				if(fentry_is_dir(entry))
+				{
+					return 1;
+				}
+				break;
+
+			case SK_BY_TARGET:
+				if(entry->type == FT_LINK)
+				{
+					return 1;
+				}
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	return 0;
+}
+
+/* Checks whether items are sorted.  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+is_ordered(const sort_item_t items[], size_t nitems)
+{
+	size_t i;
+	for(i = 1U; i < nitems; ++i)
+	{
+		if(compare_levels(&items[i - 1U], &items[i]) > 0)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Merges sorted changed items into sorted kept items by looking up position of
+ * each changed item via binary search.  Changed items go after equal kept
+ * ones. */
+static void
+merge_changed(const sort_item_t kept[], size_t nkept,
+		const sort_item_t changed[], size_t nchanged, sort_item_t out[])
+{
+	size_t from = 0U;
+	size_t i;
+	for(i = 0U; i < nchanged; ++i)
+	{
+		size_t l = from, r = nkept;
+		while(l < r)
+		{
+			const size_t m = l + (r - l)/2U;
+			if(compare_levels(&kept[m], &changed[i]) <= 0)
+			{
+				l = m + 1U;
+			}
+			else
+			{
+				r = m;
+			}
+		}
+
+		memcpy(out, &kept[from], (l - from)*sizeof(*out));
+		out += l - from;
+		*out++ = changed[i];
+		from = l;
+	}
+
+	memcpy(out, &kept[from], (nkept - from)*sizeof(*out));
+}
+
+/* Prepares globals of this unit for performing sorting.  Returns non-zero if
+ * there is no sorting to do. */
+static int
+prepare_for_sorting(view_t *v, int local)
+{
+	const signed char *sort = (local ? v->sort : v->sort_g);
+	if(sort[0] > SK_LAST)
+	{
+		/* Completely skip sorting if primary key isn't set. */
+		return 1;
+	}
+
+	view = v;
+	view_sort = sort;
+	view_sort_groups = (local ? v->sort_groups : v->sort_groups_g);
+	custom_view = flist_custom_active(v);
+	return 0;
+}
+
+/* Prepares keys of sorting and allocates storage for items of up to nentries
+ * entries.  Use cleanup_keys() to free it.  Returns zero on success. */
+static int
+setup_keys(int nentries)
+{
+	if(setup_levels() != 0)
+	{
+		cleanup_keys();
+		return 1;
+	}
+
+	sort_items = reallocarray(NULL, MAX(nentries, 1), sizeof(*sort_items));
+	sort_keys = reallocarray(NULL, (size_t)MAX(nentries, 1)*nlevels,
+			sizeof(*sort_keys));
+	if(sort_items == NULL || sort_keys == NULL)
+	{
+		cleanup_keys();
+		return 1;
+	}
+
+	/* Computing these keys might involve updating caches or querying user
+	 * interface. */
+	parallel_keys = 1;
+	integer_keys = 1;
+	int i;
+	for(i = 0; i < nlevels; ++i)
+	{
+		if(levels[i].type == SK_BY_SIZE || levels[i].type == SK_BY_NITEMS)
+		{
+			parallel_keys = 0;
+		}
+		if(!is_integer_key(levels[i].type))
+		{
+			integer_keys = 0;
+		}
+	}
+
+	return 0;
+}
+
+/* Composes list of keys to compare entries by.  Sorting by a key after sorting
+ * by keys of lower priority in a stable way is equivalent to comparing by all
+ * of them at once.  Returns zero on success. */
+static int
+setup_levels(void)
+{
+	nlevels = 0;
+
+	if(!ui_view_sort_list_contains(view_sort, SK_BY_DIR))
+	{
+		if(add_level(SK_BY_DIR, 0, NULL, 0) != 0)
+		{
+			return 1;
+		}
+	}
+
+	int i;
+	for(i = 0; i < SK_COUNT; ++i)
+	{
+		const signed char sorting_key = view_sort[i];
+		const int sorting_type = abs(sorting_key);
+
+		if(sorting_type > SK_LAST)
+		{
+			continue;
+		}
+
+		if(sorting_type == SK_BY_GROUPS)
+		{
+			add_group_levels(sorting_key);
+			continue;
+		}
+
+		if(add_level(sorting_type, sorting_key < 0, NULL, 0) != 0)
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/* Appends a key to the list of keys.  Takes ownership of the regex if own_regex
+ * is set.  Returns zero on success. */
+static int
+add_level(SortingKey type, int descending, regex_t *regex, int own_regex)
+{
+	void *const p = reallocarray(levels, nlevels + 1, sizeof(*levels));
+	if(p == NULL)
+	{
+		if(own_regex)
+		{
+			regfree(regex);
+			free(regex);
+		}
+		return 1;
+	}
+	levels = p;
+
+	levels[nlevels++] = (sort_level_t){
+		.type = type,
+		.descending = descending,
+		.regex = regex,
+		.own_regex = own_regex,
+	};
+	return 0;
+}
+
+/* Appends a key per sorting group.  Groups that fail to be added are
+ * skipped. */
+static void
+add_group_levels(signed char key)
+{
+	char **groups = NULL;
+	int ngroups = 0;
+
+	char *const copy = strdup(view_sort_groups);
+	char *group = copy, *state = NULL;
+	while((group = split_and_get(group, ',', &state)) != NULL)
+	{
+		ngroups = add_to_string_array(&groups, ngroups, group);
+	}
+	free(copy);
+
+	/* Whether view->primary_group can be used to skip compiling regexp of the
+	 * first group. */
+	const int optimized = (view_sort_groups == view->sort_groups);
+
+	int i;
+	for(i = 0; i < ngroups; ++i)
+	{
+		if(optimized && i == 0)
+		{
+			(void)add_level(SK_BY_GROUPS, key < 0, &view->primary_group, 0);
+			continue;
+		}
+
+		regex_t *const regex = malloc(sizeof(*regex));
+		if(regex == NULL)
+		{
+			continue;
+		}
+		if(regexp_compile(regex, groups[i], REG_EXTENDED | REG_ICASE) != 0)
+		{
+			free(regex);
+			continue;
+		}
+		(void)add_level(SK_BY_GROUPS, key < 0, regex, 1);
+	}
+
+	free_string_array(groups, ngroups);
+}
+
+/* Frees resources allocated by setup_keys(). */
+static void
+cleanup_keys(void)
+{
+	int i;
+	for(i = 0; i < nlevels; ++i)
+	{
+		if(levels[i].own_regex)
+		{
+			regfree(levels[i].regex);
+			free(levels[i].regex);
+		}
+	}
+	free(levels);
+	levels = NULL;
+	nlevels = 0;
+
+	/* Strings of individual keys are allocated and freed in sort_sequence(). */
+	free(sort_items);
+	sort_items = NULL;
+	free(sort_keys);
+	sort_keys = NULL;
+
+	sort_base = NULL;
+}
+
+/* Sorts sequence of file entries (plain list, not tree, although it can be some
+ * part of a tree) in a stable way.  Keys are extracted from entries once, then
+ * items are sorted and entries are rearranged accordingly. */
+static void
+sort_sequence(dir_entry_t *entries, size_t nentries)
+{
+	/* Parts of a tree can be sorted concurrently, they use different parts of
+	 * the storage. */
+	const size_t offset = entries - sort_base;
+	item_maker_t maker = {
+		.entries = entries,
+		.items = &sort_items[offset],
+		.keys = &sort_keys[offset*nlevels],
+	};
+
+	const int nthreads = (nentries >= PARALLEL_SORT_MIN ? par_nthreads() : 1);
+
+	(void)par_for(nentries, parallel_keys ? nthreads : 1, &make_item,
+			/*poll_func=*/NULL, &maker);
+
+	if(integer_keys && nentries >= RADIX_SORT_MIN &&
+			radix_sort(maker.items, nentries) == 0)
+	{
+		/* Done. */
+	}
+	else if(nthreads > 1)
+	{
+		parallel_sort(maker.items, nentries, nthreads);
+	}
+	else
+	{
+		safe_qsort(maker.items, nentries, sizeof(*maker.items), &compare_items);
+	}
+
+	free_key_strs(maker.keys, nentries*nlevels);
+	permute_entries(entries, maker.items, nentries);
+}
+
+/* Frees strings owned by the keys. */
+static void
+free_key_strs(sort_key_t keys[], size_t nkeys)
+{
+	size_t i;
+	for(i = 0U; i < nkeys; ++i)
+	{
+		if(keys[i].owned)
+		{
+			free((char *)keys[i].str);
+		}
+	}
+}
+
+/* par_for() callback that fills item of a single entry and all its keys. */
+static void
+make_item(size_t idx, void *arg)
+{
+	item_maker_t *const maker = arg;
+	const dir_entry_t *const entry = &maker->entries[idx];
+	sort_item_t *const item = &maker->items[idx];
+	const int is_dir = fentry_is_dir(entry);
+
+	item->keys = &maker->keys[idx*nlevels];
+	item->entry = entry;
+	item->pos = idx;
+	item->parent = (is_dir && is_parent_dir(entry->name));
+	item->dir = is_dir;
+
+	int i;
+	for(i = 0; i < nlevels; ++i)
+	{
+		sort_key_t *const key = &item->keys[i];
+		key->str = NULL;
+		key->ext = NULL;
+		key->num = 0U;
+		key->dot = 0;
+		key->owned = 0;
+
+		/* The keys are never looked at, ".." always goes first. */
+		if(!item->parent)
+		{
+			make_sort_key(&levels[i], key, entry, is_dir);
+		}
+	}
+}
+
+/* Fills value of a key for the entry. */
+static void
+make_sort_key(const sort_level_t *level, sort_key_t *key,
+		const dir_entry_t *entry, int is_dir)
+{
+	switch(level->type)
+	{
+		case SK_BY_DIR:
+			/* Directory flag of an item is used. */
+			break;
+
+		case SK_BY_NAME:
+		case SK_BY_INAME:
+			{
+				const int ignore_case = (level->type == SK_BY_INAME);
+				if(custom_view)
+				{
+					char short_path[PATH_MAX + 1];
+					get_short_path_of(view, entry, NF_NONE, 0, sizeof(short_path),
+							short_path);
+					set_key_str(key, map_ascii_clone(short_path, ignore_case),
+							entry->name);
+				}
+				else
+				{
+					set_key_str(key, map_ascii(entry->name, ignore_case), entry->name);
+				}
+				key->dot = (key->str[0] == '.');
+			}
+			break;
+
+		case SK_BY_FILEEXT:
+		case SK_BY_EXTENSION:
+			set_key_str(key, map_ascii(entry->name, /*ignore_case=*/0), entry->name);
+			key->ext = strrchr(key->str, '.');
+			break;
+
+		case SK_BY_TYPE:
+			key->str = get_type_str(entry->type);
+			break;
+
+		case SK_BY_SIZE:
+			key->num = fentry_get_size(view, entry);
+			break;
+
+		case SK_BY_NITEMS:
+			/* We don't want to call fentry_get_nitems() for files as sorting huge
+			 * lists of files can call this function a lot of times, thus even small
+			 * extra performance overhead is not desirable. */
+			key->num = is_dir ? fentry_get_nitems(view, entry) : 0U;
+			break;
+
+		case SK_BY_GROUPS:
+			set_key_str(key, get_group_str(entry->name, level->regex), "");
+			break;
+
+		case SK_BY_TARGET:
+			key->num = (entry->type == FT_LINK);
+			if(key->num)
+			{
+				key->str = get_target_str(entry);
+				key->owned = 1;
+			}
+			break;
+
+		case SK_BY_TIME_MODIFIED:
+			key->num = time_key(entry->mtime);
+			break;
+
+		case SK_BY_TIME_ACCESSED:
+			key->num = time_key(entry->atime);
+			break;
+
+		case SK_BY_TIME_CHANGED:
+			key->num = time_key(entry->ctime);
+			break;
+
+#ifndef _WIN32
+		case SK_BY_MODE:
+			key->num = entry->mode;
+			break;
+
+		case SK_BY_INODE:
+			key->num = entry->inode;
+			break;
+
+		case SK_BY_OWNER_NAME: /* FIXME */
+		case SK_BY_OWNER_ID:
+			key->num = entry->uid;
+			break;
+
+		case SK_BY_GROUP_NAME: /* FIXME */
+		case SK_BY_GROUP_ID:
+			key->num = entry->gid;
+			break;
+
+		case SK_BY_PERMISSIONS:
+			{
+				char perm[11];
+				get_perm_string(perm, sizeof(perm), entry->mode);
+				set_key_str(key, strdup(perm), "");
+			}
+			break;
+
+		case SK_BY_NLINKS:
+			key->num = entry->nlinks;
+			break;
+#endif
+	}
+}
+
+/* Sets string part of the key taking ownership of the str, which can be NULL
+ * in which case fallback is used instead. */
+static void
+set_key_str(sort_key_t *key, char str[], const char fallback[])
+{
+	key->str = (str == NULL ? fallback : str);
+	key->owned = (str != NULL);
+}
+
+/* Extracts part of the name matched by the first group of the regex.  Returns
+ * newly allocated string or NULL on error. */
+static char *
+get_group_str(const char name[], const regex_t *regex)
+{
+	char match[NAME_MAX + 1];
+	const regmatch_t m = get_group_match(regex, name);
+	copy_str(match, MIN(sizeof(match), (size_t)m.rm_eo - m.rm_so + 1U),
+			name + m.rm_so);
+	return strdup(match);
+}
+
+/* Reads target of a symbolic link.  Returns newly allocated string or NULL on
+ * error. */
+static char *
+get_target_str(const dir_entry_t *entry)
+{
+	char full_path[PATH_MAX + 1];
+	char target[PATH_MAX + 1];
+
+	get_full_path_of(entry, sizeof(full_path), full_path);
+	if(get_link_target(full_path, target, sizeof(target)) != 0)
+	{
+		return NULL;
+	}
+	return strdup(target);
+}
+
+/* Maps possibly negative time value onto unsigned integer preserving the order.
+ * Returns the mapped value. */
+static uint64_t
+time_key(time_t time)
+{
+	return (uint64_t)(int64_t)time ^ ((uint64_t)1 << 63);
+}
+
+/* Sorts items by several threads: equal parts of the array are sorted first and
+ * then merged pairwise.  Falls back to sorting on the calling thread on memory
+ * error. */
+static void
+parallel_sort(sort_item_t *items, size_t nitems, int nthreads)
+{
+	sort_item_t *const buf = reallocarray(NULL, nitems, sizeof(*buf));
+	size_t *const bounds = reallocarray(NULL, nthreads + 1, sizeof(*bounds));
+	if(buf == NULL || bounds == NULL)
+	{
+		free(buf);
+		free(bounds);
+		safe_qsort(items, nitems, sizeof(*items), &compare_items);
+		return;
+	}
+
+	int i;
+	for(i = 0; i <= nthreads; ++i)
+	{
+		bounds[i] = nitems*i/nthreads;
+	}
+
+	merge_state_t state = {
+		.src = items,
+		.dst = buf,
+		.bounds = bounds,
+		.nruns = nthreads,
+	};
+
+	(void)par_for(state.nruns, nthreads, &sort_run, /*poll_func=*/NULL, &state);
+
+	while(state.nruns > 1)
+	{
+		const int npairs = (state.nruns + 1)/2;
+		(void)par_for(npairs, nthreads, &merge_runs, /*poll_func=*/NULL, &state);
+
+		for(i = 1; i < npairs; ++i)
+		{
+			bounds[i] = bounds[i*2];
+		}
+		bounds[npairs] = bounds[state.nruns];
+		state.nruns = npairs;
+
+		sort_item_t *const tmp = state.src;
+		state.src = state.dst;
+		state.dst = tmp;
+	}
+
+	if(state.src != items)
 	{
-		/* This undoes effect of flist_custom_uncompress_tree() from above. */
-		filters_drop_temporaries(v, unsorted_list);
+		memcpy(items, state.src, nitems*sizeof(*items));
 	}
+
+	free(buf);
+	free(bounds);
 }
 
-/* Sorts one level of a tree per invocation, recurring to sort all nested
- * trees. */
+/* par_for() callback that sorts a single run of items. */
 static void
-sort_tree_slice(dir_entry_t *entries, const dir_entry_t *children,
-		size_t nchildren, int root)
+sort_run(size_t idx, void *arg)
 {
-	int i = 0;
-	size_t pos = 0U;
-	/* Copy all first-level nodes of the current tree forming a sequence for
-	 * sorting. */
-	while(pos < nchildren)
-	{
-		entries[i] = children[pos];
-		entries[i].child_pos = pos;
-		pos += children[pos].child_count + 1;
-		++i;
-	}
+	merge_state_t *const state = arg;
+	const size_t from = state->bounds[idx];
+	const size_t to = state->bounds[idx + 1];
+	safe_qsort(&state->src[from], to - from, sizeof(*state->src),
+			&compare_items);
+}
 
-	sort_sequence(entries, i);
+/* par_for() callback that merges a pair of adjacent runs of items or just
+ * copies the last run if it has no pair. */
+static void
+merge_runs(size_t idx, void *arg)
+{
+	merge_state_t *const state = arg;
+	const int first = idx*2;
+	const size_t from = state->bounds[first];
+	const size_t mid = state->bounds[MIN(first + 1, state->nruns)];
+	const size_t to = state->bounds[MIN(first + 2, state->nruns)];
 
-	/* Finish sorting of this level by placing nodes at their corresponding
-	 * position starting with the last one.  Each subtree is then sorted
-	 * recursively. */
-	pos = nchildren;
-	while(--i >= 0)
+	const sort_item_t *const src = state->src;
+	sort_item_t *const dst = state->dst;
+
+	size_t l = from, r = mid, out = from;
+	while(l < mid && r < to)
 	{
-		pos -= entries[i].child_count + 1;
-		entries[pos] = entries[i];
-		if(entries[pos].child_count != 0)
+		if(compare_items(&src[r], &src[l]) < 0)
 		{
-			sort_tree_slice(&entries[pos + 1U], &children[entries[pos].child_pos + 1],
-					entries[pos].child_count, 0);
+			dst[out++] = src[r++];
+		}
+		else
+		{
+			dst[out++] = src[l++];
 		}
-		entries[pos].child_pos = root ? 0 : pos + 1;
 	}
-}
-
-void
-sort_entries(view_t *v, entries_t entries)
-{
-	if(prepare_for_sorting(v, /*local=*/0) != 0)
+	while(l < mid)
 	{
-		return;
+		dst[out++] = src[l++];
 	}
-
-	if(setup_linking(entries.entries, entries.nentries) == 0)
+	while(r < to)
 	{
-		sort_sequence(entries.entries, entries.nentries);
-		cleanup_linking();
+		dst[out++] = src[r++];
 	}
 }
 
-/* Prepares globals of this unit for performing sorting.  Returns non-zero if
- * there is no sorting to do. */
+/* Checks whether key of specified type is an integer or a flag.  Returns
+ * non-zero if so, otherwise zero is returned. */
 static int
-prepare_for_sorting(view_t *v, int local)
+is_integer_key(SortingKey type)
 {
-	const signed char *sort = (local ? v->sort : v->sort_g);
-	if(sort[0] > SK_LAST)
+	switch(type)
 	{
-		/* Completely skip sorting if primary key isn't set. */
-		return 1;
-	}
+		case SK_BY_DIR:
+		case SK_BY_SIZE:
+		case SK_BY_NITEMS:
+		case SK_BY_TIME_MODIFIED:
+		case SK_BY_TIME_ACCESSED:
+		case SK_BY_TIME_CHANGED:
+#ifndef _WIN32
+		case SK_BY_MODE:
+		case SK_BY_INODE:
+		case SK_BY_OWNER_NAME:
+		case SK_BY_OWNER_ID:
+		case SK_BY_GROUP_NAME:
+		case SK_BY_GROUP_ID:
+		case SK_BY_NLINKS:
+#endif
+			return 1;
 
-	view = v;
-	view_sort = sort;
-	view_sort_groups = (local ? v->sort_groups : v->sort_groups_g);
-	custom_view = flist_custom_active(v);
-	return 0;
+		default:
+			return 0;
+	}
 }
 
-/* Initializes cached keys storage and numbers entries to make future access to
- * cache possible.  Use cleanup_linking() to cleanup.  Returns zero on
- * success. */
+/* Sorts items by LSD radix sort starting with the key of the lowest priority.
+ * Each round is stable, so the last round by ".." being first leaves items in
+ * the same order as compare_items() would.  Returns zero on success and
+ * non-zero on memory error, in which case items are left unchanged. */
 static int
-setup_linking(dir_entry_t *entries, int nentries)
+radix_sort(sort_item_t *items, size_t nitems)
 {
-	cached_keys = reallocarray(NULL, nentries, sizeof(*cached_keys));
-	if(cached_keys == NULL)
+	radix_rec_t *recs = reallocarray(NULL, nitems, sizeof(*recs));
+	radix_rec_t *tmp = reallocarray(NULL, nitems, sizeof(*tmp));
+	if(recs == NULL || tmp == NULL)
 	{
+		free(recs);
+		free(tmp);
 		return 1;
 	}
 
-	int i;
-	for(i = 0; i < nentries; ++i)
+	size_t i;
+	for(i = 0U; i < nitems; ++i)
 	{
-		entries[i].link = i;
+		recs[i].item = &items[i];
 	}
-	return 0;
-}
-
-/* Frees resources allocated by setup_linking(). */
-static void
-cleanup_linking(void)
-{
-	/* Individual array elements are allocated and freed in sort_by_key(). */
-	free(cached_keys);
-	cached_keys = NULL;
-}
 
-/* Sorts sequence of file entries (plain list, not tree, although it can be some
- * part of a tree). */
-static void
-sort_sequence(dir_entry_t *entries, size_t nentries)
-{
-	int i = SK_COUNT;
-	while(--i >= 0)
+	/* Level -1 stands for placing ".." first. */
+	int level;
+	for(level = nlevels - 1; level >= -1; --level)
 	{
-		const signed char sorting_key = view_sort[i];
-		const int sorting_type = abs(sorting_key);
-
-		if(sorting_type > SK_LAST)
-		{
-			continue;
-		}
-
-		if(sorting_type == SK_BY_GROUPS)
+		for(i = 0U; i < nitems; ++i)
 		{
-			sort_by_groups(entries, sorting_key, nentries);
-			continue;
+			recs[i].key = radix_key(recs[i].item, level);
 		}
 
-		sort_by_key(entries, nentries, sorting_key, NULL);
+		radix_rec_t *const sorted = radix_round(recs, tmp, nitems);
+		tmp = (sorted == recs ? tmp : recs);
+		recs = sorted;
 	}
 
-	if(!ui_view_sort_list_contains(view_sort, SK_BY_DIR))
+	/* Items can't be copied in place, so only their original positions are
+	 * moved, which is all that's needed to rearrange entries. */
+	for(i = 0U; i < nitems; ++i)
 	{
-		sort_by_key(entries, nentries, SK_BY_DIR, NULL);
+		recs[i].key = recs[i].item->pos;
 	}
-}
-
-/* Sorts specified range of entries according to sorting groups option. */
-static void
-sort_by_groups(dir_entry_t *entries, signed char key, size_t nentries)
-{
-	char **groups = NULL;
-	int ngroups = 0;
-
-	char *const copy = strdup(view_sort_groups);
-	char *group = copy, *state = NULL;
-	while((group = split_and_get(group, ',', &state)) != NULL)
+	for(i = 0U; i < nitems; ++i)
 	{
-		ngroups = add_to_string_array(&groups, ngroups, group);
+		items[i].pos = recs[i].key;
 	}
-	free(copy);
 
-	/* Whether view->primary_group can be used to skip compiling regexp of the
-	 * first group. */
-	const int optimized = (view_sort_groups == view->sort_groups);
+	free(recs);
+	free(tmp);
+	return 0;
+}
 
-	int i;
-	for(i = ngroups - 1; i >= (optimized ? 1 : 0); --i)
+/* Computes key of the item at specified level (-1 is for ".." entry).  Returns
+ * the key such that items need to be in ascending order of keys. */
+static uint64_t
+radix_key(const sort_item_t *item, int level)
+{
+	if(level < 0)
 	{
-		regex_t regex;
-		(void)regexp_compile(&regex, groups[i], REG_EXTENDED | REG_ICASE);
-		sort_by_key(entries, nentries, key, &regex);
-		regfree(&regex);
+		return !item->parent;
 	}
-	if(optimized && ngroups != 0)
+
+	if(item->parent)
 	{
-		sort_by_key(entries, nentries, key, &view->primary_group);
+		/* Its position is determined by the last round. */
+		return 0U;
 	}
 
-	free_string_array(groups, ngroups);
+	const uint64_t key = (levels[level].type == SK_BY_DIR)
+	                   ? !item->dir
+	                   : item->keys[level].num;
+	return levels[level].descending ? ~key : key;
 }
 
-/* Sorts specified range of entries by the key in a stable way. */
-static void
-sort_by_key(dir_entry_t *entries, size_t nentries, signed char key, void *data)
+/* Performs stable sorting of records by their keys one byte at a time, bytes
+ * which are the same for all records are skipped.  Returns pointer to sorted
+ * records, which is either recs or tmp. */
+static radix_rec_t *
+radix_round(radix_rec_t *recs, radix_rec_t *tmp, size_t nrecs)
 {
-	sort_descending = (key < 0);
-	sort_type = (SortingKey)abs(key);
-	sort_data = data;
+	size_t counts[sizeof(uint64_t)][256] = {};
 
-	int using_cache = 0;
-
-	if(sort_type == SK_BY_NAME || sort_type == SK_BY_INAME)
+	size_t i;
+	for(i = 0U; i < nrecs; ++i)
 	{
-		using_cache = 1;
-
-		const int ignore_case = (sort_type == SK_BY_INAME);
+		const uint64_t key = recs[i].key;
+		unsigned int byte;
+		for(byte = 0U; byte < sizeof(key); ++byte)
+		{
+			++counts[byte][(key >> byte*8U) & 0xffU];
+		}
+	}
 
-		unsigned int i;
-		if(custom_view)
+	unsigned int byte;
+	for(byte = 0U; byte < sizeof(uint64_t); ++byte)
+	{
+		const unsigned int shift = byte*8U;
+		size_t *const count = counts[byte];
+		if(count[(recs[0].key >> shift) & 0xffU] == nrecs)
 		{
-			for(i = 0; i < nentries; ++i)
-			{
-				char short_path[PATH_MAX + 1];
-				get_short_path_of(view, &entries[i], NF_NONE, 0, sizeof(short_path),
-						short_path);
-				cached_keys[entries[i].link] = map_ascii_clone(short_path, ignore_case);
-			}
+			continue;
 		}
-		else
+
+		size_t offset = 0U;
+		unsigned int b;
+		for(b = 0U; b < 256U; ++b)
 		{
-			for(i = 0; i < nentries; ++i)
-			{
-				cached_keys[entries[i].link] = map_ascii(entries[i].name, ignore_case);
-			}
+			const size_t n = count[b];
+			count[b] = offset;
+			offset += n;
 		}
-	}
-	else if(sort_type == SK_BY_FILEEXT || sort_type == SK_BY_EXTENSION)
-	{
-		using_cache = 1;
 
-		unsigned int i;
-		for(i = 0; i < nentries; ++i)
+		for(i = 0U; i < nrecs; ++i)
 		{
-			cached_keys[entries[i].link] =
-				map_ascii(entries[i].name, /*ignore_case=*/0);
+			tmp[count[(recs[i].key >> shift) & 0xffU]++] = recs[i];
 		}
-	}
 
-	unsigned int i;
-	for(i = 0U; i < nentries; ++i)
-	{
-		entries[i].tag = i;
+		radix_rec_t *const t = recs;
+		recs = tmp;
+		tmp = t;
 	}
 
-	safe_qsort(entries, nentries, sizeof(*entries), &sort_dir_list);
+	return recs;
+}
 
-	if(using_cache)
+/* Rearranges entries to match the order of sorted items by following cycles of
+ * the permutation, which doesn't require a copy of the entries.  Positions of
+ * items are invalidated in the process. */
+static void
+permute_entries(dir_entry_t *entries, sort_item_t *items, size_t nentries)
+{
+	size_t i;
+	for(i = 0U; i < nentries; ++i)
 	{
-		for(i = 0; i < nentries; ++i)
+		if((size_t)items[i].pos == i)
+		{
+			continue;
+		}
+
+		const dir_entry_t tmp = entries[i];
+		size_t j = i;
+		while(1)
 		{
-			free(cached_keys[entries[i].link]);
+			const size_t from = items[j].pos;
+			items[j].pos = j;
+			if(from == i)
+			{
+				entries[j] = tmp;
+				break;
+			}
+			entries[j] = entries[from];
+			j = from;
 		}
 	}
 }
@@ -558,199 +1472,100 @@ skip_leading_zeros(const char str[])
 }
 #endif
 
+/* qsort() comparator of items, which compares keys one by one resolving ties
+ * by original position.  Returns standard -1, 0, 1 for comparisons. */
 static int
-sort_dir_list(const void *one, const void *two)
+compare_items(const void *one, const void *two)
 {
-	/* TODO: refactor this function sort_dir_list(). */
-
-	int retval;
-	const dir_entry_t *const first = one;
-	const dir_entry_t *const second = two;
+	const sort_item_t *const first = one;
+	const sort_item_t *const second = two;
 
-	const int first_is_dir = fentry_is_dir(first);
-	const int second_is_dir = fentry_is_dir(second);
+	const int retval = compare_levels(first, second);
+	return (retval != 0 ? retval : SORT_CMP(first->pos, second->pos));
+}
 
-	if(first_is_dir && is_parent_dir(first->name))
+/* Compares keys of two items one by one.  Returns standard -1, 0, 1 for
+ * comparisons. */
+static int
+compare_levels(const sort_item_t *first, const sort_item_t *second)
+{
+	if(first->parent)
 	{
 		return -1;
 	}
-	if(second_is_dir && is_parent_dir(second->name))
+	if(second->parent)
 	{
 		return 1;
 	}
 
-	retval = 0;
-	switch(sort_type)
+	int i;
+	for(i = 0; i < nlevels; ++i)
+	{
+		const int retval = compare_keys(&levels[i], first, second, i);
+		if(retval != 0)
+		{
+			return levels[i].descending ? -retval : retval;
+		}
+	}
+
+	return 0;
+}
+
+/* Compares i-th keys of two items.  Returns standard -1, 0, 1 for
+ * comparisons. */
+static int
+compare_keys(const sort_level_t *level, const sort_item_t *f,
+		const sort_item_t *s, int i)
+{
+	const sort_key_t *const fk = &f->keys[i];
+	const sort_key_t *const sk = &s->keys[i];
+
+	switch(level->type)
 	{
 		case SK_BY_NAME:
 		case SK_BY_INAME:
-			retval = compare_file_names(first, second, sort_type);
-			break;
+			return compare_file_names(level, f, fk, s, sk);
 
 		case SK_BY_DIR:
-			if(first_is_dir != second_is_dir)
-			{
-				retval = first_is_dir ? -1 : 1;
-			}
-			break;
+			return (f->dir == s->dir ? 0 : (f->dir ? -1 : 1));
 
 		case SK_BY_TYPE:
-			retval = strcmp(get_type_str(first->type), get_type_str(second->type));
-			break;
-
-		case SK_BY_FILEEXT:
-		case SK_BY_EXTENSION:
-			retval = compare_file_exts(first, first_is_dir, second, second_is_dir,
-					sort_type);
-			break;
-
-		case SK_BY_SIZE:
-			retval = compare_file_sizes(first, second);
-			break;
-
-		case SK_BY_NITEMS:
-			retval = compare_item_count(first, first_is_dir, second, second_is_dir);
-			break;
-
 		case SK_BY_GROUPS:
-			retval = compare_group(first->name, second->name, sort_data);
-			break;
-
-		case SK_BY_TARGET:
-			retval = compare_targets(first, second);
-			break;
-
-		case SK_BY_TIME_MODIFIED:
-			retval = SORT_CMP(first->mtime, second->mtime);
-			break;
-
-		case SK_BY_TIME_ACCESSED:
-			retval = SORT_CMP(first->atime, second->atime);
-			break;
-
-		case SK_BY_TIME_CHANGED:
-			retval = SORT_CMP(first->ctime, second->ctime);
-			break;
-
 #ifndef _WIN32
-		case SK_BY_MODE:
-			retval = SORT_CMP(first->mode, second->mode);
-			break;
-
-		case SK_BY_INODE:
-			retval = SORT_CMP(first->inode, second->inode);
-			break;
-
-		case SK_BY_OWNER_NAME: /* FIXME */
-		case SK_BY_OWNER_ID:
-			retval = SORT_CMP(first->uid, second->uid);
-			break;
-
-		case SK_BY_GROUP_NAME: /* FIXME */
-		case SK_BY_GROUP_ID:
-			retval = SORT_CMP(first->gid, second->gid);
-			break;
-
 		case SK_BY_PERMISSIONS:
-			{
-				char first_perm[11], second_perm[11];
-				get_perm_string(first_perm, sizeof(first_perm), first->mode);
-				get_perm_string(second_perm, sizeof(second_perm), second->mode);
-				retval = strcmp(first_perm, second_perm);
-			}
-			break;
-
-		case SK_BY_NLINKS:
-			retval = SORT_CMP(first->nlinks, second->nlinks);
-			break;
 #endif
-	}
-
-	if(retval == 0)
-	{
-		retval = SORT_CMP(first->tag, second->tag);
-	}
-	else if(sort_descending)
-	{
-		retval = -retval;
-	}
-
-	return retval;
-}
-
-/* Compares two file sizes.  Returns standard -1, 0, 1 for comparisons. */
-static int
-compare_file_sizes(const dir_entry_t *f, const dir_entry_t *s)
-{
-	const uint64_t fsize = fentry_get_size(view, f);
-	const uint64_t ssize = fentry_get_size(view, s);
-	return SORT_CMP(fsize, ssize);
-}
-
-/* Compares number of items in two directories (taken as zero for files).
- * Returns standard -1, 0, 1 for comparisons. */
-static int
-compare_item_count(const dir_entry_t *f, int fdir, const dir_entry_t *s,
-		int sdir)
-{
-	/* We don't want to call fentry_get_nitems() for files as sorting huge lists
-	 * of files can call this function a lot of times, thus even small extra
-	 * performance overhead is not desirable. */
-	const uint64_t fsize = fdir ? fentry_get_nitems(view, f) : 0U;
-	const uint64_t ssize = sdir ? fentry_get_nitems(view, s) : 0U;
-	return SORT_CMP(fsize, ssize);
-}
+			return strcmp(fk->str, sk->str);
 
-/* Compares two file names according to grouping regular expression.  Returns
- * standard -1, 0, 1 for comparisons. */
-static int
-compare_group(const char f[], const char s[], regex_t *regex)
-{
-	char fname[NAME_MAX + 1], sname[NAME_MAX + 1];
-	regmatch_t fmatch = get_group_match(regex, f);
-	regmatch_t smatch = get_group_match(regex, s);
+		case SK_BY_FILEEXT:
+		case SK_BY_EXTENSION:
+			return compare_file_exts(level, f, fk, s, sk);
 
-	copy_str(fname, MIN(sizeof(fname), (size_t)fmatch.rm_eo - fmatch.rm_so + 1U),
-			f + fmatch.rm_so);
-	copy_str(sname, MIN(sizeof(sname), (size_t)smatch.rm_eo - smatch.rm_so + 1U),
-			s + smatch.rm_so);
+		case SK_BY_TARGET:
+			return compare_targets(fk, sk);
 
-	return strcmp(fname, sname);
+		default:
+			return SORT_CMP(fk->num, sk->num);
+	}
 }
 
-/* Compares two file names according to symbolic link target.  Returns standard
- * -1, 0, 1 for comparisons. */
+/* Compares keys of two entries by symbolic link target.  Returns standard -1,
+ * 0, 1 for comparisons. */
 static int
-compare_targets(const dir_entry_t *f, const dir_entry_t *s)
+compare_targets(const sort_key_t *f, const sort_key_t *s)
 {
-	char full_path[PATH_MAX + 1];
-	char nlink[PATH_MAX + 1], plink[PATH_MAX + 1];
-
-	if((f->type == FT_LINK) != (s->type == FT_LINK))
+	if(f->num != s->num)
 	{
 		/* One of the entries is not a link. */
-		return (f->type == FT_LINK) ? 1 : -1;
-	}
-	if(f->type != FT_LINK)
-	{
-		/* Both entries are not symbolic links. */
-		return 0;
+		return f->num ? 1 : -1;
 	}
 
-	/* Both entries are symbolic links. */
-
-	get_full_path_of(f, sizeof(full_path), full_path);
-	if(get_link_target(full_path, nlink, sizeof(nlink)) != 0)
-	{
-		return 0;
-	}
-	get_full_path_of(s, sizeof(full_path), full_path);
-	if(get_link_target(full_path, plink, sizeof(plink)) != 0)
+	if(f->str == NULL || s->str == NULL)
 	{
+		/* Both entries are not symbolic links or target can't be read. */
 		return 0;
 	}
 
-	return stroscmp(nlink, plink);
+	return stroscmp(f->str, s->str);
 }
 
 /* Compares two file names (could include one or several components) assuming
@@ -758,39 +1573,22 @@ compare_targets(const dir_entry_t *f, const dir_entry_t *s)
  * positive value if s is greater than t, zero if they are equal, otherwise
  * negative value is returned. */
 static int
-compare_file_names(const dir_entry_t *f, const dir_entry_t *s,
-		SortingKey sort_type)
+compare_file_names(const sort_level_t *level, const sort_item_t *f,
+		const sort_key_t *fk, const sort_item_t *s, const sort_key_t *sk)
 {
-	/* NULL check and conditional load is actually faster than just reading a
-	 * value and not by a trivial amount. */
-	const char *f_name = cached_keys[f->link];
-	if(f_name == NULL)
-	{
-		f_name = f->name;
-	}
-	const char *s_name = cached_keys[s->link];
-	if(s_name == NULL)
-	{
-		s_name = s->name;
-	}
-
-	if(f_name[0] == '.' && s_name[0] != '.')
-	{
-		return -1;
-	}
-	if(f_name[0] != '.' && s_name[0] == '.')
+	if(fk->dot != sk->dot)
 	{
-		return 1;
+		return fk->dot ? -1 : 1;
 	}
 
-	int result = compare_name_part(f_name, s_name);
+	int result = compare_name_part(fk->str, sk->str);
 
 	/* Resort to comparing original names when their normalized versions match
 	 * to always solve ties in a deterministic way. */
-	if(result == 0 && sort_type == SK_BY_INAME)
+	if(result == 0 && level->type == SK_BY_INAME)
 	{
-		f_name = f->name;
-		s_name = s->name;
+		const char *f_name = f->entry->name;
+		const char *s_name = s->entry->name;
 
 		char f_short[PATH_MAX + 1];
 		char s_short[PATH_MAX + 1];
@@ -798,10 +1596,10 @@ compare_file_names(const dir_entry_t *f, const dir_entry_t *s,
 		{
 			/* Computing these short paths here isn't a big deal as such ties should
 			 * be a rare occasion. */
-			get_short_path_of(view, f, NF_NONE, /*drop_prefix=*/0, sizeof(f_short),
-					f_short);
-			get_short_path_of(view, s, NF_NONE, /*drop_prefix=*/0, sizeof(s_short),
-					s_short);
+			get_short_path_of(view, f->entry, NF_NONE, /*drop_prefix=*/0,
+					sizeof(f_short), f_short);
+			get_short_path_of(view, s->entry, NF_NONE, /*drop_prefix=*/0,
+					sizeof(s_short), s_short);
 
 			f_name = f_short;
 			s_name = s_short;
@@ -816,46 +1614,33 @@ compare_file_names(const dir_entry_t *f, const dir_entry_t *s,
 /* Compares files/directories by extensions.  Returns standard < 0, == 0, > 0
  * comparison result. */
 static int
-compare_file_exts(const dir_entry_t *f, int f_dir, const dir_entry_t *s,
-		int s_dir, SortingKey sort_type)
+compare_file_exts(const sort_level_t *level, const sort_item_t *f,
+		const sort_key_t *fk, const sort_item_t *s, const sort_key_t *sk)
 {
-	/* NULL check and conditional load is actually faster than just reading a
-	 * value and not by a trivial amount. */
-	const char *f_name = cached_keys[f->link];
-	if(f_name == NULL)
-	{
-		f_name = f->name;
-	}
-	const char *s_name = cached_keys[s->link];
-	if(s_name == NULL)
-	{
-		s_name = s->name;
-	}
-
-	if(sort_type == SK_BY_FILEEXT)
+	if(level->type == SK_BY_FILEEXT)
 	{
-		if(f_dir && s_dir)
+		if(f->dir && s->dir)
 		{
-			return compare_name_part(f_name, s_name);
+			return compare_name_part(fk->str, sk->str);
 		}
 
-		if(f_dir || s_dir)
+		if(f->dir || s->dir)
 		{
-			return (f_dir ? -1 : 1);
+			return (f->dir ? -1 : 1);
 		}
 	}
 
-	const char *f_ext = strrchr(f_name, '.');
-	const char *s_ext = strrchr(s_name, '.');
+	const char *f_ext = fk->ext;
+	const char *s_ext = sk->ext;
 
 	if(f_ext != NULL && s_ext != NULL)
 	{
-		if(f_ext == f_name && s_ext != s_name)
+		if(f_ext == fk->str && s_ext != sk->str)
 		{
 			return -1;
 		}
 
-		if(f_ext != f_name && s_ext == s_name)
+		if(f_ext != fk->str && s_ext == sk->str)
 		{
 			return 1;
 		}
@@ -868,7 +1653,7 @@ compare_file_exts(const dir_entry_t *f, int f_dir, const dir_entry_t *s,
 		return (f_ext != NULL ? -1 : 1);
 	}
 
-	return compare_name_part(f_name, s_name);
+	return compare_name_part(fk->str, sk->str);
 }
 
 /* Compares two file names or their parts (e.g. extensions).  Returns positive
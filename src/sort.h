@@ -32,6 +32,15 @@ void sort_view(view_t *view);
 /* Sorts specified entries using global settings of the view. */
 void sort_entries(view_t *view, entries_t entries);
 
+/* Sorts entries of the view after a reload reusing order of the previous list,
+ * which must have been sorted.  prev contains index in the prev_list of an
+ * entry with the same name for each entry of the view or -1 for new entries.
+ * Only changed and new entries are sorted and then inserted among the rest.
+ * Returns zero on success and non-zero if full sorting is needed, in which case
+ * the view is left unchanged. */
+int sort_view_incremental(view_t *view, const dir_entry_t prev_list[],
+		int prev_len, const int prev[]);
+
 /* Maps primary sort key to second column type.  Returns secondary key that
  * corresponds to the primary one. */
 SortingKey get_secondary_key(SortingKey primary_key);
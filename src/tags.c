@@ -51,6 +51,7 @@ const char *tags[] = {
 	"vifm-'classify'",
 	"vifm-'co'",
 	"vifm-'columns'",
+	"vifm-'comparecache'",
 	"vifm-'confirm'",
 	"vifm-'cpo'",
 	"vifm-'cpoptions'",
@@ -84,6 +85,7 @@ const char *tags[] = {
 	"vifm-'keepsel'",
 	"vifm-'laststatus'",
 	"vifm-'lines'",
+	"vifm-'listcache'",
 	"vifm-'locateprg'",
 	"vifm-'ls'",
 	"vifm-'lsoptions'",
@@ -98,6 +100,7 @@ const char *tags[] = {
 	"vifm-'number'",
 	"vifm-'numberwidth'",
 	"vifm-'nuw'",
+	"vifm-'prefetchmax'",
 	"vifm-'previewoptions'",
 	"vifm-'previewprg'",
 	"vifm-'quickview'",
@@ -121,6 +124,7 @@ const char *tags[] = {
 	"vifm-'sizefmt'",
 	"vifm-'slowfs'",
 	"vifm-'smartcase'",
+	"vifm-'snapshotmin'",
 	"vifm-'so'",
 	"vifm-'sort'",
 	"vifm-'sortgroups'",
@@ -208,6 +212,7 @@ const char *tags[] = {
 	"vifm-:c",
 	"vifm-:ca",
 	"vifm-:cabbrev",
+	"vifm-:cachestats",
 	"vifm-:cal",
 	"vifm-:call",
 	"vifm-:cd",
@@ -168,6 +168,7 @@ static void format_inode(void *data, size_t buf_len, char buf[],
 #endif
 static void format_id(void *data, size_t buf_len, char buf[],
 		const format_info_t *info);
+static int meta_is_pending(const column_data_t *cdt, char buf[]);
 static size_t calculate_column_width(view_t *view);
 static size_t calculate_columns_count(view_t *view);
 static int has_extra_tls_col(const view_t *view, int col_width);
@@ -446,7 +447,8 @@ draw_right_column(view_t *view)
 	get_current_full_path(view, sizeof(path), path);
 	(void)flist_update_cache(view, &view->right_column, path);
 
-	if(view->right_column.entries.nentries >= 0)
+	/* Column stays empty until its entries are read in background. */
+	if(view->right_column.entries.nentries >= 0 && !view->right_column.pending)
 	{
 		print_side_column(view, view->right_column.entries, NULL, path, rcol_width,
 				offset, 0);
@@ -1607,6 +1609,11 @@ format_size(void *data, size_t buf_len, char buf[], const format_info_t *info)
 	const view_t *view = cdt->view;
 	uint64_t size = DCACHE_UNKNOWN;
 
+	if(meta_is_pending(cdt, buf))
+	{
+		return;
+	}
+
 	if(fentry_is_dir(cdt->entry))
 	{
 		uint64_t nitems;
@@ -1712,6 +1719,11 @@ format_time(void *data, size_t buf_len, char buf[], const format_info_t *info)
 	struct tm *tm_ptr;
 	const column_data_t *cdt = info->data;
 
+	if(meta_is_pending(cdt, buf))
+	{
+		return;
+	}
+
 	switch(info->id)
 	{
 		case SK_BY_TIME_MODIFIED:
@@ -1757,6 +1769,11 @@ format_group(void *data, size_t buf_len, char buf[], const format_info_t *info)
 {
 	const column_data_t *cdt = info->data;
 
+	if(meta_is_pending(cdt, buf))
+	{
+		return;
+	}
+
 	buf[0] = ' ';
 	get_gid_string(cdt->entry, info->id == SK_BY_GROUP_ID, buf_len - 1, buf + 1);
 }
@@ -1767,6 +1784,11 @@ format_owner(void *data, size_t buf_len, char buf[], const format_info_t *info)
 {
 	const column_data_t *cdt = info->data;
 
+	if(meta_is_pending(cdt, buf))
+	{
+		return;
+	}
+
 	buf[0] = ' ';
 	get_uid_string(cdt->entry, info->id == SK_BY_OWNER_ID, buf_len - 1, buf + 1);
 }
@@ -1776,6 +1798,12 @@ static void
 format_mode(void *data, size_t buf_len, char buf[], const format_info_t *info)
 {
 	const column_data_t *cdt = info->data;
+
+	if(meta_is_pending(cdt, buf))
+	{
+		return;
+	}
+
 	snprintf(buf, buf_len, " %o", cdt->entry->mode);
 }
 
@@ -1784,6 +1812,12 @@ static void
 format_perms(void *data, size_t buf_len, char buf[], const format_info_t *info)
 {
 	const column_data_t *cdt = info->data;
+
+	if(meta_is_pending(cdt, buf))
+	{
+		return;
+	}
+
 	get_perm_string(buf, buf_len, cdt->entry->mode);
 }
 
@@ -1792,6 +1826,12 @@ static void
 format_nlinks(void *data, size_t buf_len, char buf[], const format_info_t *info)
 {
 	const column_data_t *cdt = info->data;
+
+	if(meta_is_pending(cdt, buf))
+	{
+		return;
+	}
+
 	snprintf(buf, buf_len, "%lu", (unsigned long)cdt->entry->nlinks);
 }
 
@@ -1800,6 +1840,12 @@ static void
 format_inode(void *data, size_t buf_len, char buf[], const format_info_t *info)
 {
 	const column_data_t *cdt = info->data;
+
+	if(meta_is_pending(cdt, buf))
+	{
+		return;
+	}
+
 	snprintf(buf, buf_len, "%lu", (unsigned long)cdt->entry->inode);
 }
 
@@ -1813,6 +1859,19 @@ format_id(void *data, size_t buf_len, char buf[], const format_info_t *info)
 	snprintf(buf, buf_len, "#%d", cdt->entry->id);
 }
 
+/* Checks whether meta-data of the entry hasn't been loaded yet and empties the
+ * buffer if so.  Returns non-zero in that case, otherwise zero is returned. */
+static int
+meta_is_pending(const column_data_t *cdt, char buf[])
+{
+	if(cdt->entry->meta_pending)
+	{
+		buf[0] = '\0';
+		return 1;
+	}
+	return 0;
+}
+
 void
 fview_set_lsview(view_t *view, int enabled)
 {
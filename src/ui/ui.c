@@ -2644,17 +2644,23 @@ format_view_title(const view_t *view, path_func pf, int consider_qv)
 	else if(flist_custom_active(view))
 	{
 		const char *tree_mark = (cv_tree(view->custom.type) ? "[tree]" : "");
+		const char *loading_mark = (flist_is_loading(view) ? "[loading] " : "");
 		const char *path = pf(view->custom.orig_dir);
 		if(view->custom.title[0] == '\0')
 		{
-			unescaped_title = format_str("%s @ %s", tree_mark, path);
+			unescaped_title = format_str("%s%s @ %s", loading_mark, tree_mark,
+					path);
 		}
 		else
 		{
-			unescaped_title = format_str("%s[%s] @ %s", tree_mark, view->custom.title,
-					path);
+			unescaped_title = format_str("%s%s[%s] @ %s", loading_mark, tree_mark,
+					view->custom.title, path);
 		}
 	}
+	else if(flist_is_loading(view))
+	{
+		unescaped_title = format_str("[loading] %s", pf(view->curr_dir));
+	}
 	else
 	{
 		unescaped_title = strdup(pf(view->curr_dir));
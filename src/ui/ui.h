@@ -33,6 +33,7 @@
 
 #include "../compat/fs_limits.h"
 #include "../compat/pthread.h"
+#include "../utils/filemon.h"
 #include "../utils/filter.h"
 #include "../utils/fswatch.h"
 #include "../utils/test_helpers.h"
@@ -219,7 +220,8 @@ struct dir_entry_t
 	char *name;       /* File name. */
 	char *origin;     /* Location where this file comes from.  Either points to
 	                     view_t::curr_dir for non-cv views or is allocated on
-	                     a heap depending on owns_origin field. */
+	                     a heap (or is interned in an arena, see in_arena)
+	                     depending on owns_origin field. */
 	uint64_t size;    /* File size in bytes. */
 	time_t mtime;     /* Modification time. */
 	time_t atime;     /* Access time. */
@@ -268,6 +270,9 @@ struct dir_entry_t
 	unsigned int slow_target : 1;  /* Whether this symlink has a slow target. */
 	unsigned int owns_origin : 1;  /* Whether this entry is custom one. */
 	unsigned int folded : 1;       /* Whether this entry is folded. */
+	unsigned int meta_pending : 1; /* Whether metadata is yet to be loaded. */
+	unsigned int in_arena : 1;     /* Whether name and owned origin come from
+	                                  a string arena instead of a heap. */
 };
 
 /* List of entries bundled with its size. */
@@ -330,6 +335,10 @@ struct cv_data_t
 	/* Names of files in custom view while it's being composed.  Used for
 	 * duplicate elimination during construction of custom list. */
 	struct trie_t *paths_cache;
+
+	/* Population of the list with output of a command that is still running or
+	 * NULL. */
+	struct cv_loader_t *loader;
 };
 
 /* Various parameters related to local filter. */
@@ -363,6 +372,8 @@ typedef struct
 	fswatch_t *watch;  /* Watcher for the path. */
 	char *dir;         /* Path to watched directory. */
 	entries_t entries; /* Cached list of entries. */
+	int pending;       /* Whether entries are being read in background, in which
+	                      case the list of entries is empty. */
 }
 cached_entries_t;
 
@@ -419,6 +430,33 @@ struct view_t
 	int filtered;  /* number of files filtered out and not shown in list */
 	int selected_files; /* Number of currently selected files. */
 	dir_entry_t *dir_entry; /* Must be handled via dynarray unit. */
+	/* Index of entries by their names, built on demand.  Can be NULL. */
+	struct flist_index_t *name_index;
+
+	/* Loading of metadata of large directories is postponed and done piece by
+	 * piece. */
+	int meta_pending;     /* Whether some entries lack metadata. */
+	int meta_pending_pos; /* Position to continue looking for such entries. */
+
+	/* Listing of directory on a slow file system which is being read in
+	 * background or NULL. */
+	struct dir_loader_t *loader;
+
+	/* Reading of directory under the cursor in advance or NULL.  The watcher
+	 * is created before reading starts and is reset once the result is
+	 * collected. */
+	struct dir_loader_t *prefetcher;
+	fswatch_t *prefetch_watch;
+
+	/* Storage of strings of new file list entries. */
+	struct str_arena_t *arena;
+
+	/* State of current directory before its listing was read.  Reset for lists
+	 * that can't be cached. */
+	filemon_t list_mon;
+	/* How the list was filtered and sorted at the moment of leaving its
+	 * directory or NULL.  Set when the list is to be put into cache. */
+	char *cache_sig;
 
 	/* Last position that was displayed on the screen. */
 	char *last_curr_file; /* To account for file replacement. */
@@ -499,9 +537,13 @@ struct view_t
 	                                      This is a pointer, because mutexes
 	                                      shouldn't be copied. */
 
-	int on_slow_fs; /* Whether current directory has access penalties. */
-	int has_dups;   /* Whether current directory has duplicated file entries (FS
-	                   issue). */
+	int on_slow_fs;   /* Whether current directory has access penalties. */
+	int unresponsive; /* Whether current directory didn't respond in time and
+	                     wasn't entered until it's read in background. */
+	int slow_below;   /* Whether some subdirectories of current directory might
+	                     have access penalties. */
+	int has_dups;     /* Whether current directory has duplicated file entries
+	                     (FS issue). */
 
 	int location_changed; /* Whether location was recently changed. */
 
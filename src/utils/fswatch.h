@@ -19,6 +19,11 @@
 #ifndef VIFM__UTILS__FSWATCH_H__
 #define VIFM__UTILS__FSWATCH_H__
 
+#include <time.h> /* time_t */
+
+#include "string_array.h"
+#include "test_helpers.h"
+
 /* Implementation of file system changes checks via polling. */
 
 /* Kinds of state reports. */
@@ -45,6 +50,16 @@ void fswatch_free(fswatch_t *w);
  * query.  Returns latest state. */
 FSWatchState fswatch_poll(fswatch_t *w);
 
+/* Retrieves names of files of the watched directory that were affected by
+ * changes detected by the last call of fswatch_poll().  Returns the list, which
+ * is valid until the next poll, or NULL if it's unknown what exactly has
+ * changed (in which case anything could have). */
+const strlist_t * fswatch_get_changes(const fswatch_t *w);
+
+TSTATIC_DEFS(
+	time_t fswatch_time_shift;
+)
+
 #endif /* VIFM__UTILS__FSWATCH_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -35,6 +35,7 @@
 
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
+#include "test_helpers.h"
 #include "trie.h"
 
 /* TODO: consider implementation that could reuse already available descriptor
@@ -54,6 +55,14 @@ struct fswatch_t
 	/* To monitor mount events, which aren't reported by inotify. */
 	dev_t dev;
 	ino_t inode;
+	/* Names of files that were changed according to the last poll. */
+	strlist_t changes;
+	/* Whether changes field lists all changes. */
+	int changes_known;
+	/* Sequential number of the last poll, used to avoid duplicated changes. */
+	unsigned int poll_number;
+	/* Names of banned files some of whose events were ignored. */
+	strlist_t missed;
 };
 
 /* Per file statistics information. */
@@ -64,18 +73,28 @@ typedef struct
 	uint32_t ban_mask;   /* Events right before the ban. */
 	int count;           /* How many times file changed continuously in the last
 	                        several seconds. */
+	unsigned int poll_number; /* Number of the last poll that reported the file
+	                             as changed. */
+	int missed;               /* Whether events were ignored during the ban. */
 }
 notif_stat_t;
 
 static FSWatchState poll_for_replacement(fswatch_t *w);
 static int update_file_stats(fswatch_t *w, const struct inotify_event *e,
 		time_t now);
+static int report_expired_bans(fswatch_t *w, time_t now);
+static void record_change(fswatch_t *w, notif_stat_t *stats,
+		const char name[]);
+static void reset_changes(fswatch_t *w, int known);
 
 /* Events we're interested in. */
 static const uint32_t EVENTS_MASK = IN_ATTRIB | IN_MODIFY | IN_CLOSE_WRITE
                                   | IN_CREATE | IN_DELETE | IN_EXCL_UNLINK
                                   | IN_MOVED_FROM | IN_MOVED_TO;
 
+/* Offset added to current time, which lets tests skip over bans. */
+TSTATIC time_t fswatch_time_shift;
+
 fswatch_t *
 fswatch_create(const char path[])
 {
@@ -93,6 +112,12 @@ fswatch_create(const char path[])
 
 	w->dev = st.st_dev;
 	w->inode = st.st_ino;
+	w->changes.nitems = 0;
+	w->changes.items = NULL;
+	w->changes_known = 0;
+	w->poll_number = 0U;
+	w->missed.nitems = 0;
+	w->missed.items = NULL;
 
 	/* Create tree to collect update frequency statistics. */
 	w->stats = trie_create(&free);
@@ -139,6 +164,8 @@ fswatch_free(fswatch_t *w)
 	{
 		free(w->path);
 		trie_free(w->stats);
+		free_string_array(w->changes.items, w->changes.nitems);
+		free_string_array(w->missed.items, w->missed.nitems);
 		close(w->fd);
 		free(w);
 	}
@@ -154,7 +181,10 @@ fswatch_poll(fswatch_t *w)
 	int nread;
 	int changed = 0;
 	int nreads = 0;
-	const time_t now = time(NULL);
+	const time_t now = time(NULL) + fswatch_time_shift;
+
+	reset_changes(w, 1);
+	++w->poll_number;
 
 	do
 	{
@@ -167,6 +197,7 @@ fswatch_poll(fswatch_t *w)
 		{
 			if(errno != EAGAIN)
 			{
+				reset_changes(w, 0);
 				return FSWS_ERRORED;
 			}
 			break;
@@ -181,6 +212,14 @@ fswatch_poll(fswatch_t *w)
 				return poll_for_replacement(w);
 			}
 
+			if((e->mask & IN_Q_OVERFLOW) != 0)
+			{
+				/* Some events were lost, so anything could have changed. */
+				w->changes_known = 0;
+				changed = 1;
+				continue;
+			}
+
 			if((e->mask & EVENTS_MASK) != 0 && update_file_stats(w, e, now))
 			{
 				changed = 1;
@@ -196,6 +235,11 @@ fswatch_poll(fswatch_t *w)
 	}
 	while(nread != 0);
 
+	if(report_expired_bans(w, now))
+	{
+		changed = 1;
+	}
+
 	return (changed ? FSWS_UPDATED : poll_for_replacement(w));
 }
 
@@ -206,6 +250,7 @@ poll_for_replacement(fswatch_t *w)
 	struct stat st;
 	if(os_stat(w->path, &st) != 0)
 	{
+		reset_changes(w, 0);
 		return FSWS_ERRORED;
 	}
 
@@ -214,6 +259,8 @@ poll_for_replacement(fswatch_t *w)
 		return FSWS_UNCHANGED;
 	}
 
+	reset_changes(w, 0);
+
 	w->dev = st.st_dev;
 	w->inode = st.st_ino;
 
@@ -251,18 +298,22 @@ update_file_stats(fswatch_t *w, const struct inotify_event *e, time_t now)
 	 * so. */
 	if(trie_get(w->stats, fname, &data) != 0)
 	{
-		notif_stat_t *const stats = malloc(sizeof(*stats));
+		stats = malloc(sizeof(*stats));
 		if(stats != NULL)
 		{
 			stats->last_update = now;
 			stats->banned_until = 0U;
 			stats->count = 1;
+			stats->poll_number = 0U;
+			stats->missed = 0;
 			if(trie_set(w->stats, fname, stats) != 0)
 			{
 				free(stats);
+				stats = NULL;
 			}
 		}
 
+		record_change(w, stats, (e->len == 0U) ? NULL : e->name);
 		return 1;
 	}
 
@@ -275,9 +326,16 @@ update_file_stats(fswatch_t *w, const struct inotify_event *e, time_t now)
 		stats->count = 1;
 	}
 
-	/* Ignore events during banned period, unless it's something new. */
+	/* Ignore events during banned period, unless it's something new.  Such
+	 * files are reported once the ban is over to not miss their last change. */
 	if(now < stats->banned_until && !(e->mask & ~stats->ban_mask))
 	{
+		if(!stats->missed)
+		{
+			const int len = w->missed.nitems;
+			w->missed.nitems = add_to_string_array(&w->missed.items, len, fname);
+			stats->missed = (w->missed.nitems != len);
+		}
 		return 0;
 	}
 
@@ -295,9 +353,94 @@ update_file_stats(fswatch_t *w, const struct inotify_event *e, time_t now)
 
 	stats->last_update = now;
 
+	record_change(w, stats, (e->len == 0U) ? NULL : e->name);
 	return 1;
 }
 
+/* Records changes of banned files whose ban has expired and whose events were
+ * ignored during the ban.  Returns non-zero if there were such files,
+ * otherwise zero is returned. */
+static int
+report_expired_bans(fswatch_t *w, time_t now)
+{
+	int reported = 0;
+	int i, j = 0;
+	for(i = 0; i < w->missed.nitems; ++i)
+	{
+		char *const name = w->missed.items[i];
+
+		void *data;
+		if(trie_get(w->stats, name, &data) == 0)
+		{
+			notif_stat_t *const stats = data;
+			if(stats->missed && now < stats->banned_until)
+			{
+				w->missed.items[j++] = name;
+				continue;
+			}
+
+			if(stats->missed)
+			{
+				record_change(w, stats, name);
+				reported = 1;
+			}
+		}
+
+		free(name);
+	}
+	w->missed.nitems = j;
+
+	return reported;
+}
+
+/* Adds file to the list of changes unless it's already there.  stats can be
+ * NULL.  name is NULL for the watched directory itself, which isn't
+ * recorded. */
+static void
+record_change(fswatch_t *w, notif_stat_t *stats, const char name[])
+{
+	if(name == NULL)
+	{
+		return;
+	}
+
+	if(stats != NULL)
+	{
+		/* This change covers everything that was missed during a ban. */
+		stats->missed = 0;
+
+		if(stats->poll_number == w->poll_number)
+		{
+			return;
+		}
+		stats->poll_number = w->poll_number;
+	}
+
+	const int len = w->changes.nitems;
+	w->changes.nitems = add_to_string_array(&w->changes.items, len, name);
+	if(w->changes.nitems == len)
+	{
+		/* Losing a change is the same as not knowing about it. */
+		w->changes_known = 0;
+	}
+}
+
+/* Empties list of changes and sets whether it's complete. */
+static void
+reset_changes(fswatch_t *w, int known)
+{
+	free_string_array(w->changes.items, w->changes.nitems);
+	w->changes.items = NULL;
+	w->changes.nitems = 0;
+	w->changes_known = known;
+}
+
+const strlist_t *
+fswatch_get_changes(const fswatch_t *w)
+{
+	return (w->changes_known ? &w->changes : NULL);
+}
+
 #else
 
 #include "filemon.h"
@@ -362,6 +505,13 @@ fswatch_poll(fswatch_t *w)
 	return (changed ? FSWS_UPDATED : FSWS_UNCHANGED);
 }
 
+const strlist_t *
+fswatch_get_changes(const fswatch_t *w)
+{
+	/* Modification time of a directory says nothing about its files. */
+	return NULL;
+}
+
 #endif
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -107,6 +107,13 @@ fswatch_poll(fswatch_t *w)
 	return (changed ? FSWS_UPDATED : FSWS_UNCHANGED);
 }
 
+const strlist_t *
+fswatch_get_changes(const fswatch_t *w)
+{
+	/* Notifications don't say which files have changed. */
+	return NULL;
+}
+
 /* Gets last directory modification time.  Returns non-zero on error, otherwise
  * zero is returned. */
 static int
@@ -72,6 +72,11 @@ int matcher_includes(const matcher_t *matcher, const matcher_t *like);
  * otherwise zero is returned. */
 int matcher_is_full_path(const matcher_t *matcher);
 
+/* Checks whether given matcher matches mime-types of files rather than their
+ * paths.  Such matching can't be done by several threads at the same time.
+ * Returns non-zero if so, otherwise zero is returned. */
+int matcher_is_mime(const matcher_t *matcher);
+
 TSTATIC_DEFS(
 	int matcher_is_fast(const matcher_t *matcher);
 )
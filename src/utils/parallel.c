@@ -0,0 +1,660 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "parallel.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h> /* sysconf() */
+#endif
+
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* calloc() free() reallocarray() */
+#include <string.h> /* memmove() */
+#include <time.h> /* CLOCK_REALTIME clock_gettime() timespec */
+
+#include "../compat/pthread.h"
+#include "../compat/reallocarray.h"
+#include "macros.h"
+#include "utils.h"
+
+/* Upper limit on the value returned by par_nthreads(). */
+#define MAX_THREADS 16
+
+/* Period of calling poll function in milliseconds. */
+#define POLL_PERIOD_MS 50
+
+/* Period of calling poll function in tasks when par_run() doesn't start any
+ * threads. */
+#define INLINE_POLL_PERIOD 16
+
+/* State shared by all threads participating in processing. */
+typedef struct
+{
+	par_item_func item_func; /* Processor of a single item. */
+	void *arg;               /* Argument for item_func. */
+	size_t count;            /* Total number of items. */
+	size_t batch;            /* Number of items to take at once. */
+
+	pthread_mutex_t lock; /* Protects fields below. */
+	pthread_cond_t cond;  /* Signaled on completion of all items. */
+	size_t next;          /* Index of the next item to be processed. */
+	size_t done;          /* Number of processed items. */
+	int cancelled;        /* Whether processing should stop. */
+}
+par_state_t;
+
+/* Queue of tasks of a single thread of par_run().  The owner takes the newest
+ * tasks, while other threads take the oldest ones. */
+typedef struct
+{
+	pthread_mutex_t lock; /* Protects fields below. */
+	void **tasks;         /* Storage of the queue. */
+	size_t first;         /* Index of the oldest task in the storage. */
+	size_t count;         /* Number of tasks in the queue. */
+	size_t capacity;      /* Number of allocated elements of the storage. */
+}
+task_queue_t;
+
+/* State shared by all threads of par_run(). */
+struct par_tasks_t
+{
+	par_task_func task_func; /* Processor of a single task. */
+	void *arg;               /* Argument for task_func. */
+	task_queue_t *queues;    /* Queues of all workers. */
+	int nworkers;            /* Number of elements in the queues array. */
+
+	pthread_mutex_t lock; /* Protects fields below. */
+	pthread_cond_t cond;  /* Signaled on new tasks and on completion. */
+	size_t queued;        /* Number of tasks in all queues not yet taken. */
+	size_t pending;       /* Number of tasks that are not yet processed. */
+	size_t done;          /* Number of processed tasks. */
+	int cancelled;        /* Whether processing should stop. */
+};
+
+/* Argument of a worker thread of par_run(). */
+typedef struct
+{
+	par_tasks_t *tasks; /* Shared state. */
+	int worker;         /* Index of the worker. */
+	pthread_t id;       /* Thread identifier. */
+}
+task_worker_t;
+
+static int process_inline(par_state_t *state, par_poll_func poll_func);
+static void * worker_thread(void *arg);
+static void process_batches(par_state_t *state);
+static void wait_for_completion(par_state_t *state, par_poll_func poll_func);
+static int init_tasks(par_tasks_t *tasks);
+static void free_tasks(par_tasks_t *tasks);
+static int run_inline(par_tasks_t *tasks, par_poll_func poll_func);
+static void * task_worker_thread(void *arg);
+static void process_tasks(par_tasks_t *tasks, int worker);
+static int take_task(par_tasks_t *tasks, int worker, void **task);
+static void wait_for_tasks(par_tasks_t *tasks, par_poll_func poll_func);
+static int queue_push(task_queue_t *queue, void *task);
+static int queue_take(task_queue_t *queue, int oldest, void **task);
+
+int
+par_nthreads(void)
+{
+#ifndef _WIN32
+	const long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	const long ncpus = info.dwNumberOfProcessors;
+#endif
+
+	return (ncpus < 1 ? 1 : MIN(ncpus, MAX_THREADS));
+}
+
+int
+par_for(size_t count, int nthreads, par_item_func item_func,
+		par_poll_func poll_func, void *arg)
+{
+	par_state_t state = {
+		.item_func = item_func,
+		.arg = arg,
+		.count = count,
+		.next = 0U,
+		.done = 0U,
+		.cancelled = 0,
+	};
+
+	if(nthreads < 1)
+	{
+		nthreads = 1;
+	}
+	if((size_t)nthreads > count)
+	{
+		nthreads = (int)MAX(count, 1U);
+	}
+
+	/* Batches should be large enough to not make lock a bottleneck, yet small
+	 * enough for threads to finish at about the same time. */
+	state.batch = count/((size_t)nthreads*16U);
+	state.batch = MAX(state.batch, 1U);
+	state.batch = MIN(state.batch, 256U);
+
+	if(nthreads == 1)
+	{
+		return process_inline(&state, poll_func);
+	}
+
+	pthread_t *const threads = reallocarray(NULL, nthreads, sizeof(*threads));
+	if(threads == NULL)
+	{
+		return process_inline(&state, poll_func);
+	}
+
+	if(pthread_mutex_init(&state.lock, NULL) != 0)
+	{
+		free(threads);
+		return process_inline(&state, poll_func);
+	}
+	if(pthread_cond_init(&state.cond, NULL) != 0)
+	{
+		pthread_mutex_destroy(&state.lock);
+		free(threads);
+		return process_inline(&state, poll_func);
+	}
+
+	/* Calling thread takes part in processing only if it doesn't need to poll,
+	 * so start one thread less in that case. */
+	const int nworkers = (poll_func == NULL ? nthreads - 1 : nthreads);
+
+	int nstarted = 0;
+	while(nstarted < nworkers)
+	{
+		if(pthread_create(&threads[nstarted], NULL, &worker_thread, &state) != 0)
+		{
+			break;
+		}
+		++nstarted;
+	}
+
+	if(poll_func == NULL || nstarted == 0)
+	{
+		/* Calling thread does whatever is left to do. */
+		process_batches(&state);
+	}
+
+	if(poll_func != NULL)
+	{
+		wait_for_completion(&state, poll_func);
+	}
+
+	int i;
+	for(i = 0; i < nstarted; ++i)
+	{
+		(void)pthread_join(threads[i], NULL);
+	}
+	free(threads);
+
+	pthread_cond_destroy(&state.cond);
+	pthread_mutex_destroy(&state.lock);
+
+	return state.cancelled;
+}
+
+/* Processes all items on the calling thread.  Returns non-zero if processing
+ * was cancelled. */
+static int
+process_inline(par_state_t *state, par_poll_func poll_func)
+{
+	size_t i;
+	for(i = 0U; i < state->count; ++i)
+	{
+		if(poll_func != NULL && i%state->batch == 0U && poll_func(i, state->arg))
+		{
+			return 1;
+		}
+
+		state->item_func(i, state->arg);
+	}
+	return 0;
+}
+
+/* Entry point of a worker thread.  Returns NULL. */
+static void *
+worker_thread(void *arg)
+{
+	block_all_thread_signals();
+	process_batches(arg);
+	return NULL;
+}
+
+/* Processes batches of items until there are none left or processing is
+ * cancelled. */
+static void
+process_batches(par_state_t *state)
+{
+	while(1)
+	{
+		pthread_mutex_lock(&state->lock);
+		if(state->cancelled || state->next >= state->count)
+		{
+			pthread_mutex_unlock(&state->lock);
+			break;
+		}
+		const size_t from = state->next;
+		const size_t to = MIN(state->count, from + state->batch);
+		state->next = to;
+		pthread_mutex_unlock(&state->lock);
+
+		size_t i;
+		for(i = from; i < to; ++i)
+		{
+			state->item_func(i, state->arg);
+		}
+
+		pthread_mutex_lock(&state->lock);
+		state->done += to - from;
+		if(state->done == state->count)
+		{
+			pthread_cond_signal(&state->cond);
+		}
+		pthread_mutex_unlock(&state->lock);
+	}
+}
+
+/* Waits until all items are processed periodically calling poll function,
+ * which can cancel processing. */
+static void
+wait_for_completion(par_state_t *state, par_poll_func poll_func)
+{
+	pthread_mutex_lock(&state->lock);
+	while(state->done < state->count && !state->cancelled)
+	{
+		struct timespec deadline;
+		if(clock_gettime(CLOCK_REALTIME, &deadline) == 0)
+		{
+			deadline.tv_nsec += POLL_PERIOD_MS*1000L*1000L;
+			deadline.tv_sec += deadline.tv_nsec/(1000L*1000L*1000L);
+			deadline.tv_nsec %= 1000L*1000L*1000L;
+			(void)pthread_cond_timedwait(&state->cond, &state->lock, &deadline);
+		}
+		else
+		{
+			/* Not being able to poll is better than busy waiting. */
+			(void)pthread_cond_wait(&state->cond, &state->lock);
+		}
+
+		const size_t done = state->done;
+		pthread_mutex_unlock(&state->lock);
+		const int cancel = poll_func(done, state->arg);
+		pthread_mutex_lock(&state->lock);
+
+		if(cancel)
+		{
+			state->cancelled = 1;
+		}
+	}
+	pthread_mutex_unlock(&state->lock);
+}
+
+int
+par_run(void *task, int nthreads, par_task_func task_func,
+		par_poll_func poll_func, void *arg)
+{
+	par_tasks_t tasks = {
+		.task_func = task_func,
+		.arg = arg,
+		.nworkers = MAX(nthreads, 1),
+		.queued = 1U,
+		.pending = 1U,
+	};
+
+	if(init_tasks(&tasks) != 0)
+	{
+		return 1;
+	}
+
+	if(queue_push(&tasks.queues[0], task) != 0)
+	{
+		free_tasks(&tasks);
+		return 1;
+	}
+
+	if(tasks.nworkers == 1)
+	{
+		const int cancelled = run_inline(&tasks, poll_func);
+		free_tasks(&tasks);
+		return cancelled;
+	}
+
+	task_worker_t *const workers = reallocarray(NULL, tasks.nworkers,
+			sizeof(*workers));
+	if(workers == NULL)
+	{
+		const int cancelled = run_inline(&tasks, poll_func);
+		free_tasks(&tasks);
+		return cancelled;
+	}
+
+	/* Calling thread takes part in processing as the last worker only if it
+	 * doesn't need to poll. */
+	const int nthreads_to_start = (poll_func == NULL ? tasks.nworkers - 1
+	                                                 : tasks.nworkers);
+
+	int nstarted = 0;
+	while(nstarted < nthreads_to_start)
+	{
+		task_worker_t *const worker = &workers[nstarted];
+		worker->tasks = &tasks;
+		worker->worker = nstarted;
+		if(pthread_create(&worker->id, NULL, &task_worker_thread, worker) != 0)
+		{
+			break;
+		}
+		++nstarted;
+	}
+
+	if(nstarted == 0)
+	{
+		/* Calling thread does all the work then. */
+		(void)run_inline(&tasks, poll_func);
+	}
+	else if(poll_func == NULL)
+	{
+		process_tasks(&tasks, tasks.nworkers - 1);
+	}
+	else
+	{
+		wait_for_tasks(&tasks, poll_func);
+	}
+
+	int i;
+	for(i = 0; i < nstarted; ++i)
+	{
+		(void)pthread_join(workers[i].id, NULL);
+	}
+	free(workers);
+
+	const int cancelled = tasks.cancelled;
+	free_tasks(&tasks);
+	return cancelled;
+}
+
+int
+par_spawn(par_tasks_t *tasks, int worker, void *task)
+{
+	if(queue_push(&tasks->queues[worker], task) != 0)
+	{
+		return 1;
+	}
+
+	pthread_mutex_lock(&tasks->lock);
+	++tasks->queued;
+	++tasks->pending;
+	pthread_cond_broadcast(&tasks->cond);
+	pthread_mutex_unlock(&tasks->lock);
+	return 0;
+}
+
+/* Initializes synchronization primitives and queues of the tasks.  Returns zero
+ * on success, otherwise non-zero is returned. */
+static int
+init_tasks(par_tasks_t *tasks)
+{
+	tasks->queues = calloc(tasks->nworkers, sizeof(*tasks->queues));
+	if(tasks->queues == NULL)
+	{
+		return 1;
+	}
+
+	if(pthread_mutex_init(&tasks->lock, NULL) != 0)
+	{
+		free(tasks->queues);
+		return 1;
+	}
+	if(pthread_cond_init(&tasks->cond, NULL) != 0)
+	{
+		pthread_mutex_destroy(&tasks->lock);
+		free(tasks->queues);
+		return 1;
+	}
+
+	int i;
+	for(i = 0; i < tasks->nworkers; ++i)
+	{
+		if(pthread_mutex_init(&tasks->queues[i].lock, NULL) != 0)
+		{
+			tasks->nworkers = i;
+			free_tasks(tasks);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/* Frees resources allocated by init_tasks().  Tasks that remain in the queues
+ * are dropped. */
+static void
+free_tasks(par_tasks_t *tasks)
+{
+	int i;
+	for(i = 0; i < tasks->nworkers; ++i)
+	{
+		pthread_mutex_destroy(&tasks->queues[i].lock);
+		free(tasks->queues[i].tasks);
+	}
+	free(tasks->queues);
+
+	pthread_cond_destroy(&tasks->cond);
+	pthread_mutex_destroy(&tasks->lock);
+}
+
+/* Processes all tasks on the calling thread.  Returns non-zero if processing
+ * was cancelled. */
+static int
+run_inline(par_tasks_t *tasks, par_poll_func poll_func)
+{
+	void *task;
+	while(take_task(tasks, 0, &task) == 0)
+	{
+		if(poll_func != NULL && tasks->done%INLINE_POLL_PERIOD == 0U &&
+				poll_func(tasks->done, tasks->arg))
+		{
+			tasks->cancelled = 1;
+			break;
+		}
+
+		tasks->task_func(tasks, 0, task, tasks->arg);
+		--tasks->pending;
+		++tasks->done;
+	}
+	return tasks->cancelled;
+}
+
+/* Entry point of a worker thread of par_run().  Returns NULL. */
+static void *
+task_worker_thread(void *arg)
+{
+	task_worker_t *const worker = arg;
+	block_all_thread_signals();
+	process_tasks(worker->tasks, worker->worker);
+	return NULL;
+}
+
+/* Processes tasks until there are none left or processing is cancelled. */
+static void
+process_tasks(par_tasks_t *tasks, int worker)
+{
+	void *task;
+	while(take_task(tasks, worker, &task) == 0)
+	{
+		tasks->task_func(tasks, worker, task, tasks->arg);
+
+		pthread_mutex_lock(&tasks->lock);
+		--tasks->pending;
+		++tasks->done;
+		if(tasks->pending == 0U)
+		{
+			pthread_cond_broadcast(&tasks->cond);
+		}
+		pthread_mutex_unlock(&tasks->lock);
+	}
+}
+
+/* Picks next task for the worker waiting for one to appear if other workers
+ * are still busy.  Returns zero and sets *task on success, otherwise non-zero
+ * is returned. */
+static int
+take_task(par_tasks_t *tasks, int worker, void **task)
+{
+	pthread_mutex_lock(&tasks->lock);
+	while(tasks->queued == 0U && tasks->pending != 0U && !tasks->cancelled)
+	{
+		pthread_cond_wait(&tasks->cond, &tasks->lock);
+	}
+	if(tasks->queued == 0U || tasks->cancelled)
+	{
+		pthread_mutex_unlock(&tasks->lock);
+		return 1;
+	}
+	--tasks->queued;
+	pthread_mutex_unlock(&tasks->lock);
+
+	/* One of the tasks is reserved for this worker, but it can be in any of the
+	 * queues.  Own queue is tried first. */
+	int i = 0;
+	while(1)
+	{
+		const int idx = (worker + i)%tasks->nworkers;
+		if(queue_take(&tasks->queues[idx], idx != worker, task) == 0)
+		{
+			return 0;
+		}
+		++i;
+	}
+}
+
+/* Waits until all tasks are processed periodically calling poll function,
+ * which can cancel processing. */
+static void
+wait_for_tasks(par_tasks_t *tasks, par_poll_func poll_func)
+{
+	pthread_mutex_lock(&tasks->lock);
+	while(tasks->pending != 0U && !tasks->cancelled)
+	{
+		struct timespec deadline;
+		if(clock_gettime(CLOCK_REALTIME, &deadline) == 0)
+		{
+			deadline.tv_nsec += POLL_PERIOD_MS*1000L*1000L;
+			deadline.tv_sec += deadline.tv_nsec/(1000L*1000L*1000L);
+			deadline.tv_nsec %= 1000L*1000L*1000L;
+			(void)pthread_cond_timedwait(&tasks->cond, &tasks->lock, &deadline);
+		}
+		else
+		{
+			/* Not being able to poll is better than busy waiting. */
+			(void)pthread_cond_wait(&tasks->cond, &tasks->lock);
+		}
+
+		const size_t done = tasks->done;
+		pthread_mutex_unlock(&tasks->lock);
+		const int cancel = poll_func(done, tasks->arg);
+		pthread_mutex_lock(&tasks->lock);
+
+		if(cancel)
+		{
+			/* Wake up idle workers to let them quit. */
+			tasks->cancelled = 1;
+			pthread_cond_broadcast(&tasks->cond);
+		}
+	}
+	pthread_mutex_unlock(&tasks->lock);
+}
+
+/* Appends a task to the queue.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+queue_push(task_queue_t *queue, void *task)
+{
+	int error = 0;
+
+	pthread_mutex_lock(&queue->lock);
+	if(queue->first + queue->count == queue->capacity)
+	{
+		if(queue->first != 0U)
+		{
+			memmove(queue->tasks, queue->tasks + queue->first,
+					queue->count*sizeof(*queue->tasks));
+			queue->first = 0U;
+		}
+		else
+		{
+			const size_t capacity = MAX(queue->capacity*2U, 16U);
+			void **const tasks = reallocarray(queue->tasks, capacity,
+					sizeof(*tasks));
+			if(tasks == NULL)
+			{
+				error = 1;
+			}
+			else
+			{
+				queue->tasks = tasks;
+				queue->capacity = capacity;
+			}
+		}
+	}
+
+	if(!error)
+	{
+		queue->tasks[queue->first + queue->count++] = task;
+	}
+	pthread_mutex_unlock(&queue->lock);
+
+	return error;
+}
+
+/* Removes either the oldest or the newest task from the queue.  Returns zero
+ * and sets *task on success, otherwise non-zero is returned. */
+static int
+queue_take(task_queue_t *queue, int oldest, void **task)
+{
+	pthread_mutex_lock(&queue->lock);
+	if(queue->count == 0U)
+	{
+		pthread_mutex_unlock(&queue->lock);
+		return 1;
+	}
+
+	if(oldest)
+	{
+		*task = queue->tasks[queue->first++];
+	}
+	else
+	{
+		*task = queue->tasks[queue->first + queue->count - 1U];
+	}
+	if(--queue->count == 0U)
+	{
+		queue->first = 0U;
+	}
+	pthread_mutex_unlock(&queue->lock);
+
+	return 0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,78 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__PARALLEL_H__
+#define VIFM__UTILS__PARALLEL_H__
+
+#include <stddef.h> /* size_t */
+
+/* Processing of independent items on a short-lived pool of threads. */
+
+/* Type of function that processes a single item specified by its index.  It's
+ * invoked from multiple threads at the same time, so it must not modify shared
+ * state without synchronization. */
+typedef void (*par_item_func)(size_t idx, void *arg);
+
+/* Type of function that is periodically invoked on the calling thread while
+ * items are being processed.  ndone is the number of already processed items.
+ * Should return non-zero to request cancellation and zero otherwise. */
+typedef int (*par_poll_func)(size_t ndone, void *arg);
+
+/* Declaration of opaque type of a set of tasks processed by par_run(). */
+typedef struct par_tasks_t par_tasks_t;
+
+/* Type of function that processes a single task.  worker is index of the
+ * calling thread in the [0; nthreads) range, which can be used to access
+ * per-thread data without synchronization.  Can add more tasks via
+ * par_spawn(). */
+typedef void (*par_task_func)(par_tasks_t *tasks, int worker, void *task,
+		void *arg);
+
+/* Retrieves number of threads that is reasonable to use for processing.
+ * Returns the number, which is always positive. */
+int par_nthreads(void);
+
+/* Calls item_func for each index in the [0; count) range using up to nthreads
+ * threads (calling thread included).  Indexes are handed out in increasing
+ * order in small batches.  poll_func can be NULL, otherwise it's called on the
+ * calling thread every now and then.  Returns zero if all items were
+ * processed and non-zero on cancellation, in which case item_func wasn't
+ * invoked for some of the items. */
+int par_for(size_t count, int nthreads, par_item_func item_func,
+		par_poll_func poll_func, void *arg);
+
+/* Calls task_func for the task and every task spawned while processing it
+ * using up to nthreads threads (calling thread isn't one of them if poll_func
+ * isn't NULL).  Each thread has its own queue of tasks, which it processes in
+ * the last in, first out order, and threads that ran out of tasks steal the
+ * oldest ones from queues of others.  poll_func can be NULL, otherwise it's
+ * called on the calling thread every now and then.  Returns zero if all tasks
+ * were processed and non-zero on cancellation or error, in which case some of
+ * the tasks were dropped without calling task_func for them. */
+int par_run(void *task, int nthreads, par_task_func task_func,
+		par_poll_func poll_func, void *arg);
+
+/* Adds a task to the queue of the worker.  Should be called only from
+ * task_func of par_run().  Returns zero on success, otherwise non-zero is
+ * returned and the task won't be processed. */
+int par_spawn(par_tasks_t *tasks, int worker, void *task);
+
+#endif /* VIFM__UTILS__PARALLEL_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,231 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "str_arena.h"
+
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* calloc() free() malloc() */
+#include <string.h> /* memcpy() strlen() */
+
+#include "trie.h"
+
+/*
+ * Every string is preceded by a pointer to its block and blocks count strings
+ * that point to them.  This allows releasing strings in any order and from any
+ * arena without walking anything.
+ *
+ * Interning is limited to strings of the current block, which the arena keeps
+ * alive, to not have to pin older blocks.
+ */
+
+/* Size of a regular block in bytes. */
+#define BLOCK_SIZE (64*1024)
+
+/* Records larger than this get a block of their own to not waste space at the
+ * end of regular blocks. */
+#define MAX_SHARED_SIZE (BLOCK_SIZE/16)
+
+/* Rounds size up to keep records aligned. */
+#define ALIGN(size) \
+	(((size) + sizeof(void *) - 1)/sizeof(void *)*sizeof(void *))
+
+/* Header of a block of memory that holds strings. */
+typedef struct
+{
+	size_t refs; /* Number of strings in the block plus one while the block is
+	                current in some arena. */
+}
+block_t;
+
+/* Offset of the first record in a block. */
+#define FIRST_RECORD ALIGN(sizeof(block_t))
+
+/* Arena of strings. */
+struct str_arena_t
+{
+	block_t *block;   /* Block to allocate strings from or NULL. */
+	size_t used;      /* Number of used bytes of the block. */
+	trie_t *interned; /* Maps interned strings of the block to themselves. */
+};
+
+static char * alloc_str(str_arena_t *arena, size_t len);
+static void set_block(str_arena_t *arena, block_t *block);
+static block_t * get_block(const char str[]);
+static void release_block(block_t *block);
+
+str_arena_t *
+str_arena_create(void)
+{
+	return calloc(1, sizeof(str_arena_t));
+}
+
+void
+str_arena_free(str_arena_t *arena)
+{
+	if(arena != NULL)
+	{
+		set_block(arena, NULL);
+		free(arena);
+	}
+}
+
+char *
+str_arena_dup(str_arena_t *arena, const char str[])
+{
+	if(arena == NULL)
+	{
+		return NULL;
+	}
+
+	const size_t len = strlen(str);
+	char *const copy = alloc_str(arena, len);
+	if(copy != NULL)
+	{
+		memcpy(copy, str, len + 1);
+	}
+	return copy;
+}
+
+char *
+str_arena_intern(str_arena_t *arena, const char str[])
+{
+	if(arena == NULL)
+	{
+		return NULL;
+	}
+
+	void *data;
+	if(trie_get(arena->interned, str, &data) == 0)
+	{
+		char *const copy = data;
+		++get_block(copy)->refs;
+		return copy;
+	}
+
+	char *const copy = str_arena_dup(arena, str);
+	if(copy == NULL || get_block(copy) != arena->block)
+	{
+		return copy;
+	}
+
+	if(arena->interned == NULL)
+	{
+		arena->interned = trie_create(/*free_func=*/NULL);
+	}
+	if(arena->interned != NULL)
+	{
+		/* Failing to remember the string is OK, it's just not shared. */
+		(void)trie_set(arena->interned, str, copy);
+	}
+	return copy;
+}
+
+void
+str_arena_release(char str[])
+{
+	if(str != NULL)
+	{
+		release_block(get_block(str));
+	}
+}
+
+/* Allocates space for a string of specified length (not counting terminating
+ * null character).  Returns pointer to the space or NULL on error. */
+static char *
+alloc_str(str_arena_t *arena, size_t len)
+{
+	const size_t size = ALIGN(sizeof(block_t *) + len + 1U);
+
+	block_t *block;
+	size_t offset;
+	if(size > MAX_SHARED_SIZE)
+	{
+		block = malloc(FIRST_RECORD + size);
+		if(block == NULL)
+		{
+			return NULL;
+		}
+		block->refs = 0U;
+		offset = FIRST_RECORD;
+	}
+	else
+	{
+		if(arena->block == NULL || arena->used + size > BLOCK_SIZE)
+		{
+			block_t *const new_block = malloc(BLOCK_SIZE);
+			if(new_block == NULL)
+			{
+				return NULL;
+			}
+			set_block(arena, new_block);
+		}
+
+		block = arena->block;
+		offset = arena->used;
+		arena->used += size;
+	}
+
+	++block->refs;
+
+	char *const record = (char *)block + offset;
+	memcpy(record, &block, sizeof(block));
+	return record + sizeof(block);
+}
+
+/* Makes the block (can be NULL) current one for the arena releasing the
+ * previous one. */
+static void
+set_block(str_arena_t *arena, block_t *block)
+{
+	if(arena->block != NULL)
+	{
+		release_block(arena->block);
+	}
+
+	trie_free(arena->interned);
+	arena->interned = NULL;
+
+	arena->block = block;
+	arena->used = FIRST_RECORD;
+	if(block != NULL)
+	{
+		block->refs = 1U;
+	}
+}
+
+/* Retrieves block of a string allocated from an arena.  Returns the block. */
+static block_t *
+get_block(const char str[])
+{
+	block_t *block;
+	memcpy(&block, str - sizeof(block), sizeof(block));
+	return block;
+}
+
+/* Drops a reference to the block freeing it if it was the last one. */
+static void
+release_block(block_t *block)
+{
+	if(--block->refs == 0U)
+	{
+		free(block);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,54 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__STR_ARENA_H__
+#define VIFM__UTILS__STR_ARENA_H__
+
+/* Arena of strings.  Strings are appended to large blocks of memory, each
+ * block is freed when the last string in it is released, so lifetime of a
+ * string isn't bound to lifetime of the arena.  Neither arena nor strings
+ * allocated from it can be used by several threads at the same time. */
+
+/* Declaration of opaque arena type. */
+typedef struct str_arena_t str_arena_t;
+
+/* Creates new arena.  Returns NULL on error. */
+str_arena_t * str_arena_create(void);
+
+/* Frees the arena.  Strings allocated from it remain valid.  Freeing of NULL
+ * arena is OK. */
+void str_arena_free(str_arena_t *arena);
+
+/* Copies the string into the arena.  arena can be NULL, which is treated as an
+ * allocation failure.  Returns the copy, which should be released with
+ * str_arena_release(), or NULL on error. */
+char * str_arena_dup(str_arena_t *arena, const char str[]);
+
+/* Same as str_arena_dup(), but reuses previous copy of the same string if it's
+ * still in the current block of the arena.  The result must not be modified.
+ * Returns the copy, which should be released with str_arena_release(), or NULL
+ * on error. */
+char * str_arena_intern(str_arena_t *arena, const char str[]);
+
+/* Releases string allocated from an arena.  str can be NULL. */
+void str_arena_release(char str[]);
+
+#endif /* VIFM__UTILS__STR_ARENA_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
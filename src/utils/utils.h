@@ -126,6 +126,11 @@ typedef int (*mptraverser)(struct mntent *entry, void *arg);
  * Returns non-zero if so, otherwise zero is returned. */
 int is_on_slow_fs(const char full_path[], const char slowfs_specs[]);
 
+/* Checks whether some location under the full_path might be slow to access
+ * unlike the path itself.  Returns non-zero if so, otherwise zero is
+ * returned. */
+int has_slow_fs_below(const char full_path[], const char slowfs_specs[]);
+
 /* Checks whether accessing the to location from the from location might cause
  * slowdown.  Returns non-zero if so, otherwise zero is returned. */
 int refers_to_slower_fs(const char from[], const char to[]);
@@ -92,7 +92,17 @@ typedef struct
 }
 get_mount_point_traverser_state;
 
+/* State for has_slow_fs_below() traverser. */
+typedef struct
+{
+	const char *path;  /* Path under which mount points are looked for. */
+	const char *specs; /* List of slow file system types. */
+	int found;         /* Whether a slow mount point was found. */
+}
+slow_mount_traverser_state;
+
 static int get_mount_info_traverser(struct mntent *entry, void *arg);
+static int find_slow_mount_traverser(struct mntent *entry, void *arg);
 static void process_cancel_request(pid_t pid,
 		const cancellation_t *cancellation);
 static void free_mnt_entries(struct mntent *entries, unsigned int nentries);
@@ -101,6 +111,7 @@ static int clone_mnt_entry(struct mntent *lhs, const struct mntent *rhs);
 static void free_mnt_entry(struct mntent *entry);
 static int starts_with_list_item(const char str[], const char list[]);
 static int find_path_prefix_index(const char path[], const char list[]);
+static int has_path_under(const char path[], const char list[]);
 static int open_tty(void);
 static void clone_timestamps(const char path[], const char from[],
 		const struct stat *st);
@@ -524,6 +535,43 @@ is_on_slow_fs(const char full_path[], const char slowfs_specs[])
 	return find_path_prefix_index(full_path, slowfs_specs) != -1;
 }
 
+int
+has_slow_fs_below(const char full_path[], const char slowfs_specs[])
+{
+	if(is_null_or_empty(slowfs_specs))
+	{
+		return 0;
+	}
+
+	if(strcmp(slowfs_specs, "*") == 0)
+	{
+		return 1;
+	}
+
+	slow_mount_traverser_state state = {
+		.path = full_path,
+		.specs = slowfs_specs,
+		.found = 0,
+	};
+	(void)traverse_mount_points(&find_slow_mount_traverser, &state);
+
+	return state.found || has_path_under(full_path, slowfs_specs);
+}
+
+/* traverse_mount_points client that looks for a mount point of a slow file
+ * system under a given path. */
+static int
+find_slow_mount_traverser(struct mntent *entry, void *arg)
+{
+	slow_mount_traverser_state *const state = arg;
+	if(path_starts_with(entry->mnt_dir, state->path) &&
+			starts_with_list_item(entry->mnt_type, state->specs))
+	{
+		state->found = 1;
+	}
+	return state->found;
+}
+
 int
 get_mount_point(const char path[], size_t buf_len, char buf[])
 {
@@ -726,6 +774,28 @@ find_path_prefix_index(const char path[], const char list[])
 	return (prefix == NULL) ? -1 : i;
 }
 
+/* Checks whether comma separated list of paths (the list) contains a path
+ * that's prefixed with the path.  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+has_path_under(const char path[], const char list[])
+{
+	char *const list_copy = strdup(list);
+
+	char *item = list_copy, *state = NULL;
+	while((item = split_and_get(item, ',', &state)) != NULL)
+	{
+		if(path_starts_with(item, path))
+		{
+			break;
+		}
+	}
+
+	free(list_copy);
+
+	return item != NULL;
+}
+
 unsigned int
 get_pid(void)
 {
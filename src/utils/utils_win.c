@@ -226,6 +226,12 @@ is_on_slow_fs(const char full_path[], const char slowfs_specs[])
 	return 0;
 }
 
+int
+has_slow_fs_below(const char full_path[], const char slowfs_specs[])
+{
+	return 0;
+}
+
 unsigned int
 get_pid(void)
 {
@@ -0,0 +1,211 @@
+#include <stic.h>
+
+#include <stddef.h> /* NULL */
+#include <string.h> /* strcat() strcpy() strlen() strstr() */
+
+#include <test-utils.h>
+
+#include "../../src/io/private/ioeta.h"
+#include "../../src/io/private/traverser.h"
+#include "../../src/io/ioeta.h"
+
+static VisitResult log_visitor(const char full_path[], VisitAction action,
+		int deep, void *param);
+static VisitResult skip_leave_visitor(const char full_path[],
+		VisitAction action, int deep, void *param);
+static int cancel_hook(void *arg);
+
+static const io_cancellation_t no_cancellation;
+static char visits[4096];
+
+SETUP()
+{
+	visits[0] = '\0';
+
+	create_dir(SANDBOX_PATH "/dir");
+	create_dir(SANDBOX_PATH "/dir/sub");
+	create_file(SANDBOX_PATH "/dir/sub/file");
+	create_file(SANDBOX_PATH "/dir/file");
+}
+
+TEARDOWN()
+{
+	remove_file(SANDBOX_PATH "/dir/file");
+	remove_file(SANDBOX_PATH "/dir/sub/file");
+	remove_dir(SANDBOX_PATH "/dir/sub");
+	remove_dir(SANDBOX_PATH "/dir");
+}
+
+TEST(replaying_matches_traversal)
+{
+	char traversed[sizeof(visits)];
+	ioeta_estim_t *const estim = ioeta_alloc(NULL, no_cancellation);
+
+	assert_int_equal(IO_RES_SUCCEEDED, traverse(TEST_DATA_PATH "/various-sizes",
+				/*deep=*/0, &log_visitor, NULL));
+	strcpy(traversed, visits);
+	visits[0] = '\0';
+
+	ioeta_calculate(estim, TEST_DATA_PATH "/various-sizes", /*shallow=*/0,
+			/*deep=*/0);
+	assert_int_equal(IO_RES_SUCCEEDED, ioeta_traverse(estim,
+				TEST_DATA_PATH "/various-sizes", /*deep=*/0, &log_visitor, NULL));
+	assert_string_equal(traversed, visits);
+
+	ioeta_free(estim);
+}
+
+TEST(changes_after_estimation_are_visited)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL, no_cancellation);
+
+	ioeta_calculate(estim, SANDBOX_PATH "/dir", /*shallow=*/0, /*deep=*/0);
+	remove_file(SANDBOX_PATH "/dir/file");
+	create_file(SANDBOX_PATH "/dir/sub/new");
+
+	assert_int_equal(IO_RES_SUCCEEDED, ioeta_traverse(estim, SANDBOX_PATH "/dir",
+				/*deep=*/0, &log_visitor, NULL));
+	assert_true(strstr(visits, "/dir/file\n") == NULL);
+	assert_true(strstr(visits, "F:" SANDBOX_PATH "/dir/sub/new\n") != NULL);
+
+	remove_file(SANDBOX_PATH "/dir/sub/new");
+	create_file(SANDBOX_PATH "/dir/file");
+	ioeta_free(estim);
+}
+
+TEST(walk_is_not_replayed_for_other_paths)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL, no_cancellation);
+
+	ioeta_calculate(estim, SANDBOX_PATH "/dir", /*shallow=*/0, /*deep=*/0);
+	remove_file(SANDBOX_PATH "/dir/sub/file");
+
+	assert_int_equal(IO_RES_SUCCEEDED, ioeta_traverse(estim,
+				SANDBOX_PATH "/dir/sub", /*deep=*/0, &log_visitor, NULL));
+	assert_string_equal("E:" SANDBOX_PATH "/dir/sub\n"
+	                    "L:" SANDBOX_PATH "/dir/sub\n", visits);
+
+	create_file(SANDBOX_PATH "/dir/sub/file");
+	ioeta_free(estim);
+}
+
+TEST(walk_is_not_replayed_for_different_deepness)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL, no_cancellation);
+
+	ioeta_calculate(estim, SANDBOX_PATH "/dir", /*shallow=*/0, /*deep=*/0);
+	remove_file(SANDBOX_PATH "/dir/file");
+
+	assert_int_equal(IO_RES_SUCCEEDED, ioeta_traverse(estim, SANDBOX_PATH "/dir",
+				/*deep=*/1, &log_visitor, NULL));
+	assert_true(strstr(visits, "/dir/file\n") == NULL);
+
+	create_file(SANDBOX_PATH "/dir/file");
+	ioeta_free(estim);
+}
+
+TEST(shallow_estimation_records_no_walk)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL, no_cancellation);
+
+	ioeta_calculate(estim, SANDBOX_PATH "/dir", /*shallow=*/1, /*deep=*/0);
+	remove_file(SANDBOX_PATH "/dir/file");
+
+	assert_int_equal(IO_RES_SUCCEEDED, ioeta_traverse(estim, SANDBOX_PATH "/dir",
+				/*deep=*/0, &log_visitor, NULL));
+	assert_true(strstr(visits, "/dir/file\n") == NULL);
+
+	create_file(SANDBOX_PATH "/dir/file");
+	ioeta_free(estim);
+}
+
+TEST(cancelled_estimation_records_no_walk)
+{
+	const io_cancellation_t cancellation = { .hook = &cancel_hook };
+	ioeta_estim_t *const estim = ioeta_alloc(NULL, cancellation);
+
+	ioeta_calculate(estim, SANDBOX_PATH "/dir", /*shallow=*/0, /*deep=*/0);
+	remove_file(SANDBOX_PATH "/dir/file");
+
+	assert_int_equal(IO_RES_SUCCEEDED, ioeta_traverse(estim, SANDBOX_PATH "/dir",
+				/*deep=*/0, &log_visitor, NULL));
+	assert_true(strstr(visits, "/dir/file\n") == NULL);
+
+	create_file(SANDBOX_PATH "/dir/file");
+	ioeta_free(estim);
+}
+
+TEST(replaying_respects_skipping_of_leaving)
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL, no_cancellation);
+
+	ioeta_calculate(estim, TEST_DATA_PATH "/various-sizes", /*shallow=*/0,
+			/*deep=*/0);
+
+	assert_int_equal(IO_RES_SUCCEEDED, ioeta_traverse(estim,
+				TEST_DATA_PATH "/various-sizes", /*deep=*/0, &skip_leave_visitor,
+				NULL));
+	assert_true(strstr(visits, "E:") != NULL);
+	assert_true(strstr(visits, "L:") == NULL);
+
+	ioeta_free(estim);
+}
+
+TEST(walks_of_saved_estimation_are_not_freed)
+{
+	char traversed[sizeof(visits)];
+	ioeta_estim_t *const estim = ioeta_alloc(NULL, no_cancellation);
+
+	assert_int_equal(IO_RES_SUCCEEDED, traverse(TEST_DATA_PATH "/various-sizes",
+				/*deep=*/0, &log_visitor, NULL));
+	strcpy(traversed, visits);
+	visits[0] = '\0';
+
+	ioeta_calculate(estim, TEST_DATA_PATH "/various-sizes", /*shallow=*/0,
+			/*deep=*/0);
+
+	ioeta_estim_t save = ioeta_save(estim);
+	ioeta_restore(estim, &save);
+	ioeta_release(&save);
+
+	assert_non_null(estim->manifest);
+	assert_int_equal(IO_RES_SUCCEEDED, ioeta_traverse(estim,
+				TEST_DATA_PATH "/various-sizes", /*deep=*/0, &log_visitor, NULL));
+	assert_string_equal(traversed, visits);
+
+	ioeta_free(estim);
+}
+
+/* Appends description of the visit to the list of visits.  Returns VR_OK. */
+static VisitResult
+log_visitor(const char full_path[], VisitAction action, int deep, void *param)
+{
+	const char *const prefix = (action == VA_DIR_ENTER) ? "E:"
+	                         : (action == VA_FILE) ? "F:" : "L:";
+	if(strlen(visits) + strlen(prefix) + strlen(full_path) + 2U <= sizeof(visits))
+	{
+		strcat(visits, prefix);
+		strcat(visits, full_path);
+		strcat(visits, "\n");
+	}
+	return VR_OK;
+}
+
+/* Logs visits and asks to not be notified about leaving directories.  Returns
+ * VR_SKIP_DIR_LEAVE for directories and VR_OK otherwise. */
+static VisitResult
+skip_leave_visitor(const char full_path[], VisitAction action, int deep,
+		void *param)
+{
+	(void)log_visitor(full_path, action, deep, param);
+	return (action == VA_DIR_ENTER ? VR_SKIP_DIR_LEAVE : VR_OK);
+}
+
+static int
+cancel_hook(void *arg)
+{
+	return 1;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
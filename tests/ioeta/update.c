@@ -101,5 +101,24 @@ TEST(finished_update_increments_current_item)
 	assert_int_equal(prev + 1, estim->current_item);
 }
 
+TEST(finished_items_are_accounted_at_once)
+{
+	estim->total_items = 10;
+	estim->total_bytes = 100;
+
+	ioeta_update_finished(estim, "d", "w", 3, 30);
+	assert_int_equal(3, estim->current_item);
+	assert_int_equal(30, estim->current_byte);
+	assert_string_equal("d", estim->item);
+	assert_string_equal("w", estim->target);
+
+	ioeta_update_finished(estim, NULL, NULL, 8, 80);
+	assert_int_equal(11, estim->current_item);
+	assert_int_equal(11, estim->total_items);
+	assert_int_equal(110, estim->current_byte);
+	assert_int_equal(110, estim->total_bytes);
+	assert_string_equal("d", estim->item);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
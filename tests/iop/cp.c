@@ -9,12 +9,15 @@
 #include <unistd.h> /* _Exit() lstat() */
 
 #include <signal.h> /* SIGXFSZ SIG_IGN signal() */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE SEEK_SET fclose() fopen() fputc() fseek() fwrite() */
 #include <stdlib.h> /* EXIT_FAILURE EXIT_SUCCESS */
 
 #include <test-utils.h>
 
 #include "../../src/compat/fs_limits.h"
 #include "../../src/compat/os.h"
+#include "../../src/io/ioeta.h"
 #include "../../src/io/iop.h"
 #include "../../src/utils/fs.h"
 #include "../../src/utils/macros.h"
@@ -22,6 +25,9 @@
 #include "utils.h"
 
 static void file_is_copied(const char original[]);
+static int have_proc(void);
+
+static const io_cancellation_t no_cancellation;
 
 TEST(dir_is_not_copied)
 {
@@ -177,6 +183,77 @@ file_is_copied(const char original[])
 	delete_test_file(SANDBOX_PATH "/copy");
 }
 
+TEST(copying_without_cloning_does_not_use_copy_file_range)
+{
+	io_args_t args = {
+		.arg1.src = TEST_DATA_PATH "/various-sizes/block-size-file",
+		.arg2.dst = SANDBOX_PATH "/copy-of-block-size-file",
+		.arg4.fast_file_cloning = 0,
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	copy_range_calls = 0;
+	assert_int_equal(IO_RES_SUCCEEDED, iop_cp(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+	assert_int_equal(0, copy_range_calls);
+
+	assert_int_equal(get_file_size(args.arg1.src), get_file_size(args.arg2.dst));
+	remove_file(args.arg2.dst);
+}
+
+TEST(large_file_is_copied_in_chunks_with_progress)
+{
+	/* Several times larger than a chunk copied by the kernel at once. */
+	const int size = 9*1024*1024 + 1;
+
+	FILE *const f = fopen(SANDBOX_PATH "/large", "wb");
+	assert_non_null(f);
+	int i;
+	for(i = 0; i < size; ++i)
+	{
+		fputc(i%251, f);
+	}
+	fclose(f);
+
+	io_args_t args = {
+		.arg1.src = SANDBOX_PATH "/large",
+		.arg2.dst = SANDBOX_PATH "/copy",
+
+		.estim = ioeta_alloc(NULL, no_cancellation),
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	ioeta_calculate(args.estim, SANDBOX_PATH "/large", /*shallow=*/0,
+			/*deep=*/0);
+	assert_int_equal(size, args.estim->total_bytes);
+
+	assert_int_equal(IO_RES_SUCCEEDED, iop_cp(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+	assert_int_equal(size, args.estim->current_byte);
+
+	assert_true(files_are_identical(SANDBOX_PATH "/copy", SANDBOX_PATH "/large"));
+
+	ioeta_free(args.estim);
+	delete_test_file(SANDBOX_PATH "/large");
+	delete_test_file(SANDBOX_PATH "/copy");
+}
+
+TEST(files_that_look_empty_are_read_to_the_end, IF(have_proc))
+{
+	io_args_t args = {
+		.arg1.src = "/proc/self/status",
+		.arg2.dst = SANDBOX_PATH "/status",
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	assert_int_equal(IO_RES_SUCCEEDED, iop_cp(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+
+	assert_true(get_file_size(SANDBOX_PATH "/status") > 0);
+
+	delete_test_file(SANDBOX_PATH "/status");
+}
+
 TEST(appending_works_for_files)
 {
 	uint64_t size;
@@ -499,6 +576,55 @@ TEST(overwrite_removal_handles_errors, IF(regular_unix_user))
 /* Windows lacks definitions of some declarations. */
 #ifndef _WIN32
 
+TEST(holes_of_sparse_files_are_preserved, IF(not_windows))
+{
+	const int size = 64*1024*1024;
+	const int data_at = 16*1024*1024;
+	struct stat st;
+
+	FILE *const f = fopen(SANDBOX_PATH "/sparse", "wb");
+	assert_non_null(f);
+	assert_success(fseek(f, data_at, SEEK_SET));
+	assert_int_equal(5, fwrite("data!", 1, 5, f));
+	assert_success(fseek(f, size - 1, SEEK_SET));
+	fputc('\0', f);
+	fclose(f);
+
+	assert_success(stat(SANDBOX_PATH "/sparse", &st));
+	const int src_is_sparse = ((uint64_t)st.st_blocks*512U < (uint64_t)size);
+
+	io_args_t args = {
+		.arg1.src = SANDBOX_PATH "/sparse",
+		.arg2.dst = SANDBOX_PATH "/copy",
+
+		.estim = ioeta_alloc(NULL, no_cancellation),
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	ioeta_calculate(args.estim, SANDBOX_PATH "/sparse", /*shallow=*/0,
+			/*deep=*/0);
+
+	assert_int_equal(IO_RES_SUCCEEDED, iop_cp(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+	/* Holes count as copied data. */
+	assert_int_equal(size, args.estim->current_byte);
+	ioeta_free(args.estim);
+
+	assert_true(files_are_identical(SANDBOX_PATH "/copy",
+				SANDBOX_PATH "/sparse"));
+
+	/* Whether holes are supported depends on the file system. */
+	assert_success(stat(SANDBOX_PATH "/copy", &st));
+	assert_int_equal(size, st.st_size);
+	if(src_is_sparse)
+	{
+		assert_true((uint64_t)st.st_blocks*512U < (uint64_t)size);
+	}
+
+	delete_test_file(SANDBOX_PATH "/sparse");
+	delete_test_file(SANDBOX_PATH "/copy");
+}
+
 /* No named fifo in file systems on Windows. */
 TEST(fifo_is_copied, IF(not_windows))
 {
@@ -620,5 +746,11 @@ TEST(append_truncates_destination_files_on_error, IF(not_windows))
 
 #endif
 
+static int
+have_proc(void)
+{
+	return path_exists("/proc/self/status", DEREF);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -3,10 +3,15 @@
 #include <sys/stat.h> /* stat chmod() */
 #include <sys/types.h> /* stat */
 #include <unistd.h> /* F_OK access() */
+#include <utime.h> /* utimbuf utime() */
+
+#include <stdio.h> /* snprintf() */
 
 #include <test-utils.h>
 
+#include "../../src/compat/fs_limits.h"
 #include "../../src/compat/os.h"
+#include "../../src/io/ioeta.h"
 #include "../../src/io/iop.h"
 #include "../../src/io/ior.h"
 #include "../../src/utils/fs.h"
@@ -15,6 +20,7 @@
 
 static int confirm_overwrite(io_args_t *args, const char src[],
 		const char dst[]);
+static void make_tree(const char root[], int nfiles);
 
 static int confirm_called;
 
@@ -550,6 +556,112 @@ TEST(permissions_are_set_in_correct_order)
 	}
 }
 
+TEST(many_small_files_are_copied_with_directory_metadata, IF(not_windows))
+{
+	const struct utimbuf old_time = { .actime = 1000000000,
+	                                  .modtime = 1000000000 };
+	const io_cancellation_t no_cancellation = {};
+	struct stat st;
+
+	make_tree(SANDBOX_PATH "/tree", 100);
+	assert_success(chmod(SANDBOX_PATH "/tree/sub", 0500));
+	assert_success(utime(SANDBOX_PATH "/tree/sub", &old_time));
+	assert_success(utime(SANDBOX_PATH "/tree", &old_time));
+
+	io_args_t args = {
+		.arg1.src = SANDBOX_PATH "/tree",
+		.arg2.dst = SANDBOX_PATH "/copy",
+
+		.estim = ioeta_alloc(NULL, no_cancellation),
+	};
+	ioe_errlst_init(&args.result.errors);
+	ioeta_calculate(args.estim, SANDBOX_PATH "/tree", /*shallow=*/0, /*deep=*/0);
+
+	assert_int_equal(IO_RES_SUCCEEDED, ior_cp(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+
+	assert_int_equal(args.estim->total_items, args.estim->current_item);
+	assert_int_equal(args.estim->total_bytes, args.estim->current_byte);
+	ioeta_free(args.estim);
+
+	assert_int_equal(get_file_size(SANDBOX_PATH "/tree/sub/99"),
+			get_file_size(SANDBOX_PATH "/copy/sub/99"));
+	assert_int_equal(get_file_size(SANDBOX_PATH "/tree/0"),
+			get_file_size(SANDBOX_PATH "/copy/0"));
+
+	/* Directories are finished after all of their files are written. */
+	assert_success(os_stat(SANDBOX_PATH "/copy/sub", &st));
+	assert_int_equal(1000000000, st.st_mtime);
+	assert_int_equal(0500, st.st_mode & 0777);
+	assert_success(os_stat(SANDBOX_PATH "/copy", &st));
+	assert_int_equal(1000000000, st.st_mtime);
+
+	assert_success(chmod(SANDBOX_PATH "/tree/sub", 0700));
+	assert_success(chmod(SANDBOX_PATH "/copy/sub", 0700));
+	delete_tree(SANDBOX_PATH "/tree");
+	delete_tree(SANDBOX_PATH "/copy");
+}
+
+TEST(files_removed_after_estimation_are_not_copied)
+{
+	const io_cancellation_t no_cancellation = {};
+
+	make_tree(SANDBOX_PATH "/tree", 10);
+
+	io_args_t args = {
+		.arg1.src = SANDBOX_PATH "/tree",
+		.arg2.dst = SANDBOX_PATH "/copy",
+
+		.estim = ioeta_alloc(NULL, no_cancellation),
+	};
+	ioe_errlst_init(&args.result.errors);
+	ioeta_calculate(args.estim, SANDBOX_PATH "/tree", /*shallow=*/0, /*deep=*/0);
+
+	remove_file(SANDBOX_PATH "/tree/sub/7");
+	make_file(SANDBOX_PATH "/tree/new", "new");
+
+	assert_int_equal(IO_RES_SUCCEEDED, ior_cp(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+	ioeta_free(args.estim);
+
+	assert_failure(access(SANDBOX_PATH "/copy/sub/7", F_OK));
+	const char *lines[] = { "new" };
+	file_is(SANDBOX_PATH "/copy/new", lines, 1);
+
+	delete_tree(SANDBOX_PATH "/tree");
+	delete_tree(SANDBOX_PATH "/copy");
+}
+
+TEST(errors_of_small_files_are_collected, IF(not_windows))
+{
+	make_tree(SANDBOX_PATH "/tree", 10);
+	create_empty_dir(SANDBOX_PATH "/copy");
+	create_empty_dir(SANDBOX_PATH "/copy/5");
+	create_empty_file(SANDBOX_PATH "/copy/5/file");
+
+	io_args_t args = {
+		.arg1.src = SANDBOX_PATH "/tree",
+		.arg2.dst = SANDBOX_PATH "/copy",
+		.arg3.crs = IO_CRS_REPLACE_FILES,
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	assert_int_equal(IO_RES_FAILED, ior_cp(&args));
+	assert_int_equal(1, args.result.errors.error_count);
+	assert_string_equal(SANDBOX_PATH "/copy/5",
+			args.result.errors.errors[0].path);
+	ioe_errlst_free(&args.result.errors);
+
+	/* Other files of the batch are still copied. */
+	assert_int_equal(get_file_size(SANDBOX_PATH "/tree/4"),
+			get_file_size(SANDBOX_PATH "/copy/4"));
+	assert_int_equal(get_file_size(SANDBOX_PATH "/tree/6"),
+			get_file_size(SANDBOX_PATH "/copy/6"));
+
+	delete_tree(SANDBOX_PATH "/tree");
+	delete_tree(SANDBOX_PATH "/copy");
+}
+
 static int
 confirm_overwrite(io_args_t *args, const char src[], const char dst[])
 {
@@ -557,5 +669,29 @@ confirm_overwrite(io_args_t *args, const char src[], const char dst[])
 	return 1;
 }
 
+/* Creates directory with nfiles small files in it and in its "sub"
+ * subdirectory. */
+static void
+make_tree(const char root[], int nfiles)
+{
+	char path[PATH_MAX + 1];
+
+	create_empty_dir(root);
+	snprintf(path, sizeof(path), "%s/sub", root);
+	create_empty_dir(path);
+
+	int i;
+	for(i = 0; i < nfiles; ++i)
+	{
+		char contents[16];
+		snprintf(contents, sizeof(contents), "%d", i);
+
+		snprintf(path, sizeof(path), "%s/%d", root, i);
+		make_file(path, contents);
+		snprintf(path, sizeof(path), "%s/sub/%d", root, i);
+		make_file(path, contents);
+	}
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -2,7 +2,10 @@
 
 #include <unistd.h> /* F_OK access() */
 
+#include <test-utils.h>
+
 #include "../../src/compat/os.h"
+#include "../../src/io/ioeta.h"
 #include "../../src/io/ior.h"
 #include "../../src/utils/fs.h"
 
@@ -65,5 +68,34 @@ TEST(non_empty_directory_is_removed)
 	assert_failure(access(DIRECTORY_NAME, F_OK));
 }
 
+TEST(changes_after_estimation_are_removed)
+{
+	const io_cancellation_t no_cancellation = {};
+
+	os_mkdir(DIRECTORY_NAME, 0700);
+	os_mkdir(DIRECTORY_NAME "/sub", 0700);
+	create_empty_file(DIRECTORY_NAME "/sub/" FILE_NAME);
+	create_empty_file(DIRECTORY_NAME "/" FILE_NAME);
+
+	{
+		io_args_t args = {
+			.arg1.path = DIRECTORY_NAME,
+
+			.estim = ioeta_alloc(NULL, no_cancellation),
+		};
+		ioe_errlst_init(&args.result.errors);
+		ioeta_calculate(args.estim, DIRECTORY_NAME, /*shallow=*/0, /*deep=*/0);
+
+		create_empty_file(DIRECTORY_NAME "/sub/new");
+		remove_file(DIRECTORY_NAME "/" FILE_NAME);
+
+		assert_int_equal(IO_RES_SUCCEEDED, ior_rm(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+		ioeta_free(args.estim);
+	}
+
+	assert_failure(access(DIRECTORY_NAME, F_OK));
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
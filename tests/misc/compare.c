@@ -3,13 +3,18 @@
 #include <sys/stat.h> /* chmod() mkfifo() */
 #include <unistd.h> /* rmdir() */
 
-#include <stdio.h> /* FILE fopen() fwrite() fclose() remove() */
+#include <stdio.h> /* FILE fopen() fwrite() fclose() remove() snprintf() */
 #include <string.h> /* memset() strcpy() */
 
 #include <test-utils.h>
 
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
 #include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
 #include "../../src/compare.h"
+#include "../../src/hash_cache.h"
 
 /* These tests are about comparison strategies and not about handling of unusual
  * situations or results of operations in compare views. */
@@ -494,6 +499,138 @@ TEST(files_with_identical_fingerprints_are_handled_well)
 	remove_dir(SANDBOX_PATH "/b");
 }
 
+TEST(many_files_of_the_same_size_are_matched_by_contents)
+{
+	char path[PATH_MAX + 1];
+	char contents[64];
+	int i;
+
+	create_dir(SANDBOX_PATH "/a");
+	create_dir(SANDBOX_PATH "/b");
+	for(i = 0; i < 20; ++i)
+	{
+		snprintf(contents, sizeof(contents), "file %02d", i);
+		snprintf(path, sizeof(path), "%s/a/%02d", SANDBOX_PATH, i);
+		make_file(path, contents);
+
+		/* Every odd file differs in the last character. */
+		contents[6] += i % 2;
+		snprintf(path, sizeof(path), "%s/b/%02d", SANDBOX_PATH, i);
+		make_file(path, contents);
+	}
+	/* Files of unique size in one of the lists. */
+	make_file(SANDBOX_PATH "/a/unique", "unique");
+	make_file(SANDBOX_PATH "/b/unique", "unique");
+
+	strcpy(lwin.curr_dir, SANDBOX_PATH "/a");
+	strcpy(rwin.curr_dir, SANDBOX_PATH "/b");
+	compare_two_panes(CT_CONTENTS, LT_ALL, CF_SHOW | CF_GROUP_PATHS);
+
+	assert_int_equal(21, lwin.list_rows);
+	assert_int_equal(21, rwin.list_rows);
+	assert_int_equal(lwin.dir_entry[20].id, rwin.dir_entry[20].id);
+
+	for(i = 0; i < 20; ++i)
+	{
+		assert_int_equal(i % 2 == 0, lwin.dir_entry[i].id == rwin.dir_entry[i].id);
+
+		snprintf(path, sizeof(path), "%s/a/%02d", SANDBOX_PATH, i);
+		remove_file(path);
+		snprintf(path, sizeof(path), "%s/b/%02d", SANDBOX_PATH, i);
+		remove_file(path);
+	}
+	remove_file(SANDBOX_PATH "/a/unique");
+	remove_file(SANDBOX_PATH "/b/unique");
+	remove_dir(SANDBOX_PATH "/a");
+	remove_dir(SANDBOX_PATH "/b");
+}
+
+TEST(comparison_by_contents_stores_hashes, IF(not_windows))
+{
+	make_file(SANDBOX_PATH "/a", "abc");
+	make_file(SANDBOX_PATH "/b", "abc");
+	make_file(SANDBOX_PATH "/c", "abcd");
+
+	strcpy(lwin.curr_dir, SANDBOX_PATH);
+	copy_str(cfg.hash_cache_file, sizeof(cfg.hash_cache_file),
+			SANDBOX_PATH "/hashes");
+	cfg.compare_cache = 10;
+	(void)compare_one_pane(&lwin, CT_CONTENTS, LT_ALL, CF_NONE);
+	cfg.compare_cache = 0;
+	cfg.hash_cache_file[0] = '\0';
+
+	assert_int_equal(3, lwin.list_rows);
+	assert_int_equal(lwin.dir_entry[0].id, lwin.dir_entry[1].id);
+
+	/* Only files of the same size are hashed. */
+	hcache_key_t key;
+	hcache_hash_t hash;
+	hcache_t *cache = hcache_load(SANDBOX_PATH "/hashes", 10);
+	assert_success(hcache_make_key(SANDBOX_PATH "/a", &key));
+	assert_success(hcache_get(cache, &key, &hash));
+	assert_success(hcache_make_key(SANDBOX_PATH "/b", &key));
+	assert_success(hcache_get(cache, &key, &hash));
+	assert_success(hcache_make_key(SANDBOX_PATH "/c", &key));
+	assert_failure(hcache_get(cache, &key, &hash));
+	hcache_free(cache);
+
+	remove_file(SANDBOX_PATH "/a");
+	remove_file(SANDBOX_PATH "/b");
+	remove_file(SANDBOX_PATH "/c");
+	remove_file(SANDBOX_PATH "/hashes");
+}
+
+TEST(poisoned_hash_cache_does_not_make_files_identical, IF(not_windows))
+{
+	create_dir(SANDBOX_PATH "/dir");
+	make_file(SANDBOX_PATH "/dir/a", "abc");
+	make_file(SANDBOX_PATH "/dir/b", "xyz");
+
+	/* Pretend that different contents of the files was hashed to the same
+	 * value. */
+	const hcache_hash_t hash = { .high = 1, .low = 2 };
+	hcache_key_t key;
+	hcache_t *cache = hcache_load(SANDBOX_PATH "/hashes", 10);
+	assert_success(hcache_make_key(SANDBOX_PATH "/dir/a", &key));
+	hcache_put(cache, &key, &hash);
+	assert_success(hcache_make_key(SANDBOX_PATH "/dir/b", &key));
+	hcache_put(cache, &key, &hash);
+	assert_success(hcache_save(cache));
+	hcache_free(cache);
+
+	strcpy(lwin.curr_dir, SANDBOX_PATH "/dir");
+	copy_str(cfg.hash_cache_file, sizeof(cfg.hash_cache_file),
+			SANDBOX_PATH "/hashes");
+	cfg.compare_cache = 10;
+	(void)compare_one_pane(&lwin, CT_CONTENTS, LT_ALL, CF_NONE);
+	cfg.compare_cache = 0;
+	cfg.hash_cache_file[0] = '\0';
+
+	assert_int_equal(2, lwin.list_rows);
+	assert_true(lwin.dir_entry[0].id != lwin.dir_entry[1].id);
+
+	remove_file(SANDBOX_PATH "/dir/a");
+	remove_file(SANDBOX_PATH "/dir/b");
+	remove_dir(SANDBOX_PATH "/dir");
+	remove_file(SANDBOX_PATH "/hashes");
+}
+
+TEST(no_hashes_are_stored_if_cache_is_disabled)
+{
+	make_file(SANDBOX_PATH "/a", "abc");
+	make_file(SANDBOX_PATH "/b", "abc");
+
+	copy_str(cfg.hash_cache_file, sizeof(cfg.hash_cache_file),
+			SANDBOX_PATH "/hashes");
+	strcpy(lwin.curr_dir, SANDBOX_PATH);
+	(void)compare_one_pane(&lwin, CT_CONTENTS, LT_ALL, CF_NONE);
+	cfg.hash_cache_file[0] = '\0';
+	assert_false(path_exists(SANDBOX_PATH "/hashes", NODEREF));
+
+	remove_file(SANDBOX_PATH "/a");
+	remove_file(SANDBOX_PATH "/b");
+}
+
 /* Because of mkfifo() */
 #ifndef _WIN32
 
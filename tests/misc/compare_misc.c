@@ -1,5 +1,6 @@
 #include <stic.h>
 
+#include <stdio.h> /* snprintf() */
 #include <string.h> /* strcpy() */
 
 #include <test-utils.h>
@@ -12,6 +13,7 @@
 #include "../../src/ui/ui.h"
 #include "../../src/utils/filter.h"
 #include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
 #include "../../src/cmd_core.h"
 #include "../../src/compare.h"
 #include "../../src/filelist.h"
@@ -124,6 +126,44 @@ TEST(compare_skips_dir_symlinks, IF(not_windows))
 	assert_success(remove(SANDBOX_PATH "/link"));
 }
 
+TEST(compare_lists_file_symlinks_but_not_dir_symlinks, IF(not_windows))
+{
+	char path[PATH_MAX + 1];
+	int i;
+	for(i = 0; i < 5; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/d%d", SANDBOX_PATH, i);
+		create_dir(path);
+		snprintf(path, sizeof(path), "%s/d%d/f", SANDBOX_PATH, i);
+		create_file(path);
+	}
+	assert_success(make_symlink("d0/f", SANDBOX_PATH "/flink"));
+	assert_success(make_symlink("d0", SANDBOX_PATH "/dlink"));
+
+	strcpy(lwin.curr_dir, SANDBOX_PATH);
+	compare_one_pane(&lwin, CT_CONTENTS, LT_ALL, CF_NONE);
+
+	assert_true(flist_custom_active(&lwin));
+	assert_int_equal(6, lwin.list_rows);
+	for(i = 0; i < 5; ++i)
+	{
+		snprintf(path, sizeof(path), "d%d", i);
+		assert_true(ends_with(lwin.dir_entry[i].origin, path));
+		assert_string_equal("f", lwin.dir_entry[i].name);
+	}
+	assert_string_equal("flink", lwin.dir_entry[5].name);
+
+	assert_success(remove(SANDBOX_PATH "/dlink"));
+	assert_success(remove(SANDBOX_PATH "/flink"));
+	for(i = 0; i < 5; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/d%d/f", SANDBOX_PATH, i);
+		remove_file(path);
+		snprintf(path, sizeof(path), "%s/d%d", SANDBOX_PATH, i);
+		remove_dir(path);
+	}
+}
+
 TEST(not_available_files_are_ignored, IF(regular_unix_user))
 {
 	copy_file(TEST_DATA_PATH "/read/utf8-bom", SANDBOX_PATH "/utf8-bom");
@@ -0,0 +1,212 @@
+#include <stic.h>
+
+#include <unistd.h> /* chdir() usleep() */
+
+#include <test-utils.h>
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/filelist.h"
+#include "../../src/status.h"
+
+static void wait_for_loading(void);
+
+static view_t *const view = &lwin;
+static char cwd[PATH_MAX + 1];
+
+SETUP_ONCE()
+{
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+}
+
+SETUP()
+{
+	view_setup(view);
+	make_abs_path(view->curr_dir, sizeof(view->curr_dir), SANDBOX_PATH, "",
+			cwd);
+
+	create_file(SANDBOX_PATH "/file");
+	create_dir(SANDBOX_PATH "/dir");
+
+	curr_stats.load_stage = 3;
+}
+
+TEARDOWN()
+{
+	curr_stats.load_stage = 0;
+
+	view->on_slow_fs = 0;
+	view->unresponsive = 0;
+	view_teardown(view);
+	assert_success(chdir(cwd));
+
+	remove_file(SANDBOX_PATH "/file");
+	remove_dir(SANDBOX_PATH "/dir");
+}
+
+TEST(list_is_read_in_background_on_slow_fs)
+{
+	view->on_slow_fs = 1;
+	assert_success(populate_dir_list(view, /*reload=*/0));
+
+	assert_true(flist_is_loading(view));
+	assert_false(view->unresponsive);
+	assert_int_equal(1, view->list_rows);
+	assert_string_equal("..", view->dir_entry[0].name);
+
+	wait_for_loading();
+
+	assert_false(flist_is_loading(view));
+	assert_int_equal(2, view->list_rows);
+	assert_string_equal("dir", view->dir_entry[0].name);
+	assert_int_equal(FT_DIR, view->dir_entry[0].type);
+	assert_string_equal("file", view->dir_entry[1].name);
+	assert_int_equal(FT_REG, view->dir_entry[1].type);
+	assert_true(view->dir_entry[1].mtime != 0);
+}
+
+TEST(list_is_read_in_place_on_fast_fs)
+{
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_false(flist_is_loading(view));
+	assert_int_equal(2, view->list_rows);
+}
+
+TEST(reload_keeps_current_list_until_new_one_is_read)
+{
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_int_equal(2, view->list_rows);
+	view->list_pos = 1;
+	view->dir_entry[1].selected = 1;
+	view->selected_files = 1;
+
+	create_file(SANDBOX_PATH "/afile");
+
+	view->on_slow_fs = 1;
+	assert_success(populate_dir_list(view, /*reload=*/1));
+	assert_true(flist_is_loading(view));
+	assert_int_equal(2, view->list_rows);
+
+	wait_for_loading();
+
+	assert_int_equal(3, view->list_rows);
+	assert_string_equal("dir", view->dir_entry[0].name);
+	assert_string_equal("afile", view->dir_entry[1].name);
+	assert_string_equal("file", view->dir_entry[2].name);
+	assert_int_equal(2, view->list_pos);
+	assert_true(view->dir_entry[2].selected);
+
+	remove_file(SANDBOX_PATH "/afile");
+}
+
+TEST(filters_are_applied_to_list_read_in_background)
+{
+	create_file(SANDBOX_PATH "/.hidden");
+
+	view->hide_dot = 1;
+	view->on_slow_fs = 1;
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	wait_for_loading();
+
+	assert_int_equal(2, view->list_rows);
+	assert_int_equal(1, view->filtered);
+
+	remove_file(SANDBOX_PATH "/.hidden");
+}
+
+TEST(symbolic_links_are_resolved_in_background, IF(not_windows))
+{
+	assert_success(make_symlink("dir", SANDBOX_PATH "/link"));
+
+	view->on_slow_fs = 1;
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	wait_for_loading();
+
+	assert_int_equal(3, view->list_rows);
+	assert_string_equal("link", view->dir_entry[1].name);
+	assert_int_equal(FT_LINK, view->dir_entry[1].type);
+	assert_true(view->dir_entry[1].dir_link);
+
+	remove_file(SANDBOX_PATH "/link");
+}
+
+TEST(reading_in_background_can_be_cancelled)
+{
+	view->on_slow_fs = 1;
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_true(flist_is_loading(view));
+
+	flist_cancel_loading(view);
+	assert_false(flist_is_loading(view));
+
+	flist_finish_loading(view);
+	assert_int_equal(1, view->list_rows);
+	assert_string_equal("..", view->dir_entry[0].name);
+}
+
+TEST(new_location_cancels_reading_in_background)
+{
+	view->on_slow_fs = 1;
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_true(flist_is_loading(view));
+
+	make_abs_path(view->curr_dir, sizeof(view->curr_dir), SANDBOX_PATH, "dir",
+			cwd);
+	view->on_slow_fs = 0;
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_false(flist_is_loading(view));
+
+	assert_int_equal(1, view->list_rows);
+	assert_string_equal("..", view->dir_entry[0].name);
+}
+
+TEST(unresponsive_directory_is_only_read_in_background)
+{
+	view->on_slow_fs = 1;
+	view->unresponsive = 1;
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_true(flist_is_loading(view));
+	assert_true(view->unresponsive);
+
+	wait_for_loading();
+
+	assert_false(view->unresponsive);
+	assert_int_equal(2, view->list_rows);
+	assert_string_equal("dir", view->dir_entry[0].name);
+	assert_string_equal("file", view->dir_entry[1].name);
+}
+
+TEST(inaccessible_unresponsive_directory_is_left_empty)
+{
+	make_abs_path(view->curr_dir, sizeof(view->curr_dir), SANDBOX_PATH,
+			"missing", cwd);
+
+	view->on_slow_fs = 1;
+	view->unresponsive = 1;
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_true(flist_is_loading(view));
+
+	/* Prevent error dialog from waiting for input. */
+	curr_stats.load_stage = 0;
+	wait_for_loading();
+
+	assert_false(view->unresponsive);
+	assert_int_equal(1, view->list_rows);
+	assert_string_equal("..", view->dir_entry[0].name);
+}
+
+/* Waits for background reading to finish and applies its result. */
+static void
+wait_for_loading(void)
+{
+	int i;
+	for(i = 0; i < 1000 && flist_is_loading(view); ++i)
+	{
+		usleep(5000);
+		flist_finish_loading(view);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
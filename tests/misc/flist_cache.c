@@ -0,0 +1,139 @@
+#include <stic.h>
+
+#include <unistd.h> /* chdir() */
+
+#include <test-utils.h>
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/filelist.h"
+#include "../../src/flist_cache.h"
+
+static view_t *const view = &lwin;
+static char cwd[PATH_MAX + 1];
+static char dir_a[PATH_MAX + 1];
+static char dir_b[PATH_MAX + 1];
+
+SETUP_ONCE()
+{
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+	/* Not a current view to avoid extra processing of FUSE mounts. */
+	curr_view = &rwin;
+	other_view = &lwin;
+}
+
+SETUP()
+{
+	view_setup(view);
+	view_setup(&rwin);
+
+	make_abs_path(dir_a, sizeof(dir_a), SANDBOX_PATH, "a", cwd);
+	make_abs_path(dir_b, sizeof(dir_b), SANDBOX_PATH, "b", cwd);
+
+	create_dir(SANDBOX_PATH "/a");
+	create_file(SANDBOX_PATH "/a/file1");
+	create_file(SANDBOX_PATH "/a/file2");
+	create_dir(SANDBOX_PATH "/b");
+	create_file(SANDBOX_PATH "/b/file");
+
+	cfg.list_cache_size = 1024;
+
+	assert_success(navigate_to(view, dir_a));
+	assert_success(navigate_to(view, dir_b));
+}
+
+TEARDOWN()
+{
+	flist_cache_clear();
+	cfg.list_cache_size = 0;
+
+	view_teardown(view);
+	view_teardown(&rwin);
+	assert_success(chdir(cwd));
+
+	remove_file(SANDBOX_PATH "/a/file1");
+	remove_file(SANDBOX_PATH "/a/file2");
+	remove_dir(SANDBOX_PATH "/a");
+	remove_file(SANDBOX_PATH "/b/file");
+	remove_dir(SANDBOX_PATH "/b");
+}
+
+TEST(list_is_cached_on_leaving_directory)
+{
+	flist_cache_stats_t stats;
+	flist_cache_get_stats(&stats);
+	assert_int_equal(1, stats.listings);
+	assert_true(stats.size > 0U);
+	assert_int_equal(1024*1024, stats.capacity);
+}
+
+TEST(cached_list_is_used_on_return)
+{
+	assert_success(navigate_to(view, dir_a));
+	assert_int_equal(2, view->list_rows);
+	assert_string_equal("file1", view->dir_entry[0].name);
+	assert_string_equal(dir_a, view->dir_entry[0].origin);
+	assert_string_equal("file2", view->dir_entry[1].name);
+
+	flist_cache_stats_t stats;
+	flist_cache_get_stats(&stats);
+	assert_int_equal(1, stats.hits);
+	/* Both directories weren't in cache on the first visit. */
+	assert_int_equal(2, stats.misses);
+	/* The other directory has been cached instead. */
+	assert_int_equal(1, stats.listings);
+
+	assert_success(navigate_to(view, dir_b));
+	flist_cache_get_stats(&stats);
+	assert_int_equal(2, stats.hits);
+}
+
+TEST(changed_directory_is_read_anew)
+{
+	create_file(SANDBOX_PATH "/a/file3");
+
+	assert_success(navigate_to(view, dir_a));
+	assert_int_equal(3, view->list_rows);
+
+	flist_cache_stats_t stats;
+	flist_cache_get_stats(&stats);
+	assert_int_equal(0, stats.hits);
+	assert_int_equal(3, stats.misses);
+
+	remove_file(SANDBOX_PATH "/a/file3");
+}
+
+TEST(changed_filter_prevents_use_of_cached_list)
+{
+	view->hide_dot = !view->hide_dot;
+
+	assert_success(navigate_to(view, dir_a));
+
+	flist_cache_stats_t stats;
+	flist_cache_get_stats(&stats);
+	assert_int_equal(0, stats.hits);
+	assert_int_equal(3, stats.misses);
+}
+
+TEST(zero_size_disables_cache)
+{
+	cfg.list_cache_size = 0;
+	flist_cache_trim();
+
+	flist_cache_stats_t stats;
+	flist_cache_get_stats(&stats);
+	assert_int_equal(0, stats.listings);
+
+	assert_success(navigate_to(view, dir_a));
+	assert_int_equal(2, view->list_rows);
+
+	flist_cache_get_stats(&stats);
+	assert_int_equal(0, stats.listings);
+	assert_int_equal(0, stats.hits);
+	assert_int_equal(2, stats.misses);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,186 @@
+#include <stic.h>
+
+#include <sys/stat.h> /* S_ISDIR() */
+#include <unistd.h> /* chdir() */
+
+#include <test-utils.h>
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/matcher.h"
+#include "../../src/filelist.h"
+#include "../../src/flist_pos.h"
+
+static int using_inotify(void);
+
+static view_t *const view = &lwin;
+static char cwd[PATH_MAX + 1];
+
+SETUP_ONCE()
+{
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+}
+
+SETUP()
+{
+	view_setup(view);
+	make_abs_path(view->curr_dir, sizeof(view->curr_dir), SANDBOX_PATH, "",
+			cwd);
+
+	curr_view = view;
+	other_view = view;
+
+	/* Drop events that might have been scheduled by other tests. */
+	(void)ui_view_query_scheduled_event(view);
+}
+
+TEARDOWN()
+{
+	view_teardown(view);
+	assert_success(chdir(cwd));
+
+	curr_view = NULL;
+	other_view = NULL;
+}
+
+TEST(files_are_updated_in_place, IF(using_inotify))
+{
+	create_file(SANDBOX_PATH "/a");
+	create_file(SANDBOX_PATH "/b");
+
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_int_equal(2, view->list_rows);
+	view->dir_entry[1].selected = 1;
+	view->selected_files = 1;
+
+	create_file(SANDBOX_PATH "/c");
+	remove_file(SANDBOX_PATH "/a");
+	make_file(SANDBOX_PATH "/b", "data");
+
+	check_if_filelist_has_changed(view);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(view));
+
+	assert_int_equal(2, view->list_rows);
+	assert_string_equal("b", view->dir_entry[0].name);
+	assert_ulong_equal(4, view->dir_entry[0].size);
+	assert_true(view->dir_entry[0].selected);
+	assert_int_equal(1, view->selected_files);
+	assert_string_equal("c", view->dir_entry[1].name);
+	assert_int_equal(FT_REG, view->dir_entry[1].type);
+
+	remove_file(SANDBOX_PATH "/b");
+	remove_file(SANDBOX_PATH "/c");
+}
+
+TEST(new_links_are_resolved_relative_to_view, IF(using_inotify))
+{
+	create_file(SANDBOX_PATH "/a");
+	create_dir(SANDBOX_PATH "/dir");
+
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_success(chdir(cwd));
+
+	assert_success(make_symlink("dir", SANDBOX_PATH "/link"));
+
+	check_if_filelist_has_changed(view);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(view));
+
+	assert_int_equal(3, view->list_rows);
+	const int pos = fpos_find_by_name(view, "link");
+	assert_true(pos >= 0);
+	assert_int_equal(FT_LINK, view->dir_entry[pos].type);
+	assert_true(view->dir_entry[pos].dir_link);
+	assert_true(S_ISDIR(view->dir_entry[pos].mode));
+
+	remove_file(SANDBOX_PATH "/link");
+	remove_dir(SANDBOX_PATH "/dir");
+	remove_file(SANDBOX_PATH "/a");
+}
+
+TEST(cursor_stays_on_the_same_file, IF(using_inotify))
+{
+	create_file(SANDBOX_PATH "/b");
+	create_file(SANDBOX_PATH "/c");
+
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	view->list_pos = 1;
+
+	create_file(SANDBOX_PATH "/a");
+
+	check_if_filelist_has_changed(view);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(view));
+
+	assert_int_equal(3, view->list_rows);
+	assert_int_equal(2, view->list_pos);
+	assert_string_equal("c", view->dir_entry[view->list_pos].name);
+
+	remove_file(SANDBOX_PATH "/a");
+	remove_file(SANDBOX_PATH "/b");
+	remove_file(SANDBOX_PATH "/c");
+}
+
+TEST(changes_of_filtered_out_files_cause_reload, IF(using_inotify))
+{
+	create_file(SANDBOX_PATH "/a");
+	view->hide_dot = 1;
+
+	assert_success(populate_dir_list(view, /*reload=*/0));
+
+	create_file(SANDBOX_PATH "/.hidden");
+
+	check_if_filelist_has_changed(view);
+	assert_int_equal(UUE_RELOAD, ui_view_query_scheduled_event(view));
+
+	remove_file(SANDBOX_PATH "/.hidden");
+	remove_file(SANDBOX_PATH "/a");
+}
+
+TEST(type_change_of_filtered_out_file_causes_reload, IF(using_inotify))
+{
+	create_file(SANDBOX_PATH "/a");
+	create_dir(SANDBOX_PATH "/x");
+
+	char *error;
+	matcher_free(view->manual_filter);
+	assert_non_null(view->manual_filter =
+			matcher_alloc("{x/}", 0, 0, "", &error));
+
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_int_equal(1, view->list_rows);
+	assert_int_equal(1, view->filtered);
+
+	remove_dir(SANDBOX_PATH "/x");
+	create_file(SANDBOX_PATH "/x");
+
+	check_if_filelist_has_changed(view);
+	assert_int_equal(UUE_RELOAD, ui_view_query_scheduled_event(view));
+
+	remove_file(SANDBOX_PATH "/x");
+	remove_file(SANDBOX_PATH "/a");
+}
+
+TEST(removal_of_the_last_file_causes_reload, IF(using_inotify))
+{
+	create_file(SANDBOX_PATH "/a");
+
+	assert_success(populate_dir_list(view, /*reload=*/0));
+
+	remove_file(SANDBOX_PATH "/a");
+
+	check_if_filelist_has_changed(view);
+	assert_int_equal(UUE_RELOAD, ui_view_query_scheduled_event(view));
+}
+
+static int
+using_inotify(void)
+{
+#ifdef HAVE_INOTIFY
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
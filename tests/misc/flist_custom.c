@@ -93,6 +93,20 @@ TEST(duplicates_are_not_added)
 	assert_int_equal(1, lwin.list_rows);
 }
 
+TEST(origins_of_files_from_the_same_directory_are_shared)
+{
+	flist_custom_start(&lwin, "test");
+	flist_custom_add(&lwin, TEST_DATA_PATH "/existing-files/a");
+	flist_custom_add(&lwin, TEST_DATA_PATH "/existing-files/b");
+	flist_custom_add(&lwin, TEST_DATA_PATH "/read/two-lines");
+	assert_true(flist_custom_finish(&lwin, CV_REGULAR, 0) == 0);
+	assert_int_equal(3, lwin.list_rows);
+
+	assert_true(lwin.dir_entry[0].origin == lwin.dir_entry[1].origin);
+	assert_false(lwin.dir_entry[0].origin == lwin.dir_entry[2].origin);
+	assert_string_equal(TEST_DATA_PATH "/read", lwin.dir_entry[2].origin);
+}
+
 TEST(parent_dir_is_not_added_to_very_custom_view)
 {
 	opt_handlers_setup();
@@ -0,0 +1,233 @@
+#include <stic.h>
+
+#include <sys/types.h> /* pid_t */
+#include <sys/wait.h> /* WIFSIGNALED() WNOHANG WTERMSIG() waitpid() */
+#include <unistd.h> /* chdir() usleep() */
+
+#include <signal.h> /* SIGTERM */
+#include <stdio.h> /* FILE fclose() fopen() fscanf() */
+
+#include <test-utils.h>
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+#include "../../src/macros.h"
+#include "../../src/running.h"
+#include "../../src/status.h"
+
+/* Shell code that blocks until "gate" file is created. */
+#define WAIT_FOR_GATE "while [ ! -e gate ]; do sleep 0.01; done; "
+
+static void start_streaming(const char cmd[]);
+static void wait_for_streaming(view_t *view, int min_rows);
+static pid_t read_pid(const char path[]);
+
+static char cwd[PATH_MAX + 1];
+
+SETUP_ONCE()
+{
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+}
+
+SETUP()
+{
+	update_string(&cfg.fuse_home, "no");
+
+	/* So that nothing is written into directory history. */
+	rwin.list_rows = 0;
+
+	view_setup(&lwin);
+
+	curr_view = &lwin;
+	other_view = &lwin;
+
+	replace_string(&cfg.shell, "/bin/sh");
+	update_string(&cfg.shell_cmd_flag, "-c");
+	stats_update_shell_type(cfg.shell);
+
+	assert_success(chdir(SANDBOX_PATH));
+	assert_non_null(get_cwd(lwin.curr_dir, sizeof(lwin.curr_dir)));
+
+	create_file("a");
+	create_file("b");
+}
+
+TEARDOWN()
+{
+	remove_file("a");
+	remove_file("b");
+	assert_success(chdir(cwd));
+
+	stats_update_shell_type("/bin/sh");
+	update_string(&cfg.shell_cmd_flag, NULL);
+	update_string(&cfg.shell, NULL);
+	update_string(&cfg.fuse_home, NULL);
+
+	view_teardown(&lwin);
+
+	curr_view = NULL;
+	other_view = NULL;
+}
+
+TEST(output_of_command_is_shown_as_it_arrives, IF(not_windows))
+{
+	start_streaming("echo b; echo a; echo b; echo c");
+	assert_true(flist_is_loading(&lwin));
+	assert_false(flist_custom_active(&lwin));
+
+	wait_for_streaming(&lwin, /*min_rows=*/-1);
+
+	assert_true(flist_custom_active(&lwin));
+	assert_string_equal("title", lwin.custom.title);
+	assert_int_equal(2, lwin.list_rows);
+	assert_string_equal("a", lwin.dir_entry[0].name);
+	assert_string_equal("b", lwin.dir_entry[1].name);
+}
+
+TEST(late_paths_are_sorted_into_the_list, IF(not_windows))
+{
+	start_streaming("echo b; " WAIT_FOR_GATE "echo a");
+
+	wait_for_streaming(&lwin, /*min_rows=*/1);
+	assert_true(flist_is_loading(&lwin));
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("b", lwin.dir_entry[0].name);
+	assert_int_equal(0, lwin.list_pos);
+
+	create_file("gate");
+	wait_for_streaming(&lwin, /*min_rows=*/-1);
+	remove_file("gate");
+
+	assert_int_equal(2, lwin.list_rows);
+	assert_string_equal("a", lwin.dir_entry[0].name);
+	assert_string_equal("b", lwin.dir_entry[1].name);
+	/* Cursor stays on the same file. */
+	assert_int_equal(1, lwin.list_pos);
+}
+
+TEST(cancelling_keeps_received_paths, IF(not_windows))
+{
+	start_streaming("echo a; " WAIT_FOR_GATE "echo b");
+
+	wait_for_streaming(&lwin, /*min_rows=*/1);
+	flist_cancel_loading(&lwin);
+	assert_false(flist_is_loading(&lwin));
+
+	assert_true(flist_custom_active(&lwin));
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("a", lwin.dir_entry[0].name);
+}
+
+TEST(navigation_stops_streaming, IF(not_windows))
+{
+	start_streaming(WAIT_FOR_GATE "echo a");
+	assert_true(flist_is_loading(&lwin));
+
+	assert_success(populate_dir_list(&lwin, /*reload=*/0));
+	assert_false(flist_is_loading(&lwin));
+
+	flist_finish_loading(&lwin);
+	assert_false(flist_custom_active(&lwin));
+}
+
+TEST(silent_command_that_ignores_sigint_is_terminated, IF(not_windows))
+{
+	start_streaming("trap '' INT; echo $$ > pid; echo a; sleep 30");
+
+	wait_for_streaming(&lwin, /*min_rows=*/1);
+	const pid_t pid = read_pid("pid");
+	assert_true(pid > 0);
+	flist_cancel_loading(&lwin);
+
+	int i, status = 0;
+	for(i = 0; i < 1000 && waitpid(pid, &status, WNOHANG) == 0; ++i)
+	{
+		usleep(5000);
+	}
+	assert_true(WIFSIGNALED(status));
+	assert_int_equal(SIGTERM, WTERMSIG(status));
+
+	remove_file("pid");
+}
+
+TEST(lots_of_errors_do_not_block_streaming, IF(not_windows))
+{
+	start_streaming("i=0; while [ $i -lt 2000 ]; do "
+	                "echo ................................................ >&2; "
+	                "i=$((i + 1)); "
+	                "done; echo a");
+
+	wait_for_streaming(&lwin, /*min_rows=*/-1);
+
+	assert_true(flist_custom_active(&lwin));
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("a", lwin.dir_entry[0].name);
+}
+
+TEST(list_is_complete_on_return_in_scripts, IF(not_windows))
+{
+	curr_stats.sourcing_state = SOURCING_PROCESSING;
+	start_streaming("echo b; echo a");
+	curr_stats.sourcing_state = SOURCING_NONE;
+
+	assert_false(flist_is_loading(&lwin));
+	assert_true(flist_custom_active(&lwin));
+	assert_int_equal(2, lwin.list_rows);
+}
+
+/* Runs the command to populate custom view of the left view as if user
+ * interface was fully loaded. */
+static void
+start_streaming(const char cmd[])
+{
+	curr_stats.load_stage = 3;
+	assert_success(rn_for_flist(&lwin, cmd, "title", /*user_sh=*/1, MF_NONE));
+	curr_stats.load_stage = 0;
+}
+
+/* Waits for streaming of paths into custom view to finish or for the view to
+ * have at least min_rows entries if it's non-negative. */
+static void
+wait_for_streaming(view_t *view, int min_rows)
+{
+	int i;
+	for(i = 0; i < 1000 && flist_is_loading(view); ++i)
+	{
+		flist_finish_loading(view);
+		if(min_rows >= 0 && flist_custom_active(view) &&
+				view->list_rows >= min_rows)
+		{
+			return;
+		}
+
+		usleep(5000);
+	}
+	assert_false(flist_is_loading(view));
+}
+
+/* Reads process id written to a file by a command.  Returns the id or zero on
+ * error. */
+static pid_t
+read_pid(const char path[])
+{
+	FILE *const fp = fopen(path, "r");
+	if(fp == NULL)
+	{
+		return 0;
+	}
+
+	long pid = 0;
+	if(fscanf(fp, "%ld", &pid) != 1)
+	{
+		pid = 0;
+	}
+	fclose(fp);
+	return pid;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,97 @@
+#include <stic.h>
+
+#include <test-utils.h>
+
+#include "../../src/ui/ui.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+#include "../../src/flist_index.h"
+#include "../../src/flist_pos.h"
+#include "../../src/sort.h"
+
+SETUP()
+{
+	view_setup(&lwin);
+	copy_str(lwin.curr_dir, sizeof(lwin.curr_dir), "/dir");
+
+	append_view_entry(&lwin, "b");
+	append_view_entry(&lwin, "a");
+	append_view_entry(&lwin, "c");
+}
+
+TEARDOWN()
+{
+	view_teardown(&lwin);
+}
+
+TEST(entries_are_found_by_name)
+{
+	flist_index_t *index = flist_index_create(lwin.dir_entry, lwin.list_rows);
+	assert_non_null(index);
+
+	assert_int_equal(0, flist_index_find(index, "b", NULL));
+	assert_int_equal(1, flist_index_find(index, "a", NULL));
+	assert_int_equal(2, flist_index_find(index, "c", "/dir"));
+	assert_int_equal(-1, flist_index_find(index, "c", "/other"));
+	assert_int_equal(-1, flist_index_find(index, "d", NULL));
+
+	flist_index_free(index);
+}
+
+TEST(same_names_are_enumerated_in_order)
+{
+	static char other_dir[] = "/other";
+
+	int i;
+	for(i = 0; i < 100; ++i)
+	{
+		append_view_entry(&lwin, (i % 2 == 0) ? "a" : "x");
+	}
+	lwin.dir_entry[3].origin = other_dir;
+
+	flist_index_t *index = flist_index_create(lwin.dir_entry, lwin.list_rows);
+	assert_non_null(index);
+
+	int iter = 0;
+	assert_int_equal(1, flist_index_next(index, "a", &iter));
+	for(i = 0; i < 50; ++i)
+	{
+		assert_int_equal(3 + i*2, flist_index_next(index, "a", &iter));
+	}
+	assert_int_equal(-1, flist_index_next(index, "a", &iter));
+
+	assert_int_equal(3, flist_index_find(index, "a", other_dir));
+	assert_int_equal(4, flist_index_find(index, "x", NULL));
+
+	flist_index_free(index);
+}
+
+TEST(view_index_follows_changes_of_the_list)
+{
+	assert_int_equal(1, fpos_find_by_name(&lwin, "a"));
+
+	append_view_entry(&lwin, "d");
+	assert_int_equal(3, fpos_find_by_name(&lwin, "d"));
+
+	view_set_sort(lwin.sort, SK_BY_NAME, SK_NONE);
+	sort_view(&lwin);
+	assert_int_equal(0, fpos_find_by_name(&lwin, "a"));
+	assert_int_equal(3, fpos_find_by_name(&lwin, "d"));
+}
+
+TEST(entries_renamed_in_place_are_found)
+{
+	assert_int_equal(1, fpos_find_by_name(&lwin, "a"));
+
+	replace_string(&lwin.dir_entry[1].name, "z");
+	assert_int_equal(-1, fpos_find_by_name(&lwin, "a"));
+	assert_int_equal(1, fpos_find_by_name(&lwin, "z"));
+
+	assert_true(entry_from_path(&lwin, lwin.dir_entry, lwin.list_rows,
+				"/dir/z") == &lwin.dir_entry[1]);
+	assert_true(entry_from_path(&lwin, lwin.dir_entry, lwin.list_rows,
+				"/dir/a") == NULL);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
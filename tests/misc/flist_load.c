@@ -0,0 +1,204 @@
+#include <stic.h>
+
+#include <stdio.h> /* snprintf() */
+#include <unistd.h> /* chdir() */
+
+#include <test-utils.h>
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+#include "../../src/sort.h"
+
+/* Large enough to make loading use several threads. */
+enum { NFILES = 500 };
+/* Large enough to postpone loading of meta-data. */
+enum { NMANY_FILES = 10000 };
+
+static void make_many_files(void);
+static void remove_many_files(void);
+
+static view_t *const view = &lwin;
+static char cwd[PATH_MAX + 1];
+
+SETUP_ONCE()
+{
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+}
+
+SETUP()
+{
+	view_setup(view);
+	make_abs_path(view->curr_dir, sizeof(view->curr_dir), SANDBOX_PATH, "",
+			cwd);
+}
+
+TEARDOWN()
+{
+	view_teardown(view);
+	assert_success(chdir(cwd));
+}
+
+TEST(metadata_of_many_files_is_loaded_in_order)
+{
+	int i;
+	for(i = 0; i < NFILES; ++i)
+	{
+		char name[PATH_MAX + 1];
+		snprintf(name, sizeof(name), SANDBOX_PATH "/%04d", i);
+		make_file(name, (i%2 == 0 ? "" : "odd"));
+	}
+
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_int_equal(NFILES, view->list_rows);
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%04d", i);
+
+		const dir_entry_t *const entry = &view->dir_entry[i];
+		assert_string_equal(name, entry->name);
+		assert_int_equal(FT_REG, entry->type);
+		assert_ulong_equal((i%2 == 0 ? 0 : 3), entry->size);
+		assert_true(entry->mtime != 0);
+	}
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		char name[PATH_MAX + 1];
+		snprintf(name, sizeof(name), SANDBOX_PATH "/%04d", i);
+		remove_file(name);
+	}
+}
+
+TEST(filters_are_applied_before_loading_metadata)
+{
+	create_file(SANDBOX_PATH "/.hidden");
+	create_file(SANDBOX_PATH "/visible");
+	view->hide_dot = 1;
+
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_int_equal(1, view->list_rows);
+	assert_string_equal("visible", view->dir_entry[0].name);
+	assert_int_equal(1, view->filtered);
+
+	remove_file(SANDBOX_PATH "/.hidden");
+	remove_file(SANDBOX_PATH "/visible");
+}
+
+TEST(symbolic_links_are_resolved, IF(not_windows))
+{
+	create_dir(SANDBOX_PATH "/dir");
+	assert_success(make_symlink("dir", SANDBOX_PATH "/link"));
+	assert_success(make_symlink("nowhere", SANDBOX_PATH "/broken"));
+
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_int_equal(3, view->list_rows);
+
+	/* Directories and links to them come first. */
+	assert_string_equal("dir", view->dir_entry[0].name);
+	assert_int_equal(FT_DIR, view->dir_entry[0].type);
+
+	assert_string_equal("link", view->dir_entry[1].name);
+	assert_int_equal(FT_LINK, view->dir_entry[1].type);
+	assert_true(view->dir_entry[1].dir_link);
+
+	assert_string_equal("broken", view->dir_entry[2].name);
+	assert_int_equal(FT_LINK, view->dir_entry[2].type);
+	assert_false(view->dir_entry[2].dir_link);
+
+	remove_file(SANDBOX_PATH "/broken");
+	remove_file(SANDBOX_PATH "/link");
+	remove_dir(SANDBOX_PATH "/dir");
+}
+
+TEST(meta_of_huge_directory_is_postponed)
+{
+	make_many_files();
+
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_int_equal(NMANY_FILES, view->list_rows);
+	assert_true(view->meta_pending);
+	assert_true(view->dir_entry[0].meta_pending);
+	assert_int_equal(FT_REG, view->dir_entry[0].type);
+
+	/* Visible entries are loaded first. */
+	view->top_line = 5000;
+	view->list_pos = 5000;
+	view->window_cells = 10;
+	assert_true(flist_load_postponed_meta(view));
+	assert_false(view->dir_entry[5000].meta_pending);
+	assert_ulong_equal(4, view->dir_entry[5000].size);
+	assert_false(view->dir_entry[5009].meta_pending);
+	assert_ulong_equal(0, view->dir_entry[5009].size);
+	assert_true(view->dir_entry[9999].meta_pending);
+
+	while(flist_load_postponed_meta(view))
+	{
+		/* Do nothing. */
+	}
+	assert_false(view->meta_pending);
+
+	int i;
+	for(i = 0; i < NMANY_FILES; ++i)
+	{
+		const dir_entry_t *const entry = &view->dir_entry[i];
+		assert_false(entry->meta_pending);
+		assert_true(entry->mtime != 0);
+		assert_ulong_equal((i%1000 == 0 ? 4 : 0), entry->size);
+	}
+
+	remove_many_files();
+}
+
+TEST(list_is_resorted_after_loading_meta)
+{
+	make_many_files();
+	view_set_sort(view->sort, -SK_BY_SIZE, SK_BY_NAME);
+
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_string_equal("00000", view->dir_entry[0].name);
+	assert_string_equal("00001", view->dir_entry[1].name);
+
+	while(flist_load_postponed_meta(view))
+	{
+		/* Do nothing. */
+	}
+
+	assert_string_equal("00000", view->dir_entry[0].name);
+	assert_string_equal("01000", view->dir_entry[1].name);
+	assert_string_equal("09000", view->dir_entry[9].name);
+	assert_string_equal("00001", view->dir_entry[10].name);
+
+	remove_many_files();
+}
+
+static void
+make_many_files(void)
+{
+	int i;
+	for(i = 0; i < NMANY_FILES; ++i)
+	{
+		char name[PATH_MAX + 1];
+		snprintf(name, sizeof(name), SANDBOX_PATH "/%05d", i);
+		make_file(name, (i%1000 == 0 ? "data" : ""));
+	}
+}
+
+static void
+remove_many_files(void)
+{
+	int i;
+	for(i = 0; i < NMANY_FILES; ++i)
+	{
+		char name[PATH_MAX + 1];
+		snprintf(name, sizeof(name), SANDBOX_PATH "/%05d", i);
+		remove_file(name);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,190 @@
+#include <stic.h>
+
+#include <unistd.h> /* chdir() usleep() */
+
+#include <test-utils.h>
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/filelist.h"
+#include "../../src/flist_cache.h"
+
+static void wait_for_prefetch(void);
+
+static view_t *const view = &lwin;
+static char cwd[PATH_MAX + 1];
+static char sandbox[PATH_MAX + 1];
+static char dir[PATH_MAX + 1];
+
+SETUP_ONCE()
+{
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+	/* Not a current view to avoid extra processing of FUSE mounts. */
+	curr_view = &rwin;
+	other_view = &lwin;
+}
+
+SETUP()
+{
+	view_setup(view);
+	view_setup(&rwin);
+
+	make_abs_path(sandbox, sizeof(sandbox), SANDBOX_PATH, "", cwd);
+	make_abs_path(dir, sizeof(dir), SANDBOX_PATH, "dir", cwd);
+
+	create_dir(SANDBOX_PATH "/dir");
+	create_file(SANDBOX_PATH "/dir/b");
+	create_file(SANDBOX_PATH "/dir/.a");
+	create_file(SANDBOX_PATH "/file");
+
+	cfg.list_cache_size = 1024;
+	cfg.prefetch_max = 10;
+
+	assert_success(navigate_to(view, sandbox));
+	assert_int_equal(2, view->list_rows);
+	assert_string_equal("dir", view->dir_entry[0].name);
+	view->list_pos = 0;
+}
+
+TEARDOWN()
+{
+	cfg.prefetch_max = 0;
+	cfg.list_cache_size = 0;
+
+	view_teardown(view);
+	view_teardown(&rwin);
+	flist_cache_clear();
+	assert_success(chdir(cwd));
+
+	remove_file(SANDBOX_PATH "/dir/b");
+	remove_file(SANDBOX_PATH "/dir/.a");
+	remove_dir(SANDBOX_PATH "/dir");
+	remove_file(SANDBOX_PATH "/file");
+}
+
+TEST(nothing_is_started_without_permission)
+{
+	flist_prefetch(view, /*start=*/0);
+	assert_null(view->prefetcher);
+}
+
+TEST(directory_under_cursor_is_read_in_advance)
+{
+	flist_prefetch(view, /*start=*/1);
+	assert_non_null(view->prefetcher);
+	wait_for_prefetch();
+
+	flist_cache_stats_t stats;
+	flist_cache_get_stats(&stats);
+	assert_int_equal(1, stats.listings);
+
+	view->hide_dot = 1;
+	assert_success(navigate_to(view, dir));
+	assert_int_equal(1, view->list_rows);
+	assert_string_equal("b", view->dir_entry[0].name);
+	assert_string_equal(dir, view->dir_entry[0].origin);
+	assert_int_equal(1, view->filtered);
+
+	flist_cache_get_stats(&stats);
+	assert_int_equal(1, stats.hits);
+}
+
+TEST(changes_during_reading_in_advance_are_not_missed)
+{
+	flist_prefetch(view, /*start=*/1);
+	wait_for_prefetch();
+
+	create_file(SANDBOX_PATH "/dir/c");
+
+	assert_success(navigate_to(view, dir));
+	assert_int_equal(3, view->list_rows);
+
+	flist_cache_stats_t stats;
+	flist_cache_get_stats(&stats);
+	assert_int_equal(0, stats.hits);
+
+	remove_file(SANDBOX_PATH "/dir/c");
+}
+
+TEST(reading_in_advance_is_cancelled_when_cursor_moves)
+{
+	flist_prefetch(view, /*start=*/1);
+	assert_non_null(view->prefetcher);
+
+	view->list_pos = 1;
+	flist_prefetch(view, /*start=*/1);
+	assert_null(view->prefetcher);
+
+	flist_cache_stats_t stats;
+	flist_cache_get_stats(&stats);
+	assert_int_equal(0, stats.listings);
+}
+
+TEST(large_directories_are_not_read_in_advance)
+{
+	cfg.prefetch_max = 1;
+
+	flist_prefetch(view, /*start=*/1);
+	assert_non_null(view->prefetcher);
+	wait_for_prefetch();
+
+	flist_cache_stats_t stats;
+	flist_cache_get_stats(&stats);
+	assert_int_equal(0, stats.listings);
+
+	/* The directory isn't read again while cursor is on it. */
+	flist_prefetch(view, /*start=*/1);
+	assert_non_null(view->prefetcher);
+	assert_null(view->prefetch_watch);
+}
+
+TEST(reading_in_advance_can_be_disabled)
+{
+	cfg.prefetch_max = 0;
+	flist_prefetch(view, /*start=*/1);
+	assert_null(view->prefetcher);
+
+	cfg.prefetch_max = 10;
+	cfg.list_cache_size = 0;
+	flist_prefetch(view, /*start=*/1);
+	assert_null(view->prefetcher);
+}
+
+TEST(side_column_uses_list_read_in_advance)
+{
+	cached_entries_t *const column = &view->right_column;
+
+	assert_true(flist_update_cache(view, column, dir));
+	assert_true(column->pending);
+	assert_int_equal(0, column->entries.nentries);
+
+	wait_for_prefetch();
+
+	assert_true(flist_update_cache(view, column, dir));
+	assert_false(column->pending);
+	assert_int_equal(2, column->entries.nentries);
+	assert_string_equal(dir, column->entries.entries[0].origin);
+
+	/* Listing remains in the cache. */
+	flist_cache_stats_t stats;
+	flist_cache_get_stats(&stats);
+	assert_int_equal(1, stats.listings);
+}
+
+/* Waits for reading in advance to finish and collects its result. */
+static void
+wait_for_prefetch(void)
+{
+	int i;
+	for(i = 0; i < 1000 && view->prefetch_watch != NULL; ++i)
+	{
+		usleep(5000);
+		flist_prefetch(view, /*start=*/0);
+	}
+	assert_null(view->prefetch_watch);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
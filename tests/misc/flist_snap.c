@@ -0,0 +1,431 @@
+#include <stic.h>
+
+#include <dirent.h> /* DIR closedir() opendir() readdir() */
+#include <unistd.h> /* chdir() usleep() */
+#include <utime.h> /* utimbuf utime() */
+
+#include <stdio.h> /* FILE fclose() fopen() fputs() snprintf() */
+#include <string.h> /* strcmp() */
+
+#include <test-utils.h>
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/filemon.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str_arena.h"
+#include "../../src/filelist.h"
+#include "../../src/flist_snap.h"
+#include "../../src/status.h"
+
+static void wait_for_loading(void);
+static void wait_for_snapshots(int count);
+static int count_snapshots(void);
+static unsigned long long get_snapshots_size(void);
+static void age_snapshots(void);
+static void remove_snapshots(void);
+
+static view_t *const view = &lwin;
+static char cwd[PATH_MAX + 1];
+static char sandbox[PATH_MAX + 1];
+
+SETUP_ONCE()
+{
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+}
+
+SETUP()
+{
+	view_setup(view);
+	make_abs_path(sandbox, sizeof(sandbox), SANDBOX_PATH, "", cwd);
+	make_abs_path(view->curr_dir, sizeof(view->curr_dir), SANDBOX_PATH, "dir",
+			cwd);
+	make_abs_path(cfg.snapshots_dir, sizeof(cfg.snapshots_dir), SANDBOX_PATH,
+			"snaps", cwd);
+
+	create_dir(SANDBOX_PATH "/dir");
+	create_file(SANDBOX_PATH "/dir/file");
+	create_dir(SANDBOX_PATH "/dir/sub");
+
+	cfg.snapshot_min = 1;
+	curr_stats.load_stage = 3;
+}
+
+TEARDOWN()
+{
+	curr_stats.load_stage = 0;
+	cfg.snapshot_min = 0;
+
+	view_teardown(view);
+	assert_success(chdir(cwd));
+
+	remove_snapshots();
+	remove_file(SANDBOX_PATH "/dir/file");
+	remove_dir(SANDBOX_PATH "/dir/sub");
+	remove_dir(SANDBOX_PATH "/dir");
+}
+
+TEST(snapshot_can_be_saved_and_loaded)
+{
+	dir_entry_t entries[2] = {
+		{ .name = "a", .size = 10, .mtime = 20, .type = FT_REG },
+		{ .name = "bb", .size = 30, .mtime = 40, .type = FT_LINK, .dir_link = 1 },
+	};
+
+	filemon_t mon;
+	assert_success(filemon_from_file(view->curr_dir, FMT_MODIFIED, &mon));
+	assert_success(flist_snap_save(cfg.snapshots_dir, view->curr_dir, &mon,
+				entries, 2));
+	assert_int_equal(1, count_snapshots());
+
+	str_arena_t *const arena = str_arena_create();
+	filemon_t loaded_mon;
+	dir_entry_t *loaded;
+	int nloaded;
+	assert_success(flist_snap_load(cfg.snapshots_dir, view->curr_dir, arena,
+				&loaded_mon, &loaded, &nloaded));
+	str_arena_free(arena);
+
+	assert_true(filemon_equal(&mon, &loaded_mon));
+	assert_int_equal(2, nloaded);
+	assert_string_equal("a", loaded[0].name);
+	assert_int_equal(10, loaded[0].size);
+	assert_int_equal(20, loaded[0].mtime);
+	assert_int_equal(FT_REG, loaded[0].type);
+	assert_string_equal("bb", loaded[1].name);
+	assert_int_equal(30, loaded[1].size);
+	assert_int_equal(40, loaded[1].mtime);
+	assert_int_equal(FT_LINK, loaded[1].type);
+	assert_true(loaded[1].dir_link);
+
+	free_dir_entries(&loaded, &nloaded);
+}
+
+TEST(missing_snapshot_is_not_loaded)
+{
+	str_arena_t *const arena = str_arena_create();
+	filemon_t mon;
+	dir_entry_t *entries;
+	int nentries;
+	assert_failure(flist_snap_load(cfg.snapshots_dir, view->curr_dir, arena,
+				&mon, &entries, &nentries));
+	str_arena_free(arena);
+}
+
+TEST(broken_snapshot_is_not_loaded)
+{
+	dir_entry_t entries[1] = { { .name = "a", .type = FT_REG } };
+
+	filemon_t mon;
+	assert_success(filemon_from_file(view->curr_dir, FMT_MODIFIED, &mon));
+	assert_success(flist_snap_save(cfg.snapshots_dir, view->curr_dir, &mon,
+				entries, 1));
+
+	/* Append garbage to the only snapshot file. */
+	DIR *const dir = opendir(cfg.snapshots_dir);
+	assert_non_null(dir);
+	struct dirent *d;
+	while((d = readdir(dir)) != NULL)
+	{
+		if(d->d_name[0] != '.')
+		{
+			char path[PATH_MAX + 1];
+			snprintf(path, sizeof(path), "%s/%s", cfg.snapshots_dir, d->d_name);
+			FILE *const fp = fopen(path, "ab");
+			assert_non_null(fp);
+			fputs("garbage", fp);
+			fclose(fp);
+		}
+	}
+	closedir(dir);
+
+	str_arena_t *const arena = str_arena_create();
+	dir_entry_t *loaded;
+	int nloaded;
+	assert_failure(flist_snap_load(cfg.snapshots_dir, view->curr_dir, arena,
+				&mon, &loaded, &nloaded));
+	str_arena_free(arena);
+}
+
+TEST(least_recently_used_snapshots_are_pruned)
+{
+	dir_entry_t entries[1] = { { .name = "a", .type = FT_REG } };
+
+	filemon_t mon;
+	assert_success(filemon_from_file(view->curr_dir, FMT_MODIFIED, &mon));
+	assert_success(flist_snap_save(cfg.snapshots_dir, view->curr_dir, &mon,
+				entries, 1));
+	assert_success(flist_snap_save(cfg.snapshots_dir, sandbox, &mon, entries,
+				1));
+	age_snapshots();
+
+	/* Loading marks snapshot as used. */
+	str_arena_t *const arena = str_arena_create();
+	dir_entry_t *loaded;
+	int nloaded;
+	assert_success(flist_snap_load(cfg.snapshots_dir, sandbox, arena, &mon,
+				&loaded, &nloaded));
+	free_dir_entries(&loaded, &nloaded);
+
+	flist_snap_prune(cfg.snapshots_dir, get_snapshots_size());
+	assert_int_equal(2, count_snapshots());
+
+	flist_snap_prune(cfg.snapshots_dir, get_snapshots_size() - 1U);
+	assert_int_equal(1, count_snapshots());
+	assert_failure(flist_snap_load(cfg.snapshots_dir, view->curr_dir, arena,
+				&mon, &loaded, &nloaded));
+	assert_success(flist_snap_load(cfg.snapshots_dir, sandbox, arena, &mon,
+				&loaded, &nloaded));
+	free_dir_entries(&loaded, &nloaded);
+
+	flist_snap_prune(cfg.snapshots_dir, 1);
+	assert_int_equal(0, count_snapshots());
+
+	str_arena_free(arena);
+}
+
+TEST(snapshot_is_saved_after_reading_large_enough_directory)
+{
+	cfg.snapshot_min = 3;
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_false(flist_is_loading(view));
+	assert_int_equal(0, count_snapshots());
+
+	/* Snapshot is made out of the listing without reading directory again. */
+	cfg.snapshot_min = 2;
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_false(flist_is_loading(view));
+	wait_for_snapshots(1);
+	assert_int_equal(1, count_snapshots());
+	assert_int_equal(2, view->list_rows);
+}
+
+TEST(filtered_out_files_are_saved_to_snapshot)
+{
+	create_file(SANDBOX_PATH "/dir/.hidden");
+
+	view->hide_dot = 1;
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_int_equal(2, view->list_rows);
+	assert_int_equal(1, view->filtered);
+	wait_for_snapshots(1);
+
+	str_arena_t *const arena = str_arena_create();
+	filemon_t mon;
+	dir_entry_t *loaded;
+	int nloaded;
+	assert_success(flist_snap_load(cfg.snapshots_dir, view->curr_dir, arena,
+				&mon, &loaded, &nloaded));
+	str_arena_free(arena);
+
+	assert_int_equal(3, nloaded);
+	int i;
+	for(i = 0; i < nloaded; ++i)
+	{
+		assert_true(loaded[i].type != FT_UNK);
+		if(strcmp(loaded[i].name, "sub") == 0)
+		{
+			assert_int_equal(FT_DIR, loaded[i].type);
+		}
+	}
+	free_dir_entries(&loaded, &nloaded);
+
+	remove_file(SANDBOX_PATH "/dir/.hidden");
+}
+
+TEST(snapshot_is_shown_and_reconciled_in_background)
+{
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	wait_for_snapshots(1);
+
+	/* This doesn't change the directory. */
+	make_file(SANDBOX_PATH "/dir/file", "contents");
+
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_true(flist_is_loading(view));
+	assert_int_equal(2, view->list_rows);
+	assert_string_equal("sub", view->dir_entry[0].name);
+	assert_int_equal(FT_DIR, view->dir_entry[0].type);
+	assert_string_equal("file", view->dir_entry[1].name);
+	assert_int_equal(0, view->dir_entry[1].size);
+
+	wait_for_loading();
+	assert_int_equal(2, view->list_rows);
+	assert_string_equal("file", view->dir_entry[1].name);
+	assert_int_equal(8, view->dir_entry[1].size);
+}
+
+TEST(outdated_snapshot_is_updated_in_background)
+{
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	wait_for_snapshots(1);
+
+	create_file(SANDBOX_PATH "/dir/afile");
+
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_true(flist_is_loading(view));
+	assert_int_equal(2, view->list_rows);
+
+	wait_for_loading();
+	assert_int_equal(3, view->list_rows);
+	assert_string_equal("afile", view->dir_entry[1].name);
+
+	/* Updated snapshot is used on the next visit. */
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_int_equal(3, view->list_rows);
+	wait_for_loading();
+
+	remove_file(SANDBOX_PATH "/dir/afile");
+}
+
+TEST(filters_are_applied_to_snapshot)
+{
+	create_file(SANDBOX_PATH "/dir/.hidden");
+
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	wait_for_snapshots(1);
+
+	view->hide_dot = 1;
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_true(flist_is_loading(view));
+	assert_int_equal(2, view->list_rows);
+	assert_int_equal(1, view->filtered);
+	wait_for_loading();
+
+	view->hide_dot = 0;
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_true(flist_is_loading(view));
+	assert_int_equal(3, view->list_rows);
+	wait_for_loading();
+
+	remove_file(SANDBOX_PATH "/dir/.hidden");
+}
+
+TEST(snapshots_are_not_used_when_disabled)
+{
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	wait_for_snapshots(1);
+
+	make_file(SANDBOX_PATH "/dir/file", "contents");
+
+	cfg.snapshot_min = 0;
+	assert_success(populate_dir_list(view, /*reload=*/0));
+	assert_int_equal(2, view->list_rows);
+	assert_int_equal(8, view->dir_entry[1].size);
+}
+
+/* Waits for background reading to finish and applies its result. */
+static void
+wait_for_loading(void)
+{
+	int i;
+	for(i = 0; i < 1000 && flist_is_loading(view); ++i)
+	{
+		usleep(5000);
+		flist_finish_loading(view);
+	}
+}
+
+/* Waits for snapshots that are saved in background to appear. */
+static void
+wait_for_snapshots(int count)
+{
+	int i;
+	for(i = 0; i < 1000 && count_snapshots() < count; ++i)
+	{
+		usleep(5000);
+	}
+	assert_int_equal(count, count_snapshots());
+}
+
+/* Counts files in directory of snapshots.  Returns the number. */
+static int
+count_snapshots(void)
+{
+	DIR *const dir = opendir(cfg.snapshots_dir);
+	if(dir == NULL)
+	{
+		return 0;
+	}
+
+	int count = 0;
+	struct dirent *d;
+	while((d = readdir(dir)) != NULL)
+	{
+		count += (strcmp(d->d_name, ".") != 0 && strcmp(d->d_name, "..") != 0);
+	}
+	closedir(dir);
+	return count;
+}
+
+/* Computes total size of snapshots.  Returns the size. */
+static unsigned long long
+get_snapshots_size(void)
+{
+	DIR *const dir = opendir(cfg.snapshots_dir);
+	assert_non_null(dir);
+
+	unsigned long long size = 0ULL;
+	struct dirent *d;
+	while((d = readdir(dir)) != NULL)
+	{
+		if(strcmp(d->d_name, ".") != 0 && strcmp(d->d_name, "..") != 0)
+		{
+			char path[PATH_MAX + 1];
+			snprintf(path, sizeof(path), "%s/%s", cfg.snapshots_dir, d->d_name);
+			size += get_file_size(path);
+		}
+	}
+	closedir(dir);
+	return size;
+}
+
+/* Makes all snapshots look like they weren't used for a long time. */
+static void
+age_snapshots(void)
+{
+	DIR *const dir = opendir(cfg.snapshots_dir);
+	assert_non_null(dir);
+
+	struct dirent *d;
+	while((d = readdir(dir)) != NULL)
+	{
+		if(strcmp(d->d_name, ".") != 0 && strcmp(d->d_name, "..") != 0)
+		{
+			char path[PATH_MAX + 1];
+			snprintf(path, sizeof(path), "%s/%s", cfg.snapshots_dir, d->d_name);
+			const struct utimbuf times = { .actime = 1000, .modtime = 1000 };
+			assert_success(utime(path, &times));
+		}
+	}
+	closedir(dir);
+}
+
+/* Removes directory of snapshots along with its contents. */
+static void
+remove_snapshots(void)
+{
+	DIR *const dir = opendir(cfg.snapshots_dir);
+	if(dir == NULL)
+	{
+		return;
+	}
+
+	struct dirent *d;
+	while((d = readdir(dir)) != NULL)
+	{
+		if(strcmp(d->d_name, ".") != 0 && strcmp(d->d_name, "..") != 0)
+		{
+			char path[PATH_MAX + 1];
+			snprintf(path, sizeof(path), "%s/%s", cfg.snapshots_dir, d->d_name);
+			remove_file(path);
+		}
+	}
+	closedir(dir);
+
+	remove_dir(cfg.snapshots_dir);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -3,6 +3,7 @@
 #include <unistd.h> /* rmdir() */
 
 #include <stddef.h> /* NULL */
+#include <stdio.h> /* snprintf() */
 #include <stdlib.h> /* remove() */
 #include <string.h> /* memset() */
 
@@ -654,6 +655,41 @@ TEST(nesting_limit)
 	assert_int_equal(12, lwin.list_rows);
 }
 
+TEST(wide_tree_is_built_correctly)
+{
+	char path[PATH_MAX + 1];
+	int i, j;
+
+	assert_success(os_mkdir(SANDBOX_PATH "/wide", 0700));
+	for(i = 0; i < 20; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/wide/%02d", SANDBOX_PATH, i);
+		assert_success(os_mkdir(path, 0700));
+		for(j = 0; j < 3; ++j)
+		{
+			snprintf(path, sizeof(path), "%s/wide/%02d/%d", SANDBOX_PATH, i, j);
+			create_file(path);
+		}
+	}
+
+	assert_success(load_tree(&lwin, SANDBOX_PATH "/wide", cwd));
+	assert_int_equal(20*(1 + 3), lwin.list_rows);
+	validate_tree(&lwin);
+
+	for(i = 0; i < 20; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/wide/%02d", SANDBOX_PATH, i);
+		for(j = 0; j < 3; ++j)
+		{
+			char file[PATH_MAX + 1];
+			snprintf(file, sizeof(file), "%s/%d", path, j);
+			remove_file(file);
+		}
+		remove_dir(path);
+	}
+	remove_dir(SANDBOX_PATH "/wide");
+}
+
 static void
 verify_tree_node(column_data_t *cdt, int idx, const char expected[])
 {
@@ -415,6 +415,32 @@ TEST(lazy_unfolding)
 	assert_int_equal(7, lwin.list_rows);
 }
 
+TEST(unfolding_loads_only_subtree)
+{
+	lwin.hide_dot = 1;
+	assert_success(load_tree(&lwin, TEST_DATA_PATH "/tree", cwd));
+	assert_int_equal(10, lwin.list_rows);
+	assert_int_equal(2, lwin.filtered);
+
+	lwin.list_pos = 8;
+	assert_string_equal("dir5", lwin.dir_entry[lwin.list_pos].name);
+	toggle_fold_and_update(&lwin);
+	assert_int_equal(9, lwin.list_rows);
+	assert_int_equal(1, lwin.filtered);
+
+	flist_toggle_fold(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+	validate_tree(&lwin);
+	assert_int_equal(10, lwin.list_rows);
+	assert_int_equal(2, lwin.filtered);
+	assert_string_equal("dir5", lwin.dir_entry[lwin.list_pos].name);
+	assert_string_equal("file5", lwin.dir_entry[lwin.list_pos + 1].name);
+
+	populate_dir_list(&lwin, /*reload=*/1);
+	assert_int_equal(10, lwin.list_rows);
+	assert_int_equal(2, lwin.filtered);
+}
+
 TEST(lazy_unfolding_and_filtering)
 {
 	(void)filter_set(&lwin.local_filter.filter, "^[^1]+$");
@@ -0,0 +1,144 @@
+#include <stic.h>
+
+#include <unistd.h> /* usleep() */
+
+#include <test-utils.h>
+
+#include "../../src/cfg/config.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
+#include "../../src/hash_cache.h"
+
+static hcache_key_t make_key(int inode);
+
+static const hcache_hash_t hash1 = { 1, 2 };
+static const hcache_hash_t hash2 = { 3, 4 };
+
+SETUP()
+{
+	copy_str(cfg.hash_cache_file, sizeof(cfg.hash_cache_file),
+			SANDBOX_PATH "/hashes");
+}
+
+TEARDOWN()
+{
+	if(path_exists(cfg.hash_cache_file, NODEREF))
+	{
+		remove_file(cfg.hash_cache_file);
+	}
+	cfg.hash_cache_file[0] = '\0';
+}
+
+TEST(hashes_are_looked_up_by_state_of_file)
+{
+	hcache_t *cache = hcache_load(cfg.hash_cache_file, 10);
+	assert_non_null(cache);
+
+	hcache_key_t key = make_key(1);
+	hcache_hash_t hash;
+	assert_failure(hcache_get(cache, &key, &hash));
+
+	hcache_put(cache, &key, &hash1);
+	assert_success(hcache_get(cache, &key, &hash));
+	assert_true(hash.high == hash1.high && hash.low == hash1.low);
+
+	key.mtime = 11;
+	assert_failure(hcache_get(cache, &key, &hash));
+
+	hcache_put(cache, &key, &hash2);
+	assert_success(hcache_get(cache, &key, &hash));
+	assert_true(hash.high == hash2.high && hash.low == hash2.low);
+
+	hcache_free(cache);
+}
+
+TEST(hashes_survive_saving_and_loading)
+{
+	hcache_t *cache = hcache_load(cfg.hash_cache_file, 100);
+	int i;
+	for(i = 0; i < 100; ++i)
+	{
+		hcache_key_t key = make_key(i);
+		hcache_put(cache, &key, (i%2 == 0 ? &hash1 : &hash2));
+	}
+	assert_success(hcache_save(cache));
+	hcache_free(cache);
+
+	cache = hcache_load(cfg.hash_cache_file, 100);
+	for(i = 0; i < 100; ++i)
+	{
+		hcache_key_t key = make_key(i);
+		hcache_hash_t hash;
+		assert_success(hcache_get(cache, &key, &hash));
+		assert_true(hash.high == (i%2 == 0 ? hash1.high : hash2.high));
+	}
+	hcache_free(cache);
+}
+
+TEST(least_recently_used_hashes_are_dropped)
+{
+	hcache_t *cache = hcache_load(cfg.hash_cache_file, 2);
+	hcache_key_t key1 = make_key(1), key2 = make_key(2), key3 = make_key(3);
+	hcache_put(cache, &key1, &hash1);
+	hcache_put(cache, &key2, &hash1);
+	hcache_put(cache, &key3, &hash1);
+	hcache_put(cache, &key1, &hash1);
+	assert_success(hcache_save(cache));
+	hcache_free(cache);
+
+	hcache_hash_t hash;
+	cache = hcache_load(cfg.hash_cache_file, 2);
+	assert_success(hcache_get(cache, &key1, &hash));
+	assert_failure(hcache_get(cache, &key2, &hash));
+	assert_success(hcache_get(cache, &key3, &hash));
+	hcache_free(cache);
+}
+
+TEST(invalid_file_is_ignored)
+{
+	make_file(cfg.hash_cache_file, "garbage");
+
+	hcache_t *cache = hcache_load(cfg.hash_cache_file, 10);
+	assert_non_null(cache);
+
+	hcache_key_t key = make_key(1);
+	hcache_hash_t hash;
+	assert_failure(hcache_get(cache, &key, &hash));
+	hcache_free(cache);
+}
+
+TEST(key_changes_with_contents_of_file, IF(not_windows))
+{
+	hcache_key_t key1, key2;
+
+	make_file(SANDBOX_PATH "/file", "abc");
+	assert_success(hcache_make_key(SANDBOX_PATH "/file", &key1));
+	usleep(10*1000);
+	make_file(SANDBOX_PATH "/file", "abd");
+	assert_success(hcache_make_key(SANDBOX_PATH "/file", &key2));
+
+	assert_true(key1.inode == key2.inode);
+	assert_true(key1.size == key2.size);
+	assert_false(key1.ctime == key2.ctime && key1.mtime == key2.mtime);
+
+	assert_failure(hcache_make_key(SANDBOX_PATH, &key1));
+
+	remove_file(SANDBOX_PATH "/file");
+}
+
+/* Makes key of a fake file. */
+static hcache_key_t
+make_key(int inode)
+{
+	hcache_key_t key = {
+		.dev = 1,
+		.inode = inode,
+		.size = 10,
+		.mtime = 10,
+		.ctime = 10,
+	};
+	return key;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -519,6 +519,132 @@ TEST(custom_view_is_sorted_by_short_paths, IF(on_case_sensitive_fs))
 	remove_dir(SANDBOX_PATH "/D");
 }
 
+TEST(times_before_epoch_are_sorted_correctly)
+{
+	view_teardown(&lwin);
+	view_setup(&lwin);
+	set_file_list(&lwin, FT_REG, "late", "early", "epoch", NULL);
+	lwin.dir_entry[0].mtime = 100;
+	lwin.dir_entry[1].mtime = -100;
+	lwin.dir_entry[2].mtime = 0;
+
+	view_set_sort(lwin.sort, SK_BY_TIME_MODIFIED, SK_NONE);
+	sort_view(&lwin);
+
+	assert_string_equal("early", lwin.dir_entry[0].name);
+	assert_string_equal("epoch", lwin.dir_entry[1].name);
+	assert_string_equal("late", lwin.dir_entry[2].name);
+}
+
+TEST(descending_sort_keeps_parent_dir_first_and_ties_stable)
+{
+	view_teardown(&lwin);
+	view_setup(&lwin);
+	set_file_list(&lwin, FT_REG, "b", "a", "..", "c", NULL);
+	lwin.dir_entry[2].type = FT_DIR;
+	lwin.dir_entry[3].size = 10;
+
+	view_set_sort(lwin.sort, -SK_BY_SIZE, SK_NONE);
+	sort_view(&lwin);
+
+	assert_string_equal("..", lwin.dir_entry[0].name);
+	assert_string_equal("c", lwin.dir_entry[1].name);
+	assert_string_equal("b", lwin.dir_entry[2].name);
+	assert_string_equal("a", lwin.dir_entry[3].name);
+}
+
+TEST(large_lists_are_sorted_by_all_keys)
+{
+	enum { N = 20000 };
+
+	view_teardown(&lwin);
+	view_setup(&lwin);
+
+	lwin.list_rows = N;
+	lwin.dir_entry = dynarray_cextend(NULL, N*sizeof(*lwin.dir_entry));
+
+	int i;
+	for(i = 0; i < N; ++i)
+	{
+		lwin.dir_entry[i].name = format_str("f%05d", N - i);
+		lwin.dir_entry[i].type = (i % 3 == 0 ? FT_DIR : FT_REG);
+		lwin.dir_entry[i].origin = lwin.curr_dir;
+		lwin.dir_entry[i].mtime = i%10;
+	}
+
+	view_set_sort(lwin.sort, -SK_BY_TIME_MODIFIED, SK_BY_NAME);
+	sort_view(&lwin);
+
+	for(i = 1; i < N; ++i)
+	{
+		const dir_entry_t *prev = &lwin.dir_entry[i - 1];
+		const dir_entry_t *curr = &lwin.dir_entry[i];
+
+		if(prev->type != curr->type)
+		{
+			assert_int_equal(FT_DIR, prev->type);
+			continue;
+		}
+		if(prev->mtime != curr->mtime)
+		{
+			assert_true(prev->mtime > curr->mtime);
+			continue;
+		}
+		assert_true(strcmp(prev->name, curr->name) < 0);
+	}
+}
+
+TEST(large_lists_are_sorted_by_integer_keys)
+{
+	enum { N = 5000 };
+
+	view_teardown(&lwin);
+	view_setup(&lwin);
+	assert_success(stats_init(&cfg));
+
+	lwin.list_rows = N;
+	lwin.dir_entry = dynarray_cextend(NULL, N*sizeof(*lwin.dir_entry));
+
+	int i;
+	for(i = 0; i < N; ++i)
+	{
+		lwin.dir_entry[i].name = format_str("f%05d", i);
+		lwin.dir_entry[i].type = (i % 7 == 0 ? FT_DIR : FT_REG);
+		lwin.dir_entry[i].origin = lwin.curr_dir;
+		lwin.dir_entry[i].size = (i*7919)%13*((uint64_t)1 << 40);
+		lwin.dir_entry[i].mtime = (i % 5) - 2;
+	}
+	replace_string(&lwin.dir_entry[N/2].name, "..");
+	lwin.dir_entry[N/2].type = FT_DIR;
+
+	view_set_sort(lwin.sort, -SK_BY_SIZE, SK_BY_TIME_MODIFIED);
+	sort_view(&lwin);
+
+	assert_string_equal("..", lwin.dir_entry[0].name);
+	for(i = 2; i < N; ++i)
+	{
+		const dir_entry_t *prev = &lwin.dir_entry[i - 1];
+		const dir_entry_t *curr = &lwin.dir_entry[i];
+
+		if(prev->type != curr->type)
+		{
+			assert_int_equal(FT_DIR, prev->type);
+			continue;
+		}
+		if(prev->size != curr->size)
+		{
+			assert_true(prev->size > curr->size);
+			continue;
+		}
+		if(prev->mtime != curr->mtime)
+		{
+			assert_true(prev->mtime < curr->mtime);
+			continue;
+		}
+		assert_true(strcmp(prev->name, curr->name) < 0);
+	}
+}
+
 #ifndef _WIN32
 
 TEST(inode_sorting_works)
@@ -0,0 +1,157 @@
+#include <stic.h>
+
+#include <unistd.h> /* chdir() */
+
+#include <stdio.h> /* snprintf() */
+
+#include <test-utils.h>
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+#include "../../src/sort.h"
+
+#define N 100
+
+static void fill_list(view_t *view, int reverse);
+
+/* Index of the entry in the previous list, which is in reverse order. */
+static int prev[N];
+static char cwd[PATH_MAX + 1];
+
+SETUP_ONCE()
+{
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+}
+
+SETUP()
+{
+	/* Left view is the new list and right view holds the previous one. */
+	fill_list(&lwin, /*reverse=*/1);
+	fill_list(&rwin, /*reverse=*/0);
+
+	int i;
+	for(i = 0; i < N; ++i)
+	{
+		prev[i] = N - 1 - i;
+	}
+
+	view_set_sort(lwin.sort, SK_BY_SIZE, SK_NONE);
+}
+
+TEARDOWN()
+{
+	view_teardown(&lwin);
+	view_teardown(&rwin);
+}
+
+TEST(changed_entries_are_inserted_into_previous_order)
+{
+	lwin.dir_entry[49].size = 5;
+	lwin.dir_entry[0].size = 20;
+	prev[0] = -1;
+
+	assert_success(sort_view_incremental(&lwin, rwin.dir_entry, rwin.list_rows,
+				prev));
+
+	/* Order of unchanged entries is taken from the previous list. */
+	assert_string_equal("f050", lwin.dir_entry[0].name);
+	assert_string_equal("f000", lwin.dir_entry[1].name);
+	assert_string_equal("f098", lwin.dir_entry[98].name);
+	assert_string_equal("f099", lwin.dir_entry[99].name);
+}
+
+TEST(many_changes_require_full_sorting)
+{
+	int i;
+	for(i = 0; i < N/4; ++i)
+	{
+		lwin.dir_entry[i].size = 5;
+	}
+
+	assert_failure(sort_view_incremental(&lwin, rwin.dir_entry, rwin.list_rows,
+				prev));
+	assert_string_equal("f099", lwin.dir_entry[0].name);
+}
+
+TEST(previous_list_sorted_differently_requires_full_sorting)
+{
+	view_set_sort(lwin.sort, -SK_BY_NAME, SK_NONE);
+
+	assert_failure(sort_view_incremental(&lwin, rwin.dir_entry, rwin.list_rows,
+				prev));
+	assert_string_equal("f099", lwin.dir_entry[0].name);
+}
+
+TEST(small_lists_are_sorted_fully)
+{
+	lwin.list_rows = 10;
+	assert_failure(sort_view_incremental(&lwin, rwin.dir_entry, rwin.list_rows,
+				prev));
+	lwin.list_rows = N;
+}
+
+TEST(reloading_puts_changed_file_into_its_place)
+{
+	char path[PATH_MAX + 1];
+	int i;
+
+	view_teardown(&lwin);
+	view_setup(&lwin);
+	curr_view = &lwin;
+	other_view = &rwin;
+
+	for(i = 0; i < N; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/f%03d", SANDBOX_PATH, i);
+		create_file(path);
+	}
+
+	view_set_sort(lwin.sort, SK_BY_SIZE, SK_BY_NAME);
+	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), SANDBOX_PATH, "", cwd);
+	assert_success(populate_dir_list(&lwin, /*reload=*/0));
+	assert_int_equal(N, lwin.list_rows);
+	assert_string_equal("f000", lwin.dir_entry[0].name);
+
+	make_file(SANDBOX_PATH "/f000", "text");
+	assert_success(populate_dir_list(&lwin, /*reload=*/1));
+	assert_int_equal(N, lwin.list_rows);
+	assert_string_equal("f001", lwin.dir_entry[0].name);
+	assert_string_equal("f099", lwin.dir_entry[N - 2].name);
+	assert_string_equal("f000", lwin.dir_entry[N - 1].name);
+
+	for(i = 0; i < N; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/f%03d", SANDBOX_PATH, i);
+		remove_file(path);
+	}
+	assert_success(chdir(cwd));
+
+	curr_view = NULL;
+	other_view = NULL;
+}
+
+/* Fills view with N files of the same size. */
+static void
+fill_list(view_t *view, int reverse)
+{
+	view_setup(view);
+
+	view->list_rows = N;
+	view->dir_entry = dynarray_cextend(NULL, N*sizeof(*view->dir_entry));
+
+	int i;
+	for(i = 0; i < N; ++i)
+	{
+		view->dir_entry[i].name = format_str("f%03d", reverse ? N - 1 - i : i);
+		view->dir_entry[i].type = FT_REG;
+		view->dir_entry[i].origin = view->curr_dir;
+		view->dir_entry[i].size = 10;
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -9,6 +9,7 @@
 #include "../../src/utils/path.h"
 
 static int using_inotify(void);
+static int not_using_inotify(void);
 
 static char sandbox[PATH_MAX + 1];
 
@@ -153,6 +154,46 @@ TEST(to_many_events_causes_banning_of_same_events, IF(using_inotify))
 	fswatch_free(watch);
 }
 
+TEST(banned_file_is_reported_after_ban, IF(using_inotify))
+{
+	fswatch_t *watch;
+	assert_non_null(watch = fswatch_create(sandbox));
+
+	os_mkdir(SANDBOX_PATH "/testdir", 0700);
+
+	int i;
+	for(i = 0; i < 100; ++i)
+	{
+		os_chmod(SANDBOX_PATH "/testdir", 0777);
+		os_chmod(SANDBOX_PATH "/testdir", 0000);
+		(void)fswatch_poll(watch);
+	}
+
+	os_chmod(SANDBOX_PATH "/testdir", 0777);
+	assert_int_equal(FSWS_UNCHANGED, fswatch_poll(watch));
+
+	/* Move past the end of the ban instead of waiting for it. */
+#ifdef HAVE_INOTIFY
+	fswatch_time_shift = 60;
+#endif
+	FSWatchState state = fswatch_poll(watch);
+#ifdef HAVE_INOTIFY
+	fswatch_time_shift = 0;
+#endif
+	assert_int_equal(FSWS_UPDATED, state);
+
+	const strlist_t *const changes = fswatch_get_changes(watch);
+	assert_non_null(changes);
+	assert_int_equal(1, changes->nitems);
+	assert_string_equal("testdir", changes->items[0]);
+
+	assert_int_equal(FSWS_UNCHANGED, fswatch_poll(watch));
+
+	fswatch_free(watch);
+
+	assert_success(remove(SANDBOX_PATH "/testdir"));
+}
+
 TEST(file_recreation_removes_ban, IF(using_inotify))
 {
 	fswatch_t *watch;
@@ -182,6 +223,67 @@ TEST(file_recreation_removes_ban, IF(using_inotify))
 	assert_success(remove(SANDBOX_PATH "/testdir"));
 }
 
+TEST(changed_files_are_listed_once, IF(using_inotify))
+{
+	fswatch_t *watch;
+	assert_non_null(watch = fswatch_create(sandbox));
+
+	assert_success(os_mkdir(SANDBOX_PATH "/a", 0700));
+	assert_success(os_chmod(SANDBOX_PATH "/a", 0777));
+	assert_success(os_mkdir(SANDBOX_PATH "/b", 0700));
+	assert_int_equal(FSWS_UPDATED, fswatch_poll(watch));
+
+	const strlist_t *changes = fswatch_get_changes(watch);
+	assert_non_null(changes);
+	assert_int_equal(2, changes->nitems);
+	assert_string_equal("a", changes->items[0]);
+	assert_string_equal("b", changes->items[1]);
+
+	assert_int_equal(FSWS_UNCHANGED, fswatch_poll(watch));
+	assert_non_null(changes = fswatch_get_changes(watch));
+	assert_int_equal(0, changes->nitems);
+
+	assert_success(remove(SANDBOX_PATH "/a"));
+	assert_int_equal(FSWS_UPDATED, fswatch_poll(watch));
+	assert_non_null(changes = fswatch_get_changes(watch));
+	assert_int_equal(1, changes->nitems);
+	assert_string_equal("a", changes->items[0]);
+
+	fswatch_free(watch);
+
+	assert_success(remove(SANDBOX_PATH "/b"));
+}
+
+TEST(changes_are_unknown_after_replacement, IF(using_inotify))
+{
+	assert_success(os_mkdir(SANDBOX_PATH "/testdir", 0700));
+
+	fswatch_t *watch;
+	assert_non_null(watch = fswatch_create(SANDBOX_PATH "/testdir"));
+
+	assert_success(rename(SANDBOX_PATH "/testdir", SANDBOX_PATH "/eatinode"));
+	assert_success(os_mkdir(SANDBOX_PATH "/testdir", 0700));
+
+	assert_int_equal(FSWS_REPLACED, fswatch_poll(watch));
+	assert_null(fswatch_get_changes(watch));
+
+	fswatch_free(watch);
+
+	assert_success(remove(SANDBOX_PATH "/testdir"));
+	assert_success(remove(SANDBOX_PATH "/eatinode"));
+}
+
+TEST(changes_are_unknown_without_inotify, IF(not_using_inotify))
+{
+	fswatch_t *watch;
+	assert_non_null(watch = fswatch_create(sandbox));
+
+	(void)fswatch_poll(watch);
+	assert_null(fswatch_get_changes(watch));
+
+	fswatch_free(watch);
+}
+
 static int
 using_inotify(void)
 {
@@ -192,5 +294,11 @@ using_inotify(void)
 #endif
 }
 
+static int
+not_using_inotify(void)
+{
+	return !using_inotify();
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
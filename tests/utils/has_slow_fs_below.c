@@ -0,0 +1,32 @@
+#include <stic.h>
+
+#include <test-utils.h>
+
+#include "../../src/utils/utils.h"
+
+TEST(nothing_is_slow_without_specs)
+{
+	assert_false(has_slow_fs_below("/", ""));
+}
+
+TEST(everything_is_slow_with_asterisk, IF(not_windows))
+{
+	assert_true(has_slow_fs_below("/", "*"));
+}
+
+TEST(slow_paths_below_are_found, IF(not_windows))
+{
+	assert_true(has_slow_fs_below("/mnt", "/mnt/net"));
+	assert_true(has_slow_fs_below("/mnt", "/srv,/mnt/net"));
+	assert_true(has_slow_fs_below("/mnt/net", "/mnt/net"));
+}
+
+TEST(slow_paths_elsewhere_are_ignored)
+{
+	assert_false(has_slow_fs_below("/home", "/mnt/net"));
+	assert_false(has_slow_fs_below("/mnt/net/dir", "/mnt/net"));
+	assert_false(has_slow_fs_below("/mnt/ne", "/mnt/net"));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
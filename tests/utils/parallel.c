@@ -0,0 +1,157 @@
+#include <stic.h>
+
+#include <stddef.h> /* size_t */
+#include <string.h> /* memset() */
+
+#include "../../src/compat/pthread.h"
+#include "../../src/utils/parallel.h"
+
+enum { NITEMS = 10000 };
+
+static void count_item(size_t idx, void *arg);
+static void visit_task(par_tasks_t *tasks, int worker, void *task, void *arg);
+static int cancel_right_away(size_t ndone, void *arg);
+static int never_cancel(size_t ndone, void *arg);
+
+static int visits[NITEMS];
+static pthread_mutex_t visits_lock = PTHREAD_MUTEX_INITIALIZER;
+
+SETUP()
+{
+	memset(visits, 0, sizeof(visits));
+}
+
+TEST(number_of_threads_is_positive)
+{
+	assert_true(par_nthreads() > 0);
+}
+
+TEST(no_items_is_fine)
+{
+	assert_success(par_for(0, 4, &count_item, NULL, NULL));
+	assert_success(par_for(0, 4, &count_item, &never_cancel, NULL));
+}
+
+TEST(every_item_is_processed_once_by_a_single_thread)
+{
+	assert_success(par_for(NITEMS, 1, &count_item, NULL, NULL));
+
+	int i;
+	for(i = 0; i < NITEMS; ++i)
+	{
+		assert_int_equal(1, visits[i]);
+	}
+}
+
+TEST(every_item_is_processed_once_by_many_threads)
+{
+	assert_success(par_for(NITEMS, 8, &count_item, NULL, NULL));
+
+	int i;
+	for(i = 0; i < NITEMS; ++i)
+	{
+		assert_int_equal(1, visits[i]);
+	}
+}
+
+TEST(every_item_is_processed_once_while_polling)
+{
+	assert_success(par_for(NITEMS, 8, &count_item, &never_cancel, NULL));
+
+	int i;
+	for(i = 0; i < NITEMS; ++i)
+	{
+		assert_int_equal(1, visits[i]);
+	}
+}
+
+TEST(processing_can_be_cancelled)
+{
+	assert_failure(par_for(NITEMS, 1, &count_item, &cancel_right_away, NULL));
+
+	int i;
+	for(i = 0; i < NITEMS; ++i)
+	{
+		assert_int_equal(0, visits[i]);
+	}
+}
+
+TEST(every_task_is_processed_once_by_a_single_thread)
+{
+	assert_success(par_run((void *)(size_t)1, 1, &visit_task, NULL, NULL));
+
+	int i;
+	for(i = 1; i < NITEMS; ++i)
+	{
+		assert_int_equal(1, visits[i]);
+	}
+}
+
+TEST(every_task_is_processed_once_by_many_threads)
+{
+	assert_success(par_run((void *)(size_t)1, 8, &visit_task, NULL, NULL));
+
+	int i;
+	for(i = 1; i < NITEMS; ++i)
+	{
+		assert_int_equal(1, visits[i]);
+	}
+}
+
+TEST(every_task_is_processed_once_while_polling)
+{
+	assert_success(par_run((void *)(size_t)1, 8, &visit_task, &never_cancel,
+				NULL));
+
+	int i;
+	for(i = 1; i < NITEMS; ++i)
+	{
+		assert_int_equal(1, visits[i]);
+	}
+}
+
+TEST(processing_of_tasks_can_be_cancelled)
+{
+	assert_failure(par_run((void *)(size_t)1, 1, &visit_task,
+				&cancel_right_away, NULL));
+	assert_int_equal(0, visits[1]);
+}
+
+static void
+count_item(size_t idx, void *arg)
+{
+	pthread_mutex_lock(&visits_lock);
+	++visits[idx];
+	pthread_mutex_unlock(&visits_lock);
+}
+
+static void
+visit_task(par_tasks_t *tasks, int worker, void *task, void *arg)
+{
+	const size_t idx = (size_t)task;
+	count_item(idx, arg);
+
+	if(idx*2 < NITEMS)
+	{
+		(void)par_spawn(tasks, worker, (void *)(idx*2));
+	}
+	if(idx*2 + 1 < NITEMS)
+	{
+		(void)par_spawn(tasks, worker, (void *)(idx*2 + 1));
+	}
+}
+
+static int
+cancel_right_away(size_t ndone, void *arg)
+{
+	return 1;
+}
+
+static int
+never_cancel(size_t ndone, void *arg)
+{
+	return 0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,129 @@
+#include <stic.h>
+
+#include <string.h> /* memset() */
+
+#include "../../src/utils/str_arena.h"
+
+static str_arena_t *arena;
+
+SETUP()
+{
+	arena = str_arena_create();
+	assert_non_null(arena);
+}
+
+TEARDOWN()
+{
+	str_arena_free(arena);
+}
+
+TEST(null_arena_is_handled)
+{
+	str_arena_free(NULL);
+	assert_null(str_arena_dup(NULL, "str"));
+	assert_null(str_arena_intern(NULL, "str"));
+	str_arena_release(NULL);
+}
+
+TEST(strings_are_copied)
+{
+	char *const a = str_arena_dup(arena, "a");
+	char *const empty = str_arena_dup(arena, "");
+	char *const b = str_arena_dup(arena, "bbb");
+
+	assert_string_equal("a", a);
+	assert_string_equal("", empty);
+	assert_string_equal("bbb", b);
+
+	str_arena_release(b);
+	str_arena_release(a);
+	str_arena_release(empty);
+}
+
+TEST(dups_are_distinct)
+{
+	char *const a = str_arena_dup(arena, "str");
+	char *const b = str_arena_dup(arena, "str");
+	assert_true(a != b);
+
+	str_arena_release(a);
+	str_arena_release(b);
+}
+
+TEST(interned_strings_are_shared)
+{
+	char *const a = str_arena_intern(arena, "/some/dir");
+	char *const b = str_arena_intern(arena, "/other/dir");
+	char *const c = str_arena_intern(arena, "/some/dir");
+
+	assert_true(a == c);
+	assert_true(a != b);
+
+	str_arena_release(a);
+	assert_string_equal("/some/dir", c);
+
+	str_arena_release(b);
+	str_arena_release(c);
+}
+
+TEST(strings_outlive_arena)
+{
+	char *const a = str_arena_dup(arena, "a");
+	char *const b = str_arena_intern(arena, "b");
+
+	str_arena_free(arena);
+	arena = str_arena_create();
+
+	assert_string_equal("a", a);
+	assert_string_equal("b", b);
+
+	str_arena_release(a);
+	str_arena_release(b);
+}
+
+TEST(many_strings_span_several_blocks)
+{
+	enum { N = 10000 };
+	static char *strs[N];
+
+	int i;
+	for(i = 0; i < N; ++i)
+	{
+		strs[i] = (i%2 == 0 ? str_arena_intern(arena, "some string")
+		                    : str_arena_dup(arena, "other"));
+		assert_non_null(strs[i]);
+	}
+
+	for(i = 0; i < N; i += 2)
+	{
+		assert_string_equal("some string", strs[i]);
+		str_arena_release(strs[i]);
+	}
+	for(i = 1; i < N; i += 2)
+	{
+		assert_string_equal("other", strs[i]);
+		str_arena_release(strs[i]);
+	}
+}
+
+TEST(long_strings_are_supported)
+{
+	char buf[64*1024];
+	memset(buf, 'x', sizeof(buf) - 1U);
+	buf[sizeof(buf) - 1U] = '\0';
+
+	char *const small = str_arena_dup(arena, "small");
+	char *const large = str_arena_dup(arena, buf);
+	char *const interned = str_arena_intern(arena, buf);
+
+	assert_string_equal(buf, large);
+	assert_string_equal(buf, interned);
+	assert_string_equal("small", small);
+
+	str_arena_release(large);
+	str_arena_release(interned);
+	str_arena_release(small);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */